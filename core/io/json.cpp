@@ -45,73 +45,224 @@ const char *JSON::tk_name[TK_MAX] = {
 	"EOF",
 };
 
-String JSON::_make_indent(const String &p_indent, int p_size) {
-	String indent_text = "";
-	if (!p_indent.is_empty()) {
-		for (int i = 0; i < p_size; i++) {
-			indent_text += p_indent;
+// Writers append to a buffer that doubles when full, rather than concatenating strings.
+
+struct JSONStringWriter {
+	String buffer;
+	int length = 0;
+
+	_FORCE_INLINE_ char32_t *reserve(int p_count) {
+		if (length + p_count > buffer.size()) {
+			buffer.resize(MAX(next_power_of_2(length + p_count), 256u));
 		}
+		return buffer.ptrw() + length;
+	}
+
+	void write(const char32_t *p_str, int p_len) {
+		memcpy(reserve(p_len), p_str, p_len * sizeof(char32_t));
+		length += p_len;
+	}
+
+	void write(const char *p_ascii) {
+		int len = strlen(p_ascii);
+		char32_t *dst = reserve(len);
+		for (int i = 0; i < len; i++) {
+			dst[i] = uint8_t(p_ascii[i]);
+		}
+		length += len;
+	}
+
+	void write(char32_t p_char) {
+		*reserve(1) = p_char;
+		length++;
 	}
-	return indent_text;
-}
 
-String JSON::_stringify(const Variant &p_var, const String &p_indent, int p_cur_indent, bool p_sort_keys, Set<const void *> &p_markers, bool p_full_precision) {
-	String colon = ":";
-	String end_statement = "";
+	String finish() {
+		if (length == 0) {
+			return String();
+		}
+		*reserve(1) = 0;
+		buffer.resize(length + 1);
+		return buffer;
+	}
+};
+
+struct JSONUTF8Writer {
+	Vector<uint8_t> &buffer;
+	int length = 0;
+
+	_FORCE_INLINE_ uint8_t *reserve(int p_count) {
+		if (length + p_count > buffer.size()) {
+			buffer.resize(MAX(next_power_of_2(length + p_count), 256u));
+		}
+		return buffer.ptrw() + length;
+	}
+
+	_FORCE_INLINE_ void write(char32_t p_char) {
+		if (p_char <= 0x7f) {
+			*reserve(1) = p_char;
+			length++;
+			return;
+		}
+
+		uint8_t *dst = reserve(4);
+		if (p_char <= 0x7ff) {
+			dst[0] = 0xc0 | (p_char >> 6);
+			dst[1] = 0x80 | (p_char & 0x3f);
+			length += 2;
+		} else if (p_char <= 0xffff) {
+			dst[0] = 0xe0 | (p_char >> 12);
+			dst[1] = 0x80 | ((p_char >> 6) & 0x3f);
+			dst[2] = 0x80 | (p_char & 0x3f);
+			length += 3;
+		} else {
+			dst[0] = 0xf0 | ((p_char >> 18) & 0x07);
+			dst[1] = 0x80 | ((p_char >> 12) & 0x3f);
+			dst[2] = 0x80 | ((p_char >> 6) & 0x3f);
+			dst[3] = 0x80 | (p_char & 0x3f);
+			length += 4;
+		}
+	}
+
+	void write(const char32_t *p_str, int p_len) {
+		reserve(p_len);
+		for (int i = 0; i < p_len; i++) {
+			write(p_str[i]);
+		}
+	}
+
+	void write(const char *p_ascii) {
+		int len = strlen(p_ascii);
+		memcpy(reserve(len), p_ascii, len);
+		length += len;
+	}
+
+	JSONUTF8Writer(Vector<uint8_t> &r_buffer) :
+			buffer(r_buffer) {}
+};
+
+template <class W>
+static void _write_string(W &r_writer, const String &p_str) {
+	r_writer.write(U'"');
+
+	// Same escapes as String::json_escape(), plain runs are written as they are.
+	const char32_t *src = p_str.ptr();
+	int len = p_str.length();
+	int run_from = 0;
+	for (int i = 0; i < len; i++) {
+		const char *escaped = nullptr;
+		switch (src[i]) {
+			case '\\':
+				escaped = "\\\\";
+				break;
+			case '\b':
+				escaped = "\\b";
+				break;
+			case '\f':
+				escaped = "\\f";
+				break;
+			case '\n':
+				escaped = "\\n";
+				break;
+			case '\r':
+				escaped = "\\r";
+				break;
+			case '\t':
+				escaped = "\\t";
+				break;
+			case '\v':
+				escaped = "\\v";
+				break;
+			case '"':
+				escaped = "\\\"";
+				break;
+			default:
+				break;
+		}
+		if (escaped) {
+			r_writer.write(src + run_from, i - run_from);
+			r_writer.write(escaped);
+			run_from = i + 1;
+		}
+	}
+	r_writer.write(src + run_from, len - run_from);
+
+	r_writer.write(U'"');
+}
 
-	if (!p_indent.is_empty()) {
-		colon += " ";
-		end_statement += "\n";
+template <class W>
+static void _write_indent(W &r_writer, const String &p_indent, int p_size) {
+	for (int i = 0; i < p_size; i++) {
+		r_writer.write(p_indent.ptr(), p_indent.length());
 	}
+}
+
+template <class W>
+void JSON::_stringify(W &r_writer, const Variant &p_var, const String &p_indent, int p_cur_indent, bool p_sort_keys, Set<const void *> &p_markers, bool p_full_precision) {
+	const char *colon = p_indent.is_empty() ? ":" : ": ";
+	const char *end_statement = p_indent.is_empty() ? "" : "\n";
 
 	switch (p_var.get_type()) {
-		case Variant::NIL:
-			return "null";
-		case Variant::BOOL:
-			return p_var.operator bool() ? "true" : "false";
-		case Variant::INT:
-			return itos(p_var);
+		case Variant::NIL: {
+			r_writer.write("null");
+		} break;
+		case Variant::BOOL: {
+			r_writer.write(p_var.operator bool() ? "true" : "false");
+		} break;
+		case Variant::INT: {
+			String num = itos(p_var);
+			r_writer.write(num.ptr(), num.length());
+		} break;
 		case Variant::FLOAT: {
 			double num = p_var;
+			String num_str;
 			if (p_full_precision) {
 				// Store unreliable digits (17) instead of just reliable
 				// digits (14) so that the value can be decoded exactly.
-				return String::num(num, 17 - (int)floor(log10(num)));
+				num_str = String::num(num, 17 - (int)floor(log10(num)));
 			} else {
 				// Store only reliable digits (14) by default.
-				return String::num(num, 14 - (int)floor(log10(num)));
+				num_str = String::num(num, 14 - (int)floor(log10(num)));
 			}
-		}
+			r_writer.write(num_str.ptr(), num_str.length());
+		} break;
 		case Variant::PACKED_INT32_ARRAY:
 		case Variant::PACKED_INT64_ARRAY:
 		case Variant::PACKED_FLOAT32_ARRAY:
 		case Variant::PACKED_FLOAT64_ARRAY:
 		case Variant::PACKED_STRING_ARRAY:
 		case Variant::ARRAY: {
-			String s = "[";
-			s += end_statement;
 			Array a = p_var;
 
-			ERR_FAIL_COND_V_MSG(p_markers.has(a.id()), "\"[...]\"", "Converting circular structure to JSON.");
+			if (p_markers.has(a.id())) {
+				r_writer.write("\"[...]\"");
+				ERR_FAIL_MSG("Converting circular structure to JSON.");
+			}
 			p_markers.insert(a.id());
 
+			r_writer.write(U'[');
+			r_writer.write(end_statement);
 			for (int i = 0; i < a.size(); i++) {
 				if (i > 0) {
-					s += ",";
-					s += end_statement;
+					r_writer.write(U',');
+					r_writer.write(end_statement);
 				}
-				s += _make_indent(p_indent, p_cur_indent + 1) + _stringify(a[i], p_indent, p_cur_indent + 1, p_sort_keys, p_markers);
+				_write_indent(r_writer, p_indent, p_cur_indent + 1);
+				_stringify(r_writer, a[i], p_indent, p_cur_indent + 1, p_sort_keys, p_markers);
 			}
-			s += end_statement + _make_indent(p_indent, p_cur_indent) + "]";
+			r_writer.write(end_statement);
+			_write_indent(r_writer, p_indent, p_cur_indent);
+			r_writer.write(U']');
+
 			p_markers.erase(a.id());
-			return s;
-		}
+		} break;
 		case Variant::DICTIONARY: {
-			String s = "{";
-			s += end_statement;
 			Dictionary d = p_var;
 
-			ERR_FAIL_COND_V_MSG(p_markers.has(d.id()), "\"{...}\"", "Converting circular structure to JSON.");
+			if (p_markers.has(d.id())) {
+				r_writer.write("\"{...}\"");
+				ERR_FAIL_MSG("Converting circular structure to JSON.");
+			}
 			p_markers.insert(d.id());
 
 			List<Variant> keys;
@@ -121,25 +272,30 @@ String JSON::_stringify(const Variant &p_var, const String &p_indent, int p_cur_
 				keys.sort();
 			}
 
+			r_writer.write(U'{');
+			r_writer.write(end_statement);
 			bool first_key = true;
 			for (const Variant &E : keys) {
 				if (first_key) {
 					first_key = false;
 				} else {
-					s += ",";
-					s += end_statement;
+					r_writer.write(U',');
+					r_writer.write(end_statement);
 				}
-				s += _make_indent(p_indent, p_cur_indent + 1) + _stringify(String(E), p_indent, p_cur_indent + 1, p_sort_keys, p_markers);
-				s += colon;
-				s += _stringify(d[E], p_indent, p_cur_indent + 1, p_sort_keys, p_markers);
+				_write_indent(r_writer, p_indent, p_cur_indent + 1);
+				_write_string(r_writer, String(E));
+				r_writer.write(colon);
+				_stringify(r_writer, d[E], p_indent, p_cur_indent + 1, p_sort_keys, p_markers);
 			}
+			r_writer.write(end_statement);
+			_write_indent(r_writer, p_indent, p_cur_indent);
+			r_writer.write(U'}');
 
-			s += end_statement + _make_indent(p_indent, p_cur_indent) + "}";
 			p_markers.erase(d.id());
-			return s;
-		}
-		default:
-			return "\"" + String(p_var).json_escape() + "\"";
+		} break;
+		default: {
+			_write_string(r_writer, String(p_var));
+		} break;
 	}
 }
 
@@ -187,7 +343,21 @@ Error JSON::_get_token(const char32_t *p_str, int &index, int p_len, Token &r_to
 			}
 			case '"': {
 				index++;
+
+				// Find where the string ends first, so it's allocated once. Escapes only shorten it.
+				int end = index;
+				while (p_str[end] != '"' && p_str[end] != 0) {
+					if (p_str[end] == '\\' && p_str[end + 1] != 0) {
+						end++;
+					}
+					end++;
+				}
+
 				String str;
+				str.resize(end - index + 1);
+				char32_t *dst = str.ptrw();
+				int str_len = 0;
+
 				while (true) {
 					if (p_str[index] == 0) {
 						r_err_str = "Unterminated String";
@@ -304,17 +474,24 @@ Error JSON::_get_token(const char32_t *p_str, int &index, int p_len, Token &r_to
 							} break;
 						}
 
-						str += res;
+						dst[str_len++] = res;
 
 					} else {
 						if (p_str[index] == '\n') {
 							line++;
 						}
-						str += p_str[index];
+						dst[str_len++] = p_str[index];
 					}
 					index++;
 				}
 
+				if (str_len == 0) {
+					str = String();
+				} else {
+					dst[str_len] = 0;
+					str.resize(str_len + 1);
+				}
+
 				r_token.type = TK_STRING;
 				r_token.value = str;
 				return OK;
@@ -336,15 +513,13 @@ Error JSON::_get_token(const char32_t *p_str, int &index, int p_len, Token &r_to
 					return OK;
 
 				} else if ((p_str[index] >= 'A' && p_str[index] <= 'Z') || (p_str[index] >= 'a' && p_str[index] <= 'z')) {
-					String id;
-
+					int from = index;
 					while ((p_str[index] >= 'A' && p_str[index] <= 'Z') || (p_str[index] >= 'a' && p_str[index] <= 'z')) {
-						id += p_str[index];
 						index++;
 					}
 
 					r_token.type = TK_IDENTIFIER;
-					r_token.value = id;
+					r_token.value = String(&p_str[from], index - from);
 					return OK;
 				} else {
 					r_err_str = "Unexpected character.";
@@ -420,13 +595,13 @@ Error JSON::_parse_array(Array &array, const char32_t *p_str, int &index, int p_
 			}
 		}
 
-		Variant v;
-		err = _parse_value(v, token, p_str, index, p_len, line, r_err_str);
+		// Parsed in place, saves copying the value into the array.
+		array.push_back(Variant());
+		err = _parse_value(array[array.size() - 1], token, p_str, index, p_len, line, r_err_str);
 		if (err) {
 			return err;
 		}
 
-		array.push_back(v);
 		need_comma = true;
 	}
 
@@ -482,12 +657,10 @@ Error JSON::_parse_object(Dictionary &object, const char32_t *p_str, int &index,
 				return err;
 			}
 
-			Variant v;
-			err = _parse_value(v, token, p_str, index, p_len, line, r_err_str);
+			err = _parse_value(object[key], token, p_str, index, p_len, line, r_err_str);
 			if (err) {
 				return err;
 			}
-			object[key] = v;
 			need_comma = true;
 			at_key = true;
 		}
@@ -528,9 +701,167 @@ Error JSON::_parse_string(const String &p_json, Variant &r_ret, String &r_err_st
 	return err;
 }
 
+#define _HANDLER_CALL(m_call)                              \
+	{                                                      \
+		Error handler_err = p_handler->m_call;             \
+		if (handler_err != OK) {                           \
+			r_err_str = "Parsing stopped by the handler."; \
+			return handler_err;                            \
+		}                                                  \
+	}
+
+Error JSON::_parse_value_events(Token &token, const char32_t *p_str, int &index, int p_len, int &line, Handler *p_handler, String &r_err_str) {
+	if (token.type == TK_CURLY_BRACKET_OPEN) {
+		_HANDLER_CALL(begin_object());
+		bool need_comma = false;
+
+		while (index < p_len) {
+			Error err = _get_token(p_str, index, p_len, token, line, r_err_str);
+			if (err != OK) {
+				return err;
+			}
+
+			if (token.type == TK_CURLY_BRACKET_CLOSE) {
+				_HANDLER_CALL(end_object());
+				return OK;
+			}
+
+			if (need_comma) {
+				if (token.type != TK_COMMA) {
+					r_err_str = "Expected '}' or ','";
+					return ERR_PARSE_ERROR;
+				} else {
+					need_comma = false;
+					continue;
+				}
+			}
+
+			if (token.type != TK_STRING) {
+				r_err_str = "Expected key";
+				return ERR_PARSE_ERROR;
+			}
+			_HANDLER_CALL(key(token.value));
+
+			err = _get_token(p_str, index, p_len, token, line, r_err_str);
+			if (err != OK) {
+				return err;
+			}
+			if (token.type != TK_COLON) {
+				r_err_str = "Expected ':'";
+				return ERR_PARSE_ERROR;
+			}
+
+			err = _get_token(p_str, index, p_len, token, line, r_err_str);
+			if (err != OK) {
+				return err;
+			}
+			err = _parse_value_events(token, p_str, index, p_len, line, p_handler, r_err_str);
+			if (err != OK) {
+				return err;
+			}
+			need_comma = true;
+		}
+
+		r_err_str = "Expected '}'";
+		return ERR_PARSE_ERROR;
+
+	} else if (token.type == TK_BRACKET_OPEN) {
+		_HANDLER_CALL(begin_array());
+		bool need_comma = false;
+
+		while (index < p_len) {
+			Error err = _get_token(p_str, index, p_len, token, line, r_err_str);
+			if (err != OK) {
+				return err;
+			}
+
+			if (token.type == TK_BRACKET_CLOSE) {
+				_HANDLER_CALL(end_array());
+				return OK;
+			}
+
+			if (need_comma) {
+				if (token.type != TK_COMMA) {
+					r_err_str = "Expected ','";
+					return ERR_PARSE_ERROR;
+				} else {
+					need_comma = false;
+					continue;
+				}
+			}
+
+			err = _parse_value_events(token, p_str, index, p_len, line, p_handler, r_err_str);
+			if (err != OK) {
+				return err;
+			}
+			need_comma = true;
+		}
+
+		r_err_str = "Expected ']'";
+		return ERR_PARSE_ERROR;
+
+	} else if (token.type == TK_IDENTIFIER || token.type == TK_NUMBER || token.type == TK_STRING) {
+		Variant v;
+		Error err = _parse_value(v, token, p_str, index, p_len, line, r_err_str);
+		if (err != OK) {
+			return err;
+		}
+		_HANDLER_CALL(value(v));
+		return OK;
+
+	} else {
+		r_err_str = "Expected value, got " + String(tk_name[token.type]) + ".";
+		return ERR_PARSE_ERROR;
+	}
+}
+
+#undef _HANDLER_CALL
+
 String JSON::stringify(const Variant &p_var, const String &p_indent, bool p_sort_keys, bool p_full_precision) {
 	Set<const void *> markers;
-	return _stringify(p_var, p_indent, 0, p_sort_keys, markers, p_full_precision);
+	JSONStringWriter writer;
+	_stringify(writer, p_var, p_indent, 0, p_sort_keys, markers, p_full_precision);
+	return writer.finish();
+}
+
+int JSON::stringify_utf8(const Variant &p_var, Vector<uint8_t> &r_buffer, const String &p_indent, bool p_sort_keys, bool p_full_precision) {
+	Set<const void *> markers;
+	JSONUTF8Writer writer(r_buffer);
+	_stringify(writer, p_var, p_indent, 0, p_sort_keys, markers, p_full_precision);
+	return writer.length;
+}
+
+Error JSON::parse_events(const String &p_json_string, Handler *p_handler, String &r_err_str, int &r_err_line) {
+	ERR_FAIL_NULL_V(p_handler, ERR_INVALID_PARAMETER);
+
+	const char32_t *str = p_json_string.ptr();
+	int idx = 0;
+	int len = p_json_string.length();
+	Token token;
+	r_err_line = 0;
+
+	Error err = _get_token(str, idx, len, token, r_err_line, r_err_str);
+	if (err) {
+		return err;
+	}
+
+	err = _parse_value_events(token, str, idx, len, r_err_line, p_handler, r_err_str);
+
+	// Check if EOF is reached
+	// or it's a type of the next token.
+	if (err == OK && idx < len) {
+		err = _get_token(str, idx, len, token, r_err_line, r_err_str);
+
+		if (err || token.type != TK_EOF) {
+			r_err_str = "Expected 'EOF'";
+			return ERR_PARSE_ERROR;
+		}
+	}
+
+	if (err == OK) {
+		r_err_line = 0;
+	}
+	return err;
 }
 
 Error JSON::parse(const String &p_json_string) {
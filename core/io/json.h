@@ -69,13 +69,30 @@ class JSON : public RefCounted {
 
 	static const char *tk_name[];
 
-	static String _make_indent(const String &p_indent, int p_size);
-	static String _stringify(const Variant &p_var, const String &p_indent, int p_cur_indent, bool p_sort_keys, Set<const void *> &p_markers, bool p_full_precision = false);
+public:
+	// Receives the contents of a document as it is parsed, instead of building the Dictionary and Array tree.
+	// Returning an error from any method stops parsing, parse_events() then returns that error.
+	class Handler {
+	public:
+		virtual Error begin_object() { return OK; }
+		virtual Error end_object() { return OK; }
+		virtual Error begin_array() { return OK; }
+		virtual Error end_array() { return OK; }
+		virtual Error key(const String &p_key) { return OK; }
+		virtual Error value(const Variant &p_value) { return OK; }
+
+		virtual ~Handler() {}
+	};
+
+private:
+	template <class W>
+	static void _stringify(W &r_writer, const Variant &p_var, const String &p_indent, int p_cur_indent, bool p_sort_keys, Set<const void *> &p_markers, bool p_full_precision = false);
 	static Error _get_token(const char32_t *p_str, int &index, int p_len, Token &r_token, int &line, String &r_err_str);
 	static Error _parse_value(Variant &value, Token &token, const char32_t *p_str, int &index, int p_len, int &line, String &r_err_str);
 	static Error _parse_array(Array &array, const char32_t *p_str, int &index, int p_len, int &line, String &r_err_str);
 	static Error _parse_object(Dictionary &object, const char32_t *p_str, int &index, int p_len, int &line, String &r_err_str);
 	static Error _parse_string(const String &p_json, Variant &r_ret, String &r_err_str, int &r_err_line);
+	static Error _parse_value_events(Token &token, const char32_t *p_str, int &index, int p_len, int &line, Handler *p_handler, String &r_err_str);
 
 protected:
 	static void _bind_methods();
@@ -84,6 +101,11 @@ public:
 	String stringify(const Variant &p_var, const String &p_indent = "", bool p_sort_keys = true, bool p_full_precision = false);
 	Error parse(const String &p_json_string);
 
+	// Writes the document as UTF-8 into r_buffer and returns the number of bytes written. The buffer only
+	// grows, so reusing it between calls avoids allocating.
+	static int stringify_utf8(const Variant &p_var, Vector<uint8_t> &r_buffer, const String &p_indent = "", bool p_sort_keys = true, bool p_full_precision = false);
+	static Error parse_events(const String &p_json_string, Handler *p_handler, String &r_err_str, int &r_err_line);
+
 	inline Variant get_data() const { return data; }
 	inline int get_error_line() const { return err_line; }
 	inline String get_error_message() const { return err_str; }
@@ -32,6 +32,8 @@
 
 #include "core/object/ref_counted.h"
 #include "core/os/keyboard.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/local_vector.h"
 #include "core/string/print_string.h"
 
 #include <limits.h>
@@ -1676,3 +1678,878 @@ Error encode_variant(const Variant &p_variant, uint8_t *r_buffer, int &r_len, bo
 
 	return OK;
 }
+
+// Compact encoding.
+//
+// Each value starts with a tag byte holding the type in the low bits, plus a flag whose meaning depends on
+// the type. Integers and lengths are zigzag/LEB128 varints, nothing is padded, and strings are interned per
+// message: the first occurrence is written as (length << 1) followed by the UTF-8 bytes, and later ones as
+// (index << 1) | 1. Packed arrays are stored as raw little-endian data.
+
+#define COMPACT_TYPE_MASK 0x3F
+#define COMPACT_FLAG 0x40 // BOOL: true. FLOAT and math types: 64-bit. OBJECT: encoded as ID.
+#define COMPACT_VARINT_MAX_BYTES 10
+
+static_assert(Variant::VARIANT_MAX <= COMPACT_TYPE_MASK + 1, "Variant types don't fit in the compact tag.");
+static_assert(sizeof(Vector2) == sizeof(real_t) * 2, "Vector2 is expected to be tightly packed.");
+static_assert(sizeof(Rect2) == sizeof(real_t) * 4, "Rect2 is expected to be tightly packed.");
+static_assert(sizeof(Vector3) == sizeof(real_t) * 3, "Vector3 is expected to be tightly packed.");
+static_assert(sizeof(Transform2D) == sizeof(real_t) * 6, "Transform2D is expected to be tightly packed.");
+static_assert(sizeof(Plane) == sizeof(real_t) * 4, "Plane is expected to be tightly packed.");
+static_assert(sizeof(Quaternion) == sizeof(real_t) * 4, "Quaternion is expected to be tightly packed.");
+static_assert(sizeof(AABB) == sizeof(real_t) * 6, "AABB is expected to be tightly packed.");
+static_assert(sizeof(Basis) == sizeof(real_t) * 9, "Basis is expected to be tightly packed.");
+static_assert(sizeof(Transform3D) == sizeof(real_t) * 12, "Transform3D is expected to be tightly packed.");
+static_assert(sizeof(Color) == sizeof(float) * 4, "Color is expected to be tightly packed.");
+
+static _FORCE_INLINE_ uint64_t _zigzag_encode(int64_t p_value) {
+	return (uint64_t(p_value) << 1) ^ uint64_t(p_value >> 63);
+}
+
+static _FORCE_INLINE_ int64_t _zigzag_decode(uint64_t p_value) {
+	return int64_t(p_value >> 1) ^ -int64_t(p_value & 1);
+}
+
+class CompactVariantEncoder {
+	Vector<uint8_t> &buffer;
+	uint8_t *data = nullptr;
+	int size = 0;
+	int capacity = 0;
+	bool full_objects = false;
+	HashMap<String, uint32_t> strings;
+
+	_FORCE_INLINE_ uint8_t *_reserve(int p_bytes) {
+		if (unlikely(size + p_bytes > capacity)) {
+			capacity = MAX(MAX(capacity * 2, size + p_bytes), 64);
+			buffer.resize(capacity);
+			data = buffer.ptrw();
+		}
+		uint8_t *ptr = data + size;
+		size += p_bytes;
+		return ptr;
+	}
+
+	_FORCE_INLINE_ void _put_byte(uint8_t p_byte) {
+		*_reserve(1) = p_byte;
+	}
+
+	_FORCE_INLINE_ void _put_varint(uint64_t p_value) {
+		uint8_t *ptr = _reserve(COMPACT_VARINT_MAX_BYTES);
+		int written = 0;
+		while (p_value >= 0x80) {
+			ptr[written++] = uint8_t(p_value) | 0x80;
+			p_value >>= 7;
+		}
+		ptr[written++] = uint8_t(p_value);
+		size -= COMPACT_VARINT_MAX_BYTES - written;
+	}
+
+	void _put_raw(const void *p_data, int p_count, int p_element_size) {
+		if (p_count == 0) {
+			return;
+		}
+		int bytes = p_count * p_element_size;
+		uint8_t *ptr = _reserve(bytes);
+#ifdef BIG_ENDIAN_ENABLED
+		const uint8_t *src = (const uint8_t *)p_data;
+		for (int i = 0; i < p_count; i++) {
+			for (int j = 0; j < p_element_size; j++) {
+				ptr[i * p_element_size + j] = src[i * p_element_size + p_element_size - 1 - j];
+			}
+		}
+#else
+		memcpy(ptr, p_data, bytes);
+#endif
+	}
+
+	void _put_string(const String &p_string) {
+		const uint32_t *index = strings.getptr(p_string);
+		if (index) {
+			_put_varint((uint64_t(*index) << 1) | 1);
+			return;
+		}
+		strings.set(p_string, strings.size());
+
+		CharString utf8 = p_string.utf8();
+		_put_varint(uint64_t(utf8.length()) << 1);
+		memcpy(_reserve(utf8.length()), utf8.get_data(), utf8.length());
+	}
+
+	template <class T>
+	void _put_packed_array(const Variant &p_variant) {
+		Vector<T> array = p_variant;
+		_put_varint(array.size());
+		_put_raw(array.ptr(), array.size(), sizeof(T));
+	}
+
+	template <class T>
+	void _put_reals(Variant::Type p_type, const T &p_value) {
+#ifdef REAL_T_IS_DOUBLE
+		_put_byte(p_type | COMPACT_FLAG);
+#else
+		_put_byte(p_type);
+#endif
+		_put_raw(&p_value, sizeof(T) / sizeof(real_t), sizeof(real_t));
+	}
+
+public:
+	Error put_variant(const Variant &p_variant, int p_depth = 0) {
+		ERR_FAIL_COND_V_MSG(p_depth > Variant::MAX_RECURSION_DEPTH, ERR_OUT_OF_MEMORY, "Potential infinite recursion detected. Bailing.");
+
+		Variant::Type type = p_variant.get_type();
+		switch (type) {
+			case Variant::NIL:
+			case Variant::RID:
+			case Variant::CALLABLE:
+			case Variant::SIGNAL: {
+				// RID, Callable and Signal can't be sent over, decoded as their empty value.
+				_put_byte(type);
+			} break;
+			case Variant::BOOL: {
+				_put_byte(bool(p_variant) ? (type | COMPACT_FLAG) : type);
+			} break;
+			case Variant::INT: {
+				_put_byte(type);
+				_put_varint(_zigzag_encode(p_variant));
+			} break;
+			case Variant::FLOAT: {
+				double d = p_variant;
+				float f = d;
+				if (double(f) == d) {
+					_put_byte(type);
+					_put_raw(&f, 1, sizeof(float));
+				} else {
+					_put_byte(type | COMPACT_FLAG);
+					_put_raw(&d, 1, sizeof(double));
+				}
+			} break;
+			case Variant::STRING:
+			case Variant::STRING_NAME: {
+				_put_byte(type);
+				_put_string(p_variant);
+			} break;
+			case Variant::VECTOR2: {
+				_put_reals(type, Vector2(p_variant));
+			} break;
+			case Variant::VECTOR2I: {
+				Vector2i v = p_variant;
+				_put_byte(type);
+				_put_varint(_zigzag_encode(v.x));
+				_put_varint(_zigzag_encode(v.y));
+			} break;
+			case Variant::RECT2: {
+				_put_reals(type, Rect2(p_variant));
+			} break;
+			case Variant::RECT2I: {
+				Rect2i r = p_variant;
+				_put_byte(type);
+				_put_varint(_zigzag_encode(r.position.x));
+				_put_varint(_zigzag_encode(r.position.y));
+				_put_varint(_zigzag_encode(r.size.x));
+				_put_varint(_zigzag_encode(r.size.y));
+			} break;
+			case Variant::VECTOR3: {
+				_put_reals(type, Vector3(p_variant));
+			} break;
+			case Variant::VECTOR3I: {
+				Vector3i v = p_variant;
+				_put_byte(type);
+				_put_varint(_zigzag_encode(v.x));
+				_put_varint(_zigzag_encode(v.y));
+				_put_varint(_zigzag_encode(v.z));
+			} break;
+			case Variant::TRANSFORM2D: {
+				_put_reals(type, Transform2D(p_variant));
+			} break;
+			case Variant::PLANE: {
+				_put_reals(type, Plane(p_variant));
+			} break;
+			case Variant::QUATERNION: {
+				_put_reals(type, Quaternion(p_variant));
+			} break;
+			case Variant::AABB: {
+				_put_reals(type, ::AABB(p_variant));
+			} break;
+			case Variant::BASIS: {
+				_put_reals(type, Basis(p_variant));
+			} break;
+			case Variant::TRANSFORM3D: {
+				_put_reals(type, Transform3D(p_variant));
+			} break;
+			case Variant::COLOR: {
+				// Colors are always single precision.
+				Color c = p_variant;
+				_put_byte(type);
+				_put_raw(&c, 4, sizeof(float));
+			} break;
+			case Variant::NODE_PATH: {
+				NodePath np = p_variant;
+				_put_byte(type);
+				_put_varint((uint64_t(np.get_name_count()) << 1) | (np.is_absolute() ? 1 : 0));
+				_put_varint(np.get_subname_count());
+				for (int i = 0; i < np.get_name_count(); i++) {
+					_put_string(np.get_name(i));
+				}
+				for (int i = 0; i < np.get_subname_count(); i++) {
+					_put_string(np.get_subname(i));
+				}
+			} break;
+			case Variant::OBJECT: {
+				// Test for potential wrong values sent by the debugger when it breaks.
+				Object *obj = p_variant.get_validated_object();
+				if (!obj) {
+					// Object is invalid, send a nullptr instead.
+					_put_byte(Variant::NIL);
+					break;
+				}
+
+				if (!full_objects) {
+					_put_byte(type | COMPACT_FLAG);
+					uint64_t id = obj->get_instance_id();
+					_put_raw(&id, 1, sizeof(uint64_t));
+					break;
+				}
+
+				_put_byte(type);
+				_put_string(obj->get_class());
+
+				List<PropertyInfo> props;
+				obj->get_property_list(&props);
+
+				int pc = 0;
+				for (const PropertyInfo &E : props) {
+					if (E.usage & PROPERTY_USAGE_STORAGE) {
+						pc++;
+					}
+				}
+				_put_varint(pc);
+
+				for (const PropertyInfo &E : props) {
+					if (!(E.usage & PROPERTY_USAGE_STORAGE)) {
+						continue;
+					}
+					_put_string(E.name);
+					Error err = put_variant(obj->get(E.name), p_depth + 1);
+					ERR_FAIL_COND_V(err, err);
+				}
+			} break;
+			case Variant::DICTIONARY: {
+				Dictionary d = p_variant;
+				_put_byte(type);
+				_put_varint(d.size());
+
+				List<Variant> keys;
+				d.get_key_list(&keys);
+				for (const Variant &E : keys) {
+					Error err = put_variant(E, p_depth + 1);
+					ERR_FAIL_COND_V(err, err);
+					err = put_variant(d[E], p_depth + 1);
+					ERR_FAIL_COND_V(err, err);
+				}
+			} break;
+			case Variant::ARRAY: {
+				Array array = p_variant;
+				_put_byte(type);
+				_put_varint(array.size());
+				for (int i = 0; i < array.size(); i++) {
+					Error err = put_variant(array[i], p_depth + 1);
+					ERR_FAIL_COND_V(err, err);
+				}
+			} break;
+			case Variant::PACKED_BYTE_ARRAY: {
+				_put_byte(type);
+				_put_packed_array<uint8_t>(p_variant);
+			} break;
+			case Variant::PACKED_INT32_ARRAY: {
+				_put_byte(type);
+				_put_packed_array<int32_t>(p_variant);
+			} break;
+			case Variant::PACKED_INT64_ARRAY: {
+				_put_byte(type);
+				_put_packed_array<int64_t>(p_variant);
+			} break;
+			case Variant::PACKED_FLOAT32_ARRAY: {
+				_put_byte(type);
+				_put_packed_array<float>(p_variant);
+			} break;
+			case Variant::PACKED_FLOAT64_ARRAY: {
+				_put_byte(type);
+				_put_packed_array<double>(p_variant);
+			} break;
+			case Variant::PACKED_STRING_ARRAY: {
+				Vector<String> array = p_variant;
+				_put_byte(type);
+				_put_varint(array.size());
+				for (int i = 0; i < array.size(); i++) {
+					_put_string(array[i]);
+				}
+			} break;
+			case Variant::PACKED_VECTOR2_ARRAY: {
+#ifdef REAL_T_IS_DOUBLE
+				_put_byte(type | COMPACT_FLAG);
+#else
+				_put_byte(type);
+#endif
+				Vector<Vector2> array = p_variant;
+				_put_varint(array.size());
+				_put_raw(array.ptr(), array.size() * 2, sizeof(real_t));
+			} break;
+			case Variant::PACKED_VECTOR3_ARRAY: {
+#ifdef REAL_T_IS_DOUBLE
+				_put_byte(type | COMPACT_FLAG);
+#else
+				_put_byte(type);
+#endif
+				Vector<Vector3> array = p_variant;
+				_put_varint(array.size());
+				_put_raw(array.ptr(), array.size() * 3, sizeof(real_t));
+			} break;
+			case Variant::PACKED_COLOR_ARRAY: {
+				Vector<Color> array = p_variant;
+				_put_byte(type);
+				_put_varint(array.size());
+				_put_raw(array.ptr(), array.size() * 4, sizeof(float));
+			} break;
+			default: {
+				ERR_FAIL_V(ERR_BUG);
+			}
+		}
+
+		return OK;
+	}
+
+	void finish() {
+		buffer.resize(size);
+	}
+
+	CompactVariantEncoder(Vector<uint8_t> &r_buffer, bool p_full_objects) :
+			buffer(r_buffer),
+			full_objects(p_full_objects) {
+		buffer.clear();
+	}
+};
+
+class CompactVariantDecoder {
+	const uint8_t *buf = nullptr;
+	int len = 0;
+	int pos = 0;
+	bool allow_objects = false;
+	LocalVector<String> strings;
+
+	_FORCE_INLINE_ int _remaining() const {
+		return len - pos;
+	}
+
+	Error _get_byte(uint8_t &r_byte) {
+		ERR_FAIL_COND_V(_remaining() < 1, ERR_INVALID_DATA);
+		r_byte = buf[pos++];
+		return OK;
+	}
+
+	Error _get_varint(uint64_t &r_value) {
+		uint64_t value = 0;
+		for (int i = 0; i < COMPACT_VARINT_MAX_BYTES; i++) {
+			ERR_FAIL_COND_V(_remaining() < 1, ERR_INVALID_DATA);
+			uint8_t byte = buf[pos++];
+			value |= uint64_t(byte & 0x7F) << (i * 7);
+			if (!(byte & 0x80)) {
+				r_value = value;
+				return OK;
+			}
+		}
+		ERR_FAIL_V_MSG(ERR_INVALID_DATA, "Varint is too long.");
+	}
+
+	Error _get_int32(int32_t &r_value) {
+		uint64_t value;
+		Error err = _get_varint(value);
+		if (err) {
+			return err;
+		}
+		int64_t decoded = _zigzag_decode(value);
+		ERR_FAIL_COND_V(decoded < INT32_MIN || decoded > INT32_MAX, ERR_INVALID_DATA);
+		r_value = decoded;
+		return OK;
+	}
+
+	// Reads an element count, each element using at least p_min_bytes.
+	Error _get_count(int &r_count, int p_min_bytes) {
+		uint64_t count;
+		Error err = _get_varint(count);
+		if (err) {
+			return err;
+		}
+		ERR_FAIL_COND_V(count > uint64_t(_remaining()) / p_min_bytes, ERR_INVALID_DATA);
+		r_count = count;
+		return OK;
+	}
+
+	Error _get_raw(void *r_data, int p_count, int p_element_size) {
+		ERR_FAIL_COND_V(p_count < 0 || p_count > _remaining() / p_element_size, ERR_INVALID_DATA);
+		if (p_count == 0) {
+			return OK;
+		}
+		const uint8_t *src = buf + pos;
+#ifdef BIG_ENDIAN_ENABLED
+		uint8_t *dst = (uint8_t *)r_data;
+		for (int i = 0; i < p_count; i++) {
+			for (int j = 0; j < p_element_size; j++) {
+				dst[i * p_element_size + j] = src[i * p_element_size + p_element_size - 1 - j];
+			}
+		}
+#else
+		memcpy(r_data, src, p_count * p_element_size);
+#endif
+		pos += p_count * p_element_size;
+		return OK;
+	}
+
+	Error _get_string(String &r_string) {
+		uint64_t header;
+		Error err = _get_varint(header);
+		if (err) {
+			return err;
+		}
+
+		if (header & 1) {
+			uint64_t index = header >> 1;
+			ERR_FAIL_COND_V(index >= strings.size(), ERR_INVALID_DATA);
+			r_string = strings[index];
+			return OK;
+		}
+
+		uint64_t length = header >> 1;
+		ERR_FAIL_COND_V(length > uint64_t(_remaining()), ERR_INVALID_DATA);
+		r_string = String();
+		if (length > 0) {
+			ERR_FAIL_COND_V(r_string.parse_utf8((const char *)buf + pos, length), ERR_INVALID_DATA);
+			pos += length;
+		}
+		strings.push_back(r_string);
+		return OK;
+	}
+
+	// Math types are stored with the precision of the encoder, p_is_64 tells which one it was.
+	Error _get_reals(real_t *r_values, int p_count, bool p_is_64) {
+		if (p_is_64 == (sizeof(real_t) == sizeof(double))) {
+			return _get_raw(r_values, p_count, sizeof(real_t));
+		}
+
+		if (p_is_64) {
+			ERR_FAIL_COND_V(p_count > _remaining() / int(sizeof(double)), ERR_INVALID_DATA);
+			for (int i = 0; i < p_count; i++) {
+				r_values[i] = decode_double(buf + pos);
+				pos += sizeof(double);
+			}
+		} else {
+			ERR_FAIL_COND_V(p_count > _remaining() / int(sizeof(float)), ERR_INVALID_DATA);
+			for (int i = 0; i < p_count; i++) {
+				r_values[i] = decode_float(buf + pos);
+				pos += sizeof(float);
+			}
+		}
+		return OK;
+	}
+
+	template <class T>
+	Error _get_math_type(Variant &r_variant, bool p_is_64) {
+		T value;
+		Error err = _get_reals((real_t *)&value, sizeof(T) / sizeof(real_t), p_is_64);
+		if (err) {
+			return err;
+		}
+		r_variant = value;
+		return OK;
+	}
+
+	template <class T>
+	Error _get_packed_array(Variant &r_variant) {
+		int count;
+		Error err = _get_count(count, sizeof(T));
+		if (err) {
+			return err;
+		}
+		Vector<T> array;
+		array.resize(count);
+		err = _get_raw(array.ptrw(), count, sizeof(T));
+		if (err) {
+			return err;
+		}
+		r_variant = array;
+		return OK;
+	}
+
+	template <class T, int N>
+	Error _get_packed_real_array(Variant &r_variant, bool p_is_64) {
+		int count;
+		Error err = _get_count(count, N * (p_is_64 ? sizeof(double) : sizeof(float)));
+		if (err) {
+			return err;
+		}
+		Vector<T> array;
+		array.resize(count);
+		err = _get_reals((real_t *)array.ptrw(), count * N, p_is_64);
+		if (err) {
+			return err;
+		}
+		r_variant = array;
+		return OK;
+	}
+
+	Error _get_object(Variant &r_variant, int p_depth) {
+		ERR_FAIL_COND_V(!allow_objects, ERR_UNAUTHORIZED);
+
+		String class_name;
+		Error err = _get_string(class_name);
+		if (err) {
+			return err;
+		}
+
+		Object *obj = ClassDB::instantiate(class_name);
+		ERR_FAIL_COND_V(!obj, ERR_UNAVAILABLE);
+
+		// Wrap right away, so the object is freed if decoding fails.
+		RefCounted *ref_counted = Object::cast_to<RefCounted>(obj);
+		REF ref;
+		if (ref_counted) {
+			ref = REF(ref_counted);
+		}
+
+		int count;
+		err = _get_count(count, 2);
+		if (!err) {
+			for (int i = 0; i < count; i++) {
+				String name;
+				err = _get_string(name);
+				if (err) {
+					break;
+				}
+
+				Variant value;
+				err = get_variant(value, p_depth + 1);
+				if (err) {
+					break;
+				}
+
+				obj->set(name, value);
+			}
+		}
+
+		if (err) {
+			if (!ref_counted) {
+				memdelete(obj);
+			}
+			return err;
+		}
+
+		if (ref_counted) {
+			r_variant = ref;
+		} else {
+			r_variant = obj;
+		}
+		return OK;
+	}
+
+public:
+	Error get_variant(Variant &r_variant, int p_depth = 0) {
+		ERR_FAIL_COND_V_MSG(p_depth > Variant::MAX_RECURSION_DEPTH, ERR_INVALID_DATA, "Variant is nested too deeply.");
+
+		uint8_t tag;
+		Error err = _get_byte(tag);
+		if (err) {
+			return err;
+		}
+
+		bool flag = tag & COMPACT_FLAG;
+		uint8_t type = tag & COMPACT_TYPE_MASK;
+		ERR_FAIL_COND_V(tag & ~(COMPACT_TYPE_MASK | COMPACT_FLAG), ERR_INVALID_DATA);
+
+		switch (type) {
+			case Variant::NIL: {
+				r_variant = Variant();
+			} break;
+			case Variant::BOOL: {
+				r_variant = flag;
+			} break;
+			case Variant::INT: {
+				uint64_t value;
+				err = _get_varint(value);
+				if (err) {
+					return err;
+				}
+				r_variant = _zigzag_decode(value);
+			} break;
+			case Variant::FLOAT: {
+				if (flag) {
+					ERR_FAIL_COND_V(_remaining() < 8, ERR_INVALID_DATA);
+					r_variant = decode_double(buf + pos);
+					pos += 8;
+				} else {
+					ERR_FAIL_COND_V(_remaining() < 4, ERR_INVALID_DATA);
+					r_variant = decode_float(buf + pos);
+					pos += 4;
+				}
+			} break;
+			case Variant::STRING: {
+				String str;
+				err = _get_string(str);
+				if (err) {
+					return err;
+				}
+				r_variant = str;
+			} break;
+			case Variant::STRING_NAME: {
+				String str;
+				err = _get_string(str);
+				if (err) {
+					return err;
+				}
+				r_variant = StringName(str);
+			} break;
+			case Variant::VECTOR2: {
+				return _get_math_type<Vector2>(r_variant, flag);
+			} break;
+			case Variant::VECTOR2I: {
+				Vector2i v;
+				if ((err = _get_int32(v.x)) || (err = _get_int32(v.y))) {
+					return err;
+				}
+				r_variant = v;
+			} break;
+			case Variant::RECT2: {
+				return _get_math_type<Rect2>(r_variant, flag);
+			} break;
+			case Variant::RECT2I: {
+				Rect2i r;
+				if ((err = _get_int32(r.position.x)) || (err = _get_int32(r.position.y)) || (err = _get_int32(r.size.x)) || (err = _get_int32(r.size.y))) {
+					return err;
+				}
+				r_variant = r;
+			} break;
+			case Variant::VECTOR3: {
+				return _get_math_type<Vector3>(r_variant, flag);
+			} break;
+			case Variant::VECTOR3I: {
+				Vector3i v;
+				if ((err = _get_int32(v.x)) || (err = _get_int32(v.y)) || (err = _get_int32(v.z))) {
+					return err;
+				}
+				r_variant = v;
+			} break;
+			case Variant::TRANSFORM2D: {
+				return _get_math_type<Transform2D>(r_variant, flag);
+			} break;
+			case Variant::PLANE: {
+				return _get_math_type<Plane>(r_variant, flag);
+			} break;
+			case Variant::QUATERNION: {
+				return _get_math_type<Quaternion>(r_variant, flag);
+			} break;
+			case Variant::AABB: {
+				return _get_math_type<::AABB>(r_variant, flag);
+			} break;
+			case Variant::BASIS: {
+				return _get_math_type<Basis>(r_variant, flag);
+			} break;
+			case Variant::TRANSFORM3D: {
+				return _get_math_type<Transform3D>(r_variant, flag);
+			} break;
+			case Variant::COLOR: {
+				Color c;
+				err = _get_raw(&c, 4, sizeof(float));
+				if (err) {
+					return err;
+				}
+				r_variant = c;
+			} break;
+			case Variant::NODE_PATH: {
+				uint64_t header;
+				err = _get_varint(header);
+				if (err) {
+					return err;
+				}
+				uint64_t name_count = header >> 1;
+				uint64_t subname_count;
+				err = _get_varint(subname_count);
+				if (err) {
+					return err;
+				}
+				ERR_FAIL_COND_V(name_count > uint64_t(_remaining()) || subname_count > uint64_t(_remaining()) - name_count, ERR_INVALID_DATA);
+
+				Vector<StringName> names;
+				Vector<StringName> subnames;
+				names.resize(name_count);
+				subnames.resize(subname_count);
+				for (uint64_t i = 0; i < name_count + subname_count; i++) {
+					String str;
+					err = _get_string(str);
+					if (err) {
+						return err;
+					}
+					if (i < name_count) {
+						names.write[i] = str;
+					} else {
+						subnames.write[i - name_count] = str;
+					}
+				}
+
+				r_variant = NodePath(names, subnames, header & 1);
+			} break;
+			case Variant::RID: {
+				r_variant = ::RID();
+			} break;
+			case Variant::OBJECT: {
+				if (!flag) {
+					return _get_object(r_variant, p_depth);
+				}
+
+				uint64_t id;
+				err = _get_raw(&id, 1, sizeof(uint64_t));
+				if (err) {
+					return err;
+				}
+				if (id == 0) {
+					r_variant = (Object *)nullptr;
+				} else {
+					Ref<EncodedObjectAsID> obj_as_id;
+					obj_as_id.instantiate();
+					obj_as_id->set_object_id(ObjectID(id));
+					r_variant = obj_as_id;
+				}
+			} break;
+			case Variant::CALLABLE: {
+				r_variant = Callable();
+			} break;
+			case Variant::SIGNAL: {
+				r_variant = Signal();
+			} break;
+			case Variant::DICTIONARY: {
+				int count;
+				err = _get_count(count, 2);
+				if (err) {
+					return err;
+				}
+
+				Dictionary d;
+				for (int i = 0; i < count; i++) {
+					Variant key;
+					err = get_variant(key, p_depth + 1);
+					if (err) {
+						return err;
+					}
+					err = get_variant(d[key], p_depth + 1);
+					if (err) {
+						return err;
+					}
+				}
+				r_variant = d;
+			} break;
+			case Variant::ARRAY: {
+				int count;
+				err = _get_count(count, 1);
+				if (err) {
+					return err;
+				}
+
+				Array array;
+				array.resize(count);
+				for (int i = 0; i < count; i++) {
+					err = get_variant(array[i], p_depth + 1);
+					if (err) {
+						return err;
+					}
+				}
+				r_variant = array;
+			} break;
+			case Variant::PACKED_BYTE_ARRAY: {
+				return _get_packed_array<uint8_t>(r_variant);
+			} break;
+			case Variant::PACKED_INT32_ARRAY: {
+				return _get_packed_array<int32_t>(r_variant);
+			} break;
+			case Variant::PACKED_INT64_ARRAY: {
+				return _get_packed_array<int64_t>(r_variant);
+			} break;
+			case Variant::PACKED_FLOAT32_ARRAY: {
+				return _get_packed_array<float>(r_variant);
+			} break;
+			case Variant::PACKED_FLOAT64_ARRAY: {
+				return _get_packed_array<double>(r_variant);
+			} break;
+			case Variant::PACKED_STRING_ARRAY: {
+				int count;
+				err = _get_count(count, 1);
+				if (err) {
+					return err;
+				}
+
+				Vector<String> array;
+				array.resize(count);
+				String *w = array.ptrw();
+				for (int i = 0; i < count; i++) {
+					err = _get_string(w[i]);
+					if (err) {
+						return err;
+					}
+				}
+				r_variant = array;
+			} break;
+			case Variant::PACKED_VECTOR2_ARRAY: {
+				return _get_packed_real_array<Vector2, 2>(r_variant, flag);
+			} break;
+			case Variant::PACKED_VECTOR3_ARRAY: {
+				return _get_packed_real_array<Vector3, 3>(r_variant, flag);
+			} break;
+			case Variant::PACKED_COLOR_ARRAY: {
+				int count;
+				err = _get_count(count, sizeof(Color));
+				if (err) {
+					return err;
+				}
+				Vector<Color> array;
+				array.resize(count);
+				err = _get_raw(array.ptrw(), count * 4, sizeof(float));
+				if (err) {
+					return err;
+				}
+				r_variant = array;
+			} break;
+			default: {
+				ERR_FAIL_V(ERR_INVALID_DATA);
+			}
+		}
+
+		return OK;
+	}
+
+	int get_position() const {
+		return pos;
+	}
+
+	CompactVariantDecoder(const uint8_t *p_buffer, int p_len, bool p_allow_objects) :
+			buf(p_buffer),
+			len(p_len),
+			allow_objects(p_allow_objects) {}
+};
+
+Error encode_variant_compact(const Variant &p_variant, Vector<uint8_t> &r_buffer, bool p_full_objects) {
+	CompactVariantEncoder encoder(r_buffer, p_full_objects);
+	Error err = encoder.put_variant(p_variant);
+	encoder.finish();
+	return err;
+}
+
+Error decode_variant_compact(Variant &r_variant, const uint8_t *p_buffer, int p_len, int *r_len, bool p_allow_objects) {
+	ERR_FAIL_COND_V(!p_buffer || p_len < 0, ERR_INVALID_PARAMETER);
+
+	CompactVariantDecoder decoder(p_buffer, p_len, p_allow_objects);
+	Error err = decoder.get_variant(r_variant);
+	if (err) {
+		return err;
+	}
+
+	if (r_len) {
+		*r_len = decoder.get_position();
+	}
+	return OK;
+}
@@ -30,6 +30,8 @@
 
 #include "dynamic_bvh.h"
 
+#include "core/templates/thread_work_pool.h"
+
 void DynamicBVH::_delete_node(Node *p_node) {
 	node_allocator.free(p_node);
 }
@@ -386,6 +388,129 @@ bool DynamicBVH::update(const ID &p_id, const AABB &p_box) {
 	return true;
 }
 
+void DynamicBVH::_batch_update_leaf(uint32_t p_index, BatchUpdateData *p_data) {
+	const ID &id = p_data->ids[p_index];
+	const AABB &box = p_data->boxes[p_index];
+	Node *leaf = id.node;
+
+	Volume volume;
+	volume.min = box.position;
+	volume.max = box.position + box.size;
+
+	if (leaf->volume.min.is_equal_approx(volume.min) && leaf->volume.max.is_equal_approx(volume.max)) {
+		p_data->results[p_index] = BATCH_UPDATE_UNCHANGED;
+		return;
+	}
+
+	leaf->volume = volume;
+
+	// Only leaves are written here, parents still hold the bounds from before the update.
+	if (leaf->parent && !leaf->parent->volume.intersects(volume)) {
+		p_data->results[p_index] = BATCH_UPDATE_DEGRADED;
+	} else {
+		p_data->results[p_index] = BATCH_UPDATE_MOVED;
+	}
+}
+
+void DynamicBVH::_refit_marked(Node *p_node) {
+	for (int i = 0; i < 2; i++) {
+		Node *child = p_node->childs[i];
+		if (child->is_internal() && child->refit_pass == refit_pass) {
+			_refit_marked(child);
+		}
+	}
+	p_node->volume = p_node->childs[0]->volume.merge(p_node->childs[1]->volume);
+}
+
+void DynamicBVH::_refit_subtree_threaded(uint32_t p_index, void *p_userdata) {
+	_refit_marked(refit_subtrees[p_index]);
+}
+
+// Updates many leaves at once. Instead of reinserting every leaf like update(), the new bounds are
+// written in place and every affected internal node is refit once, bottom-up. Leaves that moved
+// away from their parent are still reinserted so the tree doesn't degrade over time.
+// Each leaf must appear at most once in p_ids.
+void DynamicBVH::batch_update(const ID *p_ids, const AABB *p_boxes, uint32_t p_count, ThreadWorkPool *p_thread_pool) {
+	if (p_count == 0 || !bvh_root) {
+		return;
+	}
+
+	batch_update_results.resize(p_count);
+
+	BatchUpdateData data;
+	data.ids = p_ids;
+	data.boxes = p_boxes;
+	data.results = batch_update_results.ptr();
+
+	bool use_threads = p_thread_pool && p_count >= BATCH_UPDATE_THREAD_MIN_LEAVES;
+
+	if (use_threads) {
+		p_thread_pool->do_work(p_count, this, &DynamicBVH::_batch_update_leaf, &data);
+	} else {
+		for (uint32_t i = 0; i < p_count; i++) {
+			_batch_update_leaf(i, &data);
+		}
+	}
+
+	// Mark the ancestors of every moved leaf, each one is visited only once.
+	refit_pass++;
+	bool refit_needed = false;
+
+	for (uint32_t i = 0; i < p_count; i++) {
+		if (batch_update_results[i] != BATCH_UPDATE_MOVED) {
+			continue;
+		}
+		for (Node *node = p_ids[i].node->parent; node && node->refit_pass != refit_pass; node = node->parent) {
+			node->refit_pass = refit_pass;
+			refit_needed = true;
+		}
+	}
+
+	if (refit_needed) {
+		if (use_threads) {
+			// Split the marked nodes in a top part, refit serially, and independent subtrees refit in parallel.
+			refit_top_nodes.clear();
+			refit_subtrees.clear();
+			refit_subtrees.push_back(bvh_root);
+
+			for (int depth = 0; depth < BATCH_UPDATE_SPLIT_DEPTH && !refit_subtrees.is_empty(); depth++) {
+				uint32_t level_from = refit_top_nodes.size();
+				for (uint32_t i = 0; i < refit_subtrees.size(); i++) {
+					refit_top_nodes.push_back(refit_subtrees[i]);
+				}
+				refit_subtrees.clear();
+
+				for (uint32_t i = level_from; i < refit_top_nodes.size(); i++) {
+					for (int j = 0; j < 2; j++) {
+						Node *child = refit_top_nodes[i]->childs[j];
+						if (child->is_internal() && child->refit_pass == refit_pass) {
+							refit_subtrees.push_back(child);
+						}
+					}
+				}
+			}
+
+			if (!refit_subtrees.is_empty()) {
+				p_thread_pool->do_work(refit_subtrees.size(), this, &DynamicBVH::_refit_subtree_threaded, nullptr);
+			}
+
+			// Breadth-first order, so going backwards refits children before their parents.
+			for (int64_t i = int64_t(refit_top_nodes.size()) - 1; i >= 0; i--) {
+				Node *node = refit_top_nodes[i];
+				node->volume = node->childs[0]->volume.merge(node->childs[1]->volume);
+			}
+		} else {
+			_refit_marked(bvh_root);
+		}
+	}
+
+	for (uint32_t i = 0; i < p_count; i++) {
+		if (batch_update_results[i] == BATCH_UPDATE_DEGRADED) {
+			_update(p_ids[i].node, lkhd);
+		}
+	}
+}
+
 void DynamicBVH::remove(const ID &p_id) {
 	ERR_FAIL_COND(!p_id.is_valid());
 	Node *leaf = p_id.node;
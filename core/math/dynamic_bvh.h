@@ -37,6 +37,8 @@
 #include "core/templates/paged_allocator.h"
 #include "core/typedefs.h"
 
+class ThreadWorkPool;
+
 // Based on bullet Dbvh
 
 /*
@@ -185,6 +187,7 @@ private:
 			Node *childs[2];
 			void *data;
 		};
+		uint32_t refit_pass = 0;
 
 		_FORCE_INLINE_ bool is_leaf() const { return childs[1] == nullptr; }
 		_FORCE_INLINE_ bool is_internal() const { return (!is_leaf()); }
@@ -230,9 +233,28 @@ private:
 	uint32_t index = 0;
 
 	enum {
-		ALLOCA_STACK_SIZE = 128
+		ALLOCA_STACK_SIZE = 128,
+		BATCH_UPDATE_THREAD_MIN_LEAVES = 1024, // Fewer moved leaves than this are updated on the calling thread.
+		BATCH_UPDATE_SPLIT_DEPTH = 6, // Subtrees below this depth are refit in parallel.
+	};
+
+	enum BatchUpdateResult : uint8_t {
+		BATCH_UPDATE_UNCHANGED,
+		BATCH_UPDATE_MOVED,
+		BATCH_UPDATE_DEGRADED, // Moved out of its parent, refitting would hurt the tree, so it is reinserted.
 	};
 
+	struct BatchUpdateData {
+		const ID *ids;
+		const AABB *boxes;
+		BatchUpdateResult *results;
+	};
+
+	uint32_t refit_pass = 0;
+	LocalVector<BatchUpdateResult> batch_update_results;
+	LocalVector<Node *> refit_top_nodes;
+	LocalVector<Node *> refit_subtrees;
+
 	_FORCE_INLINE_ void _delete_node(Node *p_node);
 	void _recurse_delete_node(Node *p_node);
 	_FORCE_INLINE_ Node *_create_node(Node *p_parent, void *p_data);
@@ -248,6 +270,10 @@ private:
 
 	_FORCE_INLINE_ void _update(Node *leaf, int lookahead = -1);
 
+	void _batch_update_leaf(uint32_t p_index, BatchUpdateData *p_data);
+	void _refit_marked(Node *p_node);
+	void _refit_subtree_threaded(uint32_t p_index, void *p_userdata);
+
 	void _extract_leaves(Node *p_node, List<ID> *r_elements);
 
 	_FORCE_INLINE_ bool _ray_aabb(const Vector3 &rayFrom, const Vector3 &rayInvDirection, const unsigned int raySign[3], const Vector3 bounds[2], real_t &tmin, real_t lambda_min, real_t lambda_max) {
@@ -293,6 +319,7 @@ public:
 	void optimize_incremental(int passes);
 	ID insert(const AABB &p_box, void *p_userdata);
 	bool update(const ID &p_id, const AABB &p_box);
+	void batch_update(const ID *p_ids, const AABB *p_boxes, uint32_t p_count, ThreadWorkPool *p_thread_pool = nullptr);
 	void remove(const ID &p_id);
 	void get_elements(List<ID> *r_elements);
 
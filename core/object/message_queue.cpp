@@ -33,13 +33,237 @@
 #include "core/config/project_settings.h"
 #include "core/core_string_names.h"
 #include "core/object/script_language.h"
+#include "core/os/spin_lock.h"
 
 MessageQueue *MessageQueue::singleton = nullptr;
 
+thread_local MessageQueue::ThreadBuffer *MessageQueue::thread_buffer = nullptr;
+thread_local uint64_t MessageQueue::thread_buffer_queue_id = 0;
+
+#define PAGE_HEADER_SIZE ((sizeof(Page) + 15) & ~size_t(15))
+#define PAGE_DATA(m_page) ((uint8_t *)(m_page) + PAGE_HEADER_SIZE)
+
+// Threads can exit after the queue they pushed to is gone, this guards the queue they point to.
+static SpinLock thread_buffer_lock;
+static uint64_t alive_queue_id = 0;
+static uint64_t last_queue_id = 0;
+
+struct MessageQueueThreadReleaser {
+	bool active = false;
+	~MessageQueueThreadReleaser();
+};
+
+static thread_local MessageQueueThreadReleaser thread_releaser;
+
+MessageQueueThreadReleaser::~MessageQueueThreadReleaser() {
+	if (!active) {
+		return;
+	}
+
+	thread_buffer_lock.lock();
+	if (MessageQueue::thread_buffer && MessageQueue::thread_buffer_queue_id == alive_queue_id) {
+		// The buffer is freed by flush() once empty.
+		MessageQueue::thread_buffer->exited.set();
+	}
+	MessageQueue::thread_buffer = nullptr;
+	MessageQueue::thread_buffer_queue_id = 0;
+	thread_buffer_lock.unlock();
+}
+
 MessageQueue *MessageQueue::get_singleton() {
 	return singleton;
 }
 
+uint32_t MessageQueue::_get_message_size(const Message *p_message) {
+	if ((p_message->type & FLAG_MASK) == TYPE_NOTIFICATION) {
+		return sizeof(Message);
+	}
+	return sizeof(Message) + sizeof(Variant) * p_message->args;
+}
+
+MessageQueue::Page *MessageQueue::_alloc_page(uint32_t p_size) {
+	Page *page = (Page *)Memory::alloc_static(PAGE_HEADER_SIZE + p_size);
+	ERR_FAIL_COND_V(!page, nullptr);
+	memnew_placement(page, Page);
+	page->size = p_size;
+	return page;
+}
+
+void MessageQueue::_free_pages(Page *p_page) {
+	while (p_page) {
+		Page *next = p_page->next.load(std::memory_order_relaxed);
+		p_page->~Page();
+		Memory::free_static(p_page);
+		p_page = next;
+	}
+}
+
+void MessageQueue::_recycle_page(ThreadBuffer *p_buffer, Page *p_page) {
+	// Only flush() pushes and the owner only takes the whole list, so there is no ABA problem.
+	Page *head = p_buffer->drained_pages.load(std::memory_order_relaxed);
+	do {
+		p_page->next.store(head, std::memory_order_relaxed);
+	} while (!p_buffer->drained_pages.compare_exchange_weak(head, p_page, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void MessageQueue::_free_message(Message *p_message) {
+	if ((p_message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
+		Variant *args = (Variant *)(p_message + 1);
+		for (int i = 0; i < p_message->args; i++) {
+			args[i].~Variant();
+		}
+	}
+	p_message->~Message();
+}
+
+MessageQueue::ThreadBuffer *MessageQueue::_get_thread_buffer() {
+	if (likely(thread_buffer && thread_buffer_queue_id == id)) {
+		return thread_buffer;
+	}
+
+	ThreadBuffer *buffer = memnew(ThreadBuffer);
+	buffer->write_page = _alloc_page(page_size);
+	buffer->read_page = buffer->write_page;
+	buffer->linked_bytes = page_size;
+
+	// Only flush() removes buffers, new ones are pushed in front without a lock.
+	ThreadBuffer *head = thread_buffers.load(std::memory_order_relaxed);
+	do {
+		buffer->next = head;
+	} while (!thread_buffers.compare_exchange_weak(head, buffer, std::memory_order_release, std::memory_order_relaxed));
+
+	thread_buffer = buffer;
+	thread_buffer_queue_id = id;
+	thread_releaser.active = true;
+	return buffer;
+}
+
+MessageQueue::Page *MessageQueue::_get_free_page(ThreadBuffer *p_buffer, uint32_t p_size) {
+	if (!p_buffer->spare_pages) {
+		Page *drained = p_buffer->drained_pages.exchange(nullptr, std::memory_order_acquire);
+		p_buffer->spare_pages = drained;
+		for (; drained; drained = drained->next.load(std::memory_order_relaxed)) {
+			p_buffer->linked_bytes -= drained->size;
+		}
+	}
+
+	while (p_buffer->spare_pages) {
+		Page *page = p_buffer->spare_pages;
+		p_buffer->spare_pages = page->next.load(std::memory_order_relaxed);
+		if (page->size < p_size) {
+			// Too small for this message.
+			page->~Page();
+			Memory::free_static(page);
+			continue;
+		}
+
+		page->next.store(nullptr, std::memory_order_relaxed);
+		page->end.set(0);
+		page->read_pos = 0;
+		p_buffer->linked_bytes += page->size;
+		return page;
+	}
+
+	// Sized by what is still waiting for flush(), so a past burst doesn't keep new pages large.
+	uint32_t size = MAX(MIN(MAX(p_buffer->linked_bytes, page_size), page_size_max), p_size);
+	Page *page = _alloc_page(size);
+	ERR_FAIL_COND_V(!page, nullptr);
+	p_buffer->linked_bytes += size;
+	return page;
+}
+
+MessageQueue::Message *MessageQueue::_alloc_message(uint32_t p_size) {
+	ThreadBuffer *buffer = _get_thread_buffer();
+	Page *page = buffer->write_page;
+	ERR_FAIL_COND_V(!page, nullptr);
+
+	uint32_t end = page->end.get();
+	if (unlikely(end + p_size > page->size)) {
+		// Grow instead of dropping the message, the full page stays readable until flushed.
+		Page *new_page = _get_free_page(buffer, p_size);
+		ERR_FAIL_COND_V(!new_page, nullptr);
+
+		page->next.store(new_page, std::memory_order_release);
+		buffer->write_page = new_page;
+		page = new_page;
+		end = 0;
+	}
+
+	return (Message *)(PAGE_DATA(page) + end);
+}
+
+void MessageQueue::_commit_message(Message *p_message) {
+	p_message->sequence = sequence.postincrement();
+	Page *page = thread_buffer->write_page;
+	page->end.set(page->end.get() + _get_message_size(p_message));
+}
+
+MessageQueue::Message *MessageQueue::_peek_message(ThreadBuffer *p_buffer) {
+	Page *page = p_buffer->read_page;
+	while (true) {
+		if (page->read_pos < page->end.get()) {
+			return (Message *)(PAGE_DATA(page) + page->read_pos);
+		}
+
+		Page *next = page->next.load(std::memory_order_acquire);
+		if (!next) {
+			return nullptr;
+		}
+		// The owner can commit to this page right before moving to the next one, check again.
+		if (page->read_pos < page->end.get()) {
+			continue;
+		}
+
+		p_buffer->read_page = next;
+		_recycle_page(p_buffer, page);
+		page = next;
+	}
+}
+
+void MessageQueue::_remove_exited_buffers() {
+	ThreadBuffer *prev = nullptr;
+	ThreadBuffer *buffer = thread_buffers.load(std::memory_order_acquire);
+	while (buffer) {
+		ThreadBuffer *next = buffer->next;
+		if (!buffer->exited.is_set() || _peek_message(buffer)) {
+			prev = buffer;
+			buffer = next;
+			continue;
+		}
+
+		if (prev) {
+			prev->next = next;
+		} else {
+			ThreadBuffer *expected = buffer;
+			if (!thread_buffers.compare_exchange_strong(expected, next, std::memory_order_acq_rel)) {
+				// Other threads pushed new buffers in front of this one.
+				prev = expected;
+				while (prev->next != buffer) {
+					prev = prev->next;
+				}
+				prev->next = next;
+			}
+		}
+
+		// Empty, so only the last page is left.
+		_free_pages(buffer->read_page);
+		_free_pages(buffer->drained_pages.load(std::memory_order_acquire));
+		_free_pages(buffer->spare_pages);
+		memdelete(buffer);
+		buffer = next;
+	}
+}
+
+uint32_t MessageQueue::_get_pending_bytes() const {
+	uint32_t bytes = 0;
+	for (const ThreadBuffer *buffer = thread_buffers.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+		for (const Page *page = buffer->read_page; page; page = page->next.load(std::memory_order_acquire)) {
+			bytes += page->end.get() - page->read_pos;
+		}
+	}
+	return bytes;
+}
+
 Error MessageQueue::push_call(ObjectID p_id, const StringName &p_method, const Variant **p_args, int p_argcount, bool p_show_error) {
 	return push_callable(Callable(p_id, p_method), p_args, p_argcount, p_show_error);
 }
@@ -60,55 +284,35 @@ Error MessageQueue::push_call(ObjectID p_id, const StringName &p_method, VARIANT
 }
 
 Error MessageQueue::push_set(ObjectID p_id, const StringName &p_prop, const Variant &p_value) {
-	_THREAD_SAFE_METHOD_
-
-	uint8_t room_needed = sizeof(Message) + sizeof(Variant);
-
-	if ((buffer_end + room_needed) >= buffer_size) {
-		String type;
-		if (ObjectDB::get_instance(p_id)) {
-			type = ObjectDB::get_instance(p_id)->get_class();
-		}
-		print_line("Failed set: " + type + ":" + p_prop + " target ID: " + itos(p_id));
-		statistics();
-		ERR_FAIL_V_MSG(ERR_OUT_OF_MEMORY, "Message queue out of memory. Try increasing 'memory/limits/message_queue/max_size_kb' in project settings.");
-	}
+	Message *msg = _alloc_message(sizeof(Message) + sizeof(Variant));
+	ERR_FAIL_COND_V(!msg, ERR_OUT_OF_MEMORY);
 
-	Message *msg = memnew_placement(&buffer[buffer_end], Message);
+	memnew_placement(msg, Message);
 	msg->args = 1;
 	msg->callable = Callable(p_id, p_prop);
 	msg->type = TYPE_SET;
 
-	buffer_end += sizeof(Message);
+	memnew_placement(msg + 1, Variant(p_value));
 
-	Variant *v = memnew_placement(&buffer[buffer_end], Variant);
-	buffer_end += sizeof(Variant);
-	*v = p_value;
+	_commit_message(msg);
 
 	return OK;
 }
 
 Error MessageQueue::push_notification(ObjectID p_id, int p_notification) {
-	_THREAD_SAFE_METHOD_
-
 	ERR_FAIL_COND_V(p_notification < 0, ERR_INVALID_PARAMETER);
 
-	uint8_t room_needed = sizeof(Message);
-
-	if ((buffer_end + room_needed) >= buffer_size) {
-		print_line("Failed notification: " + itos(p_notification) + " target ID: " + itos(p_id));
-		statistics();
-		ERR_FAIL_V_MSG(ERR_OUT_OF_MEMORY, "Message queue out of memory. Try increasing 'memory/limits/message_queue/max_size_kb' in project settings.");
-	}
+	Message *msg = _alloc_message(sizeof(Message));
+	ERR_FAIL_COND_V(!msg, ERR_OUT_OF_MEMORY);
 
-	Message *msg = memnew_placement(&buffer[buffer_end], Message);
+	memnew_placement(msg, Message);
 
 	msg->type = TYPE_NOTIFICATION;
 	msg->callable = Callable(p_id, CoreStringNames::get_singleton()->notification); //name is meaningless but callable needs it
 	//msg->target;
 	msg->notification = p_notification;
 
-	buffer_end += sizeof(Message);
+	_commit_message(msg);
 
 	return OK;
 }
@@ -126,17 +330,10 @@ Error MessageQueue::push_set(Object *p_object, const StringName &p_prop, const V
 }
 
 Error MessageQueue::push_callable(const Callable &p_callable, const Variant **p_args, int p_argcount, bool p_show_error) {
-	_THREAD_SAFE_METHOD_
-
-	int room_needed = sizeof(Message) + sizeof(Variant) * p_argcount;
-
-	if ((buffer_end + room_needed) >= buffer_size) {
-		print_line("Failed method: " + p_callable);
-		statistics();
-		ERR_FAIL_V_MSG(ERR_OUT_OF_MEMORY, "Message queue out of memory. Try increasing 'memory/limits/message_queue/max_size_kb' in project settings.");
-	}
+	Message *msg = _alloc_message(sizeof(Message) + sizeof(Variant) * p_argcount);
+	ERR_FAIL_COND_V(!msg, ERR_OUT_OF_MEMORY);
 
-	Message *msg = memnew_placement(&buffer[buffer_end], Message);
+	memnew_placement(msg, Message);
 	msg->args = p_argcount;
 	msg->callable = p_callable;
 	msg->type = TYPE_CALL;
@@ -144,14 +341,13 @@ Error MessageQueue::push_callable(const Callable &p_callable, const Variant **p_
 		msg->type |= FLAG_SHOW_ERROR;
 	}
 
-	buffer_end += sizeof(Message);
-
+	Variant *args = (Variant *)(msg + 1);
 	for (int i = 0; i < p_argcount; i++) {
-		Variant *v = memnew_placement(&buffer[buffer_end], Variant);
-		buffer_end += sizeof(Variant);
-		*v = *p_args[i];
+		memnew_placement(&args[i], Variant(*p_args[i]));
 	}
 
+	_commit_message(msg);
+
 	return OK;
 }
 
@@ -171,60 +367,65 @@ Error MessageQueue::push_callable(const Callable &p_callable, VARIANT_ARG_DECLAR
 }
 
 void MessageQueue::statistics() {
+	_THREAD_SAFE_METHOD_
+	ERR_FAIL_COND_MSG(flushing, "Can't gather message queue statistics while flushing.");
+
 	Map<StringName, int> set_count;
 	Map<int, int> notify_count;
 	Map<Callable, int> call_count;
 	int null_count = 0;
 
-	uint32_t read_pos = 0;
-	while (read_pos < buffer_end) {
-		Message *message = (Message *)&buffer[read_pos];
+	for (ThreadBuffer *buffer = thread_buffers.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+		for (Page *page = buffer->read_page; page; page = page->next.load(std::memory_order_acquire)) {
+			uint32_t read_pos = page->read_pos;
+			uint32_t end = page->end.get();
+			while (read_pos < end) {
+				Message *message = (Message *)(PAGE_DATA(page) + read_pos);
 
-		Object *target = message->callable.get_object();
+				Object *target = message->callable.get_object();
 
-		if (target != nullptr) {
-			switch (message->type & FLAG_MASK) {
-				case TYPE_CALL: {
-					if (!call_count.has(message->callable)) {
-						call_count[message->callable] = 0;
-					}
+				if (target != nullptr) {
+					switch (message->type & FLAG_MASK) {
+						case TYPE_CALL: {
+							if (!call_count.has(message->callable)) {
+								call_count[message->callable] = 0;
+							}
 
-					call_count[message->callable]++;
+							call_count[message->callable]++;
 
-				} break;
-				case TYPE_NOTIFICATION: {
-					if (!notify_count.has(message->notification)) {
-						notify_count[message->notification] = 0;
-					}
+						} break;
+						case TYPE_NOTIFICATION: {
+							if (!notify_count.has(message->notification)) {
+								notify_count[message->notification] = 0;
+							}
 
-					notify_count[message->notification]++;
+							notify_count[message->notification]++;
 
-				} break;
-				case TYPE_SET: {
-					StringName t = message->callable.get_method();
-					if (!set_count.has(t)) {
-						set_count[t] = 0;
-					}
+						} break;
+						case TYPE_SET: {
+							StringName t = message->callable.get_method();
+							if (!set_count.has(t)) {
+								set_count[t] = 0;
+							}
 
-					set_count[t]++;
+							set_count[t]++;
 
-				} break;
-			}
+						} break;
+					}
 
-		} else {
-			//object was deleted
-			print_line("Object was deleted while awaiting a callback");
+				} else {
+					//object was deleted
+					print_line("Object was deleted while awaiting a callback");
 
-			null_count++;
-		}
+					null_count++;
+				}
 
-		read_pos += sizeof(Message);
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
-			read_pos += sizeof(Variant) * message->args;
+				read_pos += _get_message_size(message);
+			}
 		}
 	}
 
-	print_line("TOTAL BYTES: " + itos(buffer_end));
+	print_line("TOTAL BYTES: " + itos(_get_pending_bytes()));
 	print_line("NULL count: " + itos(null_count));
 
 	for (const KeyValue<StringName, int> &E : set_count) {
@@ -262,13 +463,6 @@ void MessageQueue::_call_function(const Callable &p_callable, const Variant *p_a
 }
 
 void MessageQueue::flush() {
-	if (buffer_end > buffer_max_used) {
-		buffer_max_used = buffer_end;
-	}
-
-	uint32_t read_pos = 0;
-
-	//using reverse locking strategy
 	_THREAD_SAFE_LOCK_
 
 	if (flushing) {
@@ -277,60 +471,78 @@ void MessageQueue::flush() {
 	}
 	flushing = true;
 
-	while (read_pos < buffer_end) {
-		//lock on each iteration, so a call can re-add itself to the message queue
+	_THREAD_SAFE_UNLOCK_
 
-		Message *message = (Message *)&buffer[read_pos];
+	uint32_t pending_bytes = _get_pending_bytes();
+	if (pending_bytes > buffer_max_used) {
+		buffer_max_used = pending_bytes;
+	}
 
-		uint32_t advance = sizeof(Message);
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
-			advance += sizeof(Variant) * message->args;
+	while (true) {
+		// Find the buffer holding the oldest message, and up to which sequence it can be read
+		// before another buffer has an older one.
+		ThreadBuffer *oldest_buffer = nullptr;
+		uint64_t oldest_sequence = UINT64_MAX;
+		uint64_t sequence_limit = sequence.get();
+
+		for (ThreadBuffer *buffer = thread_buffers.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+			Message *message = _peek_message(buffer);
+			if (!message) {
+				continue;
+			}
+			if (message->sequence < oldest_sequence) {
+				sequence_limit = MIN(sequence_limit, oldest_sequence);
+				oldest_sequence = message->sequence;
+				oldest_buffer = buffer;
+			} else {
+				sequence_limit = MIN(sequence_limit, message->sequence);
+			}
 		}
 
-		//pre-advance so this function is reentrant
-		read_pos += advance;
-
-		_THREAD_SAFE_UNLOCK_
+		if (!oldest_buffer) {
+			break;
+		}
 
-		Object *target = message->callable.get_object();
+		Message *message = _peek_message(oldest_buffer);
+		while (message && message->sequence < sequence_limit) {
+			//pre-advance so this function is reentrant
+			oldest_buffer->read_page->read_pos += _get_message_size(message);
 
-		if (target != nullptr) {
-			switch (message->type & FLAG_MASK) {
-				case TYPE_CALL: {
-					Variant *args = (Variant *)(message + 1);
+			Object *target = message->callable.get_object();
 
-					// messages don't expect a return value
+			if (target != nullptr) {
+				switch (message->type & FLAG_MASK) {
+					case TYPE_CALL: {
+						Variant *args = (Variant *)(message + 1);
 
-					_call_function(message->callable, args, message->args, message->type & FLAG_SHOW_ERROR);
+						// messages don't expect a return value
 
-				} break;
-				case TYPE_NOTIFICATION: {
-					// messages don't expect a return value
-					target->notification(message->notification);
+						_call_function(message->callable, args, message->args, message->type & FLAG_SHOW_ERROR);
 
-				} break;
-				case TYPE_SET: {
-					Variant *arg = (Variant *)(message + 1);
-					// messages don't expect a return value
-					target->set(message->callable.get_method(), *arg);
+					} break;
+					case TYPE_NOTIFICATION: {
+						// messages don't expect a return value
+						target->notification(message->notification);
 
-				} break;
-			}
-		}
+					} break;
+					case TYPE_SET: {
+						Variant *arg = (Variant *)(message + 1);
+						// messages don't expect a return value
+						target->set(message->callable.get_method(), *arg);
 
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
-			Variant *args = (Variant *)(message + 1);
-			for (int i = 0; i < message->args; i++) {
-				args[i].~Variant();
+					} break;
+				}
 			}
-		}
 
-		message->~Message();
+			_free_message(message);
 
-		_THREAD_SAFE_LOCK_
+			message = _peek_message(oldest_buffer);
+		}
 	}
 
-	buffer_end = 0; // reset buffer
+	_remove_exited_buffers();
+
+	_THREAD_SAFE_LOCK_
 	flushing = false;
 	_THREAD_SAFE_UNLOCK_
 }
@@ -343,32 +555,49 @@ MessageQueue::MessageQueue() {
 	ERR_FAIL_COND_MSG(singleton != nullptr, "A MessageQueue singleton already exists.");
 	singleton = this;
 
-	buffer_size = GLOBAL_DEF_RST("memory/limits/message_queue/max_size_kb", DEFAULT_QUEUE_SIZE_KB);
+	thread_buffer_lock.lock();
+	id = ++last_queue_id;
+	alive_queue_id = id;
+	thread_buffer_lock.unlock();
+
+	page_size = GLOBAL_DEF_RST("memory/limits/message_queue/page_size_kb", DEFAULT_PAGE_SIZE_KB);
+	ProjectSettings::get_singleton()->set_custom_property_info("memory/limits/message_queue/page_size_kb", PropertyInfo(Variant::INT, "memory/limits/message_queue/page_size_kb", PROPERTY_HINT_RANGE, "4,1024,1,or_greater"));
+	page_size_max = GLOBAL_DEF_RST("memory/limits/message_queue/max_size_kb", DEFAULT_QUEUE_SIZE_KB);
 	ProjectSettings::get_singleton()->set_custom_property_info("memory/limits/message_queue/max_size_kb", PropertyInfo(Variant::INT, "memory/limits/message_queue/max_size_kb", PROPERTY_HINT_RANGE, "1024,4096,1,or_greater"));
-	buffer_size *= 1024;
-	buffer = memnew_arr(uint8_t, buffer_size);
+	page_size *= 1024;
+	page_size_max = MAX(page_size_max * 1024, page_size);
 }
 
 MessageQueue::~MessageQueue() {
-	uint32_t read_pos = 0;
-
-	while (read_pos < buffer_end) {
-		Message *message = (Message *)&buffer[read_pos];
-		Variant *args = (Variant *)(message + 1);
-		int argc = message->args;
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
-			for (int i = 0; i < argc; i++) {
-				args[i].~Variant();
+	thread_buffer_lock.lock();
+	alive_queue_id = 0;
+	thread_buffer_lock.unlock();
+
+	ThreadBuffer *buffer = thread_buffers.load(std::memory_order_acquire);
+	while (buffer) {
+		Page *page = buffer->read_page;
+		while (page) {
+			uint32_t read_pos = page->read_pos;
+			uint32_t end = page->end.get();
+			while (read_pos < end) {
+				Message *message = (Message *)(PAGE_DATA(page) + read_pos);
+				read_pos += _get_message_size(message);
+				_free_message(message);
 			}
-		}
-		message->~Message();
 
-		read_pos += sizeof(Message);
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
-			read_pos += sizeof(Variant) * message->args;
+			Page *next = page->next.load(std::memory_order_acquire);
+			page->~Page();
+			Memory::free_static(page);
+			page = next;
 		}
+
+		_free_pages(buffer->drained_pages.load(std::memory_order_acquire));
+		_free_pages(buffer->spare_pages);
+
+		ThreadBuffer *next = buffer->next;
+		memdelete(buffer);
+		buffer = next;
 	}
 
 	singleton = nullptr;
-	memdelete_arr(buffer);
 }
@@ -33,11 +33,17 @@
 
 #include "core/object/class_db.h"
 #include "core/os/thread_safe.h"
+#include "core/templates/safe_refcount.h"
 
+#include <atomic>
+
+// Each thread pushes to its own buffer without taking a lock. flush() merges
+// the buffers back in push order, using a sequence number in each message.
 class MessageQueue {
 	_THREAD_SAFE_CLASS_
 
 	enum {
+		DEFAULT_PAGE_SIZE_KB = 16,
 		DEFAULT_QUEUE_SIZE_KB = 4096
 	};
 
@@ -52,6 +58,7 @@ class MessageQueue {
 
 	struct Message {
 		Callable callable;
+		uint64_t sequence;
 		int16_t type;
 		union {
 			int16_t notification;
@@ -59,10 +66,50 @@ class MessageQueue {
 		};
 	};
 
-	uint8_t *buffer;
-	uint32_t buffer_end = 0;
+	// Pages are never moved, the flushing thread reads a page while its owner
+	// keeps appending to it. Messages up to `end` are complete. Drained pages
+	// go back to their owner for reuse.
+	struct Page {
+		std::atomic<Page *> next = { nullptr };
+		SafeNumeric<uint32_t> end;
+		uint32_t size = 0;
+		uint32_t read_pos = 0; // Only used by the flushing thread.
+	};
+
+	struct ThreadBuffer {
+		ThreadBuffer *next = nullptr;
+		Page *write_page = nullptr; // Only used by the owner thread.
+		Page *spare_pages = nullptr; // Only used by the owner thread.
+		uint32_t linked_bytes = 0; // Size of the pages not drained yet, only used by the owner thread.
+		Page *read_page = nullptr; // Only used by the flushing thread.
+		std::atomic<Page *> drained_pages = { nullptr }; // Pushed by the flushing thread, taken all at once by the owner.
+		SafeFlag exited;
+	};
+
+	static thread_local ThreadBuffer *thread_buffer;
+	static thread_local uint64_t thread_buffer_queue_id;
+
+	std::atomic<ThreadBuffer *> thread_buffers = { nullptr };
+	SafeNumeric<uint64_t> sequence;
+	uint64_t id = 0;
+
+	uint32_t page_size;
+	uint32_t page_size_max;
 	uint32_t buffer_max_used = 0;
-	uint32_t buffer_size;
+
+	static uint32_t _get_message_size(const Message *p_message);
+	static Page *_alloc_page(uint32_t p_size);
+	static void _free_pages(Page *p_page);
+	static void _recycle_page(ThreadBuffer *p_buffer, Page *p_page);
+	static void _free_message(Message *p_message);
+
+	ThreadBuffer *_get_thread_buffer();
+	Page *_get_free_page(ThreadBuffer *p_buffer, uint32_t p_size);
+	Message *_alloc_message(uint32_t p_size);
+	void _commit_message(Message *p_message);
+	Message *_peek_message(ThreadBuffer *p_buffer);
+	void _remove_exited_buffers();
+	uint32_t _get_pending_bytes() const;
 
 	void _call_function(const Callable &p_callable, const Variant *p_args, int p_argcount, bool p_show_error);
 
@@ -70,6 +117,8 @@ class MessageQueue {
 
 	bool flushing = false;
 
+	friend struct MessageQueueThreadReleaser;
+
 public:
 	static MessageQueue *get_singleton();
 
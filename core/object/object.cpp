@@ -991,6 +991,7 @@ void Object::add_user_signal(const MethodInfo &p_signal) {
 	SignalData s;
 	s.user = p_signal;
 	signal_map[p_signal.name] = s;
+	_signal_map_version++;
 }
 
 bool Object::_has_user_signal(const StringName &p_name) const {
@@ -1048,12 +1049,36 @@ Error Object::emit_signal(const StringName &p_name, const Variant **p_args, int
 		return ERR_UNAVAILABLE;
 	}
 
+	return _emit_signal_slots(p_name, s, p_args, p_argcount);
+}
+
+Error Object::emit_signal(SignalHandle &r_handle, const Variant **p_args, int p_argcount) {
+	if (_block_signals) {
+		return ERR_CANT_ACQUIRE_RESOURCE; //no emit, signals blocked
+	}
+
+	if (r_handle.object != _instance_id || r_handle.version != _signal_map_version) {
+		r_handle.object = _instance_id;
+		r_handle.version = _signal_map_version;
+		r_handle.data = signal_map.getptr(r_handle.name);
+	}
+
+	if (!r_handle.data) {
+		// Nothing connected, go through the lookup by name to validate the signal.
+		return emit_signal(r_handle.name, p_args, p_argcount);
+	}
+
+	return _emit_signal_slots(r_handle.name, r_handle.data, p_args, p_argcount);
+}
+
+Error Object::_emit_signal_slots(const StringName &p_name, SignalData *p_signal, const Variant **p_args, int p_argcount) {
 	List<_ObjectSignalDisconnectData> disconnect_data;
 
 	//copy on write will ensure that disconnecting the signal or even deleting the object will not affect the signal calling.
 	//this happens automatically and will not change the performance of calling.
 	//awesome, isn't it?
-	VMap<Callable, SignalData::Slot> slot_map = s->slot_map;
+	//keep it const, non-const access would trigger the copy on every emission.
+	const VMap<Callable, SignalData::Slot> slot_map = p_signal->slot_map;
 
 	int ssize = slot_map.size();
 
@@ -1064,7 +1089,8 @@ Error Object::emit_signal(const StringName &p_name, const Variant **p_args, int
 	Error err = OK;
 
 	for (int i = 0; i < ssize; i++) {
-		const Connection &c = slot_map.getv(i).conn;
+		const SignalData::Slot &slot = slot_map.getv(i);
+		const Connection &c = slot.conn;
 
 		Object *target = c.callable.get_object();
 		if (!target) {
@@ -1096,7 +1122,15 @@ Error Object::emit_signal(const StringName &p_name, const Variant **p_args, int
 			Callable::CallError ce;
 			_emitting = true;
 			Variant ret;
-			c.callable.call(args, argc, ret, ce);
+			if (slot.method && !target->script_instance) {
+				// Same as Object::call(), without looking up the method by name.
+#ifdef DEBUG_ENABLED
+				_ObjectDebugLock target_lock(target);
+#endif
+				ret = slot.method->call(target, args, argc, ce);
+			} else {
+				c.callable.call(args, argc, ret, ce);
+			}
 			_emitting = false;
 
 			if (ce.error != Callable::CallError::CALL_OK) {
@@ -1154,6 +1188,21 @@ Error Object::emit_signal(const StringName &p_name, VARIANT_ARG_DECLARE) {
 	return emit_signal(p_name, argptr, argc);
 }
 
+Error Object::emit_signal(SignalHandle &r_handle, VARIANT_ARG_DECLARE) {
+	VARIANT_ARGPTRS;
+
+	int argc = 0;
+
+	for (int i = 0; i < VARIANT_ARG_MAX; i++) {
+		if (argptr[i]->get_type() == Variant::NIL) {
+			break;
+		}
+		argc++;
+	}
+
+	return emit_signal(r_handle, argptr, argc);
+}
+
 void Object::_add_user_signal(const String &p_name, const Array &p_args) {
 	// this version of add_user_signal is meant to be used from scripts or external apis
 	// without access to ADD_SIGNAL in bind_methods
@@ -1329,6 +1378,7 @@ Error Object::connect(const StringName &p_signal, const Callable &p_callable, co
 
 		signal_map[p_signal] = SignalData();
 		s = &signal_map[p_signal];
+		_signal_map_version++;
 	}
 
 	Callable target = p_callable;
@@ -1352,6 +1402,9 @@ Error Object::connect(const StringName &p_signal, const Callable &p_callable, co
 	conn.binds = p_binds;
 	slot.conn = conn;
 	slot.cE = target_object->connections.push_back(conn);
+	if (target.is_standard() && target.get_method() != CoreStringNames::get_singleton()->_free) {
+		slot.method = ClassDB::get_method(target_object->get_class_name(), target.get_method());
+	}
 	if (p_flags & CONNECT_REFERENCE_COUNTED) {
 		slot.reference_count = 1;
 	}
@@ -1420,6 +1473,7 @@ void Object::_disconnect(const StringName &p_signal, const Callable &p_callable,
 	if (s->slot_map.is_empty() && ClassDB::has_signal(get_class_name(), p_signal)) {
 		//not user signal, delete
 		signal_map.erase(p_signal);
+		_signal_map_version++;
 	}
 }
 
@@ -515,12 +515,32 @@ private:
 			int reference_count = 0;
 			Connection conn;
 			List<Connection>::Element *cE = nullptr;
+			MethodBind *method = nullptr; // Native target, called directly when the target has no script.
 		};
 
 		MethodInfo user;
 		VMap<Callable, Slot> slot_map;
 	};
 
+public:
+	// Keeps the result of looking up a signal by name, for emitters that emit the same signal often.
+	class SignalHandle {
+		friend class Object;
+
+		StringName name;
+		ObjectID object;
+		uint32_t version = 0;
+		SignalData *data = nullptr;
+
+	public:
+		_FORCE_INLINE_ const StringName &get_name() const { return name; }
+
+		SignalHandle() {}
+		explicit SignalHandle(const StringName &p_name) :
+				name(p_name) {}
+	};
+
+private:
 	HashMap<StringName, SignalData> signal_map;
 	List<Connection> connections;
 #ifdef DEBUG_ENABLED
@@ -533,6 +553,7 @@ private:
 	void _postinitialize();
 	bool _can_translate = true;
 	bool _emitting = false;
+	uint32_t _signal_map_version = 0; // Bumped when signals are added or removed, invalidates SignalHandles.
 #ifdef TOOLS_ENABLED
 	bool _edited = false;
 	uint32_t _edited_version = 0;
@@ -547,6 +568,7 @@ private:
 	void _add_user_signal(const String &p_name, const Array &p_args = Array());
 	bool _has_user_signal(const StringName &p_name) const;
 	Variant _emit_signal(const Variant **p_args, int p_argcount, Callable::CallError &r_error);
+	Error _emit_signal_slots(const StringName &p_name, SignalData *p_signal, const Variant **p_args, int p_argcount);
 	Array _get_signal_list() const;
 	Array _get_signal_connection_list(const String &p_signal) const;
 	Array _get_incoming_connections() const;
@@ -783,6 +805,8 @@ public:
 	void add_user_signal(const MethodInfo &p_signal);
 	Error emit_signal(const StringName &p_name, VARIANT_ARG_LIST);
 	Error emit_signal(const StringName &p_name, const Variant **p_args, int p_argcount);
+	Error emit_signal(SignalHandle &r_handle, VARIANT_ARG_LIST);
+	Error emit_signal(SignalHandle &r_handle, const Variant **p_args, int p_argcount);
 	bool has_signal(const StringName &p_name) const;
 	void get_signal_list(List<MethodInfo> *p_signals) const;
 	void get_signal_connection_list(const StringName &p_signal, List<Connection> *p_connections) const;
@@ -0,0 +1,225 @@
+/*************************************************************************/
+/*  frame_arena.cpp                                                      */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "frame_arena.h"
+
+#include "core/error/error_macros.h"
+#include "core/os/memory.h"
+
+#include <string.h>
+
+static const size_t BLOCK_SIZE_MIN = 65536;
+static const size_t ALIGNMENT = 16;
+
+struct ArenaBlock {
+	ArenaBlock *next = nullptr;
+	size_t size = 0;
+	size_t used = 0;
+};
+
+// Before every allocation. The size is the one reserved in the block, a multiple of ALIGNMENT.
+struct ArenaAllocation {
+	uint32_t size;
+	uint32_t frame;
+	void *arena;
+};
+
+static const size_t BLOCK_HEADER_SIZE = (sizeof(ArenaBlock) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+static const size_t ALLOCATION_HEADER_SIZE = (sizeof(ArenaAllocation) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+struct ThreadArena {
+	ArenaBlock *blocks = nullptr; // The current one first.
+	uint32_t frame = 0;
+	uint32_t live_allocations = 0;
+	size_t used_bytes = 0;
+	uint64_t block_allocations = 0;
+
+	~ThreadArena() {
+		while (blocks) {
+			ArenaBlock *next = blocks->next;
+			Memory::free_static(blocks);
+			blocks = next;
+		}
+	}
+};
+
+static thread_local ThreadArena thread_arena;
+
+static _FORCE_INLINE_ uint8_t *_get_block_data(ArenaBlock *p_block) {
+	return (uint8_t *)p_block + BLOCK_HEADER_SIZE;
+}
+
+static _FORCE_INLINE_ size_t _get_reserved_size(size_t p_bytes) {
+	return (p_bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+static ArenaBlock *_add_block(ThreadArena &r_arena, size_t p_bytes) {
+	size_t size = BLOCK_SIZE_MIN;
+	if (r_arena.blocks) {
+		size = r_arena.blocks->size * 2;
+	}
+	while (size < p_bytes) {
+		size *= 2;
+	}
+
+	ArenaBlock *block = (ArenaBlock *)Memory::alloc_static(BLOCK_HEADER_SIZE + size);
+	ERR_FAIL_COND_V(!block, nullptr);
+	block->next = r_arena.blocks;
+	block->size = size;
+	block->used = 0;
+	r_arena.blocks = block;
+	r_arena.block_allocations++;
+	return block;
+}
+
+static _FORCE_INLINE_ ArenaAllocation *_get_allocation(ThreadArena &r_arena, void *p_memory) {
+	ArenaAllocation *allocation = (ArenaAllocation *)((uint8_t *)p_memory - ALLOCATION_HEADER_SIZE);
+	ERR_FAIL_COND_V_MSG(allocation->arena != &r_arena, nullptr, "Frame arena memory must be freed by the thread that allocated it.");
+	ERR_FAIL_COND_V_MSG(allocation->frame != r_arena.frame, nullptr, "Frame arena memory was used after the end of its frame.");
+	return allocation;
+}
+
+static void _rewind(ThreadArena &r_arena) {
+	for (ArenaBlock *block = r_arena.blocks; block; block = block->next) {
+		block->used = 0;
+	}
+	r_arena.used_bytes = 0;
+}
+
+void *FrameArena::alloc(size_t p_bytes) {
+	ERR_FAIL_COND_V(p_bytes > UINT32_MAX - ALIGNMENT, nullptr);
+	ThreadArena &arena = thread_arena;
+	size_t size = ALLOCATION_HEADER_SIZE + _get_reserved_size(p_bytes);
+
+	ArenaBlock *block = arena.blocks;
+	if (unlikely(!block || block->used + size > block->size)) {
+		// Earlier blocks may still have room after a rewind, but the newest is the largest.
+		block = _add_block(arena, size);
+		if (!block) {
+			return nullptr;
+		}
+	}
+
+	uint8_t *memory = _get_block_data(block) + block->used;
+	block->used += size;
+	arena.used_bytes += size;
+	arena.live_allocations++;
+
+	ArenaAllocation *allocation = (ArenaAllocation *)memory;
+	allocation->size = size - ALLOCATION_HEADER_SIZE;
+	allocation->frame = arena.frame;
+	allocation->arena = &arena;
+	return memory + ALLOCATION_HEADER_SIZE;
+}
+
+void *FrameArena::realloc(void *p_memory, size_t p_bytes) {
+	if (!p_memory) {
+		return alloc(p_bytes);
+	}
+	if (p_bytes == 0) {
+		free(p_memory);
+		return nullptr;
+	}
+	ERR_FAIL_COND_V(p_bytes > UINT32_MAX - ALIGNMENT, nullptr);
+
+	ThreadArena &arena = thread_arena;
+	ArenaAllocation *allocation = _get_allocation(arena, p_memory);
+	ERR_FAIL_COND_V(!allocation, nullptr);
+
+	size_t old_size = allocation->size;
+	size_t new_size = _get_reserved_size(p_bytes);
+	if (new_size <= old_size) {
+		return p_memory;
+	}
+
+	// The last allocation of the current block grows in place.
+	ArenaBlock *block = arena.blocks;
+	if ((uint8_t *)p_memory + old_size == _get_block_data(block) + block->used && block->used + new_size - old_size <= block->size) {
+		block->used += new_size - old_size;
+		arena.used_bytes += new_size - old_size;
+		allocation->size = new_size;
+		return p_memory;
+	}
+
+	void *memory = alloc(p_bytes);
+	if (!memory) {
+		return nullptr;
+	}
+	memcpy(memory, p_memory, old_size);
+	free(p_memory);
+	return memory;
+}
+
+void FrameArena::free(void *p_memory) {
+	ERR_FAIL_COND(!p_memory);
+	ThreadArena &arena = thread_arena;
+	ArenaAllocation *allocation = _get_allocation(arena, p_memory);
+	ERR_FAIL_COND(!allocation);
+
+	arena.live_allocations--;
+	if (arena.live_allocations == 0) {
+		_rewind(arena);
+		return;
+	}
+
+	ArenaBlock *block = arena.blocks;
+	if ((uint8_t *)p_memory + allocation->size == _get_block_data(block) + block->used) {
+		size_t size = ALLOCATION_HEADER_SIZE + allocation->size;
+		block->used -= size;
+		arena.used_bytes -= size;
+	}
+}
+
+void FrameArena::end_frame() {
+	ThreadArena &arena = thread_arena;
+	arena.frame++;
+	arena.live_allocations = 0;
+
+	if (arena.blocks && arena.blocks->next) {
+		// Needed more than one block this frame, replace them with one large enough for all of them.
+		size_t size = 0;
+		while (arena.blocks) {
+			ArenaBlock *next = arena.blocks->next;
+			size += arena.blocks->size;
+			Memory::free_static(arena.blocks);
+			arena.blocks = next;
+		}
+		_add_block(arena, size);
+	}
+	_rewind(arena);
+}
+
+uint64_t FrameArena::get_block_allocation_count() {
+	return thread_arena.block_allocations;
+}
+
+size_t FrameArena::get_used_bytes() {
+	return thread_arena.used_bytes;
+}
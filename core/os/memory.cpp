@@ -33,9 +33,37 @@
 #include "core/error/error_macros.h"
 #include "core/templates/safe_refcount.h"
 
+#ifdef BUILTIN_ALLOCATOR_ENABLED
+#include "core/os/thread_cache_allocator.h"
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 
+static _FORCE_INLINE_ void *_heap_alloc(size_t p_bytes) {
+#ifdef BUILTIN_ALLOCATOR_ENABLED
+	return ThreadCacheAllocator::alloc(p_bytes);
+#else
+	return malloc(p_bytes);
+#endif
+}
+
+static _FORCE_INLINE_ void *_heap_realloc(void *p_memory, size_t p_bytes) {
+#ifdef BUILTIN_ALLOCATOR_ENABLED
+	return ThreadCacheAllocator::realloc(p_memory, p_bytes);
+#else
+	return realloc(p_memory, p_bytes);
+#endif
+}
+
+static _FORCE_INLINE_ void _heap_free(void *p_memory) {
+#ifdef BUILTIN_ALLOCATOR_ENABLED
+	ThreadCacheAllocator::free(p_memory);
+#else
+	free(p_memory);
+#endif
+}
+
 void *operator new(size_t p_size, const char *p_description) {
 	return Memory::alloc_static(p_size, false);
 }
@@ -61,6 +89,7 @@ void operator delete(void *p_mem, void *p_pointer, size_t check, const char *p_d
 #ifdef DEBUG_ENABLED
 SafeNumeric<uint64_t> Memory::mem_usage;
 SafeNumeric<uint64_t> Memory::max_usage;
+SafeNumeric<uint64_t> Memory::alloc_calls;
 #endif
 
 SafeNumeric<uint64_t> Memory::alloc_count;
@@ -72,7 +101,7 @@ void *Memory::alloc_static(size_t p_bytes, bool p_pad_align) {
 	bool prepad = p_pad_align;
 #endif
 
-	void *mem = malloc(p_bytes + (prepad ? PAD_ALIGN : 0));
+	void *mem = _heap_alloc(p_bytes + (prepad ? PAD_ALIGN : 0));
 
 	ERR_FAIL_COND_V(!mem, nullptr);
 
@@ -87,6 +116,7 @@ void *Memory::alloc_static(size_t p_bytes, bool p_pad_align) {
 #ifdef DEBUG_ENABLED
 		uint64_t new_mem_usage = mem_usage.add(p_bytes);
 		max_usage.exchange_if_greater(new_mem_usage);
+		alloc_calls.increment();
 #endif
 		return s8 + PAD_ALIGN;
 	} else {
@@ -118,15 +148,16 @@ void *Memory::realloc_static(void *p_memory, size_t p_bytes, bool p_pad_align) {
 		} else {
 			mem_usage.sub(*s - p_bytes);
 		}
+		alloc_calls.increment();
 #endif
 
 		if (p_bytes == 0) {
-			free(mem);
+			_heap_free(mem);
 			return nullptr;
 		} else {
 			*s = p_bytes;
 
-			mem = (uint8_t *)realloc(mem, p_bytes + PAD_ALIGN);
+			mem = (uint8_t *)_heap_realloc(mem, p_bytes + PAD_ALIGN);
 			ERR_FAIL_COND_V(!mem, nullptr);
 
 			s = (uint64_t *)mem;
@@ -136,7 +167,7 @@ void *Memory::realloc_static(void *p_memory, size_t p_bytes, bool p_pad_align) {
 			return mem + PAD_ALIGN;
 		}
 	} else {
-		mem = (uint8_t *)realloc(mem, p_bytes);
+		mem = (uint8_t *)_heap_realloc(mem, p_bytes);
 
 		ERR_FAIL_COND_V(mem == nullptr && p_bytes > 0, nullptr);
 
@@ -165,9 +196,9 @@ void Memory::free_static(void *p_ptr, bool p_pad_align) {
 		mem_usage.sub(*s);
 #endif
 
-		free(mem);
+		_heap_free(mem);
 	} else {
-		free(mem);
+		_heap_free(mem);
 	}
 }
 
@@ -191,6 +222,14 @@ uint64_t Memory::get_mem_max_usage() {
 #endif
 }
 
+uint64_t Memory::get_alloc_call_count() {
+#ifdef DEBUG_ENABLED
+	return alloc_calls.get();
+#else
+	return 0;
+#endif
+}
+
 _GlobalNil::_GlobalNil() {
 	left = this;
 	right = this;
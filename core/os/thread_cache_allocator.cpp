@@ -0,0 +1,544 @@
+/*************************************************************************/
+/*  thread_cache_allocator.cpp                                           */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "thread_cache_allocator.h"
+
+#include "core/error/error_macros.h"
+#include "core/os/spin_lock.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+static const size_t SPAN_SIZE = 65536;
+static const size_t SPAN_HEADER_SIZE = 64;
+static const size_t MAX_BLOCK_SIZE = 8192;
+// 16 to 128 bytes 16 bytes apart, then four classes per power of two up to MAX_BLOCK_SIZE.
+static const uint32_t LINEAR_SIZE_CLASS_COUNT = 8;
+static const uint32_t SIZE_CLASS_COUNT = 32;
+static const uint32_t LARGE_SIZE_CLASS = SIZE_CLASS_COUNT;
+// Empty spans kept around for any size class before giving them back to the system.
+static const uint32_t FREE_SPAN_POOL_MAX = 32;
+
+struct SizeClassTable {
+	uint32_t block_sizes[SIZE_CLASS_COUNT] = {};
+	// Blocks moved between a thread cache and the span lists at once.
+	uint32_t batch_sizes[SIZE_CLASS_COUNT] = {};
+	// Indexed by (size - 1) / 16, size classes never start in the middle of 16 bytes.
+	uint8_t size_classes[MAX_BLOCK_SIZE / 16] = {};
+
+	constexpr SizeClassTable() {
+		for (uint32_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+			if (i < LINEAR_SIZE_CLASS_COUNT) {
+				block_sizes[i] = (i + 1) * 16;
+			} else {
+				uint32_t step = (i - LINEAR_SIZE_CLASS_COUNT) % 4;
+				uint32_t shift = (i - LINEAR_SIZE_CLASS_COUNT) / 4 + 5;
+				block_sizes[i] = (5 + step) << shift;
+			}
+			uint32_t batch_size = 16384 / block_sizes[i];
+			batch_sizes[i] = batch_size < 2 ? 2 : (batch_size > 64 ? 64 : batch_size);
+		}
+		uint32_t size_class = 0;
+		for (uint32_t i = 0; i < MAX_BLOCK_SIZE / 16; i++) {
+			while (block_sizes[size_class] < (i + 1) * 16) {
+				size_class++;
+			}
+			size_classes[i] = size_class;
+		}
+	}
+};
+
+static constexpr SizeClassTable size_class_table;
+
+// Stored at the start of every span. Blocks never cross a span boundary, so the span of a block is
+// found by masking its address. Large allocations get one to themselves, aligned the same way.
+struct Span {
+	uint32_t size_class;
+	uint32_t block_size;
+	uint32_t used;
+	uint32_t capacity;
+	size_t size;
+	void *free_list;
+	uint8_t *unused; // Start of the blocks never handed out.
+	Span *prev;
+	Span *next;
+	bool in_partial_list;
+};
+
+static_assert(sizeof(Span) <= SPAN_HEADER_SIZE, "Span header doesn't fit.");
+
+struct SpanList {
+	SpinLock lock;
+	Span *partial = nullptr; // Spans with free blocks.
+	uint64_t span_count = 0;
+	uint64_t blocks_out = 0; // Held by thread caches or in use.
+};
+
+struct ThreadCache {
+	struct FreeList {
+		void *head = nullptr;
+		// Only written by the owner thread, other threads read them for the stats.
+		std::atomic<uint32_t> count = { 0 };
+		std::atomic<uint64_t> allocations = { 0 };
+	};
+
+	FreeList lists[SIZE_CLASS_COUNT];
+	ThreadCache *prev = nullptr;
+	ThreadCache *next = nullptr;
+};
+
+struct ThreadCacheReleaser {
+	bool active = false;
+	~ThreadCacheReleaser();
+};
+
+// All constant initialized, allocations can happen before any static constructor runs.
+static SpanList span_lists[SIZE_CLASS_COUNT];
+
+static SpinLock span_pool_lock;
+static Span *span_pool = nullptr;
+static uint32_t span_pool_count = 0;
+
+static SpinLock thread_caches_lock;
+static ThreadCache *thread_caches = nullptr;
+static uint64_t exited_thread_allocations[SIZE_CLASS_COUNT] = {};
+
+static std::atomic<uint64_t> large_allocations = { 0 };
+static std::atomic<uint64_t> large_blocks = { 0 };
+static std::atomic<uint64_t> large_bytes = { 0 };
+
+static thread_local ThreadCache *thread_cache = nullptr;
+static thread_local bool thread_cache_released = false;
+static thread_local ThreadCacheReleaser thread_cache_releaser;
+
+static void *_alloc_aligned(size_t p_bytes) {
+#ifdef _WIN32
+	return _aligned_malloc(p_bytes, SPAN_SIZE);
+#else
+	void *memory = nullptr;
+	if (posix_memalign(&memory, SPAN_SIZE, p_bytes) != 0) {
+		return nullptr;
+	}
+	return memory;
+#endif
+}
+
+static void _free_aligned(void *p_memory) {
+#ifdef _WIN32
+	_aligned_free(p_memory);
+#else
+	::free(p_memory);
+#endif
+}
+
+static _FORCE_INLINE_ Span *_get_span(const void *p_memory) {
+	return (Span *)((uintptr_t)p_memory & ~(uintptr_t)(SPAN_SIZE - 1));
+}
+
+static Span *_span_create(uint32_t p_size_class) {
+	span_pool_lock.lock();
+	Span *span = span_pool;
+	if (span) {
+		span_pool = span->next;
+		span_pool_count--;
+	}
+	span_pool_lock.unlock();
+
+	if (!span) {
+		span = (Span *)_alloc_aligned(SPAN_SIZE);
+		if (!span) {
+			return nullptr;
+		}
+	}
+
+	span->size_class = p_size_class;
+	span->block_size = size_class_table.block_sizes[p_size_class];
+	span->used = 0;
+	span->capacity = (SPAN_SIZE - SPAN_HEADER_SIZE) / span->block_size;
+	span->size = SPAN_SIZE;
+	span->free_list = nullptr;
+	span->unused = (uint8_t *)span + SPAN_HEADER_SIZE;
+	span->prev = nullptr;
+	span->next = nullptr;
+	span->in_partial_list = false;
+	return span;
+}
+
+static void _span_release(Span *p_span) {
+	span_pool_lock.lock();
+	if (span_pool_count < FREE_SPAN_POOL_MAX) {
+		p_span->next = span_pool;
+		span_pool = p_span;
+		span_pool_count++;
+		p_span = nullptr;
+	}
+	span_pool_lock.unlock();
+
+	if (p_span) {
+		_free_aligned(p_span);
+	}
+}
+
+static _FORCE_INLINE_ void _partial_list_add(SpanList &r_list, Span *p_span) {
+	p_span->prev = nullptr;
+	p_span->next = r_list.partial;
+	if (r_list.partial) {
+		r_list.partial->prev = p_span;
+	}
+	r_list.partial = p_span;
+	p_span->in_partial_list = true;
+}
+
+static _FORCE_INLINE_ void _partial_list_remove(SpanList &r_list, Span *p_span) {
+	if (p_span->prev) {
+		p_span->prev->next = p_span->next;
+	} else {
+		r_list.partial = p_span->next;
+	}
+	if (p_span->next) {
+		p_span->next->prev = p_span->prev;
+	}
+	p_span->in_partial_list = false;
+}
+
+// Links up to p_count free blocks of the size class in r_head, returns how many.
+static uint32_t _take_blocks(uint32_t p_size_class, uint32_t p_count, void **r_head) {
+	SpanList &list = span_lists[p_size_class];
+	void *head = nullptr;
+	uint32_t taken = 0;
+
+	list.lock.lock();
+	while (taken < p_count) {
+		Span *span = list.partial;
+		if (!span) {
+			span = _span_create(p_size_class);
+			if (!span) {
+				break;
+			}
+			list.span_count++;
+			_partial_list_add(list, span);
+		}
+
+		uint8_t *unused_end = (uint8_t *)span + SPAN_HEADER_SIZE + span->capacity * span->block_size;
+		while (taken < p_count) {
+			void *block;
+			if (span->free_list) {
+				block = span->free_list;
+				span->free_list = *(void **)block;
+			} else if (span->unused < unused_end) {
+				block = span->unused;
+				span->unused += span->block_size;
+			} else {
+				break;
+			}
+			*(void **)block = head;
+			head = block;
+			span->used++;
+			taken++;
+		}
+
+		if (span->used == span->capacity) {
+			_partial_list_remove(list, span);
+		}
+	}
+	list.blocks_out += taken;
+	list.lock.unlock();
+
+	*r_head = head;
+	return taken;
+}
+
+// Gives p_count blocks linked from p_head back to their spans.
+static void _give_blocks(uint32_t p_size_class, void *p_head, uint32_t p_count) {
+	SpanList &list = span_lists[p_size_class];
+	Span *empty_spans = nullptr;
+
+	list.lock.lock();
+	void *block = p_head;
+	while (block) {
+		void *next = *(void **)block;
+		Span *span = _get_span(block);
+		*(void **)block = span->free_list;
+		span->free_list = block;
+		span->used--;
+		if (span->used == 0) {
+			if (span->in_partial_list) {
+				_partial_list_remove(list, span);
+			}
+			list.span_count--;
+			span->next = empty_spans;
+			empty_spans = span;
+		} else if (!span->in_partial_list) {
+			_partial_list_add(list, span);
+		}
+		block = next;
+	}
+	list.blocks_out -= p_count;
+	list.lock.unlock();
+
+	while (empty_spans) {
+		Span *next = empty_spans->next;
+		_span_release(empty_spans);
+		empty_spans = next;
+	}
+}
+
+static ThreadCache *_create_thread_cache() {
+	void *memory = malloc(sizeof(ThreadCache));
+	if (!memory) {
+		return nullptr;
+	}
+	ThreadCache *cache = new (memory) ThreadCache;
+
+	thread_caches_lock.lock();
+	cache->next = thread_caches;
+	if (thread_caches) {
+		thread_caches->prev = cache;
+	}
+	thread_caches = cache;
+	thread_caches_lock.unlock();
+
+	// Registers the destructor giving the cache back when the thread exits.
+	thread_cache_releaser.active = true;
+	thread_cache = cache;
+	return cache;
+}
+
+ThreadCacheReleaser::~ThreadCacheReleaser() {
+	ThreadCache *cache = thread_cache;
+	if (!active || !cache) {
+		return;
+	}
+	ThreadCacheAllocator::flush_thread_cache();
+
+	thread_caches_lock.lock();
+	for (uint32_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+		exited_thread_allocations[i] += cache->lists[i].allocations.load(std::memory_order_relaxed);
+	}
+	if (cache->prev) {
+		cache->prev->next = cache->next;
+	} else {
+		thread_caches = cache->next;
+	}
+	if (cache->next) {
+		cache->next->prev = cache->prev;
+	}
+	thread_caches_lock.unlock();
+
+	cache->~ThreadCache();
+	::free(cache);
+	thread_cache = nullptr;
+	// Memory freed from now on, e.g. by other thread local destructors, goes straight to the spans.
+	thread_cache_released = true;
+}
+
+static _FORCE_INLINE_ ThreadCache *_get_thread_cache() {
+	ThreadCache *cache = thread_cache;
+	if (likely(cache) || thread_cache_released) {
+		return cache;
+	}
+	return _create_thread_cache();
+}
+
+static void *_alloc_large(size_t p_bytes) {
+	size_t size = SPAN_HEADER_SIZE + p_bytes;
+	Span *span = (Span *)_alloc_aligned(size);
+	if (!span) {
+		return nullptr;
+	}
+	span->size_class = LARGE_SIZE_CLASS;
+	span->block_size = 0;
+	span->size = size;
+
+	large_allocations.fetch_add(1, std::memory_order_relaxed);
+	large_blocks.fetch_add(1, std::memory_order_relaxed);
+	large_bytes.fetch_add(size, std::memory_order_relaxed);
+	return (uint8_t *)span + SPAN_HEADER_SIZE;
+}
+
+static void _free_large(Span *p_span) {
+	large_blocks.fetch_sub(1, std::memory_order_relaxed);
+	large_bytes.fetch_sub(p_span->size, std::memory_order_relaxed);
+	_free_aligned(p_span);
+}
+
+void *ThreadCacheAllocator::alloc(size_t p_bytes) {
+	if (unlikely(p_bytes > MAX_BLOCK_SIZE)) {
+		return _alloc_large(p_bytes);
+	}
+	uint32_t size_class = size_class_table.size_classes[p_bytes ? (p_bytes - 1) >> 4 : 0];
+
+	ThreadCache *cache = _get_thread_cache();
+	if (unlikely(!cache)) {
+		void *block = nullptr;
+		_take_blocks(size_class, 1, &block);
+		return block;
+	}
+
+	ThreadCache::FreeList &list = cache->lists[size_class];
+	uint32_t count = list.count.load(std::memory_order_relaxed);
+	if (unlikely(!list.head)) {
+		count = _take_blocks(size_class, size_class_table.batch_sizes[size_class], &list.head);
+		if (!count) {
+			return nullptr;
+		}
+	}
+
+	void *block = list.head;
+	list.head = *(void **)block;
+	list.count.store(count - 1, std::memory_order_relaxed);
+	list.allocations.store(list.allocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	return block;
+}
+
+void *ThreadCacheAllocator::realloc(void *p_memory, size_t p_bytes) {
+	if (!p_memory) {
+		return alloc(p_bytes);
+	}
+	if (p_bytes == 0) {
+		free(p_memory);
+		return nullptr;
+	}
+
+	// Stay in place unless the block becomes too small or less than half used.
+	size_t usable_size = get_usable_size(p_memory);
+	if (p_bytes <= usable_size && p_bytes >= usable_size / 2) {
+		return p_memory;
+	}
+
+	void *memory = alloc(p_bytes);
+	if (!memory) {
+		return nullptr;
+	}
+	memcpy(memory, p_memory, MIN(p_bytes, usable_size));
+	free(p_memory);
+	return memory;
+}
+
+void ThreadCacheAllocator::free(void *p_memory) {
+	Span *span = _get_span(p_memory);
+	uint32_t size_class = span->size_class;
+	if (unlikely(size_class == LARGE_SIZE_CLASS)) {
+		_free_large(span);
+		return;
+	}
+
+	ThreadCache *cache = _get_thread_cache();
+	if (unlikely(!cache)) {
+		*(void **)p_memory = nullptr;
+		_give_blocks(size_class, p_memory, 1);
+		return;
+	}
+
+	ThreadCache::FreeList &list = cache->lists[size_class];
+	*(void **)p_memory = list.head;
+	list.head = p_memory;
+	uint32_t count = list.count.load(std::memory_order_relaxed) + 1;
+
+	uint32_t batch_size = size_class_table.batch_sizes[size_class];
+	if (unlikely(count > batch_size * 2)) {
+		// Give the most recently freed blocks back, the older ones are less likely to be in the cache.
+		void *head = list.head;
+		void *last = head;
+		for (uint32_t i = 1; i < batch_size; i++) {
+			last = *(void **)last;
+		}
+		list.head = *(void **)last;
+		*(void **)last = nullptr;
+		count -= batch_size;
+		_give_blocks(size_class, head, batch_size);
+	}
+	list.count.store(count, std::memory_order_relaxed);
+}
+
+size_t ThreadCacheAllocator::get_usable_size(const void *p_memory) {
+	const Span *span = _get_span(p_memory);
+	if (span->size_class == LARGE_SIZE_CLASS) {
+		return span->size - SPAN_HEADER_SIZE;
+	}
+	return span->block_size;
+}
+
+void ThreadCacheAllocator::flush_thread_cache() {
+	ThreadCache *cache = thread_cache;
+	if (!cache) {
+		return;
+	}
+	for (uint32_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+		ThreadCache::FreeList &list = cache->lists[i];
+		if (list.head) {
+			_give_blocks(i, list.head, list.count.load(std::memory_order_relaxed));
+			list.head = nullptr;
+			list.count.store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+int ThreadCacheAllocator::get_size_class_count() {
+	return SIZE_CLASS_COUNT + 1;
+}
+
+ThreadCacheAllocator::SizeClassStats ThreadCacheAllocator::get_size_class_stats(int p_size_class) {
+	SizeClassStats stats;
+	ERR_FAIL_INDEX_V(p_size_class, (int)SIZE_CLASS_COUNT + 1, stats);
+
+	if (p_size_class == (int)LARGE_SIZE_CLASS) {
+		stats.allocations = large_allocations.load(std::memory_order_relaxed);
+		stats.blocks_in_use = large_blocks.load(std::memory_order_relaxed);
+		stats.bytes_reserved = large_bytes.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	stats.block_size = size_class_table.block_sizes[p_size_class];
+
+	SpanList &list = span_lists[p_size_class];
+	list.lock.lock();
+	uint64_t blocks_out = list.blocks_out;
+	stats.bytes_reserved = list.span_count * SPAN_SIZE;
+	list.lock.unlock();
+
+	thread_caches_lock.lock();
+	stats.allocations = exited_thread_allocations[p_size_class];
+	for (ThreadCache *cache = thread_caches; cache; cache = cache->next) {
+		stats.allocations += cache->lists[p_size_class].allocations.load(std::memory_order_relaxed);
+		stats.blocks_cached += cache->lists[p_size_class].count.load(std::memory_order_relaxed);
+	}
+	thread_caches_lock.unlock();
+
+	// Caches are read without stopping their threads, keep the estimate sane.
+	stats.blocks_in_use = blocks_out > stats.blocks_cached ? blocks_out - stats.blocks_cached : 0;
+	return stats;
+}
@@ -0,0 +1,71 @@
+/*************************************************************************/
+/*  thread_cache_allocator.h                                             */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef THREAD_CACHE_ALLOCATOR_H
+#define THREAD_CACHE_ALLOCATOR_H
+
+#include "core/typedefs.h"
+
+#include <stddef.h>
+
+/**
+ * General purpose allocator, used by Memory instead of malloc when built with builtin_allocator=yes.
+ *
+ * Blocks up to 8 KiB are rounded up to one of the size classes and carved from 64 KiB spans. Each
+ * thread keeps a cache of free blocks per size class, so most allocations and frees don't take any
+ * lock. Caches exchange blocks with the shared span lists in batches, and spans left without used
+ * blocks go back to a small pool shared by all size classes, then to the system.
+ *
+ * Larger allocations go straight to the system.
+ */
+class ThreadCacheAllocator {
+public:
+	struct SizeClassStats {
+		uint32_t block_size = 0; // 0 for the allocations too large for a size class.
+		uint64_t allocations = 0; // Since startup.
+		uint64_t blocks_in_use = 0;
+		uint64_t blocks_cached = 0; // Free, but held by a thread cache.
+		uint64_t bytes_reserved = 0;
+	};
+
+	static void *alloc(size_t p_bytes);
+	static void *realloc(void *p_memory, size_t p_bytes);
+	static void free(void *p_memory);
+	static size_t get_usable_size(const void *p_memory);
+
+	// Gives the free blocks cached by the calling thread back. Done automatically when a thread exits.
+	static void flush_thread_cache();
+
+	// The last one is for the allocations too large for a size class.
+	static int get_size_class_count();
+	static SizeClassStats get_size_class_stats(int p_size_class);
+};
+
+#endif // THREAD_CACHE_ALLOCATOR_H
@@ -1720,6 +1720,62 @@ CharString String::ascii(bool p_allow_extended) const {
 	return cs;
 }
 
+// Transcoding fast paths. Most text is ASCII, or at least has long runs of it, so runs of
+// characters that encode to a single unit are measured in chunks of 8 and then copied in
+// plain loops the compiler can vectorize. Runs shorter than a chunk, common in other
+// languages, are measured one character at a time.
+
+// Length of the run of ASCII bytes at the start of p_str.
+static _FORCE_INLINE_ int _ascii_run_length(const char *p_str, int p_len) {
+	int i = 0;
+	int short_len = MIN(p_len, 8);
+	while (i < short_len && (p_str[i] & 0x80) == 0) {
+		i++;
+	}
+	if (i < 8) {
+		return i;
+	}
+
+	for (; i + 8 <= p_len; i += 8) {
+		uint64_t chunk;
+		memcpy(&chunk, p_str + i, sizeof(chunk));
+		if (chunk & 0x8080808080808080ULL) {
+			break;
+		}
+	}
+	while (i < p_len && (p_str[i] & 0x80) == 0) {
+		i++;
+	}
+	return i;
+}
+
+// Length of the run of characters below p_limit at the start of p_str.
+template <class C>
+static _FORCE_INLINE_ int _run_length_below(const C *p_str, int p_len, uint32_t p_limit) {
+	int i = 0;
+	int short_len = MIN(p_len, 8);
+	while (i < short_len && uint32_t(p_str[i]) < p_limit) {
+		i++;
+	}
+	if (i < 8) {
+		return i;
+	}
+
+	for (; i + 8 <= p_len; i += 8) {
+		uint32_t max = 0;
+		for (int j = 0; j < 8; j++) {
+			max = MAX(max, uint32_t(p_str[i + j]));
+		}
+		if (max >= p_limit) {
+			break;
+		}
+	}
+	while (i < p_len && uint32_t(p_str[i]) < p_limit) {
+		i++;
+	}
+	return i;
+}
+
 String String::utf8(const char *p_utf8, int p_len) {
 	String ret;
 	ret.parse_utf8(p_utf8, p_len);
@@ -1751,17 +1807,31 @@ bool String::parse_utf8(const char *p_utf8, int p_len) {
 		}
 	}
 
+	// Stop at the first null character, whether the length is given or not.
+	if (p_len < 0) {
+		p_len = strlen(p_utf8);
+	} else {
+		const char *null_char = (const char *)memchr(p_utf8, 0, p_len);
+		if (null_char) {
+			p_len = null_char - p_utf8;
+		}
+	}
+
 	{
 		const char *ptrtmp = p_utf8;
 		const char *ptrtmp_limit = &p_utf8[p_len];
 		int skip = 0;
-		while (ptrtmp != ptrtmp_limit && *ptrtmp) {
+		while (ptrtmp != ptrtmp_limit) {
 			if (skip == 0) {
 				uint8_t c = *ptrtmp >= 0 ? *ptrtmp : uint8_t(256 + *ptrtmp);
 
 				/* Determine the number of characters in sequence */
 				if ((c & 0x80) == 0) {
-					skip = 0;
+					int ascii = _ascii_run_length(ptrtmp, ptrtmp_limit - ptrtmp);
+					str_size += ascii;
+					cstr_size += ascii;
+					ptrtmp += ascii;
+					continue;
 				} else if ((c & 0xe0) == 0xc0) {
 					skip = 1;
 				} else if ((c & 0xf0) == 0xe0) {
@@ -1808,7 +1878,14 @@ bool String::parse_utf8(const char *p_utf8, int p_len) {
 
 		/* Determine the number of characters in sequence */
 		if ((*p_utf8 & 0x80) == 0) {
-			len = 1;
+			int ascii = _ascii_run_length(p_utf8, cstr_size);
+			for (int i = 0; i < ascii; i++) {
+				dst[i] = p_utf8[i];
+			}
+			dst += ascii;
+			cstr_size -= ascii;
+			p_utf8 += ascii;
+			continue;
 		} else if ((*p_utf8 & 0xe0) == 0xc0) {
 			len = 2;
 		} else if ((*p_utf8 & 0xf0) == 0xe0) {
@@ -1872,8 +1949,10 @@ CharString String::utf8() const {
 	}
 
 	const char32_t *d = &operator[](0);
-	int fl = 0;
-	for (int i = 0; i < l; i++) {
+	// Leading ASCII, often the whole string.
+	int ascii = _run_length_below(d, l, 0x80);
+	int fl = ascii;
+	for (int i = ascii; i < l; i++) {
 		uint32_t c = d[i];
 		if (c <= 0x7f) { // 7 bits.
 			fl += 1;
@@ -1903,7 +1982,12 @@ CharString String::utf8() const {
 
 #define APPEND_CHAR(m_c) *(cdst++) = m_c
 
-	for (int i = 0; i < l; i++) {
+	for (int i = 0; i < ascii; i++) {
+		cdst[i] = d[i];
+	}
+	cdst += ascii;
+
+	for (int i = ascii; i < l; i++) {
 		uint32_t c = d[i];
 
 		if (c <= 0x7f) { // 7 bits.
@@ -1966,14 +2050,27 @@ bool String::parse_utf16(const char16_t *p_utf16, int p_len) {
 		}
 	}
 
+	// Stop at the first null character, whether the length is given or not.
+	int null_char = 0;
+	while (null_char != p_len && p_utf16[null_char]) {
+		null_char++;
+	}
+	p_len = null_char;
+
 	{
 		const char16_t *ptrtmp = p_utf16;
 		const char16_t *ptrtmp_limit = &p_utf16[p_len];
 		int skip = 0;
-		while (ptrtmp != ptrtmp_limit && *ptrtmp) {
+		while (ptrtmp != ptrtmp_limit) {
 			uint32_t c = (byteswap) ? BSWAP16(*ptrtmp) : *ptrtmp;
 			if (skip == 0) {
-				if ((c & 0xfffffc00) == 0xd800) {
+				if (!byteswap && c < 0xd800) {
+					int run = _run_length_below(ptrtmp, ptrtmp_limit - ptrtmp, 0xd800);
+					str_size += run;
+					cstr_size += run;
+					ptrtmp += run;
+					continue;
+				} else if ((c & 0xfffffc00) == 0xd800) {
 					skip = 1; // lead surrogate
 				} else if ((c & 0xfffffc00) == 0xdc00) {
 					_UNICERROR("invalid utf16 surrogate at " + num_int64(cstr_size));
@@ -2014,7 +2111,16 @@ bool String::parse_utf16(const char16_t *p_utf16, int p_len) {
 		int len = 0;
 		uint32_t c = (byteswap) ? BSWAP16(*p_utf16) : *p_utf16;
 
-		if ((c & 0xfffffc00) == 0xd800) {
+		if (!byteswap && c < 0xd800) {
+			int run = _run_length_below(p_utf16, cstr_size, 0xd800);
+			for (int i = 0; i < run; i++) {
+				dst[i] = p_utf16[i];
+			}
+			dst += run;
+			cstr_size -= run;
+			p_utf16 += run;
+			continue;
+		} else if ((c & 0xfffffc00) == 0xd800) {
 			len = 2;
 		} else {
 			len = 1;
@@ -2052,7 +2158,12 @@ Char16String String::utf16() const {
 	int fl = 0;
 	for (int i = 0; i < l; i++) {
 		uint32_t c = d[i];
-		if (c <= 0xffff) { // 16 bits.
+		if (c < 0xd800) { // 16 bits, below the surrogates.
+			int run = _run_length_below(d + i, l - i, 0xd800);
+			fl += run;
+			i += run - 1;
+			continue;
+		} else if (c <= 0xffff) { // 16 bits.
 			fl += 1;
 		} else if (c <= 0x10ffff) { // 32 bits.
 			fl += 2;
@@ -2079,7 +2190,14 @@ Char16String String::utf16() const {
 	for (int i = 0; i < l; i++) {
 		uint32_t c = d[i];
 
-		if (c <= 0xffff) { // 16 bits.
+		if (c < 0xd800) { // 16 bits, below the surrogates.
+			int run = _run_length_below(d + i, l - i, 0xd800);
+			for (int j = 0; j < run; j++) {
+				cdst[j] = d[i + j];
+			}
+			cdst += run;
+			i += run - 1;
+		} else if (c <= 0xffff) { // 16 bits.
 			APPEND_CHAR(c);
 		} else { // 32 bits.
 			APPEND_CHAR(uint32_t((c >> 10) + 0xd7c0)); // lead surrogate.
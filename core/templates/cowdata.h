@@ -66,6 +66,9 @@ class CowData {
 	friend class VMap;
 
 private:
+	// Smallest buffer allocated, so short strings and vectors of a few elements grow without reallocating.
+	static constexpr size_t SMALL_BUFFER_SIZE = 32;
+
 	mutable T *_ptr = nullptr;
 
 	// internal helpers
@@ -94,7 +97,7 @@ private:
 	}
 
 	_FORCE_INLINE_ size_t _get_alloc_size(size_t p_elements) const {
-		return next_power_of_2(p_elements * sizeof(T));
+		return MAX(next_power_of_2(p_elements * sizeof(T)), SMALL_BUFFER_SIZE);
 	}
 
 	_FORCE_INLINE_ bool _get_alloc_size_checked(size_t p_elements, size_t *out) const {
@@ -105,7 +108,7 @@ private:
 			*out = 0;
 			return false;
 		}
-		*out = next_power_of_2(o);
+		*out = MAX(next_power_of_2(o), SMALL_BUFFER_SIZE);
 		if (__builtin_add_overflow(o, static_cast<size_t>(32), &p)) {
 			return false; // No longer allocated here.
 		}
@@ -121,6 +124,7 @@ private:
 	void _unref(void *p_data);
 	void _ref(const CowData *p_from);
 	void _ref(const CowData &p_from);
+	bool _copy_to_new_buffer(size_t p_alloc_size, uint32_t p_count);
 	uint32_t _copy_on_write();
 
 public:
@@ -223,6 +227,32 @@ void CowData<T>::_unref(void *p_data) {
 	Memory::free_static((uint8_t *)p_data, true);
 }
 
+template <class T>
+bool CowData<T>::_copy_to_new_buffer(size_t p_alloc_size, uint32_t p_count) {
+	uint32_t *mem_new = (uint32_t *)Memory::alloc_static(p_alloc_size, true);
+	ERR_FAIL_COND_V(!mem_new, false);
+
+	new (mem_new - 2) SafeNumeric<uint32_t>(1); //refcount
+	*(mem_new - 1) = p_count; //size
+
+	T *_data = (T *)(mem_new);
+
+	// initialize new elements
+	if (__has_trivial_copy(T)) {
+		memcpy(mem_new, _ptr, p_count * sizeof(T));
+
+	} else {
+		for (uint32_t i = 0; i < p_count; i++) {
+			memnew_placement(&_data[i], T(_get_data()[i]));
+		}
+	}
+
+	_unref(_ptr);
+	_ptr = _data;
+
+	return true;
+}
+
 template <class T>
 uint32_t CowData<T>::_copy_on_write() {
 	if (!_ptr) {
@@ -236,25 +266,7 @@ uint32_t CowData<T>::_copy_on_write() {
 		/* in use by more than me */
 		uint32_t current_size = *_get_size();
 
-		uint32_t *mem_new = (uint32_t *)Memory::alloc_static(_get_alloc_size(current_size), true);
-
-		new (mem_new - 2) SafeNumeric<uint32_t>(1); //refcount
-		*(mem_new - 1) = current_size; //size
-
-		T *_data = (T *)(mem_new);
-
-		// initialize new elements
-		if (__has_trivial_copy(T)) {
-			memcpy(mem_new, _ptr, current_size * sizeof(T));
-
-		} else {
-			for (uint32_t i = 0; i < current_size; i++) {
-				memnew_placement(&_data[i], T(_get_data()[i]));
-			}
-		}
-
-		_unref(_ptr);
-		_ptr = _data;
+		ERR_FAIL_COND_V(!_copy_to_new_buffer(_get_alloc_size(current_size), current_size), rc);
 
 		rc = 1;
 	}
@@ -278,33 +290,45 @@ Error CowData<T>::resize(int p_size) {
 		return OK;
 	}
 
-	// possibly changing size, copy on write
-	uint32_t rc = _copy_on_write();
-
 	size_t current_alloc_size = _get_alloc_size(current_size);
 	size_t alloc_size;
 	ERR_FAIL_COND_V(!_get_alloc_size_checked(p_size, &alloc_size), ERR_OUT_OF_MEMORY);
 
-	if (p_size > current_size) {
-		if (alloc_size != current_alloc_size) {
-			if (current_size == 0) {
-				// alloc from scratch
-				uint32_t *ptr = (uint32_t *)Memory::alloc_static(alloc_size, true);
-				ERR_FAIL_COND_V(!ptr, ERR_OUT_OF_MEMORY);
-				*(ptr - 1) = 0; //size, currently none
-				new (ptr - 2) SafeNumeric<uint32_t>(1); //refcount
-
-				_ptr = (T *)ptr;
+	if (current_size == 0) {
+		// alloc from scratch
+		uint32_t *ptr = (uint32_t *)Memory::alloc_static(alloc_size, true);
+		ERR_FAIL_COND_V(!ptr, ERR_OUT_OF_MEMORY);
+		*(ptr - 1) = 0; //size, currently none
+		new (ptr - 2) SafeNumeric<uint32_t>(1); //refcount
+
+		_ptr = (T *)ptr;
+
+	} else if (_get_refcount()->get() > 1) {
+		// In use by more than me, copy what is kept straight into a buffer of the new size,
+		// rather than copying everything and reallocating after.
+		ERR_FAIL_COND_V(!_copy_to_new_buffer(alloc_size, MIN(current_size, p_size)), ERR_OUT_OF_MEMORY);
+
+	} else {
+		if (p_size < current_size) {
+			if (!__has_trivial_destructor(T)) {
+				// deinitialize no longer needed elements
+				for (uint32_t i = p_size; i < *_get_size(); i++) {
+					T *t = &_get_data()[i];
+					t->~T();
+				}
+			}
+			*_get_size() = p_size;
+		}
 
-			} else {
-				uint32_t *_ptrnew = (uint32_t *)Memory::realloc_static(_ptr, alloc_size, true);
-				ERR_FAIL_COND_V(!_ptrnew, ERR_OUT_OF_MEMORY);
-				new (_ptrnew - 2) SafeNumeric<uint32_t>(rc); //refcount
+		if (alloc_size != current_alloc_size) {
+			uint32_t *_ptrnew = (uint32_t *)Memory::realloc_static(_ptr, alloc_size, true);
+			ERR_FAIL_COND_V(!_ptrnew, ERR_OUT_OF_MEMORY);
 
-				_ptr = (T *)(_ptrnew);
-			}
+			_ptr = (T *)(_ptrnew);
 		}
+	}
 
+	if (p_size > current_size) {
 		// construct the newly created elements
 
 		if (!__has_trivial_constructor(T)) {
@@ -315,25 +339,6 @@ Error CowData<T>::resize(int p_size) {
 			}
 		}
 
-		*_get_size() = p_size;
-
-	} else if (p_size < current_size) {
-		if (!__has_trivial_destructor(T)) {
-			// deinitialize no longer needed elements
-			for (uint32_t i = p_size; i < *_get_size(); i++) {
-				T *t = &_get_data()[i];
-				t->~T();
-			}
-		}
-
-		if (alloc_size != current_alloc_size) {
-			uint32_t *_ptrnew = (uint32_t *)Memory::realloc_static(_ptr, alloc_size, true);
-			ERR_FAIL_COND_V(!_ptrnew, ERR_OUT_OF_MEMORY);
-			new (_ptrnew - 2) SafeNumeric<uint32_t>(rc); //refcount
-
-			_ptr = (T *)(_ptrnew);
-		}
-
 		*_get_size() = p_size;
 	}
 
@@ -45,13 +45,19 @@
  * Implementation of a standard Hashing HashMap, for quick lookups of Data associated with a Key.
  * The implementation provides hashers for the default types, if you need a special kind of hasher, provide
  * your own.
+ *
+ * The table uses open addressing with Robin Hood hashing and backward shift deletion (like OAHashMap).
+ * It only stores the hashes and pointers to the elements, so probing reads two flat arrays and a key is
+ * only compared when its hash matches. Elements are allocated on their own, so pointers to them (and to
+ * their keys and data) stay valid until they are erased, and are linked in insertion order: iterating
+ * doesn't touch the table and the order doesn't change when it grows.
+ *
  * @param TKey  Key, search is based on it, needs to be hasheable. It is unique in this container.
  * @param TData Data, data associated with the key
  * @param Hasher Hasher object, needs to provide a valid static hash function for TKey
  * @param Comparator comparator object, needs to be able to safely compare two TKey values. It needs to ensure that x == x for any items inserted in the map. Bear in mind that nan != nan when implementing an equality check.
  * @param MIN_HASH_TABLE_POWER Miminum size of the hash table, as a power of two. You rarely need to change this parameter.
- * @param RELATIONSHIP Relationship at which the hash table is resized. if amount of elements is RELATIONSHIP
- * times bigger than the hash table, table is resized to solve this condition. if RELATIONSHIP is zero, table is always MIN_HASH_TABLE_POWER.
+ * @param RELATIONSHIP Unused since the table went open addressing, it grows whenever it is 3/4 full. Kept so existing declarations compile.
  *
 */
 
@@ -75,8 +81,8 @@ public:
 	private:
 		friend class HashMap;
 
-		uint32_t hash = 0;
-		Element *next = nullptr;
+		Element *next_element = nullptr;
+		Element *prev_element = nullptr;
 		Element() {}
 		Pair pair;
 
@@ -90,127 +96,169 @@ public:
 		}
 
 		const TData &value() const {
-			return pair.value();
+			return pair.data;
+		}
+
+		// Next element in insertion order.
+		Element *next() {
+			return next_element;
+		}
+
+		const Element *next() const {
+			return next_element;
 		}
 
 		Element(const TKey &p_key) :
 				pair(p_key) {}
+		Element(const Pair &p_pair) :
+				pair(p_pair.key, p_pair.data) {}
 		Element(const Element &p_other) :
-				hash(p_other.hash),
 				pair(p_other.pair.key, p_other.pair.data) {}
 	};
 
 private:
-	Element **hash_table = nullptr;
+	static const uint32_t EMPTY_HASH = 0;
+
+	uint32_t *hashes = nullptr;
+	Element **elements = nullptr;
 	uint8_t hash_table_power = 0;
-	uint32_t elements = 0;
+	uint32_t num_elements = 0;
 
-	void make_hash_table() {
-		ERR_FAIL_COND(hash_table);
+	Element *head_element = nullptr;
+	Element *tail_element = nullptr;
 
-		hash_table = memnew_arr(Element *, (1 << MIN_HASH_TABLE_POWER));
+	_FORCE_INLINE_ static uint32_t _hash(const TKey &p_key) {
+		uint32_t hash = Hasher::hash(p_key);
 
-		hash_table_power = MIN_HASH_TABLE_POWER;
-		elements = 0;
-		for (int i = 0; i < (1 << MIN_HASH_TABLE_POWER); i++) {
-			hash_table[i] = nullptr;
+		if (hash == EMPTY_HASH) {
+			hash = EMPTY_HASH + 1;
 		}
+
+		return hash;
 	}
 
-	void erase_hash_table() {
-		ERR_FAIL_COND_MSG(elements, "Cannot erase hash table if there are still elements inside.");
+	// Fibonacci hashing, so hashers returning the key as is (integers) don't pile up in a few runs of slots.
+	_FORCE_INLINE_ uint32_t _get_home_pos(uint32_t p_hash) const {
+		return (p_hash * 2654435769u) >> (32 - hash_table_power);
+	}
 
-		memdelete_arr(hash_table);
-		hash_table = nullptr;
-		hash_table_power = 0;
-		elements = 0;
+	_FORCE_INLINE_ uint32_t _get_probe_length(uint32_t p_pos, uint32_t p_hash) const {
+		uint32_t mask = (1 << hash_table_power) - 1;
+		return (p_pos - _get_home_pos(p_hash)) & mask;
 	}
 
-	void check_hash_table() {
-		int new_hash_table_power = -1;
+	template <class C>
+	_FORCE_INLINE_ Element *_lookup(const C &p_key, uint32_t p_hash) const {
+		if (unlikely(!hashes)) {
+			return nullptr;
+		}
 
-		if ((int)elements > ((1 << hash_table_power) * RELATIONSHIP)) {
-			/* rehash up */
-			new_hash_table_power = hash_table_power + 1;
+		uint32_t mask = (1 << hash_table_power) - 1;
+		uint32_t pos = _get_home_pos(p_hash);
+		uint32_t distance = 0;
 
-			while ((int)elements > ((1 << new_hash_table_power) * RELATIONSHIP)) {
-				new_hash_table_power++;
+		while (true) {
+			uint32_t hash = hashes[pos];
+			if (hash == EMPTY_HASH) {
+				return nullptr;
 			}
 
-		} else if ((hash_table_power > (int)MIN_HASH_TABLE_POWER) && ((int)elements < ((1 << (hash_table_power - 1)) * RELATIONSHIP))) {
-			/* rehash down */
-			new_hash_table_power = hash_table_power - 1;
-
-			while ((int)elements < ((1 << (new_hash_table_power - 1)) * RELATIONSHIP)) {
-				new_hash_table_power--;
+			// Robin Hood: the key would have taken this slot if it was in the table.
+			if (distance > _get_probe_length(pos, hash)) {
+				return nullptr;
 			}
 
-			if (new_hash_table_power < (int)MIN_HASH_TABLE_POWER) {
-				new_hash_table_power = MIN_HASH_TABLE_POWER;
+			/* checking hash first avoids comparing key, which may take longer */
+			if (hash == p_hash && Comparator::compare(elements[pos]->pair.key, p_key)) {
+				return elements[pos];
 			}
-		}
 
-		if (new_hash_table_power == -1) {
-			return;
+			pos = (pos + 1) & mask;
+			distance++;
 		}
+	}
 
-		Element **new_hash_table = memnew_arr(Element *, ((uint64_t)1 << new_hash_table_power));
-		ERR_FAIL_COND_MSG(!new_hash_table, "Out of memory.");
-
-		for (int i = 0; i < (1 << new_hash_table_power); i++) {
-			new_hash_table[i] = nullptr;
-		}
+	void _insert_with_hash(uint32_t p_hash, Element *p_element) {
+		uint32_t mask = (1 << hash_table_power) - 1;
+		uint32_t hash = p_hash;
+		Element *element = p_element;
+		uint32_t pos = _get_home_pos(hash);
+		uint32_t distance = 0;
+
+		while (true) {
+			if (hashes[pos] == EMPTY_HASH) {
+				hashes[pos] = hash;
+				elements[pos] = element;
+				return;
+			}
 
-		if (hash_table) {
-			for (int i = 0; i < (1 << hash_table_power); i++) {
-				while (hash_table[i]) {
-					Element *se = hash_table[i];
-					hash_table[i] = se->next;
-					int new_pos = se->hash & ((1 << new_hash_table_power) - 1);
-					se->next = new_hash_table[new_pos];
-					new_hash_table[new_pos] = se;
-				}
+			// Not an existing key (checked by the caller), steal the slot from a richer entry.
+			uint32_t existing_probe_len = _get_probe_length(pos, hashes[pos]);
+			if (existing_probe_len < distance) {
+				SWAP(hash, hashes[pos]);
+				SWAP(element, elements[pos]);
+				distance = existing_probe_len;
 			}
 
-			memdelete_arr(hash_table);
+			pos = (pos + 1) & mask;
+			distance++;
 		}
-		hash_table = new_hash_table;
-		hash_table_power = new_hash_table_power;
 	}
 
-	/* I want to have only one function.. */
-	_FORCE_INLINE_ const Element *get_element(const TKey &p_key) const {
-		uint32_t hash = Hasher::hash(p_key);
-		uint32_t index = hash & ((1 << hash_table_power) - 1);
+	void _resize_and_rehash(uint8_t p_new_power) {
+		uint32_t *old_hashes = hashes;
+		Element **old_elements = elements;
+		uint32_t old_capacity = hashes ? (1 << hash_table_power) : 0;
 
-		Element *e = hash_table[index];
+		uint32_t capacity = 1 << p_new_power;
+		hash_table_power = p_new_power;
+		hashes = static_cast<uint32_t *>(Memory::alloc_static(sizeof(uint32_t) * capacity));
+		elements = static_cast<Element **>(Memory::alloc_static(sizeof(Element *) * capacity));
+		for (uint32_t i = 0; i < capacity; i++) {
+			hashes[i] = EMPTY_HASH;
+		}
 
-		while (e) {
-			/* checking hash first avoids comparing key, which may take longer */
-			if (e->hash == hash && Comparator::compare(e->pair.key, p_key)) {
-				/* the pair exists in this hashtable, so just update data */
-				return e;
+		for (uint32_t i = 0; i < old_capacity; i++) {
+			if (old_hashes[i] != EMPTY_HASH) {
+				_insert_with_hash(old_hashes[i], old_elements[i]);
 			}
+		}
 
-			e = e->next;
+		if (old_hashes) {
+			Memory::free_static(old_hashes);
+			Memory::free_static(old_elements);
 		}
+	}
 
-		return nullptr;
+	void _free_table() {
+		if (hashes) {
+			Memory::free_static(hashes);
+			Memory::free_static(elements);
+		}
+		hashes = nullptr;
+		elements = nullptr;
+		hash_table_power = 0;
 	}
 
-	Element *create_element(const TKey &p_key) {
-		/* if element doesn't exist, create it */
-		Element *e = memnew(Element(p_key));
-		ERR_FAIL_COND_V_MSG(!e, nullptr, "Out of memory.");
-		uint32_t hash = Hasher::hash(p_key);
-		uint32_t index = hash & ((1 << hash_table_power) - 1);
-		e->next = hash_table[index];
-		e->hash = hash;
+	Element *_create_element(Element *p_element) {
+		if (!hashes) {
+			_resize_and_rehash(MIN_HASH_TABLE_POWER);
+		} else if ((num_elements + 1) * 4 > (3u << hash_table_power)) {
+			_resize_and_rehash(hash_table_power + 1);
+		}
+
+		if (tail_element) {
+			tail_element->next_element = p_element;
+			p_element->prev_element = tail_element;
+		} else {
+			head_element = p_element;
+		}
+		tail_element = p_element;
 
-		hash_table[index] = e;
-		elements++;
+		_insert_with_hash(_hash(p_element->pair.key), p_element);
+		num_elements++;
 
-		return e;
+		return p_element;
 	}
 
 	void copy_from(const HashMap &p_t) {
@@ -220,28 +268,13 @@ private:
 
 		clear();
 
-		if (!p_t.hash_table || p_t.hash_table_power == 0) {
+		if (!p_t.hashes) {
 			return; /* not copying from empty table */
 		}
 
-		hash_table = memnew_arr(Element *, (uint64_t)1 << p_t.hash_table_power);
-		hash_table_power = p_t.hash_table_power;
-		elements = p_t.elements;
-
-		for (int i = 0; i < (1 << p_t.hash_table_power); i++) {
-			hash_table[i] = nullptr;
-
-			const Element *e = p_t.hash_table[i];
-
-			while (e) {
-				Element *le = memnew(Element(*e)); /* local element */
-
-				/* add to list and reassign pointers */
-				le->next = hash_table[i];
-				hash_table[i] = le;
-
-				e = e->next;
-			}
+		_resize_and_rehash(p_t.hash_table_power);
+		for (const Element *e = p_t.head_element; e; e = e->next_element) {
+			_create_element(memnew(Element(*e)));
 		}
 	}
 
@@ -251,25 +284,13 @@ public:
 	}
 
 	Element *set(const Pair &p_pair) {
-		Element *e = nullptr;
-		if (!hash_table) {
-			make_hash_table(); // if no table, make one
-		} else {
-			e = const_cast<Element *>(get_element(p_pair.key));
-		}
-
-		/* if we made it up to here, the pair doesn't exist, create and assign */
-
-		if (!e) {
-			e = create_element(p_pair.key);
-			if (!e) {
-				return nullptr;
-			}
-			check_hash_table(); // perform mantenience routine
+		Element *e = _lookup(p_pair.key, _hash(p_pair.key));
+		if (e) {
+			e->pair.data = p_pair.data;
+			return e;
 		}
 
-		e->pair.data = p_pair.data;
-		return e;
+		return _create_element(memnew(Element(p_pair)));
 	}
 
 	bool has(const TKey &p_key) const {
@@ -300,31 +321,21 @@ public:
 	 */
 
 	_FORCE_INLINE_ TData *getptr(const TKey &p_key) {
-		if (unlikely(!hash_table)) {
+		if (unlikely(!hashes)) {
 			return nullptr;
 		}
 
-		Element *e = const_cast<Element *>(get_element(p_key));
-
-		if (e) {
-			return &e->pair.data;
-		}
-
-		return nullptr;
+		Element *e = _lookup(p_key, _hash(p_key));
+		return e ? &e->pair.data : nullptr;
 	}
 
 	_FORCE_INLINE_ const TData *getptr(const TKey &p_key) const {
-		if (unlikely(!hash_table)) {
+		if (unlikely(!hashes)) {
 			return nullptr;
 		}
 
-		const Element *e = const_cast<Element *>(get_element(p_key));
-
-		if (e) {
-			return &e->pair.data;
-		}
-
-		return nullptr;
+		const Element *e = _lookup(p_key, _hash(p_key));
+		return e ? &e->pair.data : nullptr;
 	}
 
 	/**
@@ -334,50 +345,14 @@ public:
 
 	template <class C>
 	_FORCE_INLINE_ TData *custom_getptr(C p_custom_key, uint32_t p_custom_hash) {
-		if (unlikely(!hash_table)) {
-			return nullptr;
-		}
-
-		uint32_t hash = p_custom_hash;
-		uint32_t index = hash & ((1 << hash_table_power) - 1);
-
-		Element *e = hash_table[index];
-
-		while (e) {
-			/* checking hash first avoids comparing key, which may take longer */
-			if (e->hash == hash && Comparator::compare(e->pair.key, p_custom_key)) {
-				/* the pair exists in this hashtable, so just update data */
-				return &e->pair.data;
-			}
-
-			e = e->next;
-		}
-
-		return nullptr;
+		Element *e = _lookup(p_custom_key, p_custom_hash == EMPTY_HASH ? EMPTY_HASH + 1 : p_custom_hash);
+		return e ? &e->pair.data : nullptr;
 	}
 
 	template <class C>
 	_FORCE_INLINE_ const TData *custom_getptr(C p_custom_key, uint32_t p_custom_hash) const {
-		if (unlikely(!hash_table)) {
-			return nullptr;
-		}
-
-		uint32_t hash = p_custom_hash;
-		uint32_t index = hash & ((1 << hash_table_power) - 1);
-
-		const Element *e = hash_table[index];
-
-		while (e) {
-			/* checking hash first avoids comparing key, which may take longer */
-			if (e->hash == hash && Comparator::compare(e->pair.key, p_custom_key)) {
-				/* the pair exists in this hashtable, so just update data */
-				return &e->pair.data;
-			}
-
-			e = e->next;
-		}
-
-		return nullptr;
+		const Element *e = _lookup(p_custom_key, p_custom_hash == EMPTY_HASH ? EMPTY_HASH + 1 : p_custom_hash);
+		return e ? &e->pair.data : nullptr;
 	}
 
 	/**
@@ -385,41 +360,57 @@ public:
 	 */
 
 	bool erase(const TKey &p_key) {
-		if (unlikely(!hash_table)) {
+		if (unlikely(!hashes)) {
 			return false;
 		}
 
-		uint32_t hash = Hasher::hash(p_key);
-		uint32_t index = hash & ((1 << hash_table_power) - 1);
+		uint32_t hash = _hash(p_key);
+		uint32_t mask = (1 << hash_table_power) - 1;
+		uint32_t pos = _get_home_pos(hash);
+		uint32_t distance = 0;
 
-		Element *e = hash_table[index];
-		Element *p = nullptr;
-		while (e) {
-			/* checking hash first avoids comparing key, which may take longer */
-			if (e->hash == hash && Comparator::compare(e->pair.key, p_key)) {
-				if (p) {
-					p->next = e->next;
-				} else {
-					//begin of list
-					hash_table[index] = e->next;
-				}
-
-				memdelete(e);
-				elements--;
-
-				if (elements == 0) {
-					erase_hash_table();
-				} else {
-					check_hash_table();
-				}
-				return true;
+		while (true) {
+			if (hashes[pos] == EMPTY_HASH || distance > _get_probe_length(pos, hashes[pos])) {
+				return false;
+			}
+			if (hashes[pos] == hash && Comparator::compare(elements[pos]->pair.key, p_key)) {
+				break;
 			}
+			pos = (pos + 1) & mask;
+			distance++;
+		}
+
+		Element *e = elements[pos];
+
+		// Backward shift, so lookups never need tombstones.
+		uint32_t next_pos = (pos + 1) & mask;
+		while (hashes[next_pos] != EMPTY_HASH && _get_probe_length(next_pos, hashes[next_pos]) != 0) {
+			hashes[pos] = hashes[next_pos];
+			elements[pos] = elements[next_pos];
+			pos = next_pos;
+			next_pos = (next_pos + 1) & mask;
+		}
+		hashes[pos] = EMPTY_HASH;
+
+		if (e->prev_element) {
+			e->prev_element->next_element = e->next_element;
+		} else {
+			head_element = e->next_element;
+		}
+		if (e->next_element) {
+			e->next_element->prev_element = e->prev_element;
+		} else {
+			tail_element = e->prev_element;
+		}
 
-			p = e;
-			e = e->next;
+		memdelete(e);
+		num_elements--;
+
+		if (num_elements == 0) {
+			_free_table();
 		}
 
-		return false;
+		return true;
 	}
 
 	inline const TData &operator[](const TKey &p_key) const { //constref
@@ -428,18 +419,11 @@ public:
 	}
 	inline TData &operator[](const TKey &p_key) { //assignment
 
-		Element *e = nullptr;
-		if (!hash_table) {
-			make_hash_table(); // if no table, make one
-		} else {
-			e = const_cast<Element *>(get_element(p_key));
-		}
+		Element *e = _lookup(p_key, _hash(p_key));
 
 		/* if we made it up to here, the pair doesn't exist, create */
 		if (!e) {
-			e = create_element(p_key);
-			CRASH_COND(!e);
-			check_hash_table(); // perform mantenience routine
+			e = _create_element(memnew(Element(p_key)));
 		}
 
 		return e->pair.data;
@@ -448,6 +432,7 @@ public:
 	/**
 	 * Get the next key to p_key, and the first key if p_key is null.
 	 * Returns a pointer to the next key if found, nullptr otherwise.
+	 * Keys are visited in insertion order.
 	 * Adding/Removing elements while iterating will, of course, have unexpected results, don't do it.
 	 *
 	 * Example:
@@ -458,70 +443,48 @@ public:
 	 *
 	 * 		print( *k );
 	 * 	}
-         *
+	 *
+	 * Walking the elements from front() doesn't need a lookup per step.
 	*/
 	const TKey *next(const TKey *p_key) const {
-		if (unlikely(!hash_table)) {
-			return nullptr;
-		}
-
 		if (!p_key) { /* get the first key */
+			return head_element ? &head_element->pair.key : nullptr;
+		}
 
-			for (int i = 0; i < (1 << hash_table_power); i++) {
-				if (hash_table[i]) {
-					return &hash_table[i]->pair.key;
-				}
-			}
-
-		} else { /* get the next key */
-
-			const Element *e = get_element(*p_key);
-			ERR_FAIL_COND_V_MSG(!e, nullptr, "Invalid key supplied.");
-			if (e->next) {
-				/* if there is a "next" in the list, return that */
-				return &e->next->pair.key;
-			} else {
-				/* go to next elements */
-				uint32_t index = e->hash & ((1 << hash_table_power) - 1);
-				index++;
-				for (int i = index; i < (1 << hash_table_power); i++) {
-					if (hash_table[i]) {
-						return &hash_table[i]->pair.key;
-					}
-				}
-			}
+		const Element *e = _lookup(*p_key, _hash(*p_key));
+		ERR_FAIL_COND_V_MSG(!e, nullptr, "Invalid key supplied.");
+		return e->next_element ? &e->next_element->pair.key : nullptr;
+	}
 
-			/* nothing found, was at end */
-		}
+	Element *front() {
+		return head_element;
+	}
 
-		return nullptr; /* nothing found */
+	const Element *front() const {
+		return head_element;
 	}
 
 	inline unsigned int size() const {
-		return elements;
+		return num_elements;
 	}
 
 	inline bool is_empty() const {
-		return elements == 0;
+		return num_elements == 0;
 	}
 
 	void clear() {
 		/* clean up */
-		if (hash_table) {
-			for (int i = 0; i < (1 << hash_table_power); i++) {
-				while (hash_table[i]) {
-					Element *e = hash_table[i];
-					hash_table[i] = e->next;
-					memdelete(e);
-				}
-			}
-
-			memdelete_arr(hash_table);
+		Element *e = head_element;
+		while (e) {
+			Element *next = e->next_element;
+			memdelete(e);
+			e = next;
 		}
 
-		hash_table = nullptr;
-		hash_table_power = 0;
-		elements = 0;
+		head_element = nullptr;
+		tail_element = nullptr;
+		num_elements = 0;
+		_free_table();
 	}
 
 	void operator=(const HashMap &p_table) {
@@ -529,15 +492,8 @@ public:
 	}
 
 	void get_key_list(List<TKey> *r_keys) const {
-		if (unlikely(!hash_table)) {
-			return;
-		}
-		for (int i = 0; i < (1 << hash_table_power); i++) {
-			Element *e = hash_table[i];
-			while (e) {
-				r_keys->push_back(e->pair.key);
-				e = e->next;
-			}
+		for (const Element *e = head_element; e; e = e->next_element) {
+			r_keys->push_back(e->pair.key);
 		}
 	}
 
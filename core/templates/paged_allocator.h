@@ -43,6 +43,7 @@ class PagedAllocator {
 	T ***available_pool = nullptr;
 	uint32_t pages_allocated = 0;
 	uint32_t allocs_available = 0;
+	uint32_t frees_since_sort = 0;
 
 	uint32_t page_shift = 0;
 	uint32_t page_mask = 0;
@@ -86,10 +87,22 @@ public:
 		}
 		p_mem->~T();
 		available_pool[allocs_available >> page_shift][allocs_available & page_mask] = p_mem;
+		allocs_available++;
+		frees_since_sort++;
+		if (unlikely(allocs_available == pages_allocated * page_size) && frees_since_sort >= allocs_available / 2) {
+			// Everything was given back, likely by a container being torn down. Hand out elements in
+			// address order again so the next batch is as cache friendly as fresh pages would be.
+			// Only done after enough frees to pay for it.
+			for (uint32_t i = 0; i < pages_allocated; i++) {
+				for (uint32_t j = 0; j < page_size; j++) {
+					available_pool[i][j] = &page_pool[i][j];
+				}
+			}
+			frees_since_sort = 0;
+		}
 		if (thread_safe) {
 			spin_lock.unlock();
 		}
-		allocs_available++;
 	}
 
 	void reset(bool p_allow_unfreed = false) {
@@ -107,6 +120,7 @@ public:
 			available_pool = nullptr;
 			pages_allocated = 0;
 			allocs_available = 0;
+			frees_since_sort = 0;
 		}
 	}
 	bool is_configured() const {
@@ -0,0 +1,117 @@
+/*************************************************************************/
+/*  paged_node_allocator.h                                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef PAGED_NODE_ALLOCATOR_H
+#define PAGED_NODE_ALLOCATOR_H
+
+#include "core/templates/paged_allocator.h"
+
+/**
+ * Allocator for the nodes of List, Map and Set, passed as their allocator parameter:
+ *
+ * 	Map<StringName, Variant, Comparator<StringName>, PagedNodeAllocator> map;
+ *
+ * Nodes are served from thread safe PagedAllocator pools (one per 16 bytes size class), so allocating
+ * or freeing one is a free list push or pop under a spin lock instead of a trip through malloc. Larger
+ * blocks fall back to Memory.
+ *
+ * The pools are shared by every container and thread, since nodes are often freed by another thread
+ * than the one that allocated them. Freed nodes are reused, but pages are never given back: use it for
+ * containers that are built and torn down often, not for one-off huge ones.
+ */
+class PagedNodeAllocator {
+	static const uint32_t SIZE_CLASS_BYTES = 16;
+	static const uint32_t SIZE_CLASS_COUNT = 16;
+	// Stores the size class. Nodes only hold pointers and engine types, so they get 8 bytes alignment.
+	static const uint32_t HEADER_SIZE = 8;
+	static const uint32_t PAGE_BYTES = 65536;
+
+	template <uint32_t SIZE_CLASS>
+	struct Block {
+		uint8_t data[(SIZE_CLASS + 1) * SIZE_CLASS_BYTES];
+		Block() {} // Leave the memory uninitialized.
+	};
+
+	template <uint32_t SIZE_CLASS>
+	static PagedAllocator<Block<SIZE_CLASS>, true> *_get_pool() {
+		// Never deleted, containers destroyed during static deinitialization may still give nodes back.
+		static PagedAllocator<Block<SIZE_CLASS>, true> *pool = memnew((PagedAllocator<Block<SIZE_CLASS>, true>)(PAGE_BYTES / sizeof(Block<SIZE_CLASS>)));
+		return pool;
+	}
+
+	template <uint32_t SIZE_CLASS>
+	static uint8_t *_pool_alloc(uint32_t p_size_class) {
+		if (p_size_class == SIZE_CLASS) {
+			return _get_pool<SIZE_CLASS>()->alloc()->data;
+		}
+		if constexpr (SIZE_CLASS + 1 < SIZE_CLASS_COUNT) {
+			return _pool_alloc<SIZE_CLASS + 1>(p_size_class);
+		}
+		return nullptr;
+	}
+
+	template <uint32_t SIZE_CLASS>
+	static void _pool_free(uint32_t p_size_class, uint8_t *p_block) {
+		if (p_size_class == SIZE_CLASS) {
+			_get_pool<SIZE_CLASS>()->free(reinterpret_cast<Block<SIZE_CLASS> *>(p_block));
+			return;
+		}
+		if constexpr (SIZE_CLASS + 1 < SIZE_CLASS_COUNT) {
+			_pool_free<SIZE_CLASS + 1>(p_size_class, p_block);
+		}
+	}
+
+public:
+	_FORCE_INLINE_ static void *alloc(size_t p_memory) {
+		uint32_t size_class = (p_memory + HEADER_SIZE - 1) / SIZE_CLASS_BYTES;
+		uint8_t *block;
+		if (size_class < SIZE_CLASS_COUNT) {
+			block = _pool_alloc<0>(size_class);
+		} else {
+			size_class = SIZE_CLASS_COUNT;
+			block = (uint8_t *)Memory::alloc_static(p_memory + HEADER_SIZE, false);
+			ERR_FAIL_COND_V(!block, nullptr);
+		}
+		*(uint32_t *)block = size_class;
+		return block + HEADER_SIZE;
+	}
+
+	_FORCE_INLINE_ static void free(void *p_ptr) {
+		uint8_t *block = (uint8_t *)p_ptr - HEADER_SIZE;
+		uint32_t size_class = *(uint32_t *)block;
+		if (size_class < SIZE_CLASS_COUNT) {
+			_pool_free<0>(size_class, block);
+		} else {
+			Memory::free_static(block, false);
+		}
+	}
+};
+
+#endif // PAGED_NODE_ALLOCATOR_H
@@ -32,6 +32,7 @@
 
 #include "core/object/message_queue.h"
 #include "core/os/os.h"
+#include "core/os/thread_cache_allocator.h"
 #include "scene/main/node.h"
 #include "scene/main/scene_tree.h"
 #include "servers/audio_server.h"
@@ -73,10 +74,29 @@ void Performance::_bind_methods() {
 	BIND_ENUM_CONSTANT(PHYSICS_3D_COLLISION_PAIRS);
 	BIND_ENUM_CONSTANT(PHYSICS_3D_ISLAND_COUNT);
 	BIND_ENUM_CONSTANT(AUDIO_OUTPUT_LATENCY);
+	BIND_ENUM_CONSTANT(PHYSICS_3D_STEP_TIME);
+	BIND_ENUM_CONSTANT(RENDER_MESH_LOD_CHANGES_IN_FRAME);
+	BIND_ENUM_CONSTANT(RENDER_VISIBILITY_RANGE_CHANGES_IN_FRAME);
 
 	BIND_ENUM_CONSTANT(MONITOR_MAX);
 }
 
+#ifdef BUILTIN_ALLOCATOR_ENABLED
+uint64_t Performance::_get_allocator_blocks_in_use(int p_size_class) const {
+	return ThreadCacheAllocator::get_size_class_stats(p_size_class).blocks_in_use;
+}
+
+void Performance::_add_allocator_monitors() {
+	for (int i = 0; i < ThreadCacheAllocator::get_size_class_count(); i++) {
+		uint32_t block_size = ThreadCacheAllocator::get_size_class_stats(i).block_size;
+		String id = block_size ? vformat("allocator/%d_bytes_blocks", block_size) : String("allocator/large_blocks");
+		Vector<Variant> args;
+		args.push_back(i);
+		add_custom_monitor(id, callable_mp(this, &Performance::_get_allocator_blocks_in_use), args);
+	}
+}
+#endif
+
 int Performance::_get_node_count() const {
 	MainLoop *ml = OS::get_singleton()->get_main_loop();
 	SceneTree *sml = Object::cast_to<SceneTree>(ml);
@@ -112,6 +132,9 @@ String Performance::get_monitor_name(Monitor p_monitor) const {
 		"physics_3d/collision_pairs",
 		"physics_3d/islands",
 		"audio/driver/output_latency",
+		"physics_3d/step_time",
+		"raster/mesh_lod_changes",
+		"raster/visibility_range_changes",
 
 	};
 
@@ -166,6 +189,12 @@ double Performance::get_monitor(Monitor p_monitor) const {
 			return PhysicsServer3D::get_singleton()->get_process_info(PhysicsServer3D::INFO_ISLAND_COUNT);
 		case AUDIO_OUTPUT_LATENCY:
 			return AudioServer::get_singleton()->get_output_latency();
+		case PHYSICS_3D_STEP_TIME:
+			return USEC_TO_SEC(PhysicsServer3D::get_singleton()->get_process_info(PhysicsServer3D::INFO_STEP_TIME));
+		case RENDER_MESH_LOD_CHANGES_IN_FRAME:
+			return RS::get_singleton()->get_rendering_info(RS::RENDERING_INFO_MESH_LOD_CHANGES_IN_FRAME);
+		case RENDER_VISIBILITY_RANGE_CHANGES_IN_FRAME:
+			return RS::get_singleton()->get_rendering_info(RS::RENDERING_INFO_VISIBILITY_RANGE_CHANGES_IN_FRAME);
 
 		default: {
 		}
@@ -201,6 +230,9 @@ Performance::MonitorType Performance::get_monitor_type(Monitor p_monitor) const
 		MONITOR_TYPE_QUANTITY,
 		MONITOR_TYPE_QUANTITY,
 		MONITOR_TYPE_TIME,
+		MONITOR_TYPE_TIME,
+		MONITOR_TYPE_QUANTITY,
+		MONITOR_TYPE_QUANTITY,
 
 	};
 
@@ -263,6 +295,10 @@ Performance::Performance() {
 	_physics_process_time = 0;
 	_monitor_modification_time = 0;
 	singleton = this;
+
+#ifdef BUILTIN_ALLOCATOR_ENABLED
+	_add_allocator_monitors();
+#endif
 }
 
 Performance::MonitorCall::MonitorCall(Callable p_callable, Vector<Variant> p_arguments) {
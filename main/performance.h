@@ -45,6 +45,12 @@ class Performance : public Object {
 
 	int _get_node_count() const;
 
+#ifdef BUILTIN_ALLOCATOR_ENABLED
+	// Blocks in use for each size class of the built-in allocator, as custom monitors.
+	uint64_t _get_allocator_blocks_in_use(int p_size_class) const;
+	void _add_allocator_monitors();
+#endif
+
 	double _process_time;
 	double _physics_process_time;
 
@@ -87,6 +93,9 @@ public:
 		PHYSICS_3D_ISLAND_COUNT,
 		//physics
 		AUDIO_OUTPUT_LATENCY,
+		PHYSICS_3D_STEP_TIME,
+		RENDER_MESH_LOD_CHANGES_IN_FRAME,
+		RENDER_VISIBILITY_RANGE_CHANGES_IN_FRAME,
 		MONITOR_MAX
 	};
 
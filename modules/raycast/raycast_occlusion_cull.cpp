@@ -329,6 +329,12 @@ void RaycastOcclusionCull::scenario_remove_instance(RID p_scenario, RID p_instan
 	}
 }
 
+// Blocks until the scene committed by the last buffer update is built, the next update uses it.
+void RaycastOcclusionCull::scenario_wait_for_commit(RID p_scenario) {
+	ERR_FAIL_COND(!scenarios.has(p_scenario));
+	scenarios[p_scenario].wait_for_commit();
+}
+
 void RaycastOcclusionCull::Scenario::_update_dirty_instance_thread(int p_idx, RID *p_instances) {
 	_update_dirty_instance(p_idx, p_instances, nullptr);
 }
@@ -391,6 +397,17 @@ void RaycastOcclusionCull::Scenario::_commit_scene(void *p_ud) {
 	scenario->commit_done = true;
 }
 
+void RaycastOcclusionCull::Scenario::_finish_commit() {
+	commit_thread->wait_to_finish();
+	current_scene_idx = 1 - current_scene_idx;
+}
+
+void RaycastOcclusionCull::Scenario::wait_for_commit() {
+	if (commit_thread && commit_thread->is_started()) {
+		_finish_commit();
+	}
+}
+
 bool RaycastOcclusionCull::Scenario::update(ThreadWorkPool &p_thread_pool) {
 	ERR_FAIL_COND_V(singleton == nullptr, false);
 
@@ -400,8 +417,7 @@ bool RaycastOcclusionCull::Scenario::update(ThreadWorkPool &p_thread_pool) {
 
 	if (commit_thread->is_started()) {
 		if (commit_done) {
-			commit_thread->wait_to_finish();
-			current_scene_idx = 1 - current_scene_idx;
+			_finish_commit();
 		} else {
 			return false;
 		}
@@ -145,7 +145,9 @@ private:
 		void _transform_vertices_thread(uint32_t p_thread, TransformThreadData *p_data);
 		void _transform_vertices_range(const Vector3 *p_read, Vector3 *p_write, const Transform3D &p_xform, int p_from, int p_to);
 		static void _commit_scene(void *p_ud);
+		void _finish_commit();
 		bool update(ThreadWorkPool &p_thread_pool);
+		void wait_for_commit();
 
 		void _raycast(uint32_t p_thread, const RaycastThreadData *p_raycast_data) const;
 		void raycast(CameraRayTile *r_rays, const uint32_t *p_valid_masks, uint32_t p_tile_count, ThreadWorkPool &p_thread_pool) const;
@@ -175,6 +177,7 @@ public:
 	virtual void remove_scenario(RID p_scenario) override;
 	virtual void scenario_set_instance(RID p_scenario, RID p_instance, RID p_occluder, const Transform3D &p_xform, bool p_enabled) override;
 	virtual void scenario_remove_instance(RID p_scenario, RID p_instance) override;
+	void scenario_wait_for_commit(RID p_scenario);
 
 	virtual void add_buffer(RID p_buffer) override;
 	virtual void remove_buffer(RID p_buffer) override;
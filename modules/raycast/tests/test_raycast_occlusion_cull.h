@@ -0,0 +1,228 @@
+/*************************************************************************/
+/*  test_raycast_occlusion_cull.h                                        */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_RAYCAST_OCCLUSION_CULL_H
+#define TEST_RAYCAST_OCCLUSION_CULL_H
+
+#include "core/config/project_settings.h"
+#include "core/os/os.h"
+#include "core/templates/thread_work_pool.h"
+#include "modules/raycast/raycast_occlusion_cull.h"
+#include "servers/rendering/renderer_scene_occlusion_cull_raster.h"
+
+#include "tests/test_macros.h"
+
+namespace TestRaycastOcclusionCull {
+
+static RID create_box_occluder(RendererSceneOcclusionCull *p_cull, const Vector3 &p_half_extents) {
+	PackedVector3Array vertices;
+	for (int i = 0; i < 8; i++) {
+		vertices.push_back(Vector3((i & 1) ? p_half_extents.x : -p_half_extents.x, (i & 2) ? p_half_extents.y : -p_half_extents.y, (i & 4) ? p_half_extents.z : -p_half_extents.z));
+	}
+
+	static const int32_t box_indices[36] = {
+		0, 1, 3, 0, 3, 2, // -Z
+		4, 6, 7, 4, 7, 5, // +Z
+		0, 4, 5, 0, 5, 1, // -Y
+		2, 3, 7, 2, 7, 6, // +Y
+		0, 2, 6, 0, 6, 4, // -X
+		1, 5, 7, 1, 7, 3, // +X
+	};
+
+	PackedInt32Array indices;
+	for (int i = 0; i < 36; i++) {
+		indices.push_back(box_indices[i]);
+	}
+
+	RID occluder = p_cull->occluder_allocate();
+	p_cull->occluder_initialize(occluder);
+	p_cull->occluder_set_mesh(occluder, vertices, indices);
+	return occluder;
+}
+
+// Builds a city-like grid of box occluders in front of the camera, the same for every backend.
+static void setup_scene(RendererSceneOcclusionCull *p_cull, RID p_scenario, RID p_buffer, const Size2i &p_buffer_size, LocalVector<RID> &r_occluders) {
+	p_cull->add_scenario(p_scenario);
+	p_cull->add_buffer(p_buffer);
+	p_cull->buffer_set_scenario(p_buffer, p_scenario);
+	p_cull->buffer_set_size(p_buffer, p_buffer_size);
+
+	uint64_t instance_id = 1000;
+	for (int x = 0; x < 32; x++) {
+		for (int z = 0; z < 32; z++) {
+			RID occluder = create_box_occluder(p_cull, Vector3(2, 4 + (x * 7 + z * 3) % 5, 2));
+			r_occluders.push_back(occluder);
+			p_cull->scenario_set_instance(p_scenario, RID::from_uint64(instance_id++), occluder, Transform3D(Basis(), Vector3((x - 16) * 8, 0, -10 - z * 8)), true);
+		}
+	}
+}
+
+static int count_occluded(RendererSceneOcclusionCull *p_cull, RID p_buffer, const Transform3D &p_cam_transform, const CameraMatrix &p_cam_projection) {
+	RendererSceneOcclusionCull::HZBuffer *buffer = p_cull->buffer_get_ptr(p_buffer);
+	Transform3D cam_inv_transform = p_cam_transform.affine_inverse();
+
+	int occluded = 0;
+	for (int x = 0; x < 64; x++) {
+		for (int z = 0; z < 64; z++) {
+			Vector3 position = Vector3((x - 32) * 4 + 2, 0, -14 - z * 4);
+			real_t bounds[6] = { position.x - 0.5f, position.y - 0.5f, position.z - 0.5f, position.x + 0.5f, position.y + 0.5f, position.z + 0.5f };
+			if (buffer->is_occluded(bounds, p_cam_transform.origin, cam_inv_transform, p_cam_projection, p_cam_projection.get_z_near())) {
+				occluded++;
+			}
+		}
+	}
+	return occluded;
+}
+
+static Transform3D get_camera_transform(int p_frame) {
+	Transform3D transform;
+	transform.origin = Vector3(0, 2, 0);
+	transform.basis = Basis(Vector3(0, 1, 0), Math::sin(p_frame * 0.05) * 0.3);
+	return transform;
+}
+
+static Size2i get_buffer_size(ThreadWorkPool &p_thread_pool) {
+	// Same buffer size as a 1920x1080 viewport with the default occlusion_rays_per_thread.
+	const float aspect = 16.0 / 9.0;
+	int max_size = 512 * p_thread_pool.get_thread_count();
+	float height = Math::sqrt(max_size / aspect);
+	return Size2i(height * aspect, height);
+}
+
+// Sets up the scene and waits until the backend can use it.
+static void setup_backend(RendererSceneOcclusionCull *p_cull, RaycastOcclusionCull *p_raycast_cull, RID p_scenario, RID p_buffer, const Size2i &p_buffer_size, const CameraMatrix &p_cam_projection, ThreadWorkPool &p_thread_pool, LocalVector<RID> &r_occluders) {
+	setup_scene(p_cull, p_scenario, p_buffer, p_buffer_size, r_occluders);
+
+	// Embree builds the scene on a separate thread, started by the first update.
+	p_cull->buffer_update(p_buffer, get_camera_transform(0), p_cam_projection, false, p_thread_pool);
+	if (p_cull == p_raycast_cull) {
+		p_raycast_cull->scenario_wait_for_commit(p_scenario);
+	}
+}
+
+TEST_CASE("[RaycastOcclusionCull] Occluders are culled with Embree and the software rasterizer") {
+	GLOBAL_DEF_RST("rendering/occlusion_culling/bvh_build_quality", 2);
+
+	ThreadWorkPool thread_pool;
+	thread_pool.init();
+
+	Size2i buffer_size = get_buffer_size(thread_pool);
+	CameraMatrix cam_projection;
+	cam_projection.set_perspective(70, 16.0 / 9.0, 0.05, 500);
+
+	RasterOcclusionCull *raster_cull = memnew(RasterOcclusionCull);
+	RaycastOcclusionCull *raycast_cull = memnew(RaycastOcclusionCull);
+	RendererSceneOcclusionCull *backends[2] = { raster_cull, raycast_cull };
+
+	RID scenario = RID::from_uint64(1);
+	RID buffer = RID::from_uint64(2);
+
+	int occluded[2] = { 0, 0 };
+	for (int i = 0; i < 2; i++) {
+		LocalVector<RID> occluders;
+		setup_backend(backends[i], raycast_cull, scenario, buffer, buffer_size, cam_projection, thread_pool, occluders);
+
+		backends[i]->buffer_update(buffer, get_camera_transform(0), cam_projection, false, thread_pool);
+		occluded[i] = count_occluded(backends[i], buffer, get_camera_transform(0), cam_projection);
+
+		for (uint32_t j = 0; j < occluders.size(); j++) {
+			backends[i]->free_occluder(occluders[j]);
+		}
+	}
+
+	CHECK_MESSAGE(occluded[0] > 0, "Some of the instances behind the occluders should be culled by the software rasterizer.");
+	CHECK_MESSAGE(occluded[1] > 0, "Some of the instances behind the occluders should be culled by Embree.");
+
+	memdelete(raycast_cull);
+	memdelete(raster_cull);
+
+	thread_pool.finish();
+}
+
+// Run with `godot --test raycast-occlusion-cull-benchmark`.
+void benchmark() {
+	GLOBAL_DEF_RST("rendering/occlusion_culling/bvh_build_quality", 2);
+
+	const int frame_count = 60;
+
+	ThreadWorkPool thread_pool;
+	thread_pool.init();
+
+	Size2i buffer_size = get_buffer_size(thread_pool);
+	CameraMatrix cam_projection;
+	cam_projection.set_perspective(70, 16.0 / 9.0, 0.05, 500);
+
+	RasterOcclusionCull *raster_cull = memnew(RasterOcclusionCull);
+	RaycastOcclusionCull *raycast_cull = memnew(RaycastOcclusionCull);
+
+	RendererSceneOcclusionCull *backends[2] = { raster_cull, raycast_cull };
+	const char *backend_names[2] = { "software rasterizer", "Embree raycast" };
+
+	RID scenario = RID::from_uint64(1);
+	RID buffer = RID::from_uint64(2);
+
+	for (int i = 0; i < 2; i++) {
+		RendererSceneOcclusionCull *cull = backends[i];
+
+		LocalVector<RID> occluders;
+		setup_backend(cull, raycast_cull, scenario, buffer, buffer_size, cam_projection, thread_pool, occluders);
+
+		uint64_t update_usec = 0;
+		int occluded = 0;
+		for (int j = 0; j < frame_count; j++) {
+			Transform3D cam_transform = get_camera_transform(j);
+
+			uint64_t time = OS::get_singleton()->get_ticks_usec();
+			cull->buffer_update(buffer, cam_transform, cam_projection, false, thread_pool);
+			update_usec += OS::get_singleton()->get_ticks_usec() - time;
+
+			occluded += count_occluded(cull, buffer, cam_transform, cam_projection);
+		}
+
+		String result = vformat("Occlusion buffer update with %s (%d occluders, %s buffer): %d usec per frame, ", backend_names[i], occluders.size(), String(buffer_size), update_usec / frame_count);
+		result += vformat("%d of %d test AABBs occluded per frame.", occluded / frame_count, 64 * 64);
+		print_line(result);
+
+		for (uint32_t j = 0; j < occluders.size(); j++) {
+			cull->free_occluder(occluders[j]);
+		}
+	}
+
+	memdelete(raycast_cull);
+	memdelete(raster_cull);
+
+	thread_pool.finish();
+}
+
+} // namespace TestRaycastOcclusionCull
+
+REGISTER_TEST_COMMAND("raycast-occlusion-cull-benchmark", &TestRaycastOcclusionCull::benchmark);
+
+#endif // TEST_RAYCAST_OCCLUSION_CULL_H
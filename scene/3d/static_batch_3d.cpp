@@ -0,0 +1,468 @@
+/*************************************************************************/
+/*  static_batch_3d.cpp                                                  */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "static_batch_3d.h"
+
+#include "core/config/engine.h"
+#include "core/templates/hash_map.h"
+#include "scene/3d/mesh_instance_3d.h"
+#include "scene/resources/skin.h"
+
+static const uint32_t batchable_format = Mesh::ARRAY_FORMAT_VERTEX | Mesh::ARRAY_FORMAT_NORMAL | Mesh::ARRAY_FORMAT_TANGENT | Mesh::ARRAY_FORMAT_COLOR | Mesh::ARRAY_FORMAT_TEX_UV | Mesh::ARRAY_FORMAT_TEX_UV2;
+
+uint32_t StaticBatch3D::get_surface_format(const Array &p_arrays) {
+	uint32_t format = 0;
+	for (int i = 0; i < p_arrays.size(); i++) {
+		if (i != Mesh::ARRAY_INDEX && p_arrays[i].get_type() != Variant::NIL) {
+			format |= 1 << i;
+		}
+	}
+	return format;
+}
+
+Array StaticBatch3D::merge_surfaces(const Vector<SurfaceSource> &p_surfaces) {
+	ERR_FAIL_COND_V(p_surfaces.is_empty(), Array());
+
+	uint32_t format = get_surface_format(p_surfaces[0].arrays);
+	ERR_FAIL_COND_V(!(format & Mesh::ARRAY_FORMAT_VERTEX), Array());
+	ERR_FAIL_COND_V_MSG(format & ~batchable_format, Array(), "Only vertex, normal, tangent, color and UV arrays can be batched.");
+
+	int vertex_count = 0;
+	int index_count = 0;
+	for (int i = 0; i < p_surfaces.size(); i++) {
+		const Array &arrays = p_surfaces[i].arrays;
+		ERR_FAIL_COND_V_MSG(get_surface_format(arrays) != format, Array(), "All merged surfaces must use the same vertex format.");
+
+		int surface_vertex_count = PackedVector3Array(arrays[Mesh::ARRAY_VERTEX]).size();
+		vertex_count += surface_vertex_count;
+		if (arrays[Mesh::ARRAY_INDEX].get_type() == Variant::NIL) {
+			index_count += surface_vertex_count;
+		} else {
+			index_count += PackedInt32Array(arrays[Mesh::ARRAY_INDEX]).size();
+		}
+	}
+
+	PackedVector3Array vertices;
+	PackedVector3Array normals;
+	PackedFloat32Array tangents;
+	PackedColorArray colors;
+	PackedVector2Array uvs;
+	PackedVector2Array uv2s;
+	PackedInt32Array indices;
+
+	vertices.resize(vertex_count);
+	if (format & Mesh::ARRAY_FORMAT_NORMAL) {
+		normals.resize(vertex_count);
+	}
+	if (format & Mesh::ARRAY_FORMAT_TANGENT) {
+		tangents.resize(vertex_count * 4);
+	}
+	if (format & Mesh::ARRAY_FORMAT_COLOR) {
+		colors.resize(vertex_count);
+	}
+	if (format & Mesh::ARRAY_FORMAT_TEX_UV) {
+		uvs.resize(vertex_count);
+	}
+	if (format & Mesh::ARRAY_FORMAT_TEX_UV2) {
+		uv2s.resize(vertex_count);
+	}
+	indices.resize(index_count);
+
+	int vertex_offset = 0;
+	int index_offset = 0;
+
+	for (int i = 0; i < p_surfaces.size(); i++) {
+		const Array &arrays = p_surfaces[i].arrays;
+		const Transform3D &transform = p_surfaces[i].transform;
+		Basis normal_basis = transform.basis.inverse().transposed();
+		// A mirroring transform flips the winding order and the bitangent.
+		bool flip = transform.basis.determinant() < 0;
+
+		PackedVector3Array src_vertices = arrays[Mesh::ARRAY_VERTEX];
+		int count = src_vertices.size();
+		{
+			const Vector3 *r = src_vertices.ptr();
+			Vector3 *w = vertices.ptrw() + vertex_offset;
+			for (int j = 0; j < count; j++) {
+				w[j] = transform.xform(r[j]);
+			}
+		}
+
+		if (format & Mesh::ARRAY_FORMAT_NORMAL) {
+			PackedVector3Array src_normals = arrays[Mesh::ARRAY_NORMAL];
+			ERR_FAIL_COND_V(src_normals.size() != count, Array());
+			const Vector3 *r = src_normals.ptr();
+			Vector3 *w = normals.ptrw() + vertex_offset;
+			for (int j = 0; j < count; j++) {
+				w[j] = normal_basis.xform(r[j]).normalized();
+			}
+		}
+
+		if (format & Mesh::ARRAY_FORMAT_TANGENT) {
+			PackedFloat32Array src_tangents = arrays[Mesh::ARRAY_TANGENT];
+			ERR_FAIL_COND_V(src_tangents.size() != count * 4, Array());
+			const float *r = src_tangents.ptr();
+			float *w = tangents.ptrw() + vertex_offset * 4;
+			for (int j = 0; j < count; j++) {
+				Vector3 tangent = transform.basis.xform(Vector3(r[j * 4 + 0], r[j * 4 + 1], r[j * 4 + 2])).normalized();
+				w[j * 4 + 0] = tangent.x;
+				w[j * 4 + 1] = tangent.y;
+				w[j * 4 + 2] = tangent.z;
+				w[j * 4 + 3] = flip ? -r[j * 4 + 3] : r[j * 4 + 3];
+			}
+		}
+
+		if (format & Mesh::ARRAY_FORMAT_COLOR) {
+			PackedColorArray src_colors = arrays[Mesh::ARRAY_COLOR];
+			ERR_FAIL_COND_V(src_colors.size() != count, Array());
+			memcpy(colors.ptrw() + vertex_offset, src_colors.ptr(), sizeof(Color) * count);
+		}
+
+		if (format & Mesh::ARRAY_FORMAT_TEX_UV) {
+			PackedVector2Array src_uvs = arrays[Mesh::ARRAY_TEX_UV];
+			ERR_FAIL_COND_V(src_uvs.size() != count, Array());
+			memcpy(uvs.ptrw() + vertex_offset, src_uvs.ptr(), sizeof(Vector2) * count);
+		}
+
+		if (format & Mesh::ARRAY_FORMAT_TEX_UV2) {
+			PackedVector2Array src_uv2s = arrays[Mesh::ARRAY_TEX_UV2];
+			ERR_FAIL_COND_V(src_uv2s.size() != count, Array());
+			memcpy(uv2s.ptrw() + vertex_offset, src_uv2s.ptr(), sizeof(Vector2) * count);
+		}
+
+		{
+			int *w = indices.ptrw() + index_offset;
+			int surface_index_count;
+			if (arrays[Mesh::ARRAY_INDEX].get_type() == Variant::NIL) {
+				surface_index_count = count;
+				for (int j = 0; j < count; j++) {
+					w[j] = vertex_offset + j;
+				}
+			} else {
+				PackedInt32Array src_indices = arrays[Mesh::ARRAY_INDEX];
+				surface_index_count = src_indices.size();
+				const int *r = src_indices.ptr();
+				for (int j = 0; j < surface_index_count; j++) {
+					w[j] = vertex_offset + r[j];
+				}
+			}
+
+			if (flip) {
+				for (int j = 0; j + 2 < surface_index_count; j += 3) {
+					SWAP(w[j + 1], w[j + 2]);
+				}
+			}
+
+			index_offset += surface_index_count;
+		}
+
+		vertex_offset += count;
+	}
+
+	Array arrays;
+	arrays.resize(Mesh::ARRAY_MAX);
+	arrays[Mesh::ARRAY_VERTEX] = vertices;
+	if (format & Mesh::ARRAY_FORMAT_NORMAL) {
+		arrays[Mesh::ARRAY_NORMAL] = normals;
+	}
+	if (format & Mesh::ARRAY_FORMAT_TANGENT) {
+		arrays[Mesh::ARRAY_TANGENT] = tangents;
+	}
+	if (format & Mesh::ARRAY_FORMAT_COLOR) {
+		arrays[Mesh::ARRAY_COLOR] = colors;
+	}
+	if (format & Mesh::ARRAY_FORMAT_TEX_UV) {
+		arrays[Mesh::ARRAY_TEX_UV] = uvs;
+	}
+	if (format & Mesh::ARRAY_FORMAT_TEX_UV2) {
+		arrays[Mesh::ARRAY_TEX_UV2] = uv2s;
+	}
+	arrays[Mesh::ARRAY_INDEX] = indices;
+
+	return arrays;
+}
+
+bool StaticBatch3D::_is_batchable(MeshInstance3D *p_instance) const {
+	if (!p_instance->is_visible_in_tree()) {
+		return false;
+	}
+
+	Ref<Mesh> mesh = p_instance->get_mesh();
+	if (mesh.is_null() || mesh->get_surface_count() == 0 || mesh->get_blend_shape_count() > 0) {
+		return false;
+	}
+
+	// Skinned meshes move every frame and visibility ranges are evaluated per instance.
+	if (p_instance->get_skin().is_valid() || p_instance->get_visibility_range_begin() > 0.0 || p_instance->get_visibility_range_end() > 0.0) {
+		return false;
+	}
+
+	for (int i = 0; i < mesh->get_surface_count(); i++) {
+		if (mesh->surface_get_primitive_type(i) != Mesh::PRIMITIVE_TRIANGLES) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void StaticBatch3D::_find_sources(Node *p_node, LocalVector<MeshInstance3D *> &r_sources) const {
+	// Internal children are the chunks created by a previous batch.
+	for (int i = 0; i < p_node->get_child_count(false); i++) {
+		Node *child = p_node->get_child(i, false);
+
+		if (Object::cast_to<StaticBatch3D>(child)) {
+			continue; // Nested batches handle their own children.
+		}
+
+		MeshInstance3D *mi = Object::cast_to<MeshInstance3D>(child);
+		if (mi && _is_batchable(mi)) {
+			r_sources.push_back(mi);
+		}
+
+		_find_sources(child, r_sources);
+	}
+}
+
+void StaticBatch3D::_add_chunk(const BatchKey &p_key, const Vector<SurfaceSource> &p_surfaces) {
+	Array arrays = merge_surfaces(p_surfaces);
+	ERR_FAIL_COND(arrays.is_empty());
+
+	Ref<ArrayMesh> mesh;
+	mesh.instantiate();
+	mesh->add_surface_from_arrays(Mesh::PRIMITIVE_TRIANGLES, arrays);
+	mesh->surface_set_material(0, p_key.material);
+
+	MeshInstance3D *chunk = memnew(MeshInstance3D);
+	chunk->set_skeleton_path(NodePath());
+	chunk->set_mesh(mesh);
+	chunk->set_cast_shadows_setting(GeometryInstance3D::ShadowCastingSetting(p_key.cast_shadows));
+	chunk->set_layer_mask(p_key.layers);
+	add_child(chunk, false, INTERNAL_MODE_BACK);
+	chunks.push_back(chunk);
+}
+
+void StaticBatch3D::batch() {
+	ERR_FAIL_COND_MSG(!is_inside_tree(), "StaticBatch3D must be inside the scene tree to batch its children.");
+
+	if (is_batched()) {
+		unbatch();
+	}
+
+	LocalVector<MeshInstance3D *> found;
+	_find_sources(this, found);
+
+	Transform3D global_to_local = get_global_transform().affine_inverse();
+	Map<BatchKey, Vector<SurfaceSource>> batches;
+
+	// Props usually share a few meshes, and surface_get_arrays() copies the arrays out of the server on every call.
+	HashMap<ObjectID, LocalVector<Array>> surface_arrays;
+
+	for (uint32_t i = 0; i < found.size(); i++) {
+		MeshInstance3D *mi = found[i];
+		Ref<Mesh> mesh = mi->get_mesh();
+		Transform3D transform = global_to_local * mi->get_global_transform();
+
+		BatchKey key;
+		key.cast_shadows = mi->get_cast_shadows_setting();
+		key.layers = mi->get_layer_mask();
+		key.cell = Vector3i((transform.xform(mesh->get_aabb()).get_center() / cell_size).floor());
+
+		// All surfaces must be batchable, otherwise the instance is left alone.
+		Vector<SurfaceSource> surfaces;
+		Vector<BatchKey> keys;
+		bool valid = true;
+
+		LocalVector<Array> &mesh_arrays = surface_arrays[mesh->get_instance_id()];
+		if (mesh_arrays.is_empty()) {
+			mesh_arrays.resize(mesh->get_surface_count());
+		}
+
+		for (int j = 0; j < mesh->get_surface_count(); j++) {
+			if (mesh_arrays[j].is_empty()) {
+				mesh_arrays[j] = mesh->surface_get_arrays(j);
+			}
+
+			SurfaceSource source;
+			source.arrays = mesh_arrays[j];
+			source.transform = transform;
+
+			key.material = mi->get_active_material(j);
+			key.format = get_surface_format(source.arrays);
+			if (!(key.format & Mesh::ARRAY_FORMAT_VERTEX) || (key.format & ~batchable_format)) {
+				valid = false;
+				break;
+			}
+
+			surfaces.push_back(source);
+			keys.push_back(key);
+		}
+
+		if (!valid) {
+			continue;
+		}
+
+		for (int j = 0; j < surfaces.size(); j++) {
+			batches[keys[j]].push_back(surfaces[j]);
+		}
+
+		// Only the instance is hidden, the node and its children keep their visibility.
+		RS::get_singleton()->instance_set_visible(mi->get_instance(), false);
+		sources.push_back(mi->get_instance_id());
+	}
+
+	for (Map<BatchKey, Vector<SurfaceSource>>::Element *E = batches.front(); E; E = E->next()) {
+		const Vector<SurfaceSource> &surfaces = E->get();
+		Vector<SurfaceSource> chunk;
+		int chunk_vertices = 0;
+
+		for (int i = 0; i < surfaces.size(); i++) {
+			int surface_vertices = PackedVector3Array(surfaces[i].arrays[Mesh::ARRAY_VERTEX]).size();
+			if (!chunk.is_empty() && chunk_vertices + surface_vertices > max_chunk_vertices) {
+				_add_chunk(E->key(), chunk);
+				chunk.clear();
+				chunk_vertices = 0;
+			}
+			chunk.push_back(surfaces[i]);
+			chunk_vertices += surface_vertices;
+		}
+
+		if (!chunk.is_empty()) {
+			_add_chunk(E->key(), chunk);
+		}
+	}
+}
+
+void StaticBatch3D::unbatch() {
+	for (uint32_t i = 0; i < chunks.size(); i++) {
+		remove_child(chunks[i]);
+		memdelete(chunks[i]);
+	}
+	chunks.clear();
+
+	for (uint32_t i = 0; i < sources.size(); i++) {
+		MeshInstance3D *mi = Object::cast_to<MeshInstance3D>(ObjectDB::get_instance(sources[i]));
+		if (mi) {
+			RS::get_singleton()->instance_set_visible(mi->get_instance(), mi->is_visible_in_tree());
+		}
+	}
+	sources.clear();
+}
+
+bool StaticBatch3D::is_batched() const {
+	return !sources.is_empty();
+}
+
+int StaticBatch3D::get_batched_instance_count() const {
+	return sources.size();
+}
+
+int StaticBatch3D::get_chunk_count() const {
+	return chunks.size();
+}
+
+void StaticBatch3D::set_cell_size(real_t p_size) {
+	ERR_FAIL_COND(p_size <= 0.0);
+	cell_size = p_size;
+}
+
+real_t StaticBatch3D::get_cell_size() const {
+	return cell_size;
+}
+
+void StaticBatch3D::set_max_chunk_vertices(int p_count) {
+	ERR_FAIL_COND(p_count < 3);
+	max_chunk_vertices = p_count;
+}
+
+int StaticBatch3D::get_max_chunk_vertices() const {
+	return max_chunk_vertices;
+}
+
+void StaticBatch3D::set_batch_on_ready(bool p_enable) {
+	batch_on_ready = p_enable;
+}
+
+bool StaticBatch3D::is_batch_on_ready_enabled() const {
+	return batch_on_ready;
+}
+
+void StaticBatch3D::_hide_sources() {
+	for (uint32_t i = 0; i < sources.size(); i++) {
+		MeshInstance3D *mi = Object::cast_to<MeshInstance3D>(ObjectDB::get_instance(sources[i]));
+		if (mi) {
+			RS::get_singleton()->instance_set_visible(mi->get_instance(), false);
+		}
+	}
+}
+
+void StaticBatch3D::_notification(int p_what) {
+	switch (p_what) {
+		case NOTIFICATION_READY: {
+			if (batch_on_ready && !Engine::get_singleton()->is_editor_hint()) {
+				batch();
+			}
+		} break;
+		case NOTIFICATION_VISIBILITY_CHANGED: {
+			// The sources show their instances again once the notification reaches them.
+			if (is_batched()) {
+				callable_mp(this, &StaticBatch3D::_hide_sources).call_deferred({}, 0);
+			}
+		} break;
+	}
+}
+
+void StaticBatch3D::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("set_cell_size", "size"), &StaticBatch3D::set_cell_size);
+	ClassDB::bind_method(D_METHOD("get_cell_size"), &StaticBatch3D::get_cell_size);
+
+	ClassDB::bind_method(D_METHOD("set_max_chunk_vertices", "count"), &StaticBatch3D::set_max_chunk_vertices);
+	ClassDB::bind_method(D_METHOD("get_max_chunk_vertices"), &StaticBatch3D::get_max_chunk_vertices);
+
+	ClassDB::bind_method(D_METHOD("set_batch_on_ready", "enable"), &StaticBatch3D::set_batch_on_ready);
+	ClassDB::bind_method(D_METHOD("is_batch_on_ready_enabled"), &StaticBatch3D::is_batch_on_ready_enabled);
+
+	ClassDB::bind_method(D_METHOD("batch"), &StaticBatch3D::batch);
+	ClassDB::bind_method(D_METHOD("unbatch"), &StaticBatch3D::unbatch);
+	ClassDB::bind_method(D_METHOD("is_batched"), &StaticBatch3D::is_batched);
+
+	ClassDB::bind_method(D_METHOD("get_batched_instance_count"), &StaticBatch3D::get_batched_instance_count);
+	ClassDB::bind_method(D_METHOD("get_chunk_count"), &StaticBatch3D::get_chunk_count);
+
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "cell_size", PROPERTY_HINT_RANGE, "0.1,1024,0.1,or_greater"), "set_cell_size", "get_cell_size");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "max_chunk_vertices", PROPERTY_HINT_RANGE, "3,1048576,1,or_greater"), "set_max_chunk_vertices", "get_max_chunk_vertices");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "batch_on_ready"), "set_batch_on_ready", "is_batch_on_ready_enabled");
+}
+
+StaticBatch3D::StaticBatch3D() {
+}
+
+StaticBatch3D::~StaticBatch3D() {
+}
@@ -0,0 +1,114 @@
+/*************************************************************************/
+/*  static_batch_3d.h                                                    */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef STATIC_BATCH_3D_H
+#define STATIC_BATCH_3D_H
+
+#include "core/templates/local_vector.h"
+#include "scene/3d/node_3d.h"
+#include "scene/resources/mesh.h"
+
+class MeshInstance3D;
+
+class StaticBatch3D : public Node3D {
+	GDCLASS(StaticBatch3D, Node3D);
+
+public:
+	struct SurfaceSource {
+		Array arrays;
+		Transform3D transform;
+	};
+
+private:
+	struct BatchKey {
+		Ref<Material> material;
+		int cast_shadows = 0;
+		uint32_t layers = 0;
+		uint32_t format = 0;
+		Vector3i cell;
+
+		bool operator<(const BatchKey &p_key) const {
+			if (material != p_key.material) {
+				return material.ptr() < p_key.material.ptr();
+			}
+			if (cast_shadows != p_key.cast_shadows) {
+				return cast_shadows < p_key.cast_shadows;
+			}
+			if (layers != p_key.layers) {
+				return layers < p_key.layers;
+			}
+			if (format != p_key.format) {
+				return format < p_key.format;
+			}
+			return cell < p_key.cell;
+		}
+	};
+
+	real_t cell_size = 32.0;
+	int max_chunk_vertices = 65535;
+	bool batch_on_ready = true;
+
+	LocalVector<ObjectID> sources;
+	LocalVector<MeshInstance3D *> chunks;
+
+	bool _is_batchable(MeshInstance3D *p_instance) const;
+	void _find_sources(Node *p_node, LocalVector<MeshInstance3D *> &r_sources) const;
+	void _add_chunk(const BatchKey &p_key, const Vector<SurfaceSource> &p_surfaces);
+	void _hide_sources();
+
+protected:
+	void _notification(int p_what);
+	static void _bind_methods();
+
+public:
+	static uint32_t get_surface_format(const Array &p_arrays);
+	static Array merge_surfaces(const Vector<SurfaceSource> &p_surfaces);
+
+	void set_cell_size(real_t p_size);
+	real_t get_cell_size() const;
+
+	void set_max_chunk_vertices(int p_count);
+	int get_max_chunk_vertices() const;
+
+	void set_batch_on_ready(bool p_enable);
+	bool is_batch_on_ready_enabled() const;
+
+	void batch();
+	void unbatch();
+	bool is_batched() const;
+
+	int get_batched_instance_count() const;
+	int get_chunk_count() const;
+
+	StaticBatch3D();
+	~StaticBatch3D();
+};
+
+#endif // STATIC_BATCH_3D_H
@@ -885,6 +885,7 @@ void AnimationTree::_process_graph(real_t p_delta) {
 	}
 
 	if (!state.valid) {
+		state.animation_states.reset();
 		return; //state is not valid. do nothing.
 	}
 	//apply value/transform/bezier blends to track caches and execute method/audio/animation tracks
@@ -892,7 +893,8 @@ void AnimationTree::_process_graph(real_t p_delta) {
 	{
 		bool can_call = is_inside_tree() && !Engine::get_singleton()->is_editor_hint();
 
-		for (const AnimationNode::AnimationState &as : state.animation_states) {
+		for (uint32_t as_idx = 0; as_idx < state.animation_states.size(); as_idx++) {
+			const AnimationNode::AnimationState &as = state.animation_states[as_idx];
 			Ref<Animation> a = as.animation;
 			double time = as.time;
 			double delta = as.delta;
@@ -1392,6 +1394,9 @@ void AnimationTree::_process_graph(real_t p_delta) {
 		}
 	}
 
+	// Allocated from the frame arena, must not be kept for the next frame.
+	state.animation_states.reset();
+
 	{
 		// finally, set the tracks
 		const NodePath *K = nullptr;
@@ -32,6 +32,8 @@
 #define ANIMATION_GRAPH_PLAYER_H
 
 #include "animation_player.h"
+#include "core/os/frame_arena.h"
+#include "core/templates/local_vector.h"
 #include "scene/3d/node_3d.h"
 #include "scene/3d/skeleton_3d.h"
 #include "scene/resources/animation.h"
@@ -71,7 +73,7 @@ public:
 	struct State {
 		int track_count = 0;
 		HashMap<NodePath, int> track_map;
-		List<AnimationState> animation_states;
+		LocalVector<AnimationState, uint32_t, false, FrameArena> animation_states; // Rebuilt on every process.
 		bool valid = false;
 		AnimationPlayer *player = nullptr;
 		AnimationTree *tree = nullptr;
@@ -1653,7 +1653,7 @@ void Node::add_to_group(const StringName &p_identifier, bool p_persistent) {
 void Node::remove_from_group(const StringName &p_identifier) {
 	ERR_FAIL_COND(!data.grouped.has(p_identifier));
 
-	Map<StringName, GroupData>::Element *E = data.grouped.find(p_identifier);
+	Map<StringName, GroupData, ::Comparator<StringName>, PagedNodeAllocator>::Element *E = data.grouped.find(p_identifier);
 
 	ERR_FAIL_COND(!E);
 
@@ -36,6 +36,7 @@
 #include "core/object/script_language.h"
 #include "core/string/node_path.h"
 #include "core/templates/map.h"
+#include "core/templates/paged_node_allocator.h"
 #include "core/variant/typed_array.h"
 #include "scene/main/scene_tree.h"
 
@@ -120,7 +121,7 @@ private:
 
 		Viewport *viewport = nullptr;
 
-		Map<StringName, GroupData> grouped;
+		Map<StringName, GroupData, ::Comparator<StringName>, PagedNodeAllocator> grouped; // Pooled, scenes instantiate and free nodes in bulk.
 		List<Node *>::Element *OW = nullptr; // Owned element.
 		List<Node *> owned;
 
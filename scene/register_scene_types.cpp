@@ -239,6 +239,7 @@
 #include "scene/3d/soft_dynamic_body_3d.h"
 #include "scene/3d/spring_arm_3d.h"
 #include "scene/3d/sprite_3d.h"
+#include "scene/3d/static_batch_3d.h"
 #include "scene/3d/vehicle_body_3d.h"
 #include "scene/3d/visible_on_screen_notifier_3d.h"
 #include "scene/3d/voxel_gi.h"
@@ -513,6 +514,7 @@ void register_scene_types() {
 	GDREGISTER_CLASS(CollisionPolygon3D);
 	GDREGISTER_CLASS(RayCast3D);
 	GDREGISTER_CLASS(MultiMeshInstance3D);
+	GDREGISTER_CLASS(StaticBatch3D);
 
 	GDREGISTER_CLASS(Curve3D);
 	GDREGISTER_CLASS(Path3D);
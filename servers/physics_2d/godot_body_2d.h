@@ -78,6 +78,9 @@ class GodotBody2D : public GodotCollisionObject2D {
 
 	real_t still_time = 0.0;
 
+	Vector2 integrated_motion;
+	bool integrated_motion_pending = false;
+
 	Vector2 applied_force;
 	real_t applied_torque = 0.0;
 
@@ -285,8 +288,12 @@ public:
 	_FORCE_INLINE_ real_t get_linear_damp() const { return linear_damp; }
 	_FORCE_INLINE_ real_t get_angular_damp() const { return angular_damp; }
 
+	// Only touch the body itself and can run on any thread, the broad phase and
+	// space lists are updated by the post_integrate_*() calls on the physics thread.
 	void integrate_forces(real_t p_step);
+	void post_integrate_forces();
 	void integrate_velocities(real_t p_step);
+	void post_integrate_velocities();
 
 	_FORCE_INLINE_ Vector2 get_velocity_in_local_point(const Vector2 &rel_pos) const {
 		return linear_velocity + Vector2(-angular_velocity * rel_pos.y, angular_velocity * rel_pos.x);
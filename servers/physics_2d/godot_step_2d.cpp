@@ -37,6 +37,7 @@
 #define ISLAND_COUNT_RESERVE 128
 #define ISLAND_SIZE_RESERVE 512
 #define CONSTRAINT_COUNT_RESERVE 1024
+#define ACTIVE_BODY_COUNT_RESERVE 1024
 
 void GodotStep2D::_populate_island(GodotBody2D *p_body, LocalVector<GodotBody2D *> &p_body_island, LocalVector<GodotConstraint2D *> &p_constraint_island) {
 	p_body->set_island_step(_step);
@@ -71,6 +72,24 @@ void GodotStep2D::_populate_island(GodotBody2D *p_body, LocalVector<GodotBody2D
 	}
 }
 
+void GodotStep2D::_collect_active_bodies(const SelfList<GodotBody2D>::List &p_body_list) {
+	active_bodies.clear();
+
+	const SelfList<GodotBody2D> *b = p_body_list.first();
+	while (b) {
+		active_bodies.push_back(b->self());
+		b = b->next();
+	}
+}
+
+void GodotStep2D::_integrate_forces(uint32_t p_body_index, void *p_userdata) {
+	active_bodies[p_body_index]->integrate_forces(delta);
+}
+
+void GodotStep2D::_integrate_velocities(uint32_t p_body_index, void *p_userdata) {
+	active_bodies[p_body_index]->integrate_velocities(delta);
+}
+
 void GodotStep2D::_setup_contraint(uint32_t p_constraint_index, void *p_userdata) {
 	GodotConstraint2D *constraint = all_constraints[p_constraint_index];
 	constraint->setup(delta);
@@ -141,16 +160,18 @@ void GodotStep2D::step(GodotSpace2D *p_space, real_t p_delta, int p_iterations)
 	uint64_t profile_begtime = OS::get_singleton()->get_ticks_usec();
 	uint64_t profile_endtime = 0;
 
-	int active_count = 0;
+	_collect_active_bodies(*body_list);
 
-	const SelfList<GodotBody2D> *b = body_list->first();
-	while (b) {
-		b->self()->integrate_forces(p_delta);
-		b = b->next();
-		active_count++;
+	uint32_t active_count = active_bodies.size();
+	work_pool.do_work(active_count, this, &GodotStep2D::_integrate_forces, nullptr);
+
+	// Broad phase updates can't run on threads, they are applied in list order
+	// so the results don't depend on the scheduling.
+	for (uint32_t body_index = 0; body_index < active_count; ++body_index) {
+		active_bodies[body_index]->post_integrate_forces();
 	}
 
-	p_space->set_active_objects(active_count);
+	p_space->set_active_objects((int)active_count);
 
 	{ //profile
 		profile_endtime = OS::get_singleton()->get_ticks_usec();
@@ -188,7 +209,7 @@ void GodotStep2D::step(GodotSpace2D *p_space, real_t p_delta, int p_iterations)
 
 	/* GENERATE CONSTRAINT ISLANDS FOR ACTIVE RIGID BODIES */
 
-	b = body_list->first();
+	const SelfList<GodotBody2D> *b = body_list->first();
 
 	uint32_t body_island_count = 0;
 
@@ -269,11 +290,14 @@ void GodotStep2D::step(GodotSpace2D *p_space, real_t p_delta, int p_iterations)
 
 	/* INTEGRATE VELOCITIES */
 
-	b = body_list->first();
-	while (b) {
-		const SelfList<GodotBody2D> *n = b->next();
-		b->self()->integrate_velocities(p_delta);
-		b = n; // in case it shuts itself down
+	// Solving may have woken up more bodies.
+	_collect_active_bodies(*body_list);
+
+	active_count = active_bodies.size();
+	work_pool.do_work(active_count, this, &GodotStep2D::_integrate_velocities, nullptr);
+
+	for (uint32_t body_index = 0; body_index < active_count; ++body_index) {
+		active_bodies[body_index]->post_integrate_velocities(); // May remove the body from the active list.
 	}
 
 	/* SLEEP / WAKE UP ISLANDS */
@@ -289,6 +313,7 @@ void GodotStep2D::step(GodotSpace2D *p_space, real_t p_delta, int p_iterations)
 	}
 
 	all_constraints.clear();
+	active_bodies.clear();
 
 	p_space->update();
 	p_space->unlock();
@@ -299,6 +324,7 @@ GodotStep2D::GodotStep2D() {
 	body_islands.reserve(BODY_ISLAND_COUNT_RESERVE);
 	constraint_islands.reserve(ISLAND_COUNT_RESERVE);
 	all_constraints.reserve(CONSTRAINT_COUNT_RESERVE);
+	active_bodies.reserve(ACTIVE_BODY_COUNT_RESERVE);
 
 	work_pool.init();
 }
@@ -40,6 +40,14 @@ void GodotBody3D::_mass_properties_changed() {
 	}
 }
 
+void GodotBody3D::_sleep_state_changed() {
+	// Broad phase sleeping state is applied by the space outside of the solver,
+	// since it can add and remove pair constraints.
+	if (get_space() && !sleep_state_update_list.in_list()) {
+		get_space()->body_add_to_sleep_state_update_list(&sleep_state_update_list);
+	}
+}
+
 void GodotBody3D::_update_transform_dependent() {
 	center_of_mass = get_transform().basis.xform(center_of_mass_local);
 	principal_inertia_axes = get_transform().basis * principal_inertia_axes_local;
@@ -164,6 +172,11 @@ void GodotBody3D::update_mass_properties() {
 	_update_transform_dependent();
 }
 
+void GodotBody3D::update_sleep_state() {
+	// Only dynamic bodies go to sleep, kinematic bodies must keep pairing with everything to push them.
+	_set_sleeping(!active && mode >= PhysicsServer3D::BODY_MODE_DYNAMIC);
+}
+
 void GodotBody3D::reset_mass_properties() {
 	calculate_inertia = true;
 	calculate_center_of_mass = true;
@@ -187,6 +200,8 @@ void GodotBody3D::set_active(bool p_active) {
 	} else if (get_space()) {
 		get_space()->body_remove_from_active_list(&active_list);
 	}
+
+	_sleep_state_changed();
 }
 
 void GodotBody3D::set_param(PhysicsServer3D::BodyParameter p_param, const Variant &p_value) {
@@ -319,6 +334,8 @@ void GodotBody3D::set_mode(PhysicsServer3D::BodyMode p_mode) {
 			set_active(true);
 		}
 	}
+
+	_sleep_state_changed();
 }
 
 PhysicsServer3D::BodyMode GodotBody3D::get_mode() const {
@@ -431,6 +448,9 @@ void GodotBody3D::set_space(GodotSpace3D *p_space) {
 		if (direct_state_query_list.in_list()) {
 			get_space()->body_remove_from_state_query_list(&direct_state_query_list);
 		}
+		if (sleep_state_update_list.in_list()) {
+			get_space()->body_remove_from_sleep_state_update_list(&sleep_state_update_list);
+		}
 	}
 
 	_set_space(p_space);
@@ -440,6 +460,7 @@ void GodotBody3D::set_space(GodotSpace3D *p_space) {
 		if (active) {
 			get_space()->body_add_to_active_list(&active_list);
 		}
+		_sleep_state_changed();
 	}
 }
 
@@ -746,7 +767,8 @@ GodotBody3D::GodotBody3D() :
 		GodotCollisionObject3D(TYPE_BODY),
 		active_list(this),
 		mass_properties_update_list(this),
-		direct_state_query_list(this) {
+		direct_state_query_list(this),
+		sleep_state_update_list(this) {
 	_set_static(false);
 }
 
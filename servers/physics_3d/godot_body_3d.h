@@ -89,6 +89,7 @@ class GodotBody3D : public GodotCollisionObject3D {
 	SelfList<GodotBody3D> active_list;
 	SelfList<GodotBody3D> mass_properties_update_list;
 	SelfList<GodotBody3D> direct_state_query_list;
+	SelfList<GodotBody3D> sleep_state_update_list;
 
 	VSet<RID> exceptions;
 	bool omit_force_integration = false;
@@ -99,6 +100,7 @@ class GodotBody3D : public GodotCollisionObject3D {
 	bool first_time_kinematic = false;
 
 	void _mass_properties_changed();
+	void _sleep_state_changed();
 	virtual void _shapes_changed();
 	Transform3D new_transform;
 
@@ -281,6 +283,8 @@ public:
 	void update_mass_properties();
 	void reset_mass_properties();
 
+	void update_sleep_state();
+
 	_FORCE_INLINE_ real_t get_inv_mass() const { return _inv_mass; }
 	_FORCE_INLINE_ const Vector3 &get_inv_inertia() const { return _inv_inertia; }
 	_FORCE_INLINE_ const Basis &get_inv_inertia_tensor() const { return _inv_inertia_tensor; }
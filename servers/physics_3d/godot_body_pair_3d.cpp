@@ -175,30 +175,19 @@ bool GodotBodyPair3D::_test_ccd(real_t p_step, GodotBody3D *p_A, int p_shape_A,
 	p_A->get_shape(p_shape_A)->project_range(mnormal, p_xform_A, min, max);
 	bool fast_object = mlen > (max - min) * 0.3; //going too fast in that direction
 
-	if (!fast_object) { //did it move enough in this direction to even attempt raycast? let's say it should move more than 1/3 the size of the object in that axis
+	if (!fast_object) { //did it move enough in this direction to even attempt a sweep? let's say it should move more than 1/3 the size of the object in that axis
 		return false;
 	}
 
-	//cast a segment from support in motion normal, in the same direction of motion by motion length
-	//support is the worst case collision point, so real collision happened before
-	Vector3 s = p_A->get_shape(p_shape_A)->get_support(p_xform_A.basis.xform(mnormal).normalized());
-	Vector3 from = p_xform_A.xform(s);
-	Vector3 to = from + motion;
-
-	Transform3D from_inv = p_xform_B.affine_inverse();
-
-	Vector3 local_from = from_inv.xform(from - mnormal * mlen * 0.1); //start from a little inside the bounding box
-	Vector3 local_to = from_inv.xform(to);
-
-	Vector3 rpos, rnorm;
-	if (!p_B->get_shape(p_shape_B)->intersect_segment(local_from, local_to, rpos, rnorm)) {
+	// Sweep the whole shape along the motion, so walls thinner than the shape can't be tunneled through.
+	real_t margin = (max - min) * 0.01;
+	real_t toi;
+	if (!GodotCollisionSolver3D::solve_time_of_impact(p_A->get_shape(p_shape_A), p_xform_A, motion, p_B->get_shape(p_shape_B), p_xform_B, margin, toi)) {
 		return false;
 	}
 
 	//shorten the linear velocity so it does not hit, but gets close enough, next frame will hit softly or soft enough
-	Vector3 hitpos = p_xform_B.xform(rpos);
-
-	real_t newlen = hitpos.distance_to(from) - (max - min) * 0.01;
+	real_t newlen = MAX(mlen * toi - margin, (real_t)0.0);
 	p_A->set_linear_velocity((mnormal * newlen) / p_step);
 
 	return true;
@@ -249,7 +238,7 @@ bool GodotBodyPair3D::setup(real_t p_step) {
 	collided = GodotCollisionSolver3D::solve_static(shape_A_ptr, xform_A, shape_B_ptr, xform_B, _contact_added_callback, this, &sep_axis);
 
 	if (!collided) {
-		//test ccd (currently just a raycast)
+		//test ccd
 
 		if (A->is_continuous_collision_detection_enabled() && collide_A) {
 			_test_ccd(p_step, A, shape_A, xform_A, B, shape_B, xform_B);
@@ -46,6 +46,18 @@ void GodotBroadPhase3DBVH::set_static(ID p_id, bool p_static) {
 	bvh.set_pairable(p_id - 1, !p_static, 1 << it->get_type(), p_static ? 0 : 0xFFFFF, false); // Pair everything, don't care?
 }
 
+void GodotBroadPhase3DBVH::set_sleeping(ID p_id, bool p_sleeping) {
+	if (is_static(p_id)) {
+		return; // Static objects already only pair with active ones.
+	}
+	GodotCollisionObject3D *it = bvh.get(p_id - 1);
+	// Sleeping objects stay in the pairable tree so active objects can still find (and wake) them,
+	// but they stop pairing with each other and with static objects. Only area pairs are kept,
+	// so that sleeping doesn't trigger exit/enter notifications.
+	uint32_t pairable_mask = p_sleeping ? (1 << GodotCollisionObject3D::TYPE_AREA) : 0xFFFFF;
+	bvh.set_pairable(p_id - 1, true, 1 << it->get_type(), pairable_mask, false);
+}
+
 void GodotBroadPhase3DBVH::remove(ID p_id) {
 	bvh.erase(p_id - 1);
 }
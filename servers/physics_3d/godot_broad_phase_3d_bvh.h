@@ -51,6 +51,7 @@ public:
 	virtual ID create(GodotCollisionObject3D *p_object, int p_subindex = 0, const AABB &p_aabb = AABB(), bool p_static = false);
 	virtual void move(ID p_id, const AABB &p_aabb);
 	virtual void set_static(ID p_id, bool p_static);
+	virtual void set_sleeping(ID p_id, bool p_sleeping);
 	virtual void remove(ID p_id);
 
 	virtual GodotCollisionObject3D *get_object(ID p_id) const;
@@ -570,3 +570,120 @@ bool GodotCollisionSolver3D::solve_distance(const GodotShape3D *p_shape_A, const
 		return gjk_epa_calculate_distance(p_shape_A, p_transform_A, p_shape_B, p_transform_B, r_point_A, r_point_B); //should pass sepaxis..
 	}
 }
+
+#define TIME_OF_IMPACT_MAX_ITERATIONS 32
+
+bool GodotCollisionSolver3D::solve_convex_time_of_impact(const GodotShape3D *p_shape_A, const Transform3D &p_transform_A, const Vector3 &p_motion_A, const GodotShape3D *p_shape_B, const Transform3D &p_transform_B, real_t p_tolerance, real_t &r_toi) {
+	bool world_boundary_B = p_shape_B->get_type() == PhysicsServer3D::SHAPE_WORLD_BOUNDARY;
+
+	Transform3D transform_A = p_transform_A;
+	real_t toi = 0.0;
+
+	for (int i = 0; i < TIME_OF_IMPACT_MAX_ITERATIONS; i++) {
+		transform_A.origin = p_transform_A.origin + p_motion_A * toi;
+
+		Vector3 close_A, close_B;
+		bool separated;
+		if (world_boundary_B) {
+			separated = !solve_distance_world_boundary(p_shape_B, p_transform_B, p_shape_A, transform_A, close_B, close_A);
+		} else {
+			separated = gjk_epa_calculate_distance(p_shape_A, transform_A, p_shape_B, p_transform_B, close_A, close_B);
+		}
+
+		if (!separated) {
+			if (i == 0) {
+				return false; // Already in contact, left to the regular collision.
+			}
+			r_toi = toi;
+			return true;
+		}
+
+		Vector3 normal = close_B - close_A;
+		real_t distance = normal.length();
+		if (distance < CMP_EPSILON) {
+			r_toi = toi;
+			return i > 0;
+		}
+		normal /= distance;
+
+		real_t approach = p_motion_A.dot(normal);
+		if (approach <= CMP_EPSILON) {
+			return false; // Moving away from B, or sliding along it.
+		}
+
+		if (distance <= p_tolerance) {
+			r_toi = toi;
+			return true;
+		}
+
+		// The distance between two convex shapes is convex along a translation, so
+		// advancing by the distance over the approach speed never skips the contact.
+		toi += distance / approach;
+		if (toi > 1.0) {
+			return false;
+		}
+	}
+
+	// Still approaching, the current fraction is a safe lower bound.
+	r_toi = toi;
+	return true;
+}
+
+struct _ConcaveTimeOfImpactInfo {
+	const GodotShape3D *shape_A;
+	const Transform3D *transform_A;
+	const Vector3 *motion_A;
+	const Transform3D *transform_B;
+	real_t tolerance;
+	bool hit;
+	real_t toi;
+};
+
+bool GodotCollisionSolver3D::concave_time_of_impact_callback(void *p_userdata, GodotShape3D *p_convex) {
+	_ConcaveTimeOfImpactInfo &tinfo = *(_ConcaveTimeOfImpactInfo *)(p_userdata);
+
+	real_t toi;
+	if (solve_convex_time_of_impact(tinfo.shape_A, *tinfo.transform_A, *tinfo.motion_A, p_convex, *tinfo.transform_B, tinfo.tolerance, toi)) {
+		if (!tinfo.hit || toi < tinfo.toi) {
+			tinfo.toi = toi;
+			tinfo.hit = true;
+		}
+	}
+
+	return false;
+}
+
+bool GodotCollisionSolver3D::solve_time_of_impact(const GodotShape3D *p_shape_A, const Transform3D &p_transform_A, const Vector3 &p_motion_A, const GodotShape3D *p_shape_B, const Transform3D &p_transform_B, real_t p_tolerance, real_t &r_toi) {
+	if (p_shape_A->is_concave() || p_shape_A->get_type() == PhysicsServer3D::SHAPE_WORLD_BOUNDARY) {
+		return false;
+	}
+
+	PhysicsServer3D::ShapeType type_B = p_shape_B->get_type();
+	if (type_B == PhysicsServer3D::SHAPE_SEPARATION_RAY || type_B == PhysicsServer3D::SHAPE_SOFT_BODY) {
+		return false;
+	}
+
+	if (!p_shape_B->is_concave()) {
+		return solve_convex_time_of_impact(p_shape_A, p_transform_A, p_motion_A, p_shape_B, p_transform_B, p_tolerance, r_toi);
+	}
+
+	// Test every face swept over by A.
+	AABB swept_aabb = p_transform_A.xform(p_shape_A->get_aabb());
+	swept_aabb.merge_with(AABB(swept_aabb.position + p_motion_A, swept_aabb.size));
+	AABB local_aabb = p_transform_B.affine_inverse().xform(swept_aabb);
+
+	_ConcaveTimeOfImpactInfo tinfo;
+	tinfo.shape_A = p_shape_A;
+	tinfo.transform_A = &p_transform_A;
+	tinfo.motion_A = &p_motion_A;
+	tinfo.transform_B = &p_transform_B;
+	tinfo.tolerance = p_tolerance;
+	tinfo.hit = false;
+	tinfo.toi = 1.0;
+
+	const GodotConcaveShape3D *concave_B = static_cast<const GodotConcaveShape3D *>(p_shape_B);
+	concave_B->cull(local_aabb, concave_time_of_impact_callback, &tinfo);
+
+	r_toi = tinfo.toi;
+	return tinfo.hit;
+}
@@ -1605,6 +1605,8 @@ void GodotPhysicsServer3D::step(real_t p_step) {
 
 	_update_shapes();
 
+	uint64_t time_beg = OS::get_singleton()->get_ticks_usec();
+
 	island_count = 0;
 	active_objects = 0;
 	collision_pairs = 0;
@@ -1614,6 +1616,8 @@ void GodotPhysicsServer3D::step(real_t p_step) {
 		active_objects += E->get()->get_active_objects();
 		collision_pairs += E->get()->get_collision_pairs();
 	}
+
+	step_time = OS::get_singleton()->get_ticks_usec() - time_beg;
 #endif
 }
 
@@ -1693,6 +1697,9 @@ int GodotPhysicsServer3D::get_process_info(ProcessInfo p_info) {
 		case INFO_ISLAND_COUNT: {
 			return island_count;
 		} break;
+		case INFO_STEP_TIME: {
+			return step_time;
+		} break;
 	}
 
 	return 0;
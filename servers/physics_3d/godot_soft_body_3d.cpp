@@ -36,6 +36,10 @@
 #include "core/templates/map.h"
 #include "servers/rendering_server.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 // Based on Bullet soft body.
 
 /*
@@ -193,24 +197,18 @@ void GodotSoftBody3D::update_normals_and_centroids() {
 	}
 }
 
-void GodotSoftBody3D::update_bounds() {
+void GodotSoftBody3D::compute_bounds() {
 	AABB prev_bounds = bounds;
 	prev_bounds.grow_by(collision_margin);
 
 	bounds = AABB();
-
-	const uint32_t nodes_count = nodes.size();
-	if (nodes_count == 0) {
-		deinitialize_shape();
-		return;
-	}
+	bounds_moved = false;
 
 	bool first = true;
-	bool moved = false;
-	for (uint32_t node_index = 0; node_index < nodes_count; ++node_index) {
+	for (uint32_t node_index = 0, nodes_count = nodes.size(); node_index < nodes_count; ++node_index) {
 		const Node &node = nodes[node_index];
 		if (!prev_bounds.has_point(node.x)) {
-			moved = true;
+			bounds_moved = true;
 		}
 		if (first) {
 			bounds.position = node.x;
@@ -219,15 +217,28 @@ void GodotSoftBody3D::update_bounds() {
 			bounds.expand_to(node.x);
 		}
 	}
+}
+
+void GodotSoftBody3D::update_bounds() {
+	compute_bounds();
+	update_shape();
+}
+
+void GodotSoftBody3D::update_shape() {
+	if (nodes.is_empty()) {
+		deinitialize_shape();
+		return;
+	}
 
 	if (get_space()) {
-		initialize_shape(moved);
+		initialize_shape(bounds_moved);
 	}
 }
 
 void GodotSoftBody3D::update_constants() {
 	reset_link_rest_lengths();
 	update_link_constants();
+	update_link_solver();
 	update_area();
 }
 
@@ -293,6 +304,28 @@ void GodotSoftBody3D::update_link_constants() {
 	}
 }
 
+void GodotSoftBody3D::update_link_solver() {
+	const uint32_t link_count = links.size();
+	link_solver.node_a.resize(link_count);
+	link_solver.node_b.resize(link_count);
+	link_solver.inv_c0.resize(link_count);
+	link_solver.c1.resize(link_count);
+	for (uint32_t i = 0; i < link_count; ++i) {
+		const Link &link = links[i];
+		link_solver.node_a[i] = link.n[0]->index;
+		link_solver.node_b[i] = link.n[1]->index;
+		// Links between pinned nodes are kept, but have no effect.
+		link_solver.inv_c0[i] = (link.c0 > 0) ? (1.0 / link.c0) : 0.0;
+		link_solver.c1[i] = link.c1;
+	}
+
+	const uint32_t node_count = nodes.size();
+	link_solver.x.resize(node_count);
+	link_solver.y.resize(node_count);
+	link_solver.z.resize(node_count);
+	link_solver.im.resize(node_count);
+}
+
 void GodotSoftBody3D::apply_nodes_transform(const Transform3D &p_transform) {
 	if (soft_mesh.is_null()) {
 		return;
@@ -588,7 +621,7 @@ bool GodotSoftBody3D::create_from_trimesh(const Vector<int> &p_indices, const Ve
 	}
 
 	generate_bending_constraints(2);
-	reoptimize_link_order();
+	color_links();
 
 	update_constants();
 	update_normals_and_centroids();
@@ -696,133 +729,55 @@ void GodotSoftBody3D::generate_bending_constraints(int p_distance) {
 	}
 }
 
-//===================================================================
-//
-//
-// This function takes in a list of interdependent Links and tries
-// to maximize the distance between calculation
-// of dependent links. This increases the amount of parallelism that can
-// be exploited by out-of-order instruction processors with large but
-// (inevitably) finite instruction windows.
-//
-//===================================================================
-
-// A small structure to track lists of dependent link calculations.
-class LinkDeps {
-public:
-	int value; // A link calculation that is dependent on this one
-			// Positive values = "input A" while negative values = "input B"
-	LinkDeps *next; // Next dependence in the list
-};
-typedef LinkDeps *LinkDepsPtr;
-
-void GodotSoftBody3D::reoptimize_link_order() {
-	const int reop_not_dependent = -1;
-	const int reop_node_complete = -2;
-
-	uint32_t i, link_count = links.size(), node_count = nodes.size();
-	Link *lr;
-	int ar, br;
-	Node *node0 = &(nodes[0]);
-	Node *node1 = &(nodes[1]);
-	LinkDepsPtr link_dep;
-	int ready_list_head, ready_list_tail, link_num, link_dep_frees, dep_link;
-
-	// Allocate temporary buffers.
-	int *node_written_at = memnew_arr(int, node_count + 1); // What link calculation produced this node's current values?
-	int *link_dep_A = memnew_arr(int, link_count); // Link calculation input is dependent upon prior calculation #N
-	int *link_dep_B = memnew_arr(int, link_count);
-	int *ready_list = memnew_arr(int, link_count); // List of ready-to-process link calculations (# of links, maximum)
-	LinkDeps *link_dep_free_list = memnew_arr(LinkDeps, 2 * link_count); // Dependent-on-me list elements (2x# of links, maximum)
-	LinkDepsPtr *link_dep_list_starts = memnew_arr(LinkDepsPtr, link_count); // Start nodes of dependent-on-me lists, one for each link
-
-	// Copy the original, unsorted links to a side buffer.
-	Link *link_buffer = memnew_arr(Link, link_count);
-	memcpy(link_buffer, &(links[0]), sizeof(Link) * link_count);
-
-	// Clear out the node setup and ready list.
-	for (i = 0; i < node_count + 1; i++) {
-		node_written_at[i] = reop_not_dependent;
-	}
-	for (i = 0; i < link_count; i++) {
-		link_dep_list_starts[i] = nullptr;
-	}
-	ready_list_head = ready_list_tail = link_dep_frees = 0;
-
-	// Initial link analysis to set up data structures.
-	for (i = 0; i < link_count; i++) {
-		// Note which prior link calculations we are dependent upon & build up dependence lists.
-		lr = &(links[i]);
-		ar = (lr->n[0] - node0) / (node1 - node0);
-		br = (lr->n[1] - node0) / (node1 - node0);
-		if (node_written_at[ar] > reop_not_dependent) {
-			link_dep_A[i] = node_written_at[ar];
-			link_dep = &link_dep_free_list[link_dep_frees++];
-			link_dep->value = i;
-			link_dep->next = link_dep_list_starts[node_written_at[ar]];
-			link_dep_list_starts[node_written_at[ar]] = link_dep;
-		} else {
-			link_dep_A[i] = reop_not_dependent;
-		}
-		if (node_written_at[br] > reop_not_dependent) {
-			link_dep_B[i] = node_written_at[br];
-			link_dep = &link_dep_free_list[link_dep_frees++];
-			link_dep->value = -(int)(i + 1);
-			link_dep->next = link_dep_list_starts[node_written_at[br]];
-			link_dep_list_starts[node_written_at[br]] = link_dep;
-		} else {
-			link_dep_B[i] = reop_not_dependent;
-		}
+// Sorts links by color, so that no two links of the same color share a node.
+// Within a color, links are kept in their original order for memory locality.
+void GodotSoftBody3D::color_links() {
+	const uint32_t link_count = links.size();
 
-		// Add this link to the initial ready list, if it is not dependent on any other links.
-		if ((link_dep_A[i] == reop_not_dependent) && (link_dep_B[i] == reop_not_dependent)) {
-			ready_list[ready_list_tail++] = i;
-			link_dep_A[i] = link_dep_B[i] = reop_node_complete; // Probably not needed now.
-		}
+	LocalVector<Link> sorted_links;
+	sorted_links.reserve(link_count);
+
+	LocalVector<uint32_t> remaining_links;
+	remaining_links.resize(link_count);
+	for (uint32_t i = 0; i < link_count; ++i) {
+		remaining_links[i] = i;
+	}
+
+	// Last color each node was used with.
+	LocalVector<uint32_t> node_colors;
+	node_colors.resize(nodes.size());
+	for (uint32_t i = 0; i < node_colors.size(); ++i) {
+		node_colors[i] = UINT32_MAX;
+	}
+
+	link_solver.color_offsets.clear();
+
+	uint32_t color = 0;
+	while (!remaining_links.is_empty()) {
+		link_solver.color_offsets.push_back(sorted_links.size());
 
-		// Update the nodes to mark which ones are calculated by this link.
-		node_written_at[ar] = node_written_at[br] = i;
-	}
-
-	// Process the ready list and create the sorted list of links:
-	// -- By treating the ready list as a queue, we maximize the distance between any
-	//    inter-dependent node calculations.
-	// -- All other (non-related) nodes in the ready list will automatically be inserted
-	//    in between each set of inter-dependent link calculations by this loop.
-	i = 0;
-	while (ready_list_head != ready_list_tail) {
-		// Use ready list to select the next link to process.
-		link_num = ready_list[ready_list_head++];
-		// Copy the next-to-calculate link back into the original link array.
-		links[i++] = link_buffer[link_num];
-
-		// Free up any link inputs that are dependent on this one.
-		link_dep = link_dep_list_starts[link_num];
-		while (link_dep) {
-			dep_link = link_dep->value;
-			if (dep_link >= 0) {
-				link_dep_A[dep_link] = reop_not_dependent;
+		uint32_t remaining_count = 0;
+		for (uint32_t i = 0; i < remaining_links.size(); ++i) {
+			const Link &link = links[remaining_links[i]];
+			uint32_t &color_a = node_colors[link.n[0]->index];
+			uint32_t &color_b = node_colors[link.n[1]->index];
+			if (color_a == color || color_b == color) {
+				// One of the nodes is already used in this color, try again with the next one.
+				remaining_links[remaining_count++] = remaining_links[i];
 			} else {
-				dep_link = -dep_link - 1;
-				link_dep_B[dep_link] = reop_not_dependent;
+				color_a = color;
+				color_b = color;
+				sorted_links.push_back(link);
 			}
-			// Add this dependent link calculation to the ready list if *both* inputs are clear.
-			if ((link_dep_A[dep_link] == reop_not_dependent) && (link_dep_B[dep_link] == reop_not_dependent)) {
-				ready_list[ready_list_tail++] = dep_link;
-				link_dep_A[dep_link] = link_dep_B[dep_link] = reop_node_complete; // Probably not needed now.
-			}
-			link_dep = link_dep->next;
 		}
+		remaining_links.resize(remaining_count);
+
+		++color;
 	}
 
-	// Delete the temporary buffers.
-	memdelete_arr(node_written_at);
-	memdelete_arr(link_dep_A);
-	memdelete_arr(link_dep_B);
-	memdelete_arr(ready_list);
-	memdelete_arr(link_dep_free_list);
-	memdelete_arr(link_dep_list_starts);
-	memdelete_arr(link_buffer);
+	link_solver.color_offsets.push_back(sorted_links.size());
+
+	links = sorted_links;
 }
 
 void GodotSoftBody3D::append_link(uint32_t p_node1, uint32_t p_node2) {
@@ -1061,8 +1016,8 @@ void GodotSoftBody3D::predict_motion(real_t p_delta) {
 		node.f = Vector3();
 	}
 
-	// Bounds and tree update.
-	update_bounds();
+	// Bounds update, the shape is updated later in update_shape() since it's not thread safe.
+	compute_bounds();
 
 	// Node tree update.
 	for (i = 0, ni = nodes.size(); i < ni; ++i) {
@@ -1090,16 +1045,15 @@ void GodotSoftBody3D::solve_constraints(real_t p_delta) {
 
 	uint32_t i, ni;
 
-	for (i = 0, ni = links.size(); i < ni; ++i) {
-		Link &link = links[i];
-		link.c3 = link.n[1]->q - link.n[0]->q;
-		link.c2 = 1 / (link.c3.length_squared() * link.c0);
-	}
-
 	// Solve velocities.
 	for (i = 0, ni = nodes.size(); i < ni; ++i) {
 		Node &node = nodes[i];
 		node.x = node.q + node.v * p_delta;
+
+		link_solver.x[i] = node.x.x;
+		link_solver.y[i] = node.x.y;
+		link_solver.z[i] = node.x.z;
+		link_solver.im[i] = node.im;
 	}
 
 	// Solve positions.
@@ -1111,6 +1065,7 @@ void GodotSoftBody3D::solve_constraints(real_t p_delta) {
 	for (i = 0, ni = nodes.size(); i < ni; ++i) {
 		Node &node = nodes[i];
 
+		node.x = Vector3(link_solver.x[i], link_solver.y[i], link_solver.z[i]);
 		node.x += node.bv * p_delta;
 		node.bv = Vector3();
 
@@ -1123,19 +1078,89 @@ void GodotSoftBody3D::solve_constraints(real_t p_delta) {
 }
 
 void GodotSoftBody3D::solve_links(real_t kst, real_t ti) {
-	for (uint32_t i = 0, ni = links.size(); i < ni; ++i) {
-		Link &link = links[i];
-		if (link.c0 > 0) {
-			Node &node_a = *link.n[0];
-			Node &node_b = *link.n[1];
-			const Vector3 del = node_b.x - node_a.x;
-			const real_t len = del.length_squared();
-			if (link.c1 + len > CMP_EPSILON) {
-				const real_t k = ((link.c1 - len) / (link.c0 * (link.c1 + len))) * kst;
-				node_a.x -= del * (k * node_a.im);
-				node_b.x += del * (k * node_b.im);
+	const uint32_t *node_a = link_solver.node_a.ptr();
+	const uint32_t *node_b = link_solver.node_b.ptr();
+	const real_t *inv_c0 = link_solver.inv_c0.ptr();
+	const real_t *c1 = link_solver.c1.ptr();
+
+	real_t *x = link_solver.x.ptr();
+	real_t *y = link_solver.y.ptr();
+	real_t *z = link_solver.z.ptr();
+	const real_t *im = link_solver.im.ptr();
+
+	const uint32_t color_count = link_solver.color_offsets.is_empty() ? 0 : link_solver.color_offsets.size() - 1;
+	for (uint32_t color = 0; color < color_count; ++color) {
+		// Links don't share nodes within a color, so they can be solved side by side
+		// and the results written back without conflicts.
+		uint32_t i = link_solver.color_offsets[color];
+		const uint32_t ni = link_solver.color_offsets[color + 1];
+
+#if defined(__SSE2__) && !defined(REAL_T_IS_DOUBLE)
+		const __m128 epsilon = _mm_set1_ps(CMP_EPSILON);
+		const __m128 stiffness = _mm_set1_ps(kst);
+
+		for (; i + 4 <= ni; i += 4) {
+			const uint32_t *a = node_a + i;
+			const uint32_t *b = node_b + i;
+
+			const __m128 xa = _mm_setr_ps(x[a[0]], x[a[1]], x[a[2]], x[a[3]]);
+			const __m128 ya = _mm_setr_ps(y[a[0]], y[a[1]], y[a[2]], y[a[3]]);
+			const __m128 za = _mm_setr_ps(z[a[0]], z[a[1]], z[a[2]], z[a[3]]);
+			const __m128 xb = _mm_setr_ps(x[b[0]], x[b[1]], x[b[2]], x[b[3]]);
+			const __m128 yb = _mm_setr_ps(y[b[0]], y[b[1]], y[b[2]], y[b[3]]);
+			const __m128 zb = _mm_setr_ps(z[b[0]], z[b[1]], z[b[2]], z[b[3]]);
+
+			const __m128 dx = _mm_sub_ps(xb, xa);
+			const __m128 dy = _mm_sub_ps(yb, ya);
+			const __m128 dz = _mm_sub_ps(zb, za);
+			const __m128 len = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			const __m128 rest = _mm_loadu_ps(c1 + i);
+			const __m128 sum = _mm_add_ps(rest, len);
+
+			// Lanes where the sum is too small get k = 0, same as the scalar loop.
+			__m128 k = _mm_div_ps(_mm_mul_ps(_mm_sub_ps(rest, len), _mm_loadu_ps(inv_c0 + i)), sum);
+			k = _mm_and_ps(_mm_cmpgt_ps(sum, epsilon), _mm_mul_ps(k, stiffness));
+
+			const __m128 ka = _mm_mul_ps(k, _mm_setr_ps(im[a[0]], im[a[1]], im[a[2]], im[a[3]]));
+			const __m128 kb = _mm_mul_ps(k, _mm_setr_ps(im[b[0]], im[b[1]], im[b[2]], im[b[3]]));
+
+			float rxa[4], rya[4], rza[4], rxb[4], ryb[4], rzb[4];
+			_mm_storeu_ps(rxa, _mm_sub_ps(xa, _mm_mul_ps(dx, ka)));
+			_mm_storeu_ps(rya, _mm_sub_ps(ya, _mm_mul_ps(dy, ka)));
+			_mm_storeu_ps(rza, _mm_sub_ps(za, _mm_mul_ps(dz, ka)));
+			_mm_storeu_ps(rxb, _mm_add_ps(xb, _mm_mul_ps(dx, kb)));
+			_mm_storeu_ps(ryb, _mm_add_ps(yb, _mm_mul_ps(dy, kb)));
+			_mm_storeu_ps(rzb, _mm_add_ps(zb, _mm_mul_ps(dz, kb)));
+
+			for (int j = 0; j < 4; j++) {
+				x[a[j]] = rxa[j];
+				y[a[j]] = rya[j];
+				z[a[j]] = rza[j];
+				x[b[j]] = rxb[j];
+				y[b[j]] = ryb[j];
+				z[b[j]] = rzb[j];
 			}
 		}
+#endif
+
+		for (; i < ni; ++i) {
+			const uint32_t a = node_a[i];
+			const uint32_t b = node_b[i];
+			const real_t dx = x[b] - x[a];
+			const real_t dy = y[b] - y[a];
+			const real_t dz = z[b] - z[a];
+			const real_t len = dx * dx + dy * dy + dz * dz;
+			const real_t sum = c1[i] + len;
+			const real_t k = (sum > CMP_EPSILON) ? ((c1[i] - len) * inv_c0[i] / sum) * kst : 0.0;
+			const real_t ka = k * im[a];
+			const real_t kb = k * im[b];
+			x[a] -= dx * ka;
+			y[a] -= dy * ka;
+			z[a] -= dz * ka;
+			x[b] += dx * kb;
+			y[b] += dy * kb;
+			z[b] += dz * kb;
+		}
 	}
 }
 
@@ -1252,6 +1277,8 @@ void GodotSoftBody3D::destroy() {
 	links.clear();
 	faces.clear();
 
+	link_solver = LinkSolver();
+
 	bounds = AABB();
 	deinitialize_shape();
 }
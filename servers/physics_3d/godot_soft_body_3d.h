@@ -61,12 +61,10 @@ class GodotSoftBody3D : public GodotCollisionObject3D {
 	};
 
 	struct Link {
-		Vector3 c3; // gradient
 		Node *n[2] = { nullptr, nullptr }; // Node pointers
 		real_t rl = 0.0; // Rest length
 		real_t c0 = 0.0; // (ima+imb)*kLST
 		real_t c1 = 0.0; // rl^2
-		real_t c2 = 0.0; // |gradient|^2/c0
 	};
 
 	struct Face {
@@ -78,16 +76,38 @@ class GodotSoftBody3D : public GodotCollisionObject3D {
 		uint32_t index = 0;
 	};
 
+	// Data used by the link solver, stored as separate arrays.
+	// Links are sorted by color: links of the same color never share a node,
+	// so there is no dependency between them and they can be solved in any order.
+	struct LinkSolver {
+		LocalVector<uint32_t> color_offsets; // Index of the first link of each color, plus the link count.
+
+		// Per link.
+		LocalVector<uint32_t> node_a;
+		LocalVector<uint32_t> node_b;
+		LocalVector<real_t> inv_c0;
+		LocalVector<real_t> c1;
+
+		// Per node.
+		LocalVector<real_t> x;
+		LocalVector<real_t> y;
+		LocalVector<real_t> z;
+		LocalVector<real_t> im;
+	};
+
 	LocalVector<Node> nodes;
 	LocalVector<Link> links;
 	LocalVector<Face> faces;
 
+	LinkSolver link_solver;
+
 	DynamicBVH node_tree;
 	DynamicBVH face_tree;
 
 	LocalVector<uint32_t> map_visual_to_physics;
 
 	AABB bounds;
+	bool bounds_moved = false;
 
 	real_t collision_margin = 0.05;
 
@@ -204,7 +224,10 @@ public:
 	void set_drag_coefficient(real_t p_val);
 	_FORCE_INLINE_ real_t get_drag_coefficient() const { return drag_coefficient; }
 
+	// Can be called from multiple threads for different soft bodies, but must be followed by update_shape().
 	void predict_motion(real_t p_delta);
+	void update_shape();
+	// Can be called from multiple threads for different soft bodies.
 	void solve_constraints(real_t p_delta);
 
 	_FORCE_INLINE_ uint32_t get_node_index(void *p_node) const { return ((Node *)p_node)->index; }
@@ -222,11 +245,13 @@ protected:
 
 private:
 	void update_normals_and_centroids();
+	void compute_bounds();
 	void update_bounds();
 	void update_constants();
 	void update_area();
 	void reset_link_rest_lengths();
 	void update_link_constants();
+	void update_link_solver();
 
 	void apply_nodes_transform(const Transform3D &p_transform);
 
@@ -236,7 +261,7 @@ private:
 
 	bool create_from_trimesh(const Vector<int> &p_indices, const Vector<Vector3> &p_vertices);
 	void generate_bending_constraints(int p_distance);
-	void reoptimize_link_order();
+	void color_links();
 	void append_link(uint32_t p_node1, uint32_t p_node2);
 	void append_face(uint32_t p_node1, uint32_t p_node2, uint32_t p_node3);
 
@@ -1089,6 +1089,14 @@ void GodotSpace3D::body_remove_from_state_query_list(SelfList<GodotBody3D> *p_bo
 	state_query_list.remove(p_body);
 }
 
+void GodotSpace3D::body_add_to_sleep_state_update_list(SelfList<GodotBody3D> *p_body) {
+	sleep_state_update_list.add(p_body);
+}
+
+void GodotSpace3D::body_remove_from_sleep_state_update_list(SelfList<GodotBody3D> *p_body) {
+	sleep_state_update_list.remove(p_body);
+}
+
 void GodotSpace3D::area_add_to_monitor_query_list(SelfList<GodotArea3D> *p_area) {
 	monitor_query_list.add(p_area);
 }
@@ -1141,12 +1149,21 @@ void GodotSpace3D::setup() {
 		mass_properties_update_list.first()->self()->update_mass_properties();
 		mass_properties_update_list.remove(mass_properties_update_list.first());
 	}
+	_update_sleep_states();
 }
 
 void GodotSpace3D::update() {
+	_update_sleep_states();
 	broadphase->update();
 }
 
+void GodotSpace3D::_update_sleep_states() {
+	while (sleep_state_update_list.first()) {
+		sleep_state_update_list.first()->self()->update_sleep_state();
+		sleep_state_update_list.remove(sleep_state_update_list.first());
+	}
+}
+
 void GodotSpace3D::set_param(PhysicsServer3D::SpaceParameter p_param, real_t p_value) {
 	switch (p_param) {
 		case PhysicsServer3D::SPACE_PARAM_CONTACT_RECYCLE_RADIUS:
@@ -82,6 +82,7 @@ private:
 	SelfList<GodotBody3D>::List active_list;
 	SelfList<GodotBody3D>::List mass_properties_update_list;
 	SelfList<GodotBody3D>::List state_query_list;
+	SelfList<GodotBody3D>::List sleep_state_update_list;
 	SelfList<GodotArea3D>::List monitor_query_list;
 	SelfList<GodotArea3D>::List area_moved_list;
 	SelfList<GodotSoftBody3D>::List active_soft_body_list;
@@ -126,6 +127,7 @@ private:
 	friend class GodotPhysicsDirectSpaceState3D;
 
 	int _cull_aabb_for_body(GodotBody3D *p_body, const AABB &p_aabb);
+	void _update_sleep_states();
 
 public:
 	_FORCE_INLINE_ void set_self(const RID &p_self) { self = p_self; }
@@ -143,6 +145,9 @@ public:
 	void body_add_to_state_query_list(SelfList<GodotBody3D> *p_body);
 	void body_remove_from_state_query_list(SelfList<GodotBody3D> *p_body);
 
+	void body_add_to_sleep_state_update_list(SelfList<GodotBody3D> *p_body);
+	void body_remove_from_sleep_state_update_list(SelfList<GodotBody3D> *p_body);
+
 	void area_add_to_monitor_query_list(SelfList<GodotArea3D> *p_area);
 	void area_remove_from_monitor_query_list(SelfList<GodotArea3D> *p_area);
 	void area_add_to_moved_list(SelfList<GodotArea3D> *p_area);
@@ -39,6 +39,7 @@
 #define ISLAND_COUNT_RESERVE 128
 #define ISLAND_SIZE_RESERVE 512
 #define CONSTRAINT_COUNT_RESERVE 1024
+#define SOFT_BODY_COUNT_RESERVE 64
 
 void GodotStep3D::_populate_island(GodotBody3D *p_body, LocalVector<GodotBody3D *> &p_body_island, LocalVector<GodotConstraint3D *> &p_constraint_island) {
 	p_body->set_island_step(_step);
@@ -181,6 +182,14 @@ void GodotStep3D::_check_suspend(const LocalVector<GodotBody3D *> &p_body_island
 	}
 }
 
+void GodotStep3D::_predict_soft_body_motion(uint32_t p_soft_body_index, void *p_userdata) {
+	active_soft_bodies[p_soft_body_index]->predict_motion(delta);
+}
+
+void GodotStep3D::_solve_soft_body_constraints(uint32_t p_soft_body_index, void *p_userdata) {
+	active_soft_bodies[p_soft_body_index]->solve_constraints(delta);
+}
+
 void GodotStep3D::step(GodotSpace3D *p_space, real_t p_delta, int p_iterations) {
 	p_space->lock(); // can't access space during this
 
@@ -213,11 +222,23 @@ void GodotStep3D::step(GodotSpace3D *p_space, real_t p_delta, int p_iterations)
 
 	const SelfList<GodotSoftBody3D> *sb = soft_body_list->first();
 	while (sb) {
-		sb->self()->predict_motion(p_delta);
+		active_soft_bodies.push_back(sb->self());
 		sb = sb->next();
 		active_count++;
 	}
 
+	// Soft bodies are independent from each other, shapes are updated afterwards since it's not thread safe.
+	uint32_t soft_body_count = active_soft_bodies.size();
+	if (soft_body_count > 1) {
+		work_pool.do_work(soft_body_count, this, &GodotStep3D::_predict_soft_body_motion, nullptr);
+	} else if (soft_body_count > 0) {
+		_predict_soft_body_motion(0);
+	}
+
+	for (uint32_t soft_body_index = 0; soft_body_index < soft_body_count; ++soft_body_index) {
+		active_soft_bodies[soft_body_index]->update_shape();
+	}
+
 	p_space->set_active_objects(active_count);
 
 	{ //profile
@@ -388,10 +409,10 @@ void GodotStep3D::step(GodotSpace3D *p_space, real_t p_delta, int p_iterations)
 
 	/* UPDATE SOFT BODY CONSTRAINTS */
 
-	sb = soft_body_list->first();
-	while (sb) {
-		sb->self()->solve_constraints(p_delta);
-		sb = sb->next();
+	if (soft_body_count > 1) {
+		work_pool.do_work(soft_body_count, this, &GodotStep3D::_solve_soft_body_constraints, nullptr);
+	} else if (soft_body_count > 0) {
+		_solve_soft_body_constraints(0);
 	}
 
 	{ //profile
@@ -401,6 +422,7 @@ void GodotStep3D::step(GodotSpace3D *p_space, real_t p_delta, int p_iterations)
 	}
 
 	all_constraints.clear();
+	active_soft_bodies.clear();
 
 	p_space->update();
 	p_space->unlock();
@@ -411,6 +433,7 @@ GodotStep3D::GodotStep3D() {
 	body_islands.reserve(BODY_ISLAND_COUNT_RESERVE);
 	constraint_islands.reserve(ISLAND_COUNT_RESERVE);
 	all_constraints.reserve(CONSTRAINT_COUNT_RESERVE);
+	active_soft_bodies.reserve(SOFT_BODY_COUNT_RESERVE);
 
 	work_pool.init();
 }
@@ -73,6 +73,7 @@ public:
 #define ServerNameWrapMT PhysicsServer2DWrapMT
 #define server_name physics_2d_server
 #define WRITE_ACTION
+#define READ_ACTION
 
 #include "servers/server_wrap_mt_common.h"
 
@@ -321,6 +322,7 @@ public:
 #undef ServerName
 #undef server_name
 #undef WRITE_ACTION
+#undef READ_ACTION
 };
 
 #ifdef DEBUG_SYNC
@@ -32,15 +32,289 @@
 
 #include "core/os/os.h"
 
+void PhysicsDirectBodyState3DWrapMT::_invalidate_snapshot() {
+	server->_invalidate_body_snapshot(body);
+}
+
+void PhysicsDirectBodyState3DWrapMT::set_linear_velocity(const Vector3 &p_velocity) {
+	_invalidate_snapshot();
+	state->set_linear_velocity(p_velocity);
+}
+
+void PhysicsDirectBodyState3DWrapMT::set_angular_velocity(const Vector3 &p_velocity) {
+	_invalidate_snapshot();
+	state->set_angular_velocity(p_velocity);
+}
+
+void PhysicsDirectBodyState3DWrapMT::set_transform(const Transform3D &p_transform) {
+	_invalidate_snapshot();
+	state->set_transform(p_transform);
+}
+
+void PhysicsDirectBodyState3DWrapMT::add_central_force(const Vector3 &p_force) {
+	_invalidate_snapshot();
+	state->add_central_force(p_force);
+}
+
+void PhysicsDirectBodyState3DWrapMT::add_force(const Vector3 &p_force, const Vector3 &p_position) {
+	_invalidate_snapshot();
+	state->add_force(p_force, p_position);
+}
+
+void PhysicsDirectBodyState3DWrapMT::add_torque(const Vector3 &p_torque) {
+	_invalidate_snapshot();
+	state->add_torque(p_torque);
+}
+
+void PhysicsDirectBodyState3DWrapMT::apply_central_impulse(const Vector3 &p_impulse) {
+	_invalidate_snapshot();
+	state->apply_central_impulse(p_impulse);
+}
+
+void PhysicsDirectBodyState3DWrapMT::apply_impulse(const Vector3 &p_impulse, const Vector3 &p_position) {
+	_invalidate_snapshot();
+	state->apply_impulse(p_impulse, p_position);
+}
+
+void PhysicsDirectBodyState3DWrapMT::apply_torque_impulse(const Vector3 &p_impulse) {
+	_invalidate_snapshot();
+	state->apply_torque_impulse(p_impulse);
+}
+
+void PhysicsDirectBodyState3DWrapMT::set_sleep_state(bool p_sleep) {
+	_invalidate_snapshot();
+	state->set_sleep_state(p_sleep);
+}
+
 void PhysicsServer3DWrapMT::thread_exit() {
 	exit = true;
 }
 
 void PhysicsServer3DWrapMT::thread_step(real_t p_delta) {
 	physics_3d_server->step(p_delta);
+	_thread_update_body_snapshots();
 	step_sem.post();
 }
 
+bool PhysicsServer3DWrapMT::_thread_get_body_snapshot(RID p_body, BodyStateSnapshot *r_snapshot) const {
+	Variant transform = physics_3d_server->body_get_state(p_body, BODY_STATE_TRANSFORM);
+	if (transform.get_type() == Variant::NIL) {
+		return false; // Not a body.
+	}
+
+	r_snapshot->transform = transform;
+	r_snapshot->linear_velocity = physics_3d_server->body_get_state(p_body, BODY_STATE_LINEAR_VELOCITY);
+	r_snapshot->angular_velocity = physics_3d_server->body_get_state(p_body, BODY_STATE_ANGULAR_VELOCITY);
+	r_snapshot->sleeping = physics_3d_server->body_get_state(p_body, BODY_STATE_SLEEPING);
+	r_snapshot->can_sleep = physics_3d_server->body_get_state(p_body, BODY_STATE_CAN_SLEEP);
+	return true;
+}
+
+bool PhysicsServer3DWrapMT::thread_track_body(RID p_body, BodyStateSnapshot *r_snapshot) const {
+	if (!_thread_get_body_snapshot(p_body, r_snapshot)) {
+		return false;
+	}
+
+	snapshot_bodies.insert(p_body);
+	return true;
+}
+
+void PhysicsServer3DWrapMT::thread_untrack_body(RID p_body) {
+	if (snapshot_bodies.erase(p_body)) {
+		snapshot_bodies_removed.push_back(p_body);
+	}
+}
+
+void PhysicsServer3DWrapMT::_thread_update_body_snapshots() {
+	HashMap<RID, BodyStateSnapshot> &snapshots = body_snapshots[1 - body_snapshot_read];
+	for (Set<RID>::Element *E = snapshot_bodies.front(); E; E = E->next()) {
+		_thread_get_body_snapshot(E->get(), &snapshots[E->get()]);
+	}
+
+	// Handed over to the main thread, which erases them from both buffers in sync().
+	for (uint32_t i = 0; i < snapshot_bodies_removed.size(); i++) {
+		body_snapshots_released.push_back(snapshot_bodies_removed[i]);
+	}
+	snapshot_bodies_removed.clear();
+}
+
+void PhysicsServer3DWrapMT::_sync_body_snapshots() {
+	body_snapshot_read = 1 - body_snapshot_read;
+
+	// The step may have captured these before the main thread changed or freed them.
+	for (uint32_t i = 0; i < body_snapshots_invalidated.size(); i++) {
+		body_snapshots[0].erase(body_snapshots_invalidated[i]);
+		body_snapshots[1].erase(body_snapshots_invalidated[i]);
+	}
+	body_snapshots_invalidated.clear();
+
+	for (uint32_t i = 0; i < body_snapshots_released.size(); i++) {
+		body_snapshots[0].erase(body_snapshots_released[i]);
+		body_snapshots[1].erase(body_snapshots_released[i]);
+	}
+	body_snapshots_released.clear();
+}
+
+void PhysicsServer3DWrapMT::_refresh_body_snapshots() {
+	// Called between sync() and step(), while the server thread is idle, same as flush_queries().
+	HashMap<RID, BodyStateSnapshot> &snapshots = body_snapshots[body_snapshot_read];
+	for (HashMap<RID, BodyStateSnapshot>::Element *E = snapshots.front(); E; E = E->next()) {
+		_thread_get_body_snapshot(E->key(), &E->value());
+	}
+}
+
+void PhysicsServer3DWrapMT::_invalidate_body_snapshot(RID p_body) const {
+	if (body_snapshots[body_snapshot_read].erase(p_body) && step_in_flight) {
+		body_snapshots_invalidated.push_back(p_body);
+	}
+}
+
+void PhysicsServer3DWrapMT::_flush_pending_body_states() const {
+	if (Thread::get_caller_id() != main_thread || pending_body_states.is_empty()) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < pending_body_states.size(); i++) {
+		const PendingBodyState &pending = pending_body_states[i];
+		for (uint32_t j = 0; j < pending.state_count; j++) {
+			command_queue.push(physics_3d_server, &PhysicsServer3D::body_set_state, pending.body, pending.states[j], pending.values[pending.states[j]]);
+		}
+	}
+
+	pending_body_states.clear();
+	pending_body_state_indices.clear();
+}
+
+void PhysicsServer3DWrapMT::_body_write_action(RID p_body) const {
+	if (Thread::get_caller_id() != main_thread) {
+		return;
+	}
+
+	_flush_pending_body_states();
+	_invalidate_body_snapshot(p_body);
+}
+
+void PhysicsServer3DWrapMT::body_set_state(RID p_body, BodyState p_state, const Variant &p_variant) {
+	ERR_FAIL_INDEX(p_state, BODY_STATE_CAN_SLEEP + 1);
+
+	if (Thread::get_caller_id() == server_thread) {
+		command_queue.flush_if_pending();
+		physics_3d_server->body_set_state(p_body, p_state, p_variant);
+		return;
+	}
+
+	if (Thread::get_caller_id() != main_thread) {
+		command_queue.push(physics_3d_server, &PhysicsServer3D::body_set_state, p_body, p_state, p_variant);
+		return;
+	}
+
+	_invalidate_body_snapshot(p_body);
+
+	// Only the last value written to each state is sent, in the order of the last writes.
+	const uint32_t *index = pending_body_state_indices.getptr(p_body);
+	if (!index) {
+		pending_body_state_indices[p_body] = pending_body_states.size();
+		pending_body_states.push_back(PendingBodyState());
+		pending_body_states[pending_body_states.size() - 1].body = p_body;
+		index = pending_body_state_indices.getptr(p_body);
+	}
+
+	PendingBodyState &pending = pending_body_states[*index];
+	for (uint32_t i = 0; i < pending.state_count; i++) {
+		if (pending.states[i] == p_state) {
+			for (uint32_t j = i + 1; j < pending.state_count; j++) {
+				pending.states[j - 1] = pending.states[j];
+			}
+			pending.state_count--;
+			break;
+		}
+	}
+	pending.states[pending.state_count++] = p_state;
+	pending.values[p_state] = p_variant;
+}
+
+Variant PhysicsServer3DWrapMT::body_get_state(RID p_body, BodyState p_state) const {
+	if (Thread::get_caller_id() == server_thread) {
+		command_queue.flush_if_pending();
+		return physics_3d_server->body_get_state(p_body, p_state);
+	}
+
+	if (Thread::get_caller_id() != main_thread) {
+		Variant ret;
+		command_queue.push_and_ret(physics_3d_server, &PhysicsServer3D::body_get_state, p_body, p_state, &ret);
+		return ret;
+	}
+
+	const BodyStateSnapshot *snapshot = body_snapshots[body_snapshot_read].getptr(p_body);
+	if (!snapshot) {
+		// First read since the body was created or changed, fetch it and keep it updated after each step.
+		_flush_pending_body_states();
+
+		BodyStateSnapshot fetched;
+		bool valid = false;
+		command_queue.push_and_ret(this, &PhysicsServer3DWrapMT::thread_track_body, p_body, &fetched, &valid);
+		if (!valid) {
+			return Variant();
+		}
+		body_snapshots[body_snapshot_read][p_body] = fetched;
+		snapshot = body_snapshots[body_snapshot_read].getptr(p_body);
+	}
+
+	switch (p_state) {
+		case BODY_STATE_TRANSFORM:
+			return snapshot->transform;
+		case BODY_STATE_LINEAR_VELOCITY:
+			return snapshot->linear_velocity;
+		case BODY_STATE_ANGULAR_VELOCITY:
+			return snapshot->angular_velocity;
+		case BODY_STATE_SLEEPING:
+			return snapshot->sleeping;
+		case BODY_STATE_CAN_SLEEP:
+			return snapshot->can_sleep;
+	}
+
+	return Variant();
+}
+
+PhysicsDirectBodyState3D *PhysicsServer3DWrapMT::body_get_direct_state(RID p_body) {
+	ERR_FAIL_COND_V(main_thread != Thread::get_caller_id(), nullptr);
+
+	PhysicsDirectBodyState3D *state = physics_3d_server->body_get_direct_state(p_body);
+	if (!state || !create_thread) {
+		return state;
+	}
+
+	// Writes made through the direct state bypass the command queue, so they are wrapped to drop the snapshot.
+	PhysicsDirectBodyState3DWrapMT **wrapped = direct_body_states.getptr(p_body);
+	if (!wrapped) {
+		PhysicsDirectBodyState3DWrapMT *new_state = memnew(PhysicsDirectBodyState3DWrapMT);
+		new_state->server = this;
+		new_state->body = p_body;
+		direct_body_states[p_body] = new_state;
+		wrapped = direct_body_states.getptr(p_body);
+	}
+	(*wrapped)->state = state;
+	return *wrapped;
+}
+
+void PhysicsServer3DWrapMT::free(RID p_rid) {
+	if (Thread::get_caller_id() != server_thread) {
+		PhysicsDirectBodyState3DWrapMT **wrapped = Thread::get_caller_id() == main_thread ? direct_body_states.getptr(p_rid) : nullptr;
+		if (wrapped) {
+			memdelete(*wrapped);
+			direct_body_states.erase(p_rid);
+		}
+
+		_body_write_action(p_rid);
+		command_queue.push(physics_3d_server, &PhysicsServer3D::free, p_rid);
+		command_queue.push(this, &PhysicsServer3DWrapMT::thread_untrack_body, p_rid);
+	} else {
+		command_queue.flush_if_pending();
+		physics_3d_server->free(p_rid);
+		thread_untrack_body(p_rid);
+	}
+}
+
 void PhysicsServer3DWrapMT::_thread_callback(void *_instance) {
 	PhysicsServer3DWrapMT *vsmt = reinterpret_cast<PhysicsServer3DWrapMT *>(_instance);
 
@@ -68,7 +342,9 @@ void PhysicsServer3DWrapMT::thread_loop() {
 
 void PhysicsServer3DWrapMT::step(real_t p_step) {
 	if (create_thread) {
+		_flush_pending_body_states();
 		command_queue.push(this, &PhysicsServer3DWrapMT::thread_step, p_step);
+		step_in_flight = true;
 	} else {
 		command_queue.flush_all(); //flush all pending from other threads
 		physics_3d_server->step(p_step);
@@ -81,6 +357,8 @@ void PhysicsServer3DWrapMT::sync() {
 			first_frame = false;
 		} else {
 			step_sem.wait(); //must not wait if a step was not issued
+			step_in_flight = false;
+			_sync_body_snapshots();
 		}
 	}
 	physics_3d_server->sync();
@@ -88,6 +366,11 @@ void PhysicsServer3DWrapMT::sync() {
 
 void PhysicsServer3DWrapMT::flush_queries() {
 	physics_3d_server->flush_queries();
+
+	if (create_thread) {
+		// State sync callbacks and _integrate_forces() write to the bodies directly.
+		_refresh_body_snapshots();
+	}
 }
 
 void PhysicsServer3DWrapMT::end_sync() {
@@ -108,6 +391,7 @@ void PhysicsServer3DWrapMT::init() {
 
 void PhysicsServer3DWrapMT::finish() {
 	if (thread.is_started()) {
+		_flush_pending_body_states();
 		command_queue.push(this, &PhysicsServer3DWrapMT::thread_exit);
 		thread.wait_to_finish();
 	} else {
@@ -132,6 +416,9 @@ PhysicsServer3DWrapMT::PhysicsServer3DWrapMT(PhysicsServer3D *p_contained, bool
 }
 
 PhysicsServer3DWrapMT::~PhysicsServer3DWrapMT() {
+	for (HashMap<RID, PhysicsDirectBodyState3DWrapMT *>::Element *E = direct_body_states.front(); E; E = E->next()) {
+		memdelete(E->value());
+	}
 	memdelete(physics_3d_server);
 	//finish();
 }
@@ -34,6 +34,9 @@
 #include "core/config/project_settings.h"
 #include "core/os/thread.h"
 #include "core/templates/command_queue_mt.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/local_vector.h"
+#include "core/templates/set.h"
 #include "servers/physics_server_3d.h"
 
 #ifdef DEBUG_SYNC
@@ -42,6 +45,72 @@
 #define SYNC_DEBUG
 #endif
 
+class PhysicsServer3DWrapMT;
+
+// Hands the main thread the server's own direct body state, and drops the
+// state snapshot of the body whenever it is written through.
+class PhysicsDirectBodyState3DWrapMT : public PhysicsDirectBodyState3D {
+	GDCLASS(PhysicsDirectBodyState3DWrapMT, PhysicsDirectBodyState3D);
+
+	friend class PhysicsServer3DWrapMT;
+
+	const PhysicsServer3DWrapMT *server = nullptr;
+	RID body;
+	PhysicsDirectBodyState3D *state = nullptr;
+
+	void _invalidate_snapshot();
+
+public:
+	virtual Vector3 get_total_gravity() const override { return state->get_total_gravity(); }
+	virtual real_t get_total_angular_damp() const override { return state->get_total_angular_damp(); }
+	virtual real_t get_total_linear_damp() const override { return state->get_total_linear_damp(); }
+
+	virtual Vector3 get_center_of_mass() const override { return state->get_center_of_mass(); }
+	virtual Basis get_principal_inertia_axes() const override { return state->get_principal_inertia_axes(); }
+	virtual real_t get_inverse_mass() const override { return state->get_inverse_mass(); }
+	virtual Vector3 get_inverse_inertia() const override { return state->get_inverse_inertia(); }
+	virtual Basis get_inverse_inertia_tensor() const override { return state->get_inverse_inertia_tensor(); }
+
+	virtual void set_linear_velocity(const Vector3 &p_velocity) override;
+	virtual Vector3 get_linear_velocity() const override { return state->get_linear_velocity(); }
+
+	virtual void set_angular_velocity(const Vector3 &p_velocity) override;
+	virtual Vector3 get_angular_velocity() const override { return state->get_angular_velocity(); }
+
+	virtual void set_transform(const Transform3D &p_transform) override;
+	virtual Transform3D get_transform() const override { return state->get_transform(); }
+
+	virtual Vector3 get_velocity_at_local_position(const Vector3 &p_position) const override { return state->get_velocity_at_local_position(p_position); }
+
+	virtual void add_central_force(const Vector3 &p_force) override;
+	virtual void add_force(const Vector3 &p_force, const Vector3 &p_position = Vector3()) override;
+	virtual void add_torque(const Vector3 &p_torque) override;
+	virtual void apply_central_impulse(const Vector3 &p_impulse) override;
+	virtual void apply_impulse(const Vector3 &p_impulse, const Vector3 &p_position = Vector3()) override;
+	virtual void apply_torque_impulse(const Vector3 &p_impulse) override;
+
+	virtual void set_sleep_state(bool p_sleep) override;
+	virtual bool is_sleeping() const override { return state->is_sleeping(); }
+
+	virtual int get_contact_count() const override { return state->get_contact_count(); }
+
+	virtual Vector3 get_contact_local_position(int p_contact_idx) const override { return state->get_contact_local_position(p_contact_idx); }
+	virtual Vector3 get_contact_local_normal(int p_contact_idx) const override { return state->get_contact_local_normal(p_contact_idx); }
+	virtual real_t get_contact_impulse(int p_contact_idx) const override { return state->get_contact_impulse(p_contact_idx); }
+	virtual int get_contact_local_shape(int p_contact_idx) const override { return state->get_contact_local_shape(p_contact_idx); }
+
+	virtual RID get_contact_collider(int p_contact_idx) const override { return state->get_contact_collider(p_contact_idx); }
+	virtual Vector3 get_contact_collider_position(int p_contact_idx) const override { return state->get_contact_collider_position(p_contact_idx); }
+	virtual ObjectID get_contact_collider_id(int p_contact_idx) const override { return state->get_contact_collider_id(p_contact_idx); }
+	virtual Object *get_contact_collider_object(int p_contact_idx) const override { return state->get_contact_collider_object(p_contact_idx); }
+	virtual int get_contact_collider_shape(int p_contact_idx) const override { return state->get_contact_collider_shape(p_contact_idx); }
+	virtual Vector3 get_contact_collider_velocity_at_position(int p_contact_idx) const override { return state->get_contact_collider_velocity_at_position(p_contact_idx); }
+
+	virtual real_t get_step() const override { return state->get_step(); }
+
+	virtual PhysicsDirectSpaceState3D *get_space_state() override { return state->get_space_state(); }
+};
+
 class PhysicsServer3DWrapMT : public PhysicsServer3D {
 	mutable PhysicsServer3D *physics_3d_server;
 
@@ -67,11 +136,63 @@ class PhysicsServer3DWrapMT : public PhysicsServer3D {
 	Mutex alloc_mutex;
 	int pool_max_size = 0;
 
+	struct BodyStateSnapshot {
+		Transform3D transform;
+		Vector3 linear_velocity;
+		Vector3 angular_velocity;
+		bool sleeping = false;
+		bool can_sleep = true;
+	};
+
+	// Body states captured by the server thread at the end of each step, so the
+	// main thread can read them without waiting on the command queue. The server
+	// thread only writes the buffer that is not being read, the buffers are
+	// swapped in sync() once the step is done.
+	mutable HashMap<RID, BodyStateSnapshot> body_snapshots[2];
+	int body_snapshot_read = 0;
+	bool step_in_flight = false;
+	mutable LocalVector<RID> body_snapshots_invalidated;
+	LocalVector<RID> body_snapshots_released;
+
+	// Server thread only.
+	mutable Set<RID> snapshot_bodies;
+	mutable LocalVector<RID> snapshot_bodies_removed;
+
+	struct PendingBodyState {
+		RID body;
+		uint32_t state_count = 0;
+		BodyState states[BODY_STATE_CAN_SLEEP + 1];
+		Variant values[BODY_STATE_CAN_SLEEP + 1];
+	};
+
+	// body_set_state() calls made on the main thread, coalesced per body and
+	// state until anything else has to be pushed to the server thread.
+	mutable LocalVector<PendingBodyState> pending_body_states;
+	mutable HashMap<RID, uint32_t> pending_body_state_indices;
+
+	bool _thread_get_body_snapshot(RID p_body, BodyStateSnapshot *r_snapshot) const;
+	bool thread_track_body(RID p_body, BodyStateSnapshot *r_snapshot) const;
+	void thread_untrack_body(RID p_body);
+	void _thread_update_body_snapshots();
+	void _sync_body_snapshots();
+
+	// Main thread only.
+	HashMap<RID, PhysicsDirectBodyState3DWrapMT *> direct_body_states;
+
+	friend class PhysicsDirectBodyState3DWrapMT;
+
+	void _refresh_body_snapshots();
+	void _invalidate_body_snapshot(RID p_body) const;
+	void _flush_pending_body_states() const;
+	void _body_write_action(RID p_body) const;
+
 public:
 #define ServerName PhysicsServer3D
 #define ServerNameWrapMT PhysicsServer3DWrapMT
 #define server_name physics_3d_server
-#define WRITE_ACTION
+// Coalesced body writes have to reach the server before anything reads from it.
+#define WRITE_ACTION _flush_pending_body_states();
+#define READ_ACTION _flush_pending_body_states();
 
 #include "servers/server_wrap_mt_common.h"
 
@@ -171,6 +292,12 @@ public:
 
 	/* BODY API */
 
+	// Body writes also invalidate the state snapshot of the body (p1).
+	// Const getters (FUNCnRC) don't expand WRITE_ACTION, read-only calls that use
+	// another macro are declared after this section so they keep the snapshot.
+#undef WRITE_ACTION
+#define WRITE_ACTION _body_write_action(p1);
+
 	//FUNC2RID(body,BodyMode,bool);
 	FUNCRID(body)
 
@@ -213,8 +340,8 @@ public:
 
 	FUNC1(body_reset_mass_properties, RID);
 
-	FUNC3(body_set_state, RID, BodyState, const Variant &);
-	FUNC2RC(Variant, body_get_state, RID, BodyState);
+	virtual void body_set_state(RID p_body, BodyState p_state, const Variant &p_variant) override;
+	virtual Variant body_get_state(RID p_body, BodyState p_state) const override;
 
 	FUNC2(body_set_applied_force, RID, const Vector3 &);
 	FUNC1RC(Vector3, body_get_applied_force, RID);
@@ -235,7 +362,6 @@ public:
 
 	FUNC2(body_add_collision_exception, RID, RID);
 	FUNC2(body_remove_collision_exception, RID, RID);
-	FUNC2S(body_get_collision_exceptions, RID, List<RID> *);
 
 	FUNC2(body_set_max_contacts_reported, RID, int);
 	FUNC1RC(int, body_get_max_contacts_reported, RID);
@@ -251,16 +377,18 @@ public:
 
 	FUNC2(body_set_ray_pickable, RID, bool);
 
+#undef WRITE_ACTION
+#define WRITE_ACTION _flush_pending_body_states();
+
+	FUNC2S(body_get_collision_exceptions, RID, List<RID> *);
+
 	bool body_test_motion(RID p_body, const MotionParameters &p_parameters, MotionResult *r_result = nullptr) override {
 		ERR_FAIL_COND_V(main_thread != Thread::get_caller_id(), false);
 		return physics_3d_server->body_test_motion(p_body, p_parameters, r_result);
 	}
 
 	// this function only works on physics process, errors and returns null otherwise
-	PhysicsDirectBodyState3D *body_get_direct_state(RID p_body) override {
-		ERR_FAIL_COND_V(main_thread != Thread::get_caller_id(), nullptr);
-		return physics_3d_server->body_get_direct_state(p_body);
-	}
+	PhysicsDirectBodyState3D *body_get_direct_state(RID p_body) override;
 
 	/* SOFT BODY API */
 
@@ -371,7 +499,7 @@ public:
 
 	/* MISC */
 
-	FUNC1(free, RID);
+	virtual void free(RID p_rid) override;
 	FUNC1(set_active, bool);
 	FUNC1(set_collision_iterations, int);
 
@@ -397,6 +525,7 @@ public:
 #undef ServerName
 #undef server_name
 #undef WRITE_ACTION
+#undef READ_ACTION
 };
 
 #ifdef DEBUG_SYNC
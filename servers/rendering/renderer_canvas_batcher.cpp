@@ -0,0 +1,330 @@
+/*************************************************************************/
+/*  renderer_canvas_batcher.cpp                                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "renderer_canvas_batcher.h"
+
+RendererCanvasBatcher::Batch *RendererCanvasBatcher::_get_batch(const Item *p_item, RID p_material, RID p_texture, RS::CanvasItemTextureFilter p_filter, RS::CanvasItemTextureRepeat p_repeat) {
+	if (batches.size()) {
+		// Only the last batch can be extended, anything else would change the draw order.
+		Batch *last = &batches[batches.size() - 1];
+		if (!last->item && last->clip_owner == p_item->final_clip_owner && last->material == p_material && last->texture == p_texture && last->filter == p_filter && last->repeat == p_repeat) {
+			return last;
+		}
+	}
+
+	Batch batch;
+	batch.clip_owner = p_item->final_clip_owner;
+	batch.material = p_material;
+	batch.texture = p_texture;
+	batch.filter = p_filter;
+	batch.repeat = p_repeat;
+	batch.index_from = indices.size();
+	batches.push_back(batch);
+	stats.batches++;
+
+	return &batches[batches.size() - 1];
+}
+
+void RendererCanvasBatcher::_push_quad(Batch *p_batch, const Transform2D &p_xform, const Vector2 *p_positions, const Vector2 *p_uvs, const Color &p_color) {
+	uint32_t base = vertices.size();
+	for (int i = 0; i < 4; i++) {
+		_push_vertex(p_xform, p_positions[i], p_uvs[i], p_color);
+	}
+
+	// Same winding as the quad index array.
+	static const uint32_t quad_indices[6] = { 0, 1, 2, 0, 2, 3 };
+	for (int i = 0; i < 6; i++) {
+		indices.push_back(base + quad_indices[i]);
+	}
+	p_batch->index_count += 6;
+}
+
+void RendererCanvasBatcher::_add_rect(const Item *p_item, const Item::CommandRect *p_rect, RID p_material, const Transform2D &p_xform, RS::CanvasItemTextureFilter p_filter, RS::CanvasItemTextureRepeat p_repeat) {
+	Batch *batch = _get_batch(p_item, p_material, p_rect->texture, p_filter, p_repeat);
+
+	Rect2 dst_rect = p_rect->rect;
+	if (dst_rect.size.width < 0) {
+		dst_rect.position.x += dst_rect.size.width;
+		dst_rect.size.width *= -1;
+	}
+	if (dst_rect.size.height < 0) {
+		dst_rect.position.y += dst_rect.size.height;
+		dst_rect.size.height *= -1;
+	}
+
+	Rect2 src_rect(0, 0, 1, 1);
+	if (p_rect->texture.is_valid()) {
+		Size2i size;
+		if ((p_rect->flags & RendererCanvasRender::CANVAS_RECT_REGION) && _get_texture_size(p_rect->texture, p_filter, p_repeat, size) && size.width > 0 && size.height > 0) {
+			Vector2 texpixel_size(1.0 / size.width, 1.0 / size.height);
+			src_rect = Rect2(p_rect->source.position * texpixel_size, p_rect->source.size * texpixel_size);
+		}
+
+		if (p_rect->flags & RendererCanvasRender::CANVAS_RECT_FLIP_H) {
+			src_rect.size.x *= -1;
+		}
+		if (p_rect->flags & RendererCanvasRender::CANVAS_RECT_FLIP_V) {
+			src_rect.size.y *= -1;
+		}
+	}
+
+	// Same mapping as the quad shader, a negative source size mirrors the vertices instead of the UVs.
+	static const Vector2 vertex_base[4] = { Vector2(0, 0), Vector2(0, 1), Vector2(1, 1), Vector2(1, 0) };
+	Vector2 positions[4];
+	Vector2 uvs[4];
+	for (int i = 0; i < 4; i++) {
+		Vector2 base = vertex_base[i];
+		uvs[i] = src_rect.position + src_rect.size.abs() * base;
+		if (src_rect.size.x < 0) {
+			base.x = 1.0 - base.x;
+		}
+		if (src_rect.size.y < 0) {
+			base.y = 1.0 - base.y;
+		}
+		positions[i] = dst_rect.position + dst_rect.size * base;
+	}
+
+	_push_quad(batch, p_xform, positions, uvs, p_rect->modulate * p_item->final_modulate);
+	batch->command_count++;
+	stats.batched_commands++;
+}
+
+void RendererCanvasBatcher::_add_ninepatch(const Item *p_item, const Item::CommandNinePatch *p_ninepatch, RID p_material, const Transform2D &p_xform, RS::CanvasItemTextureFilter p_filter, RS::CanvasItemTextureRepeat p_repeat) {
+	Batch *batch = _get_batch(p_item, p_material, p_ninepatch->texture, p_filter, p_repeat);
+
+	Size2 texpixel_size(1, 1);
+	Rect2 src_rect(0, 0, 1, 1);
+	if (p_ninepatch->texture.is_valid()) {
+		Size2i size;
+		if (_get_texture_size(p_ninepatch->texture, p_filter, p_repeat, size) && size.width > 0 && size.height > 0) {
+			texpixel_size = Size2(1.0 / size.width, 1.0 / size.height);
+		}
+		if (p_ninepatch->source != Rect2()) {
+			src_rect = Rect2(p_ninepatch->source.position * texpixel_size, p_ninepatch->source.size * texpixel_size);
+			texpixel_size = Size2(1.0 / p_ninepatch->source.size.width, 1.0 / p_ninepatch->source.size.height);
+		}
+	}
+
+	// Stretched nine patches are a 3x3 grid, margins are in source pixels for the UVs and in draw pixels for the vertices.
+	const Rect2 &dst_rect = p_ninepatch->rect;
+	const float *margin = p_ninepatch->margin;
+
+	float x[4] = { dst_rect.position.x, dst_rect.position.x + margin[SIDE_LEFT], dst_rect.position.x + dst_rect.size.width - margin[SIDE_RIGHT], dst_rect.position.x + dst_rect.size.width };
+	float y[4] = { dst_rect.position.y, dst_rect.position.y + margin[SIDE_TOP], dst_rect.position.y + dst_rect.size.height - margin[SIDE_BOTTOM], dst_rect.position.y + dst_rect.size.height };
+	float u[4] = { 0, margin[SIDE_LEFT] * texpixel_size.width, 1.0f - margin[SIDE_RIGHT] * texpixel_size.width, 1 };
+	float v[4] = { 0, margin[SIDE_TOP] * texpixel_size.height, 1.0f - margin[SIDE_BOTTOM] * texpixel_size.height, 1 };
+
+	Color color = p_ninepatch->color * p_item->final_modulate;
+
+	for (int j = 0; j < 3; j++) {
+		for (int i = 0; i < 3; i++) {
+			if ((i == 1 && j == 1 && !p_ninepatch->draw_center) || x[i] == x[i + 1] || y[j] == y[j + 1]) {
+				continue;
+			}
+
+			Vector2 positions[4] = { Vector2(x[i], y[j]), Vector2(x[i], y[j + 1]), Vector2(x[i + 1], y[j + 1]), Vector2(x[i + 1], y[j]) };
+			Vector2 uvs[4] = { Vector2(u[i], v[j]), Vector2(u[i], v[j + 1]), Vector2(u[i + 1], v[j + 1]), Vector2(u[i + 1], v[j]) };
+			for (int k = 0; k < 4; k++) {
+				uvs[k] = src_rect.position + uvs[k] * src_rect.size;
+			}
+
+			_push_quad(batch, p_xform, positions, uvs, color);
+		}
+	}
+
+	batch->command_count++;
+	stats.batched_commands++;
+}
+
+void RendererCanvasBatcher::_add_polygon(const Item *p_item, const Item::CommandPolygon *p_polygon, RID p_material, const Transform2D &p_xform, RS::CanvasItemTextureFilter p_filter, RS::CanvasItemTextureRepeat p_repeat) {
+	const Polygon *polygon = _get_polygon(p_polygon->polygon.polygon_id);
+	ERR_FAIL_COND(!polygon);
+
+	Batch *batch = _get_batch(p_item, p_material, p_polygon->texture, p_filter, p_repeat);
+
+	uint32_t base = vertices.size();
+	uint32_t vertex_count = polygon->points.size();
+	bool use_colors = polygon->colors.size() == vertex_count;
+	bool use_uvs = polygon->uvs.size() == vertex_count;
+
+	// Missing attributes read the same defaults as the vertex arrays.
+	Color color = polygon->colors.size() == 1 ? polygon->colors[0] : Color(1, 1, 1, 1);
+
+	for (uint32_t i = 0; i < vertex_count; i++) {
+		_push_vertex(p_xform, polygon->points[i], use_uvs ? polygon->uvs[i] : Vector2(), (use_colors ? polygon->colors[i] : color) * p_item->final_modulate);
+	}
+
+	if (polygon->indices.size()) {
+		for (uint32_t i = 0; i < polygon->indices.size(); i++) {
+			indices.push_back(base + polygon->indices[i]);
+		}
+		batch->index_count += polygon->indices.size();
+	} else {
+		for (uint32_t i = 0; i < vertex_count; i++) {
+			indices.push_back(base + i);
+		}
+		batch->index_count += vertex_count;
+	}
+
+	batch->command_count++;
+	stats.batched_commands++;
+}
+
+void RendererCanvasBatcher::_add_primitive(const Item *p_item, const Item::CommandPrimitive *p_primitive, RID p_material, const Transform2D &p_xform, RS::CanvasItemTextureFilter p_filter, RS::CanvasItemTextureRepeat p_repeat) {
+	// Primitives are always drawn with the default texture.
+	Batch *batch = _get_batch(p_item, p_material, RID(), p_filter, p_repeat);
+
+	uint32_t base = vertices.size();
+	for (uint32_t i = 0; i < p_primitive->point_count; i++) {
+		_push_vertex(p_xform, p_primitive->points[i], p_primitive->uvs[i], p_primitive->colors[i] * p_item->final_modulate);
+	}
+
+	indices.push_back(base + 0);
+	indices.push_back(base + 1);
+	indices.push_back(base + 2);
+	batch->index_count += 3;
+
+	if (p_primitive->point_count == 4) {
+		indices.push_back(base + 0);
+		indices.push_back(base + 2);
+		indices.push_back(base + 3);
+		batch->index_count += 3;
+	}
+
+	batch->command_count++;
+	stats.batched_commands++;
+}
+
+void RendererCanvasBatcher::begin(const Transform2D &p_canvas_transform_inverse, RS::CanvasItemTextureFilter p_default_filter, RS::CanvasItemTextureRepeat p_default_repeat) {
+	canvas_transform_inverse = p_canvas_transform_inverse;
+	default_filter = p_default_filter;
+	default_repeat = p_default_repeat;
+
+	vertices.clear();
+	indices.clear();
+	batches.clear();
+	stats = Stats();
+}
+
+bool RendererCanvasBatcher::is_item_batchable(const Item *p_item) const {
+	if (!p_item->commands || p_item->canvas_group) {
+		return false;
+	}
+
+	for (const Item::Command *c = p_item->commands; c; c = c->next) {
+		switch (c->type) {
+			case Item::Command::TYPE_RECT: {
+				const Item::CommandRect *rect = static_cast<const Item::CommandRect *>(c);
+				// These need the rect in the fragment shader.
+				if (rect->flags & (RendererCanvasRender::CANVAS_RECT_TRANSPOSE | RendererCanvasRender::CANVAS_RECT_CLIP_UV | RendererCanvasRender::CANVAS_RECT_MSDF)) {
+					return false;
+				}
+			} break;
+			case Item::Command::TYPE_NINEPATCH: {
+				const Item::CommandNinePatch *np = static_cast<const Item::CommandNinePatch *>(c);
+				// Tiled axes are mapped per pixel, and overlapping margins don't split into a grid.
+				if (np->axis_x != RS::NINE_PATCH_STRETCH || np->axis_y != RS::NINE_PATCH_STRETCH) {
+					return false;
+				}
+				if (np->margin[SIDE_LEFT] + np->margin[SIDE_RIGHT] > np->rect.size.width || np->margin[SIDE_TOP] + np->margin[SIDE_BOTTOM] > np->rect.size.height) {
+					return false;
+				}
+				if (np->source != Rect2() && (np->source.size.width <= 0 || np->source.size.height <= 0)) {
+					return false;
+				}
+			} break;
+			case Item::Command::TYPE_POLYGON: {
+				const Item::CommandPolygon *polygon = static_cast<const Item::CommandPolygon *>(c);
+				if (polygon->primitive != RS::PRIMITIVE_TRIANGLES || !_get_polygon(polygon->polygon.polygon_id)) {
+					return false;
+				}
+			} break;
+			case Item::Command::TYPE_PRIMITIVE: {
+				const Item::CommandPrimitive *primitive = static_cast<const Item::CommandPrimitive *>(c);
+				if (primitive->point_count < 3 || primitive->point_count > 4) {
+					return false;
+				}
+			} break;
+			case Item::Command::TYPE_TRANSFORM: {
+			} break;
+			default: {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void RendererCanvasBatcher::add_item(const Item *p_item, RID p_material, bool p_batchable) {
+	if (!p_batchable) {
+		Batch batch;
+		batch.item = p_item;
+		batch.clip_owner = p_item->final_clip_owner;
+		batch.material = p_material;
+		batches.push_back(batch);
+		stats.unbatched_items++;
+		return;
+	}
+
+	RS::CanvasItemTextureFilter filter = p_item->texture_filter != RS::CANVAS_ITEM_TEXTURE_FILTER_DEFAULT ? p_item->texture_filter : default_filter;
+	RS::CanvasItemTextureRepeat repeat = p_item->texture_repeat != RS::CANVAS_ITEM_TEXTURE_REPEAT_DEFAULT ? p_item->texture_repeat : default_repeat;
+
+	Transform2D base_transform = canvas_transform_inverse * p_item->final_transform;
+	Transform2D xform = base_transform;
+
+	for (const Item::Command *c = p_item->commands; c; c = c->next) {
+		switch (c->type) {
+			case Item::Command::TYPE_RECT: {
+				const Item::CommandRect *rect = static_cast<const Item::CommandRect *>(c);
+				if (rect->flags & RendererCanvasRender::CANVAS_RECT_TILE) {
+					// Sticks for the rest of the item, as in the regular path.
+					repeat = RS::CANVAS_ITEM_TEXTURE_REPEAT_ENABLED;
+				}
+				_add_rect(p_item, rect, p_material, xform, filter, repeat);
+			} break;
+			case Item::Command::TYPE_NINEPATCH: {
+				_add_ninepatch(p_item, static_cast<const Item::CommandNinePatch *>(c), p_material, xform, filter, repeat);
+			} break;
+			case Item::Command::TYPE_POLYGON: {
+				_add_polygon(p_item, static_cast<const Item::CommandPolygon *>(c), p_material, xform, filter, repeat);
+			} break;
+			case Item::Command::TYPE_PRIMITIVE: {
+				_add_primitive(p_item, static_cast<const Item::CommandPrimitive *>(c), p_material, xform, filter, repeat);
+			} break;
+			case Item::Command::TYPE_TRANSFORM: {
+				xform = base_transform * static_cast<const Item::CommandTransform *>(c)->xform;
+			} break;
+			default: {
+				// Filtered out by is_item_batchable().
+			}
+		}
+	}
+}
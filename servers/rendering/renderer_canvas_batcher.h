@@ -0,0 +1,132 @@
+/*************************************************************************/
+/*  renderer_canvas_batcher.h                                            */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef RENDERER_CANVAS_BATCHER_H
+#define RENDERER_CANVAS_BATCHER_H
+
+#include "core/templates/local_vector.h"
+#include "servers/rendering/renderer_canvas_render.h"
+
+// Merges consecutive canvas item commands that share texture, material and clip into
+// indexed triangle lists, so they can be drawn with a single call. The geometry is
+// transformed to canvas space on the CPU. Nothing here touches the GPU, renderers
+// upload the result and draw each batch, falling back to their regular path for
+// items that can't be merged.
+
+class RendererCanvasBatcher {
+public:
+	typedef RendererCanvasRender::Item Item;
+	typedef RendererCanvasRender::PolygonID PolygonID;
+
+	enum {
+		MAX_POLYGON_VERTICES = 128 // Bigger polygons are drawn from their own vertex arrays.
+	};
+
+	struct Vertex {
+		float position[2];
+		float color[4];
+		float uv[2];
+	};
+
+	// Copy of a small polygon, kept by the renderer so it can be merged.
+	struct Polygon {
+		LocalVector<Vector2> points;
+		LocalVector<Color> colors;
+		LocalVector<Vector2> uvs;
+		LocalVector<int> indices;
+	};
+
+	struct Batch {
+		// Set when the item can't be merged and must be drawn on its own.
+		const Item *item = nullptr;
+
+		Item *clip_owner = nullptr;
+		RID material;
+		RID texture;
+		RS::CanvasItemTextureFilter filter = RS::CANVAS_ITEM_TEXTURE_FILTER_DEFAULT;
+		RS::CanvasItemTextureRepeat repeat = RS::CANVAS_ITEM_TEXTURE_REPEAT_DEFAULT;
+
+		uint32_t index_from = 0;
+		uint32_t index_count = 0;
+		uint32_t command_count = 0;
+	};
+
+	struct Stats {
+		uint32_t batches = 0;
+		uint32_t batched_commands = 0;
+		uint32_t unbatched_items = 0;
+	};
+
+private:
+	Transform2D canvas_transform_inverse;
+	RS::CanvasItemTextureFilter default_filter = RS::CANVAS_ITEM_TEXTURE_FILTER_LINEAR;
+	RS::CanvasItemTextureRepeat default_repeat = RS::CANVAS_ITEM_TEXTURE_REPEAT_DISABLED;
+
+	Batch *_get_batch(const Item *p_item, RID p_material, RID p_texture, RS::CanvasItemTextureFilter p_filter, RS::CanvasItemTextureRepeat p_repeat);
+
+	_FORCE_INLINE_ void _push_vertex(const Transform2D &p_xform, const Vector2 &p_position, const Vector2 &p_uv, const Color &p_color) {
+		Vertex v;
+		Vector2 position = p_xform.xform(p_position);
+		v.position[0] = position.x;
+		v.position[1] = position.y;
+		v.color[0] = p_color.r;
+		v.color[1] = p_color.g;
+		v.color[2] = p_color.b;
+		v.color[3] = p_color.a;
+		v.uv[0] = p_uv.x;
+		v.uv[1] = p_uv.y;
+		vertices.push_back(v);
+	}
+
+	void _push_quad(Batch *p_batch, const Transform2D &p_xform, const Vector2 *p_positions, const Vector2 *p_uvs, const Color &p_color);
+
+	void _add_rect(const Item *p_item, const Item::CommandRect *p_rect, RID p_material, const Transform2D &p_xform, RS::CanvasItemTextureFilter p_filter, RS::CanvasItemTextureRepeat p_repeat);
+	void _add_ninepatch(const Item *p_item, const Item::CommandNinePatch *p_ninepatch, RID p_material, const Transform2D &p_xform, RS::CanvasItemTextureFilter p_filter, RS::CanvasItemTextureRepeat p_repeat);
+	void _add_polygon(const Item *p_item, const Item::CommandPolygon *p_polygon, RID p_material, const Transform2D &p_xform, RS::CanvasItemTextureFilter p_filter, RS::CanvasItemTextureRepeat p_repeat);
+	void _add_primitive(const Item *p_item, const Item::CommandPrimitive *p_primitive, RID p_material, const Transform2D &p_xform, RS::CanvasItemTextureFilter p_filter, RS::CanvasItemTextureRepeat p_repeat);
+
+protected:
+	virtual bool _get_texture_size(RID p_texture, RS::CanvasItemTextureFilter p_filter, RS::CanvasItemTextureRepeat p_repeat, Size2i &r_size) = 0;
+	virtual const Polygon *_get_polygon(PolygonID p_polygon) const = 0;
+
+public:
+	LocalVector<Vertex> vertices;
+	LocalVector<uint32_t> indices;
+	LocalVector<Batch> batches;
+	Stats stats;
+
+	void begin(const Transform2D &p_canvas_transform_inverse, RS::CanvasItemTextureFilter p_default_filter, RS::CanvasItemTextureRepeat p_default_repeat);
+	bool is_item_batchable(const Item *p_item) const;
+	void add_item(const Item *p_item, RID p_material, bool p_batchable);
+
+	virtual ~RendererCanvasBatcher() {}
+};
+
+#endif // RENDERER_CANVAS_BATCHER_H
@@ -30,42 +30,162 @@
 
 #include "renderer_canvas_cull.h"
 
+#include "core/config/project_settings.h"
 #include "core/math/geometry_2d.h"
+#include "core/os/frame_arena.h"
+#include "renderer_thread_pool.h"
 #include "renderer_viewport.h"
 #include "rendering_server_default.h"
 #include "rendering_server_globals.h"
 
 static const int z_range = RS::CANVAS_ITEM_Z_MAX - RS::CANVAS_ITEM_Z_MIN + 1;
 
+static void _allocate_cull_context(RendererCanvasCull::CullContext &r_context) {
+	r_context.z_list = (RendererCanvasRender::Item **)memalloc(z_range * sizeof(RendererCanvasRender::Item *));
+	r_context.z_last_list = (RendererCanvasRender::Item **)memalloc(z_range * sizeof(RendererCanvasRender::Item *));
+	memset(r_context.z_list, 0, z_range * sizeof(RendererCanvasRender::Item *));
+	memset(r_context.z_last_list, 0, z_range * sizeof(RendererCanvasRender::Item *));
+}
+
+static void _free_cull_context(RendererCanvasCull::CullContext &r_context) {
+	if (r_context.z_list) {
+		memfree(r_context.z_list);
+		memfree(r_context.z_last_list);
+	}
+}
+
 void RendererCanvasCull::_render_canvas_item_tree(RID p_to_render_target, Canvas::ChildItem *p_child_items, int p_child_item_count, Item *p_canvas_item, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, RendererCanvasRender::Light *p_lights, RendererCanvasRender::Light *p_directional_lights, RenderingServer::CanvasItemTextureFilter p_default_filter, RenderingServer::CanvasItemTextureRepeat p_default_repeat, bool p_snap_2d_vertices_to_pixel) {
 	RENDER_TIMESTAMP("Cull CanvasItem Tree");
 
-	memset(z_list, 0, z_range * sizeof(RendererCanvasRender::Item *));
-	memset(z_last_list, 0, z_range * sizeof(RendererCanvasRender::Item *));
+	CullContext &context = cull_context;
 
+	cull_root_items.clear();
+	uint32_t total_items = 0;
 	for (int i = 0; i < p_child_item_count; i++) {
-		_cull_canvas_item(p_child_items[i].item, p_transform, p_clip_rect, Color(1, 1, 1, 1), 0, z_list, z_last_list, nullptr, nullptr, true);
+		cull_root_items.push_back(p_child_items[i].item);
 	}
 	if (p_canvas_item) {
-		_cull_canvas_item(p_canvas_item, p_transform, p_clip_rect, Color(1, 1, 1, 1), 0, z_list, z_last_list, nullptr, nullptr, true);
+		cull_root_items.push_back(p_canvas_item);
+	}
+	for (uint32_t i = 0; i < cull_root_items.size(); i++) {
+		total_items += MAX(1u, cull_root_items[i]->cull_subtree_size);
+	}
+
+	if (total_items < thread_cull_threshold) {
+		for (uint32_t i = 0; i < cull_root_items.size(); i++) {
+			_cull_canvas_item(cull_root_items[i], p_transform, p_clip_rect, Color(1, 1, 1, 1), 0, context, nullptr, nullptr, true, false);
+		}
+	} else {
+		// Split the tree into runs of siblings of roughly the same size, sized from the last pass.
+		uint32_t thread_count = cull_thread_contexts.size();
+		if (!cull_thread_contexts[0].z_list) {
+			for (uint32_t i = 0; i < thread_count; i++) {
+				_allocate_cull_context(cull_thread_contexts[i]);
+			}
+		}
+		cull_job_size = MAX(total_items / (thread_count * CANVAS_CULL_JOBS_PER_THREAD), (uint32_t)CANVAS_CULL_MIN_ITEMS_PER_JOB);
+
+		_cull_canvas_items_split(cull_root_items.ptr(), cull_root_items.size(), -1, p_transform, p_clip_rect, Color(1, 1, 1, 1), 0, context, nullptr, nullptr);
+
+		CullSegment serial;
+		serial.from = cull_serial_ranges.size();
+		_take_z_ranges(context, cull_serial_ranges);
+		serial.to = cull_serial_ranges.size();
+		cull_segments.push_back(serial);
+
+		if (cull_jobs.size()) {
+			cull_next_job.set(0);
+			uint32_t worker_count = MIN(thread_count, cull_jobs.size());
+			if (worker_count > 1) {
+				RendererThreadPool::singleton->thread_work_pool.do_work(worker_count, this, &RendererCanvasCull::_cull_jobs_threaded, nullptr);
+			} else {
+				_cull_jobs_threaded(0, nullptr);
+			}
+		}
+
+		// Merge the segments back in tree order, per z layer.
+		for (uint32_t i = 0; i < cull_segments.size(); i++) {
+			const CullSegment &segment = cull_segments[i];
+			const ZRange *ranges = segment.job ? segment.job->ranges.ptr() : cull_serial_ranges.ptr() + segment.from;
+			uint32_t range_count = segment.job ? segment.job->ranges.size() : segment.to - segment.from;
+
+			for (uint32_t j = 0; j < range_count; j++) {
+				int zidx = ranges[j].z;
+				if (context.z_last_list[zidx]) {
+					context.z_last_list[zidx]->next = ranges[j].first;
+				} else {
+					context.z_list[zidx] = ranges[j].first;
+					context.used_z.push_back(zidx);
+				}
+				context.z_last_list[zidx] = ranges[j].last;
+			}
+		}
+
+		for (uint32_t i = 0; i < thread_count; i++) {
+			CullContext &thread_context = cull_thread_contexts[i];
+			for (uint32_t j = 0; j < thread_context.visible_notifiers.size(); j++) {
+				context.visible_notifiers.push_back(thread_context.visible_notifiers[j]);
+			}
+			thread_context.visible_notifiers.clear();
+			context.redraw = context.redraw || thread_context.redraw;
+			thread_context.redraw = false;
+		}
+
+		cull_segments.clear();
+		cull_serial_ranges.clear();
+		cull_jobs.clear();
+
+		uint32_t job_index = 0;
+		while (job_index < cull_job_list.size()) {
+			if (cull_job_list[job_index]->used_pass + CANVAS_CULL_JOB_MAX_UNUSED_PASSES < cull_pass) {
+				_free_cull_job(cull_job_list[job_index]);
+			} else {
+				job_index++;
+			}
+		}
 	}
 
 	RendererCanvasRender::Item *list = nullptr;
 	RendererCanvasRender::Item *list_end = nullptr;
 
 	for (int i = 0; i < z_range; i++) {
-		if (!z_list[i]) {
+		if (!context.z_list[i]) {
 			continue;
 		}
 		if (!list) {
-			list = z_list[i];
-			list_end = z_last_list[i];
+			list = context.z_list[i];
+			list_end = context.z_last_list[i];
 		} else {
-			list_end->next = z_list[i];
-			list_end = z_last_list[i];
+			list_end->next = context.z_list[i];
+			list_end = context.z_last_list[i];
 		}
 	}
 
+	for (uint32_t i = 0; i < context.used_z.size(); i++) {
+		context.z_list[context.used_z[i]] = nullptr;
+		context.z_last_list[context.used_z[i]] = nullptr;
+	}
+	context.used_z.clear();
+
+	uint64_t frame = RSG::rasterizer->get_frame_number();
+	for (uint32_t i = 0; i < context.visible_notifiers.size(); i++) {
+		Item::VisibilityNotifierData *notifier = context.visible_notifiers[i]->visibility_notifier;
+		if (!notifier->visible_element.in_list()) {
+			visibility_notifier_list.add(&notifier->visible_element);
+			notifier->just_visible = true;
+		}
+
+		notifier->visible_in_frame = frame;
+	}
+	context.visible_notifiers.clear();
+
+	if (context.redraw) {
+		RenderingServerDefault::redraw_request();
+		context.redraw = false;
+	}
+
+	cull_pass++;
+
 	RENDER_TIMESTAMP("Render Canvas Items");
 
 	bool sdf_flag;
@@ -75,6 +195,196 @@ void RendererCanvasCull::_render_canvas_item_tree(RID p_to_render_target, Canvas
 	}
 }
 
+void RendererCanvasCull::_take_z_ranges(CullContext &r_context, LocalVector<ZRange> &r_ranges) {
+	for (uint32_t i = 0; i < r_context.used_z.size(); i++) {
+		int zidx = r_context.used_z[i];
+		ZRange range;
+		range.z = zidx;
+		range.first = r_context.z_list[zidx];
+		range.last = r_context.z_last_list[zidx];
+		r_ranges.push_back(range);
+
+		r_context.z_list[zidx] = nullptr;
+		r_context.z_last_list[zidx] = nullptr;
+	}
+	r_context.used_z.clear();
+}
+
+uint32_t RendererCanvasCull::_cull_canvas_items_split(Item **p_items, int p_item_count, int p_behind, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, int p_z, CullContext &r_context, Item *p_canvas_clip, Item *p_material_owner) {
+	uint32_t visited = 0;
+	uint32_t run_size = 0;
+	// Rebuilt on every pass, the jobs keep their own copy.
+	LocalVector<Item *, uint32_t, false, FrameArena> run;
+
+	for (int i = 0; i < p_item_count; i++) {
+		Item *item = p_items[i];
+		if (!item->visible || (p_behind != -1 && item->behind != bool(p_behind))) {
+			continue;
+		}
+
+		if (item->cull_subtree_size > cull_job_size && !item->sort_y && !item->canvas_group) {
+			// Too big for a single job, split its children instead.
+			if (run.size()) {
+				_queue_cull_job(run.ptr(), run.size(), p_transform, p_clip_rect, p_modulate, p_z, r_context, p_canvas_clip, p_material_owner);
+				visited += run_size;
+				run.clear();
+				run_size = 0;
+			}
+			visited += _cull_canvas_item(item, p_transform, p_clip_rect, p_modulate, p_z, r_context, p_canvas_clip, p_material_owner, true, true);
+			continue;
+		}
+
+		run.push_back(item);
+		run_size += MAX(1u, item->cull_subtree_size);
+		if (run_size >= cull_job_size) {
+			_queue_cull_job(run.ptr(), run.size(), p_transform, p_clip_rect, p_modulate, p_z, r_context, p_canvas_clip, p_material_owner);
+			visited += run_size;
+			run.clear();
+			run_size = 0;
+		}
+	}
+
+	if (run.size()) {
+		_queue_cull_job(run.ptr(), run.size(), p_transform, p_clip_rect, p_modulate, p_z, r_context, p_canvas_clip, p_material_owner);
+		visited += run_size;
+	}
+
+	return visited;
+}
+
+void RendererCanvasCull::_queue_cull_job(Item *const *p_items, uint32_t p_item_count, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, int p_z, CullContext &r_context, Item *p_canvas_clip, Item *p_material_owner) {
+	Item *owner = p_items[0];
+	CullJob *job = owner->cull_job;
+	if (!job) {
+		job = memnew(CullJob);
+		job->owner = owner;
+		job->index = cull_job_list.size();
+		cull_job_list.push_back(job);
+		owner->cull_job = job;
+	}
+
+	Rect2 canvas_clip_rect = p_canvas_clip ? p_canvas_clip->final_clip_rect : Rect2();
+
+	// The recorded result can be reused if the inputs are the same and nothing changed below.
+	bool valid = job->pass != 0 && job->items.size() == p_item_count && job->transform == p_transform && job->clip_rect == p_clip_rect && job->modulate == p_modulate && job->z == p_z && job->canvas_clip == p_canvas_clip && job->canvas_clip_rect == canvas_clip_rect && job->material_owner == p_material_owner && job->snap == snapping_2d_transforms_to_pixel;
+	for (uint32_t i = 0; valid && i < p_item_count; i++) {
+		valid = job->items[i] == p_items[i] && p_items[i]->changed_pass <= job->pass;
+	}
+
+	if (!valid) {
+		job->items.resize(p_item_count);
+		memcpy(job->items.ptr(), p_items, p_item_count * sizeof(Item *));
+		job->transform = p_transform;
+		job->clip_rect = p_clip_rect;
+		job->modulate = p_modulate;
+		job->z = p_z;
+		job->canvas_clip = p_canvas_clip;
+		job->canvas_clip_rect = canvas_clip_rect;
+		job->material_owner = p_material_owner;
+		job->snap = snapping_2d_transforms_to_pixel;
+		job->pass = 0;
+	}
+
+	job->use_cache = valid;
+	job->used_pass = cull_pass;
+
+	// Close the serial segment culled so far, the job goes after it.
+	CullSegment serial;
+	serial.from = cull_serial_ranges.size();
+	_take_z_ranges(r_context, cull_serial_ranges);
+	serial.to = cull_serial_ranges.size();
+	if (serial.to > serial.from) {
+		cull_segments.push_back(serial);
+	}
+
+	CullSegment segment;
+	segment.job = job;
+	cull_segments.push_back(segment);
+	cull_jobs.push_back(job);
+}
+
+void RendererCanvasCull::_cull_job(CullJob *p_job, CullContext &r_context) {
+	if (p_job->use_cache) {
+		// Another cull (e.g. a second viewport) may have written the items since.
+		for (uint32_t i = 0; i < p_job->elements.size(); i++) {
+			if (p_job->elements[i].item->cull_state_pass != p_job->pass) {
+				p_job->use_cache = false;
+				break;
+			}
+		}
+	}
+
+	if (p_job->use_cache) {
+		for (uint32_t i = 0; i < p_job->elements.size(); i++) {
+			const CullJob::Element &element = p_job->elements[i];
+			Item *ci = element.item;
+
+			if (element.drawn) {
+				ci->next = nullptr;
+				ci->light_masked = false;
+
+				if (r_context.z_last_list[element.z]) {
+					r_context.z_last_list[element.z]->next = ci;
+				} else {
+					r_context.z_list[element.z] = ci;
+					r_context.used_z.push_back(element.z);
+				}
+				r_context.z_last_list[element.z] = ci;
+			}
+
+			if (element.visible && ci->visibility_notifier) {
+				r_context.visible_notifiers.push_back(ci);
+			}
+		}
+	} else {
+		p_job->elements.clear();
+		r_context.record = &p_job->elements;
+		r_context.cacheable = true;
+
+		for (uint32_t i = 0; i < p_job->items.size(); i++) {
+			_cull_canvas_item(p_job->items[i], p_job->transform, p_job->clip_rect, p_job->modulate, p_job->z, r_context, p_job->canvas_clip, p_job->material_owner, true, false);
+		}
+
+		r_context.record = nullptr;
+		p_job->pass = r_context.cacheable ? cull_pass : 0;
+	}
+
+	p_job->ranges.clear();
+	_take_z_ranges(r_context, p_job->ranges);
+}
+
+void RendererCanvasCull::_cull_jobs_threaded(uint32_t p_thread, void *p_userdata) {
+	CullContext &context = cull_thread_contexts[p_thread];
+	while (true) {
+		uint32_t job = cull_next_job.postincrement();
+		if (job >= cull_jobs.size()) {
+			break;
+		}
+		_cull_job(cull_jobs[job], context);
+	}
+}
+
+void RendererCanvasCull::_free_cull_job(CullJob *p_job) {
+	p_job->owner->cull_job = nullptr;
+
+	CullJob *last = cull_job_list[cull_job_list.size() - 1];
+	last->index = p_job->index;
+	cull_job_list[p_job->index] = last;
+	cull_job_list.resize(cull_job_list.size() - 1);
+
+	memdelete(p_job);
+}
+
+void RendererCanvasCull::_item_changed(Item *p_item) {
+	// Parents are always stamped at least as late as their children, so stop at the first one already stamped.
+	p_item->changed_pass = cull_pass;
+	Item *parent = canvas_item_owner.owns(p_item->parent) ? canvas_item_owner.get_or_null(p_item->parent) : nullptr;
+	while (parent && parent->changed_pass != cull_pass) {
+		parent->changed_pass = cull_pass;
+		parent = canvas_item_owner.owns(parent->parent) ? canvas_item_owner.get_or_null(parent->parent) : nullptr;
+	}
+}
+
 void _collect_ysort_children(RendererCanvasCull::Item *p_canvas_item, Transform2D p_transform, RendererCanvasCull::Item *p_material_owner, RendererCanvasCull::Item **r_items, int &r_index) {
 	int child_item_count = p_canvas_item->child_items.size();
 	RendererCanvasCull::Item **child_items = p_canvas_item->child_items.ptrw();
@@ -104,16 +414,19 @@ void _mark_ysort_dirty(RendererCanvasCull::Item *ysort_owner, RID_Owner<Renderer
 	} while (ysort_owner && ysort_owner->sort_y);
 }
 
-void RendererCanvasCull::_attach_canvas_item_for_draw(RendererCanvasCull::Item *ci, RendererCanvasCull::Item *p_canvas_clip, RendererCanvasRender::Item **z_list, RendererCanvasRender::Item **z_last_list, const Transform2D &xform, const Rect2 &p_clip_rect, Rect2 global_rect, const Color &modulate, int p_z, RendererCanvasCull::Item *p_material_owner, bool use_canvas_group, RendererCanvasRender::Item *canvas_group_from, const Transform2D &p_xform) {
+void RendererCanvasCull::_attach_canvas_item_for_draw(RendererCanvasCull::Item *ci, RendererCanvasCull::Item *p_canvas_clip, CullContext &r_context, const Transform2D &xform, const Rect2 &p_clip_rect, Rect2 global_rect, const Color &modulate, int p_z, RendererCanvasCull::Item *p_material_owner, bool use_canvas_group, RendererCanvasRender::Item *canvas_group_from, const Transform2D &p_xform) {
 	if (ci->copy_back_buffer) {
 		ci->copy_back_buffer->screen_rect = xform.xform(ci->copy_back_buffer->rect).intersection(p_clip_rect);
 	}
 
 	if (use_canvas_group) {
+		// The group rewrites its commands while culling, so it can't be reused from the cache.
+		r_context.cacheable = false;
+
 		int zidx = p_z - RS::CANVAS_ITEM_Z_MIN;
 		if (canvas_group_from == nullptr) {
 			// no list before processing this item, means must put stuff in group from the beginning of list.
-			canvas_group_from = z_list[zidx];
+			canvas_group_from = r_context.z_list[zidx];
 		} else {
 			// there was a list before processing, so begin group from this one.
 			canvas_group_from = canvas_group_from->next;
@@ -173,11 +486,25 @@ void RendererCanvasCull::_attach_canvas_item_for_draw(RendererCanvasCull::Item *
 		}
 	}
 
-	if (((ci->commands != nullptr || ci->visibility_notifier) && p_clip_rect.intersects(global_rect, true)) || ci->vp_render || ci->copy_back_buffer) {
+	int zidx = p_z - RS::CANVAS_ITEM_Z_MIN;
+	bool visible = ((ci->commands != nullptr || ci->visibility_notifier) && p_clip_rect.intersects(global_rect, true)) || ci->vp_render || ci->copy_back_buffer;
+
+	ci->cull_state_pass = cull_pass;
+	if (r_context.record) {
+		CullJob::Element element;
+		element.item = ci;
+		element.z = zidx;
+		element.drawn = visible && ci->commands != nullptr;
+		element.visible = visible;
+		r_context.record->push_back(element);
+	}
+
+	if (visible) {
 		//something to draw?
 
 		if (ci->update_when_visible) {
-			RenderingServerDefault::redraw_request();
+			r_context.redraw = true;
+			r_context.cacheable = false;
 		}
 
 		if (ci->commands != nullptr) {
@@ -187,15 +514,14 @@ void RendererCanvasCull::_attach_canvas_item_for_draw(RendererCanvasCull::Item *
 			ci->global_rect_cache.position -= p_clip_rect.position;
 			ci->light_masked = false;
 
-			int zidx = p_z - RS::CANVAS_ITEM_Z_MIN;
-
-			if (z_last_list[zidx]) {
-				z_last_list[zidx]->next = ci;
-				z_last_list[zidx] = ci;
+			if (r_context.z_last_list[zidx]) {
+				r_context.z_last_list[zidx]->next = ci;
+				r_context.z_last_list[zidx] = ci;
 
 			} else {
-				z_list[zidx] = ci;
-				z_last_list[zidx] = ci;
+				r_context.z_list[zidx] = ci;
+				r_context.z_last_list[zidx] = ci;
+				r_context.used_z.push_back(zidx);
 			}
 
 			ci->z_final = p_z;
@@ -204,21 +530,16 @@ void RendererCanvasCull::_attach_canvas_item_for_draw(RendererCanvasCull::Item *
 		}
 
 		if (ci->visibility_notifier) {
-			if (!ci->visibility_notifier->visible_element.in_list()) {
-				visibility_notifier_list.add(&ci->visibility_notifier->visible_element);
-				ci->visibility_notifier->just_visible = true;
-			}
-
-			ci->visibility_notifier->visible_in_frame = RSG::rasterizer->get_frame_number();
+			r_context.visible_notifiers.push_back(ci);
 		}
 	}
 }
 
-void RendererCanvasCull::_cull_canvas_item(Item *p_canvas_item, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, int p_z, RendererCanvasRender::Item **z_list, RendererCanvasRender::Item **z_last_list, Item *p_canvas_clip, Item *p_material_owner, bool allow_y_sort) {
+uint32_t RendererCanvasCull::_cull_canvas_item(Item *p_canvas_item, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, int p_z, CullContext &r_context, Item *p_canvas_clip, Item *p_material_owner, bool allow_y_sort, bool p_split) {
 	Item *ci = p_canvas_item;
 
 	if (!ci->visible) {
-		return;
+		return 0;
 	}
 
 	if (ci->children_order_dirty) {
@@ -253,9 +574,12 @@ void RendererCanvasCull::_cull_canvas_item(Item *p_canvas_item, const Transform2
 	Color modulate(ci->modulate.r * p_modulate.r, ci->modulate.g * p_modulate.g, ci->modulate.b * p_modulate.b, ci->modulate.a * p_modulate.a);
 
 	if (modulate.a < 0.007) {
-		return;
+		ci->cull_subtree_size = 1;
+		return 1;
 	}
 
+	uint32_t visited = 1;
+
 	int child_item_count = ci->child_items.size();
 	Item **child_items = ci->child_items.ptrw();
 
@@ -297,41 +621,51 @@ void RendererCanvasCull::_cull_canvas_item(Item *p_canvas_item, const Transform2
 			SortArray<Item *, ItemPtrSort> sorter;
 			sorter.sort(child_items, child_item_count);
 
+			visited = 0;
 			for (i = 0; i < child_item_count; i++) {
-				_cull_canvas_item(child_items[i], xform * child_items[i]->ysort_xform, p_clip_rect, modulate, p_z, z_list, z_last_list, (Item *)ci->final_clip_owner, (Item *)child_items[i]->material_owner, false);
+				visited += _cull_canvas_item(child_items[i], xform * child_items[i]->ysort_xform, p_clip_rect, modulate, p_z, r_context, (Item *)ci->final_clip_owner, (Item *)child_items[i]->material_owner, false, false);
 			}
 		} else {
 			RendererCanvasRender::Item *canvas_group_from = nullptr;
 			bool use_canvas_group = ci->canvas_group != nullptr && (ci->canvas_group->fit_empty || ci->commands != nullptr);
 			if (use_canvas_group) {
 				int zidx = p_z - RS::CANVAS_ITEM_Z_MIN;
-				canvas_group_from = z_last_list[zidx];
+				canvas_group_from = r_context.z_last_list[zidx];
 			}
 
-			_attach_canvas_item_for_draw(ci, p_canvas_clip, z_list, z_last_list, xform, p_clip_rect, global_rect, modulate, p_z, p_material_owner, use_canvas_group, canvas_group_from, xform);
+			_attach_canvas_item_for_draw(ci, p_canvas_clip, r_context, xform, p_clip_rect, global_rect, modulate, p_z, p_material_owner, use_canvas_group, canvas_group_from, xform);
 		}
 	} else {
 		RendererCanvasRender::Item *canvas_group_from = nullptr;
 		bool use_canvas_group = ci->canvas_group != nullptr && (ci->canvas_group->fit_empty || ci->commands != nullptr);
 		if (use_canvas_group) {
 			int zidx = p_z - RS::CANVAS_ITEM_Z_MIN;
-			canvas_group_from = z_last_list[zidx];
+			canvas_group_from = r_context.z_last_list[zidx];
 		}
 
-		for (int i = 0; i < child_item_count; i++) {
-			if (!child_items[i]->behind && !use_canvas_group) {
-				continue;
+		if (p_split && !use_canvas_group) {
+			visited += _cull_canvas_items_split(child_items, child_item_count, true, xform, p_clip_rect, modulate, p_z, r_context, (Item *)ci->final_clip_owner, p_material_owner);
+			_attach_canvas_item_for_draw(ci, p_canvas_clip, r_context, xform, p_clip_rect, global_rect, modulate, p_z, p_material_owner, use_canvas_group, canvas_group_from, xform);
+			visited += _cull_canvas_items_split(child_items, child_item_count, false, xform, p_clip_rect, modulate, p_z, r_context, (Item *)ci->final_clip_owner, p_material_owner);
+		} else {
+			for (int i = 0; i < child_item_count; i++) {
+				if (!child_items[i]->behind && !use_canvas_group) {
+					continue;
+				}
+				visited += _cull_canvas_item(child_items[i], xform, p_clip_rect, modulate, p_z, r_context, (Item *)ci->final_clip_owner, p_material_owner, true, false);
 			}
-			_cull_canvas_item(child_items[i], xform, p_clip_rect, modulate, p_z, z_list, z_last_list, (Item *)ci->final_clip_owner, p_material_owner, true);
-		}
-		_attach_canvas_item_for_draw(ci, p_canvas_clip, z_list, z_last_list, xform, p_clip_rect, global_rect, modulate, p_z, p_material_owner, use_canvas_group, canvas_group_from, xform);
-		for (int i = 0; i < child_item_count; i++) {
-			if (child_items[i]->behind || use_canvas_group) {
-				continue;
+			_attach_canvas_item_for_draw(ci, p_canvas_clip, r_context, xform, p_clip_rect, global_rect, modulate, p_z, p_material_owner, use_canvas_group, canvas_group_from, xform);
+			for (int i = 0; i < child_item_count; i++) {
+				if (child_items[i]->behind || use_canvas_group) {
+					continue;
+				}
+				visited += _cull_canvas_item(child_items[i], xform, p_clip_rect, modulate, p_z, r_context, (Item *)ci->final_clip_owner, p_material_owner, true, false);
 			}
-			_cull_canvas_item(child_items[i], xform, p_clip_rect, modulate, p_z, z_list, z_last_list, (Item *)ci->final_clip_owner, p_material_owner, true);
 		}
 	}
+
+	ci->cull_subtree_size = visited;
+	return visited;
 }
 
 void RendererCanvasCull::render_canvas(RID p_render_target, Canvas *p_canvas, const Transform2D &p_transform, RendererCanvasRender::Light *p_lights, RendererCanvasRender::Light *p_directional_lights, const Rect2 &p_clip_rect, RenderingServer::CanvasItemTextureFilter p_default_filter, RenderingServer::CanvasItemTextureRepeat p_default_repeat, bool p_snap_2d_transforms_to_pixel, bool p_snap_2d_vertices_to_pixel) {
@@ -434,6 +768,7 @@ void RendererCanvasCull::canvas_item_initialize(RID p_rid) {
 void RendererCanvasCull::canvas_item_set_parent(RID p_item, RID p_parent) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	if (canvas_item->parent.is_valid()) {
 		if (canvas_owner.owns(canvas_item->parent)) {
@@ -473,11 +808,13 @@ void RendererCanvasCull::canvas_item_set_parent(RID p_item, RID p_parent) {
 	}
 
 	canvas_item->parent = p_parent;
+	_item_changed(canvas_item);
 }
 
 void RendererCanvasCull::canvas_item_set_visible(RID p_item, bool p_visible) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	canvas_item->visible = p_visible;
 
@@ -487,6 +824,7 @@ void RendererCanvasCull::canvas_item_set_visible(RID p_item, bool p_visible) {
 void RendererCanvasCull::canvas_item_set_light_mask(RID p_item, int p_mask) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	canvas_item->light_mask = p_mask;
 }
@@ -494,6 +832,7 @@ void RendererCanvasCull::canvas_item_set_light_mask(RID p_item, int p_mask) {
 void RendererCanvasCull::canvas_item_set_transform(RID p_item, const Transform2D &p_transform) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	canvas_item->xform = p_transform;
 }
@@ -501,6 +840,7 @@ void RendererCanvasCull::canvas_item_set_transform(RID p_item, const Transform2D
 void RendererCanvasCull::canvas_item_set_clip(RID p_item, bool p_clip) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	canvas_item->clip = p_clip;
 }
@@ -508,6 +848,7 @@ void RendererCanvasCull::canvas_item_set_clip(RID p_item, bool p_clip) {
 void RendererCanvasCull::canvas_item_set_distance_field_mode(RID p_item, bool p_enable) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	canvas_item->distance_field = p_enable;
 }
@@ -515,6 +856,7 @@ void RendererCanvasCull::canvas_item_set_distance_field_mode(RID p_item, bool p_
 void RendererCanvasCull::canvas_item_set_custom_rect(RID p_item, bool p_custom_rect, const Rect2 &p_rect) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	canvas_item->custom_rect = p_custom_rect;
 	canvas_item->rect = p_rect;
@@ -523,6 +865,7 @@ void RendererCanvasCull::canvas_item_set_custom_rect(RID p_item, bool p_custom_r
 void RendererCanvasCull::canvas_item_set_modulate(RID p_item, const Color &p_color) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	canvas_item->modulate = p_color;
 }
@@ -530,6 +873,7 @@ void RendererCanvasCull::canvas_item_set_modulate(RID p_item, const Color &p_col
 void RendererCanvasCull::canvas_item_set_self_modulate(RID p_item, const Color &p_color) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	canvas_item->self_modulate = p_color;
 }
@@ -537,6 +881,7 @@ void RendererCanvasCull::canvas_item_set_self_modulate(RID p_item, const Color &
 void RendererCanvasCull::canvas_item_set_draw_behind_parent(RID p_item, bool p_enable) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	canvas_item->behind = p_enable;
 }
@@ -544,6 +889,7 @@ void RendererCanvasCull::canvas_item_set_draw_behind_parent(RID p_item, bool p_e
 void RendererCanvasCull::canvas_item_set_update_when_visible(RID p_item, bool p_update) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	canvas_item->update_when_visible = p_update;
 }
@@ -551,6 +897,7 @@ void RendererCanvasCull::canvas_item_set_update_when_visible(RID p_item, bool p_
 void RendererCanvasCull::canvas_item_add_line(RID p_item, const Point2 &p_from, const Point2 &p_to, const Color &p_color, float p_width) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	Item::CommandPrimitive *line = canvas_item->alloc_command<Item::CommandPrimitive>();
 	ERR_FAIL_COND(!line);
@@ -575,6 +922,7 @@ void RendererCanvasCull::canvas_item_add_polyline(RID p_item, const Vector<Point
 	ERR_FAIL_COND(p_points.size() < 2);
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	Color color = Color(1, 1, 1, 1);
 
@@ -716,6 +1064,7 @@ void RendererCanvasCull::canvas_item_add_multiline(RID p_item, const Vector<Poin
 	ERR_FAIL_COND(p_points.size() < 2);
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	Item::CommandPolygon *pline = canvas_item->alloc_command<Item::CommandPolygon>();
 	ERR_FAIL_COND(!pline);
@@ -732,6 +1081,7 @@ void RendererCanvasCull::canvas_item_add_multiline(RID p_item, const Vector<Poin
 void RendererCanvasCull::canvas_item_add_rect(RID p_item, const Rect2 &p_rect, const Color &p_color) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	Item::CommandRect *rect = canvas_item->alloc_command<Item::CommandRect>();
 	ERR_FAIL_COND(!rect);
@@ -742,6 +1092,7 @@ void RendererCanvasCull::canvas_item_add_rect(RID p_item, const Rect2 &p_rect, c
 void RendererCanvasCull::canvas_item_add_circle(RID p_item, const Point2 &p_pos, float p_radius, const Color &p_color) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	Item::CommandPolygon *circle = canvas_item->alloc_command<Item::CommandPolygon>();
 	ERR_FAIL_COND(!circle);
@@ -778,6 +1129,7 @@ void RendererCanvasCull::canvas_item_add_circle(RID p_item, const Point2 &p_pos,
 void RendererCanvasCull::canvas_item_add_texture_rect(RID p_item, const Rect2 &p_rect, RID p_texture, bool p_tile, const Color &p_modulate, bool p_transpose) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	Item::CommandRect *rect = canvas_item->alloc_command<Item::CommandRect>();
 	ERR_FAIL_COND(!rect);
@@ -809,6 +1161,7 @@ void RendererCanvasCull::canvas_item_add_texture_rect(RID p_item, const Rect2 &p
 void RendererCanvasCull::canvas_item_add_msdf_texture_rect_region(RID p_item, const Rect2 &p_rect, RID p_texture, const Rect2 &p_src_rect, const Color &p_modulate, int p_outline_size, float p_px_range) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	Item::CommandRect *rect = canvas_item->alloc_command<Item::CommandRect>();
 	ERR_FAIL_COND(!rect);
@@ -843,6 +1196,7 @@ void RendererCanvasCull::canvas_item_add_msdf_texture_rect_region(RID p_item, co
 void RendererCanvasCull::canvas_item_add_texture_rect_region(RID p_item, const Rect2 &p_rect, RID p_texture, const Rect2 &p_src_rect, const Color &p_modulate, bool p_transpose, bool p_clip_uv) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	Item::CommandRect *rect = canvas_item->alloc_command<Item::CommandRect>();
 	ERR_FAIL_COND(!rect);
@@ -884,6 +1238,7 @@ void RendererCanvasCull::canvas_item_add_texture_rect_region(RID p_item, const R
 void RendererCanvasCull::canvas_item_add_nine_patch(RID p_item, const Rect2 &p_rect, const Rect2 &p_source, RID p_texture, const Vector2 &p_topleft, const Vector2 &p_bottomright, RS::NinePatchAxisMode p_x_axis_mode, RS::NinePatchAxisMode p_y_axis_mode, bool p_draw_center, const Color &p_modulate) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	Item::CommandNinePatch *style = canvas_item->alloc_command<Item::CommandNinePatch>();
 	ERR_FAIL_COND(!style);
@@ -908,6 +1263,7 @@ void RendererCanvasCull::canvas_item_add_primitive(RID p_item, const Vector<Poin
 
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	Item::CommandPrimitive *prim = canvas_item->alloc_command<Item::CommandPrimitive>();
 	ERR_FAIL_COND(!prim);
@@ -934,6 +1290,7 @@ void RendererCanvasCull::canvas_item_add_primitive(RID p_item, const Vector<Poin
 void RendererCanvasCull::canvas_item_add_polygon(RID p_item, const Vector<Point2> &p_points, const Vector<Color> &p_colors, const Vector<Point2> &p_uvs, RID p_texture) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 #ifdef DEBUG_ENABLED
 	int pointcount = p_points.size();
 	ERR_FAIL_COND(pointcount < 3);
@@ -955,6 +1312,7 @@ void RendererCanvasCull::canvas_item_add_polygon(RID p_item, const Vector<Point2
 void RendererCanvasCull::canvas_item_add_triangle_array(RID p_item, const Vector<int> &p_indices, const Vector<Point2> &p_points, const Vector<Color> &p_colors, const Vector<Point2> &p_uvs, const Vector<int> &p_bones, const Vector<float> &p_weights, RID p_texture, int p_count) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	int vertex_count = p_points.size();
 	ERR_FAIL_COND(vertex_count == 0);
@@ -978,6 +1336,7 @@ void RendererCanvasCull::canvas_item_add_triangle_array(RID p_item, const Vector
 void RendererCanvasCull::canvas_item_add_set_transform(RID p_item, const Transform2D &p_transform) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	Item::CommandTransform *tr = canvas_item->alloc_command<Item::CommandTransform>();
 	ERR_FAIL_COND(!tr);
@@ -987,6 +1346,7 @@ void RendererCanvasCull::canvas_item_add_set_transform(RID p_item, const Transfo
 void RendererCanvasCull::canvas_item_add_mesh(RID p_item, const RID &p_mesh, const Transform2D &p_transform, const Color &p_modulate, RID p_texture) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 	ERR_FAIL_COND(!p_mesh.is_valid());
 
 	Item::CommandMesh *m = canvas_item->alloc_command<Item::CommandMesh>();
@@ -1006,6 +1366,7 @@ void RendererCanvasCull::canvas_item_add_mesh(RID p_item, const RID &p_mesh, con
 void RendererCanvasCull::canvas_item_add_particles(RID p_item, RID p_particles, RID p_texture) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	Item::CommandParticles *part = canvas_item->alloc_command<Item::CommandParticles>();
 	ERR_FAIL_COND(!part);
@@ -1020,6 +1381,7 @@ void RendererCanvasCull::canvas_item_add_particles(RID p_item, RID p_particles,
 void RendererCanvasCull::canvas_item_add_multimesh(RID p_item, RID p_mesh, RID p_texture) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	Item::CommandMultiMesh *mm = canvas_item->alloc_command<Item::CommandMultiMesh>();
 	ERR_FAIL_COND(!mm);
@@ -1031,6 +1393,7 @@ void RendererCanvasCull::canvas_item_add_multimesh(RID p_item, RID p_mesh, RID p
 void RendererCanvasCull::canvas_item_add_clip_ignore(RID p_item, bool p_ignore) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	Item::CommandClipIgnore *ci = canvas_item->alloc_command<Item::CommandClipIgnore>();
 	ERR_FAIL_COND(!ci);
@@ -1040,6 +1403,7 @@ void RendererCanvasCull::canvas_item_add_clip_ignore(RID p_item, bool p_ignore)
 void RendererCanvasCull::canvas_item_add_animation_slice(RID p_item, double p_animation_length, double p_slice_begin, double p_slice_end, double p_offset) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	Item::CommandAnimationSlice *as = canvas_item->alloc_command<Item::CommandAnimationSlice>();
 	ERR_FAIL_COND(!as);
@@ -1052,6 +1416,7 @@ void RendererCanvasCull::canvas_item_add_animation_slice(RID p_item, double p_an
 void RendererCanvasCull::canvas_item_set_sort_children_by_y(RID p_item, bool p_enable) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	canvas_item->sort_y = p_enable;
 
@@ -1063,6 +1428,7 @@ void RendererCanvasCull::canvas_item_set_z_index(RID p_item, int p_z) {
 
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	canvas_item->z_index = p_z;
 }
@@ -1070,6 +1436,7 @@ void RendererCanvasCull::canvas_item_set_z_index(RID p_item, int p_z) {
 void RendererCanvasCull::canvas_item_set_z_as_relative_to_parent(RID p_item, bool p_enable) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	canvas_item->z_relative = p_enable;
 }
@@ -1077,6 +1444,7 @@ void RendererCanvasCull::canvas_item_set_z_as_relative_to_parent(RID p_item, boo
 void RendererCanvasCull::canvas_item_attach_skeleton(RID p_item, RID p_skeleton) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 	if (canvas_item->skeleton == p_skeleton) {
 		return;
 	}
@@ -1106,6 +1474,7 @@ void RendererCanvasCull::canvas_item_attach_skeleton(RID p_item, RID p_skeleton)
 void RendererCanvasCull::canvas_item_set_copy_to_backbuffer(RID p_item, bool p_enable, const Rect2 &p_rect) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 	if (p_enable && (canvas_item->copy_back_buffer == nullptr)) {
 		canvas_item->copy_back_buffer = memnew(RendererCanvasRender::Item::CopyBackBuffer);
 	}
@@ -1123,6 +1492,7 @@ void RendererCanvasCull::canvas_item_set_copy_to_backbuffer(RID p_item, bool p_e
 void RendererCanvasCull::canvas_item_clear(RID p_item) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	canvas_item->clear();
 }
@@ -1130,6 +1500,7 @@ void RendererCanvasCull::canvas_item_clear(RID p_item) {
 void RendererCanvasCull::canvas_item_set_draw_index(RID p_item, int p_index) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	canvas_item->index = p_index;
 
@@ -1149,6 +1520,7 @@ void RendererCanvasCull::canvas_item_set_draw_index(RID p_item, int p_index) {
 void RendererCanvasCull::canvas_item_set_material(RID p_item, RID p_material) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	canvas_item->material = p_material;
 }
@@ -1156,6 +1528,7 @@ void RendererCanvasCull::canvas_item_set_material(RID p_item, RID p_material) {
 void RendererCanvasCull::canvas_item_set_use_parent_material(RID p_item, bool p_enable) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	canvas_item->use_parent_material = p_enable;
 }
@@ -1163,6 +1536,7 @@ void RendererCanvasCull::canvas_item_set_use_parent_material(RID p_item, bool p_
 void RendererCanvasCull::canvas_item_set_visibility_notifier(RID p_item, bool p_enable, const Rect2 &p_area, const Callable &p_enter_callable, const Callable &p_exit_callable) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	if (p_enable) {
 		if (!canvas_item->visibility_notifier) {
@@ -1183,6 +1557,7 @@ void RendererCanvasCull::canvas_item_set_visibility_notifier(RID p_item, bool p_
 void RendererCanvasCull::canvas_item_set_canvas_group_mode(RID p_item, RS::CanvasGroupMode p_mode, float p_clear_margin, bool p_fit_empty, float p_fit_margin, bool p_blur_mipmaps) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_changed(canvas_item);
 
 	if (p_mode == RS::CANVAS_GROUP_MODE_DISABLED) {
 		if (canvas_item->canvas_group != nullptr) {
@@ -1552,11 +1927,13 @@ void RendererCanvasCull::canvas_texture_set_texture_repeat(RID p_canvas_texture,
 void RendererCanvasCull::canvas_item_set_default_texture_filter(RID p_item, RS::CanvasItemTextureFilter p_filter) {
 	Item *ci = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!ci);
+	_item_changed(ci);
 	ci->texture_filter = p_filter;
 }
 void RendererCanvasCull::canvas_item_set_default_texture_repeat(RID p_item, RS::CanvasItemTextureRepeat p_repeat) {
 	Item *ci = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!ci);
+	_item_changed(ci);
 	ci->texture_repeat = p_repeat;
 }
 
@@ -1639,6 +2016,7 @@ bool RendererCanvasCull::free(RID p_rid) {
 			} else if (canvas_item_owner.owns(canvas_item->parent)) {
 				Item *item_owner = canvas_item_owner.get_or_null(canvas_item->parent);
 				item_owner->child_items.erase(canvas_item);
+				_item_changed(item_owner);
 
 				if (item_owner->sort_y) {
 					_mark_ysort_dirty(item_owner, canvas_item_owner);
@@ -1650,6 +2028,10 @@ bool RendererCanvasCull::free(RID p_rid) {
 			canvas_item->child_items[i]->parent = RID();
 		}
 
+		if (canvas_item->cull_job) {
+			_free_cull_job(canvas_item->cull_job);
+		}
+
 		if (canvas_item->visibility_notifier != nullptr) {
 			visibility_notifier_allocator.free(canvas_item->visibility_notifier);
 		}
@@ -1714,13 +2096,23 @@ bool RendererCanvasCull::free(RID p_rid) {
 }
 
 RendererCanvasCull::RendererCanvasCull() {
-	z_list = (RendererCanvasRender::Item **)memalloc(z_range * sizeof(RendererCanvasRender::Item *));
-	z_last_list = (RendererCanvasRender::Item **)memalloc(z_range * sizeof(RendererCanvasRender::Item *));
+	_allocate_cull_context(cull_context);
+
+	// Thread contexts are allocated the first time a canvas is big enough to be culled in parallel.
+	cull_thread_contexts.resize(MAX(1, RendererThreadPool::singleton->thread_work_pool.get_thread_count()));
+
+	thread_cull_threshold = GLOBAL_GET("rendering/2d/cull/threaded_cull_minimum_items");
 
 	disable_scale = false;
 }
 
 RendererCanvasCull::~RendererCanvasCull() {
-	memfree(z_list);
-	memfree(z_last_list);
+	_free_cull_context(cull_context);
+	for (uint32_t i = 0; i < cull_thread_contexts.size(); i++) {
+		_free_cull_context(cull_thread_contexts[i]);
+	}
+
+	while (cull_job_list.size()) {
+		_free_cull_job(cull_job_list[0]);
+	}
 }
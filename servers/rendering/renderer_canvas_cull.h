@@ -31,12 +31,22 @@
 #ifndef RENDERING_SERVER_CANVAS_CULL_H
 #define RENDERING_SERVER_CANVAS_CULL_H
 
+#include "core/templates/local_vector.h"
 #include "core/templates/paged_allocator.h"
+#include "core/templates/safe_refcount.h"
 #include "renderer_compositor.h"
 #include "renderer_viewport.h"
 
 class RendererCanvasCull {
 public:
+	enum {
+		CANVAS_CULL_MIN_ITEMS_PER_JOB = 128,
+		CANVAS_CULL_JOBS_PER_THREAD = 4,
+		CANVAS_CULL_JOB_MAX_UNUSED_PASSES = 120,
+	};
+
+	struct CullJob;
+
 	struct Item : public RendererCanvasRender::Item {
 		RID parent; // canvas it belongs to
 		List<Item *>::Element *E;
@@ -70,6 +80,11 @@ public:
 
 		VisibilityNotifierData *visibility_notifier = nullptr;
 
+		uint32_t cull_subtree_size = 0; // Items visited below this one in the last cull, used to split threaded culling.
+		uint64_t changed_pass = 0; // Last cull pass in which this item or one of its children changed.
+		uint64_t cull_state_pass = 0; // Last cull pass that wrote the final transform and rect of this item.
+		CullJob *cull_job = nullptr; // Cached cull of the sibling run starting at this item.
+
 		Item() {
 			children_order_dirty = true;
 			E = nullptr;
@@ -174,14 +189,87 @@ public:
 	PagedAllocator<Item::VisibilityNotifierData> visibility_notifier_allocator;
 	SelfList<Item::VisibilityNotifierData>::List visibility_notifier_list;
 
-	_FORCE_INLINE_ void _attach_canvas_item_for_draw(Item *ci, Item *p_canvas_clip, RendererCanvasRender::Item **z_list, RendererCanvasRender::Item **z_last_list, const Transform2D &xform, const Rect2 &p_clip_rect, Rect2 global_rect, const Color &modulate, int p_z, RendererCanvasCull::Item *p_material_owner, bool use_canvas_group, RendererCanvasRender::Item *canvas_group_from, const Transform2D &p_xform);
+	struct ZRange {
+		int z;
+		RendererCanvasRender::Item *first;
+		RendererCanvasRender::Item *last;
+	};
+
+	// A run of sibling items culled as one unit, either on a worker thread or from the cache.
+	struct CullJob {
+		struct Element {
+			Item *item;
+			int z;
+			bool drawn;
+			bool visible;
+		};
+
+		Item *owner = nullptr;
+		uint32_t index = 0;
+
+		LocalVector<Item *> items;
+		Transform2D transform;
+		Rect2 clip_rect;
+		Color modulate;
+		int z = 0;
+		Item *canvas_clip = nullptr;
+		Rect2 canvas_clip_rect;
+		Item *material_owner = nullptr;
+		bool snap = false;
+
+		uint64_t pass = 0; // Pass the cached elements were recorded in, 0 if they can't be reused.
+		uint64_t used_pass = 0;
+		bool use_cache = false;
+		LocalVector<Element> elements;
+
+		LocalVector<ZRange> ranges;
+	};
+
+	struct CullContext {
+		RendererCanvasRender::Item **z_list = nullptr;
+		RendererCanvasRender::Item **z_last_list = nullptr;
+		LocalVector<int> used_z;
+
+		// Side effects are applied on the render thread once culling is done.
+		LocalVector<Item *> visible_notifiers;
+		bool redraw = false;
+
+		LocalVector<CullJob::Element> *record = nullptr;
+		bool cacheable = true;
+	};
+
+	struct CullSegment {
+		CullJob *job = nullptr;
+		uint32_t from = 0; // Range of cull_serial_ranges when not a job.
+		uint32_t to = 0;
+	};
+
+	_FORCE_INLINE_ void _attach_canvas_item_for_draw(Item *ci, Item *p_canvas_clip, CullContext &r_context, const Transform2D &xform, const Rect2 &p_clip_rect, Rect2 global_rect, const Color &modulate, int p_z, RendererCanvasCull::Item *p_material_owner, bool use_canvas_group, RendererCanvasRender::Item *canvas_group_from, const Transform2D &p_xform);
+
+	uint32_t thread_cull_threshold = 2000;
 
 private:
 	void _render_canvas_item_tree(RID p_to_render_target, Canvas::ChildItem *p_child_items, int p_child_item_count, Item *p_canvas_item, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, RendererCanvasRender::Light *p_lights, RendererCanvasRender::Light *p_directional_lights, RS::CanvasItemTextureFilter p_default_filter, RS::CanvasItemTextureRepeat p_default_repeat, bool p_snap_2d_vertices_to_pixel);
-	void _cull_canvas_item(Item *p_canvas_item, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, int p_z, RendererCanvasRender::Item **z_list, RendererCanvasRender::Item **z_last_list, Item *p_canvas_clip, Item *p_material_owner, bool allow_y_sort);
-
-	RendererCanvasRender::Item **z_list;
-	RendererCanvasRender::Item **z_last_list;
+	uint32_t _cull_canvas_item(Item *p_canvas_item, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, int p_z, CullContext &r_context, Item *p_canvas_clip, Item *p_material_owner, bool allow_y_sort, bool p_split);
+	uint32_t _cull_canvas_items_split(Item **p_items, int p_item_count, int p_behind, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, int p_z, CullContext &r_context, Item *p_canvas_clip, Item *p_material_owner);
+	void _queue_cull_job(Item *const *p_items, uint32_t p_item_count, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, int p_z, CullContext &r_context, Item *p_canvas_clip, Item *p_material_owner);
+	void _cull_job(CullJob *p_job, CullContext &r_context);
+	void _cull_jobs_threaded(uint32_t p_thread, void *p_userdata);
+	void _take_z_ranges(CullContext &r_context, LocalVector<ZRange> &r_ranges);
+	void _free_cull_job(CullJob *p_job);
+	void _item_changed(Item *p_item);
+
+	CullContext cull_context;
+	LocalVector<CullContext> cull_thread_contexts;
+
+	uint64_t cull_pass = 1;
+	uint32_t cull_job_size = CANVAS_CULL_MIN_ITEMS_PER_JOB;
+	LocalVector<Item *> cull_root_items;
+	LocalVector<CullSegment> cull_segments;
+	LocalVector<ZRange> cull_serial_ranges;
+	LocalVector<CullJob *> cull_jobs; // Queued in the current pass.
+	LocalVector<CullJob *> cull_job_list; // All allocated jobs.
+	SafeNumeric<uint32_t> cull_next_job;
 
 public:
 	void render_canvas(RID p_render_target, Canvas *p_canvas, const Transform2D &p_transform, RendererCanvasRender::Light *p_lights, RendererCanvasRender::Light *p_directional_lights, const Rect2 &p_clip_rect, RS::CanvasItemTextureFilter p_default_filter, RS::CanvasItemTextureRepeat p_default_repeat, bool p_snap_2d_transforms_to_pixel, bool p_snap_2d_vertices_to_pixel);
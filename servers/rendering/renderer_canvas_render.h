@@ -577,6 +577,8 @@ public:
 	virtual void canvas_render_items(RID p_to_render_target, Item *p_item_list, const Color &p_modulate, Light *p_light_list, Light *p_directional_list, const Transform2D &p_canvas_transform, RS::CanvasItemTextureFilter p_default_filter, RS::CanvasItemTextureRepeat p_default_repeat, bool p_snap_2d_vertices_to_pixel, bool &r_sdf_used) = 0;
 	virtual void canvas_debug_viewport_shadows(Light *p_lights_with_shadow) = 0;
 
+	virtual uint64_t get_rendering_info(RS::RenderingInfo p_info) = 0;
+
 	struct LightOccluderInstance {
 		bool enabled;
 		RID canvas;
@@ -1423,7 +1423,11 @@ void RenderForwardMobile::_fill_render_list(RenderListType p_render_list, const
 				}
 
 				uint32_t indices;
-				surf->lod_index = storage->mesh_surface_get_lod(surf->surface, inst->lod_model_scale * inst->lod_bias, distance * p_render_data->lod_distance_multiplier, p_render_data->screen_lod_threshold, &indices);
+				surf->lod_index = storage->mesh_surface_get_lod(surf->surface, inst->lod_model_scale * inst->lod_bias, distance * p_render_data->lod_distance_multiplier * inst->lod_distance_scale, p_render_data->screen_lod_threshold, &indices);
+				if (p_render_list != RENDER_LIST_SECONDARY && surf->lod_index != surf->drawn_lod_index) {
+					surf->drawn_lod_index = surf->lod_index;
+					mesh_lod_changes++;
+				}
 				if (p_render_data->render_info) {
 					indices = _indices_to_primitives(surf->primitive, indices);
 					if (p_render_list == RENDER_LIST_OPAQUE) { //opaque
@@ -2072,6 +2076,12 @@ void RenderForwardMobile::geometry_instance_set_lod_bias(GeometryInstance *p_geo
 	ginstance->lod_bias = p_lod_bias;
 }
 
+void RenderForwardMobile::geometry_instance_set_lod_distance_scale(GeometryInstance *p_geometry_instance, float p_scale) {
+	GeometryInstanceForwardMobile *ginstance = static_cast<GeometryInstanceForwardMobile *>(p_geometry_instance);
+	ERR_FAIL_COND(!ginstance);
+	ginstance->lod_distance_scale = p_scale;
+}
+
 void RenderForwardMobile::geometry_instance_set_use_baked_light(GeometryInstance *p_geometry_instance, bool p_enable) {
 	GeometryInstanceForwardMobile *ginstance = static_cast<GeometryInstanceForwardMobile *>(p_geometry_instance);
 	ERR_FAIL_COND(!ginstance);
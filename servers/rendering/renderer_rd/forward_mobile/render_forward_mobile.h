@@ -499,6 +499,7 @@ protected:
 		RS::PrimitiveType primitive = RS::PRIMITIVE_MAX;
 		uint32_t flags = 0;
 		uint32_t surface_index = 0;
+		uint32_t drawn_lod_index = 0; // Last LOD picked outside shadow passes.
 		uint32_t lod_index = 0;
 
 		void *surface = nullptr;
@@ -550,6 +551,7 @@ protected:
 		AABB transformed_aabb; //needed for LOD
 		float lod_bias = 0.0;
 		float lod_model_scale = 1.0;
+		float lod_distance_scale = 1.0; // Hysteresis from the scene cull.
 		int32_t shader_parameters_offset = -1;
 		uint32_t instance_count = 0;
 		uint32_t trail_steps = 1;
@@ -632,6 +634,7 @@ public:
 	virtual void geometry_instance_set_transform(GeometryInstance *p_geometry_instance, const Transform3D &p_transform, const AABB &p_aabb, const AABB &p_transformed_aabb) override;
 	virtual void geometry_instance_set_layer_mask(GeometryInstance *p_geometry_instance, uint32_t p_layer_mask) override;
 	virtual void geometry_instance_set_lod_bias(GeometryInstance *p_geometry_instance, float p_lod_bias) override;
+	virtual void geometry_instance_set_lod_distance_scale(GeometryInstance *p_geometry_instance, float p_scale) override;
 	virtual void geometry_instance_set_use_baked_light(GeometryInstance *p_geometry_instance, bool p_enable) override;
 	virtual void geometry_instance_set_use_dynamic_gi(GeometryInstance *p_geometry_instance, bool p_enable) override;
 	virtual void geometry_instance_set_use_lightmap(GeometryInstance *p_geometry_instance, RID p_lightmap_instance, const Rect2 &p_lightmap_uv_scale, int p_lightmap_slice_index) override;
@@ -314,6 +314,40 @@ RendererCanvasRender::PolygonID RendererCanvasRenderRD::request_polygon(const Ve
 
 	pb.vertex_format_id = vertex_id;
 
+	if (vertex_count <= RendererCanvasBatcher::MAX_POLYGON_VERTICES && (uint32_t)p_bones.size() != vertex_count * 4) {
+		pb.batchable = true;
+		for (int i = 0; i < p_indices.size(); i++) {
+			if ((uint32_t)p_indices[i] >= vertex_count) {
+				pb.batchable = false;
+				break;
+			}
+		}
+	}
+
+	if (pb.batchable) {
+		RendererCanvasBatcher::Polygon &polygon = pb.batch_polygon;
+		polygon.points.resize(vertex_count);
+		for (uint32_t i = 0; i < vertex_count; i++) {
+			polygon.points[i] = p_points[i];
+		}
+		if ((uint32_t)p_colors.size() == vertex_count || p_colors.size() == 1) {
+			polygon.colors.resize(p_colors.size());
+			for (int i = 0; i < p_colors.size(); i++) {
+				polygon.colors[i] = p_colors[i];
+			}
+		}
+		if ((uint32_t)p_uvs.size() == vertex_count) {
+			polygon.uvs.resize(vertex_count);
+			for (uint32_t i = 0; i < vertex_count; i++) {
+				polygon.uvs[i] = p_uvs[i];
+			}
+		}
+		polygon.indices.resize(p_indices.size());
+		for (int i = 0; i < p_indices.size(); i++) {
+			polygon.indices[i] = p_indices[i];
+		}
+	}
+
 	PolygonID id = polygon_buffers.last_id++;
 
 	polygon_buffers.polygons[id] = pb;
@@ -440,7 +474,7 @@ void RendererCanvasRenderRD::_render_item(RD::DrawListID p_draw_list, RID p_rend
 		Light *light = p_lights;
 
 		while (light) {
-			if (light->render_index_cache >= 0 && p_item->light_mask & light->item_mask && p_item->z_final >= light->z_min && p_item->z_final <= light->z_max && p_item->global_rect_cache.intersects_transformed(light->xform_cache, light->rect_cache)) {
+			if (_is_item_lit(p_item, light)) {
 				uint32_t light_index = light->render_index_cache;
 				push_constant.lights[light_count >> 2] |= light_index << ((light_count & 3) * 8);
 
@@ -1028,6 +1062,186 @@ RID RendererCanvasRenderRD::_create_base_uniform_set(RID p_to_render_target, boo
 	return uniform_set;
 }
 
+bool RendererCanvasRenderRD::Batcher::_get_texture_size(RID p_texture, RS::CanvasItemTextureFilter p_filter, RS::CanvasItemTextureRepeat p_repeat, Size2i &r_size) {
+	RID uniform_set;
+	Color specular_shininess;
+	bool use_normal;
+	bool use_specular;
+	return canvas_render->storage->canvas_texture_get_uniform_set(p_texture, p_filter, p_repeat, canvas_render->shader.default_version_rd_shader, CANVAS_TEXTURE_UNIFORM_SET, uniform_set, r_size, specular_shininess, use_normal, use_specular);
+}
+
+const RendererCanvasBatcher::Polygon *RendererCanvasRenderRD::Batcher::_get_polygon(PolygonID p_polygon) const {
+	const PolygonBuffers *pb = canvas_render->polygon_buffers.polygons.getptr(p_polygon);
+	return (pb && pb->batchable) ? &pb->batch_polygon : nullptr;
+}
+
+RID RendererCanvasRenderRD::_get_item_material(const Item *p_item) const {
+	RID material = p_item->material_owner == nullptr ? p_item->material : p_item->material_owner->material;
+
+	if (material.is_null() && p_item->canvas_group != nullptr) {
+		material = default_canvas_group_material;
+	}
+
+	return material;
+}
+
+bool RendererCanvasRenderRD::_is_material_batchable(RID p_material) {
+	if (p_material.is_null()) {
+		return true;
+	}
+
+	MaterialData *material_data = (MaterialData *)storage->material_get_data(p_material, RendererStorageRD::SHADER_TYPE_2D);
+	if (!material_data || !material_data->shader_data->version.is_valid() || !material_data->shader_data->valid) {
+		return true; // Drawn with the default shader.
+	}
+
+	return !material_data->shader_data->uses_vertex_function;
+}
+
+void RendererCanvasRenderRD::_build_batches(int p_item_count, const Transform2D &p_canvas_transform_inverse, Light *p_lights) {
+	Batcher &batcher = batching.batcher;
+	batcher.begin(p_canvas_transform_inverse, default_filter, default_repeat);
+
+	RID prev_material;
+	bool material_batchable = true;
+
+	for (int i = 0; i < p_item_count; i++) {
+		Item *ci = items[i];
+
+		RID material = _get_item_material(ci);
+		if (i == 0 || material != prev_material) {
+			material_batchable = _is_material_batchable(material);
+			prev_material = material;
+		}
+
+		bool batchable = batching.enabled && material_batchable && batcher.is_item_batchable(ci);
+		if (batchable) {
+			// Lights are selected per item, so lit items keep their own draws.
+			for (Light *light = p_lights; light; light = light->next_ptr) {
+				if (_is_item_lit(ci, light)) {
+					batchable = false;
+					break;
+				}
+			}
+		}
+
+		batcher.add_item(ci, material, batchable);
+	}
+
+	uint64_t frame = RendererCompositorRD::singleton->get_frame_number();
+	if (batching.info_frame != frame) {
+		batching.info_frame = frame;
+		batching.info_batches = 0;
+		batching.info_batched_commands = 0;
+	}
+	batching.info_batches += batcher.stats.batches;
+	batching.info_batched_commands += batcher.stats.batched_commands;
+}
+
+void RendererCanvasRenderRD::_update_batch_buffers() {
+	Batcher &batcher = batching.batcher;
+
+	batching.index_arrays.resize(batcher.batches.size());
+
+	uint32_t vertex_count = batcher.vertices.size();
+	uint32_t index_count = batcher.indices.size();
+	if (index_count == 0) {
+		return;
+	}
+
+	uint64_t frame = RendererCompositorRD::singleton->get_frame_number();
+	if (batching.frame != frame) {
+		batching.frame = frame;
+		batching.vertex_offset = 0;
+		batching.index_offset = 0;
+	}
+
+	if (batching.vertex_offset + vertex_count > batching.vertex_capacity || batching.index_offset + index_count > batching.index_capacity) {
+		// Draws recorded earlier in the frame still read the old buffers, freeing them is deferred until the GPU is done.
+		if (batching.vertex_buffer.is_valid()) {
+			RD::get_singleton()->free(batching.vertex_array);
+			RD::get_singleton()->free(batching.vertex_buffer);
+			RD::get_singleton()->free(batching.index_buffer);
+		}
+
+		batching.vertex_capacity = next_power_of_2(MAX(batching.vertex_offset + vertex_count, batching.vertex_capacity));
+		batching.index_capacity = next_power_of_2(MAX(batching.index_offset + index_count, batching.index_capacity));
+		batching.vertex_offset = 0;
+		batching.index_offset = 0;
+
+		batching.vertex_buffer = RD::get_singleton()->vertex_buffer_create(batching.vertex_capacity * sizeof(RendererCanvasBatcher::Vertex));
+
+		// Created with data so the debug validation knows the indices are in range, they are rewritten every frame.
+		Vector<uint8_t> index_data;
+		index_data.resize(batching.index_capacity * sizeof(uint32_t));
+		memset(index_data.ptrw(), 0, index_data.size());
+		batching.index_buffer = RD::get_singleton()->index_buffer_create(batching.index_capacity, RD::INDEX_BUFFER_FORMAT_UINT32, index_data);
+
+		Vector<RID> buffers;
+		buffers.push_back(batching.vertex_buffer);
+		buffers.push_back(batching.vertex_buffer);
+		buffers.push_back(batching.vertex_buffer);
+		buffers.push_back(storage->mesh_get_default_rd_buffer(RendererStorageRD::DEFAULT_RD_BUFFER_BONES));
+		buffers.push_back(storage->mesh_get_default_rd_buffer(RendererStorageRD::DEFAULT_RD_BUFFER_BONES));
+		batching.vertex_array = RD::get_singleton()->vertex_array_create(batching.vertex_capacity, batching.vertex_format, buffers);
+	}
+
+	if (batching.vertex_offset) {
+		for (uint32_t i = 0; i < index_count; i++) {
+			batcher.indices[i] += batching.vertex_offset;
+		}
+	}
+
+	RD::get_singleton()->buffer_update(batching.vertex_buffer, batching.vertex_offset * sizeof(RendererCanvasBatcher::Vertex), vertex_count * sizeof(RendererCanvasBatcher::Vertex), batcher.vertices.ptr());
+	RD::get_singleton()->buffer_update(batching.index_buffer, batching.index_offset * sizeof(uint32_t), index_count * sizeof(uint32_t), batcher.indices.ptr());
+
+	for (uint32_t i = 0; i < batcher.batches.size(); i++) {
+		const RendererCanvasBatcher::Batch &batch = batcher.batches[i];
+		if (!batch.item && batch.index_count) {
+			batching.index_arrays[i] = RD::get_singleton()->index_array_create(batching.index_buffer, batching.index_offset + batch.index_from, batch.index_count);
+		}
+	}
+
+	batching.vertex_offset += vertex_count;
+	batching.index_offset += index_count;
+}
+
+void RendererCanvasRenderRD::_render_batch(RD::DrawListID p_draw_list, const RendererCanvasBatcher::Batch &p_batch, RID p_index_array, RD::FramebufferFormatID p_framebuffer_format, PipelineVariants *p_pipeline_variants) {
+	if (p_index_array.is_null()) {
+		return;
+	}
+
+	// Merged items have no lights of their own, only the directional ones apply.
+	PipelineLightMode light_mode = using_directional_lights ? PIPELINE_LIGHT_MODE_ENABLED : PIPELINE_LIGHT_MODE_DISABLED;
+	RID pipeline = p_pipeline_variants->variants[light_mode][PIPELINE_VARIANT_ATTRIBUTE_TRIANGLES].get_render_pipeline(batching.vertex_format, p_framebuffer_format);
+	RD::get_singleton()->draw_list_bind_render_pipeline(p_draw_list, pipeline);
+
+	// Vertices are already in canvas space and carry their final color.
+	PushConstant push_constant;
+	_update_transform_2d_to_mat2x3(Transform2D(), push_constant.world);
+	push_constant.flags = 0;
+	push_constant.specular_shininess = 0;
+
+	for (int i = 0; i < 4; i++) {
+		push_constant.modulation[i] = 1;
+		push_constant.ninepatch_margins[i] = 0;
+		push_constant.src_rect[i] = 0;
+		push_constant.dst_rect[i] = 0;
+		push_constant.lights[i] = 0;
+	}
+	push_constant.pad[0] = 0;
+	push_constant.pad[1] = 0;
+
+	RID last_texture;
+	Size2 texpixel_size;
+	_bind_canvas_texture(p_draw_list, p_batch.texture, p_batch.filter, p_batch.repeat, last_texture, push_constant, texpixel_size);
+
+	RD::get_singleton()->draw_list_set_push_constant(p_draw_list, &push_constant, sizeof(PushConstant));
+	RD::get_singleton()->draw_list_bind_vertex_array(p_draw_list, batching.vertex_array);
+	RD::get_singleton()->draw_list_bind_index_array(p_draw_list, p_index_array);
+	RD::get_singleton()->draw_list_draw(p_draw_list, true);
+}
+
 void RendererCanvasRenderRD::_render_items(RID p_to_render_target, int p_item_count, const Transform2D &p_canvas_transform_inverse, Light *p_lights, bool p_to_backbuffer) {
 	Item *current_clip = nullptr;
 
@@ -1062,6 +1276,10 @@ void RendererCanvasRenderRD::_render_items(RID p_to_render_target, int p_item_co
 
 	RD::FramebufferFormatID fb_format = RD::get_singleton()->framebuffer_get_format(framebuffer);
 
+	// Buffers can't be updated while drawing, so the batches are built and uploaded first.
+	_build_batches(p_item_count, canvas_transform_inverse, p_lights);
+	_update_batch_buffers();
+
 	RD::DrawListID draw_list = RD::get_singleton()->draw_list_begin(framebuffer, clear ? RD::INITIAL_ACTION_CLEAR : RD::INITIAL_ACTION_KEEP, RD::FINAL_ACTION_READ, RD::INITIAL_ACTION_KEEP, RD::FINAL_ACTION_DISCARD, clear_colors);
 
 	RD::get_singleton()->draw_list_bind_uniform_set(draw_list, fb_uniform_set, BASE_UNIFORM_SET);
@@ -1071,11 +1289,13 @@ void RendererCanvasRenderRD::_render_items(RID p_to_render_target, int p_item_co
 
 	PipelineVariants *pipeline_variants = &shader.pipeline_variants;
 
-	for (int i = 0; i < p_item_count; i++) {
-		Item *ci = items[i];
+	const LocalVector<RendererCanvasBatcher::Batch> &batches = batching.batcher.batches;
+
+	for (uint32_t i = 0; i < batches.size(); i++) {
+		const RendererCanvasBatcher::Batch &batch = batches[i];
 
-		if (current_clip != ci->final_clip_owner) {
-			current_clip = ci->final_clip_owner;
+		if (current_clip != batch.clip_owner) {
+			current_clip = batch.clip_owner;
 
 			//setup clip
 			if (current_clip) {
@@ -1086,11 +1306,7 @@ void RendererCanvasRenderRD::_render_items(RID p_to_render_target, int p_item_co
 			}
 		}
 
-		RID material = ci->material_owner == nullptr ? ci->material : ci->material_owner->material;
-
-		if (material.is_null() && ci->canvas_group != nullptr) {
-			material = default_canvas_group_material;
-		}
+		RID material = batch.material;
 
 		if (material != prev_material) {
 			MaterialData *material_data = nullptr;
@@ -1113,12 +1329,23 @@ void RendererCanvasRenderRD::_render_items(RID p_to_render_target, int p_item_co
 			}
 		}
 
-		_render_item(draw_list, p_to_render_target, ci, fb_format, canvas_transform_inverse, current_clip, p_lights, pipeline_variants);
+		if (batch.item) {
+			_render_item(draw_list, p_to_render_target, batch.item, fb_format, canvas_transform_inverse, current_clip, p_lights, pipeline_variants);
+		} else {
+			_render_batch(draw_list, batch, batching.index_arrays[i], fb_format, pipeline_variants);
+		}
 
 		prev_material = material;
 	}
 
 	RD::get_singleton()->draw_list_end();
+
+	for (uint32_t i = 0; i < batching.index_arrays.size(); i++) {
+		if (batching.index_arrays[i].is_valid()) {
+			RD::get_singleton()->free(batching.index_arrays[i]);
+		}
+	}
+	batching.index_arrays.clear();
 }
 
 void RendererCanvasRenderRD::canvas_render_items(RID p_to_render_target, Item *p_item_list, const Color &p_modulate, Light *p_light_list, Light *p_directional_light_list, const Transform2D &p_canvas_transform, RenderingServer::CanvasItemTextureFilter p_default_filter, RenderingServer::CanvasItemTextureRepeat p_default_repeat, bool p_snap_2d_vertices_to_pixel, bool &r_sdf_used) {
@@ -1950,6 +2177,7 @@ void RendererCanvasRenderRD::ShaderData::set_code(const String &p_code) {
 	uses_screen_texture = false;
 	uses_sdf = false;
 	uses_time = false;
+	uses_vertex_function = false;
 
 	if (code == String()) {
 		return; //just invalid, but no error
@@ -2006,6 +2234,8 @@ void RendererCanvasRenderRD::ShaderData::set_code(const String &p_code) {
 	ubo_size = gen_code.uniform_total_size;
 	ubo_offsets = gen_code.uniform_offsets;
 	texture_uniforms = gen_code.texture_uniforms;
+	// Vertex code works in item space, so it can't be merged into pre-transformed batches.
+	uses_vertex_function = gen_code.code.has("vertex");
 
 	//update them pipelines
 
@@ -2234,6 +2464,15 @@ RendererStorageRD::MaterialData *RendererCanvasRenderRD::_create_material_func(S
 	return material_data;
 }
 
+uint64_t RendererCanvasRenderRD::get_rendering_info(RS::RenderingInfo p_info) {
+	if (p_info == RS::RENDERING_INFO_CANVAS_BATCHES_IN_FRAME) {
+		return batching.info_batches;
+	} else if (p_info == RS::RENDERING_INFO_CANVAS_BATCHED_COMMANDS_IN_FRAME) {
+		return batching.info_batched_commands;
+	}
+	return 0;
+}
+
 void RendererCanvasRenderRD::set_time(double p_time) {
 	state.time = p_time;
 }
@@ -2509,6 +2748,43 @@ RendererCanvasRenderRD::RendererCanvasRenderRD(RendererStorageRD *p_storage) {
 		polygon_buffers.last_id = 1;
 	}
 
+	{ // batching, same layout as polygons without bones
+		Vector<RD::VertexAttribute> descriptions;
+
+		RD::VertexAttribute vd;
+		vd.stride = sizeof(RendererCanvasBatcher::Vertex);
+
+		vd.format = RD::DATA_FORMAT_R32G32_SFLOAT;
+		vd.offset = offsetof(RendererCanvasBatcher::Vertex, position);
+		vd.location = RS::ARRAY_VERTEX;
+		descriptions.push_back(vd);
+
+		vd.format = RD::DATA_FORMAT_R32G32B32A32_SFLOAT;
+		vd.offset = offsetof(RendererCanvasBatcher::Vertex, color);
+		vd.location = RS::ARRAY_COLOR;
+		descriptions.push_back(vd);
+
+		vd.format = RD::DATA_FORMAT_R32G32_SFLOAT;
+		vd.offset = offsetof(RendererCanvasBatcher::Vertex, uv);
+		vd.location = RS::ARRAY_TEX_UV;
+		descriptions.push_back(vd);
+
+		vd.stride = 0;
+		vd.offset = 0;
+
+		vd.format = RD::DATA_FORMAT_R32G32B32A32_UINT;
+		vd.location = RS::ARRAY_BONES;
+		descriptions.push_back(vd);
+
+		vd.format = RD::DATA_FORMAT_R32G32B32A32_SFLOAT;
+		vd.location = RS::ARRAY_WEIGHTS;
+		descriptions.push_back(vd);
+
+		batching.vertex_format = RD::get_singleton()->vertex_format_create(descriptions);
+		batching.batcher.canvas_render = this;
+		batching.enabled = GLOBAL_GET("rendering/2d/batching/enabled");
+	}
+
 	{ // default index buffer
 
 		Vector<uint8_t> pv;
@@ -2686,6 +2962,12 @@ RendererCanvasRenderRD::~RendererCanvasRenderRD() {
 		//primitives are erase by dependency
 	}
 
+	if (batching.vertex_buffer.is_valid()) {
+		RD::get_singleton()->free(batching.vertex_array);
+		RD::get_singleton()->free(batching.vertex_buffer);
+		RD::get_singleton()->free(batching.index_buffer);
+	}
+
 	if (state.shadow_fb.is_valid()) {
 		RD::get_singleton()->free(state.shadow_depth_texture);
 	}
@@ -31,6 +31,7 @@
 #ifndef RENDERING_SERVER_CANVAS_RENDER_RD_H
 #define RENDERING_SERVER_CANVAS_RENDER_RD_H
 
+#include "servers/rendering/renderer_canvas_batcher.h"
 #include "servers/rendering/renderer_canvas_render.h"
 #include "servers/rendering/renderer_compositor.h"
 #include "servers/rendering/renderer_rd/pipeline_cache_rd.h"
@@ -178,6 +179,7 @@ class RendererCanvasRenderRD : public RendererCanvasRender {
 		bool uses_screen_texture = false;
 		bool uses_sdf = false;
 		bool uses_time = false;
+		bool uses_vertex_function = false;
 
 		virtual void set_code(const String &p_Code);
 		virtual void set_default_texture_param(const StringName &p_name, RID p_texture);
@@ -234,6 +236,10 @@ class RendererCanvasRenderRD : public RendererCanvasRender {
 		RID vertex_array;
 		RID index_buffer;
 		RID indices;
+
+		// Small polygons without bones also keep their arrays, so they can be merged into batches.
+		bool batchable = false;
+		RendererCanvasBatcher::Polygon batch_polygon;
 	};
 
 	struct {
@@ -249,6 +255,39 @@ class RendererCanvasRenderRD : public RendererCanvasRender {
 		RID index_array[4];
 	} primitive_arrays;
 
+	/******************/
+	/**** BATCHING ****/
+	/******************/
+
+	struct Batcher : public RendererCanvasBatcher {
+		RendererCanvasRenderRD *canvas_render = nullptr;
+
+		virtual bool _get_texture_size(RID p_texture, RS::CanvasItemTextureFilter p_filter, RS::CanvasItemTextureRepeat p_repeat, Size2i &r_size);
+		virtual const Polygon *_get_polygon(PolygonID p_polygon) const;
+	};
+
+	struct {
+		bool enabled = true;
+		Batcher batcher;
+
+		// Merged geometry of all the batches in a frame, each _render_items() call appends to it.
+		RD::VertexFormatID vertex_format = RD::INVALID_ID;
+		RID vertex_buffer;
+		RID vertex_array;
+		RID index_buffer;
+		uint32_t vertex_capacity = 0;
+		uint32_t index_capacity = 0;
+		uint32_t vertex_offset = 0;
+		uint32_t index_offset = 0;
+		uint64_t frame = 0;
+
+		LocalVector<RID> index_arrays;
+
+		uint64_t info_frame = 0;
+		uint32_t info_batches = 0;
+		uint32_t info_batched_commands = 0;
+	} batching;
+
 	/*******************/
 	/**** MATERIALS ****/
 	/*******************/
@@ -427,6 +466,14 @@ class RendererCanvasRenderRD : public RendererCanvasRender {
 	RID _create_base_uniform_set(RID p_to_render_target, bool p_backbuffer);
 
 	inline void _bind_canvas_texture(RD::DrawListID p_draw_list, RID p_texture, RS::CanvasItemTextureFilter p_base_filter, RS::CanvasItemTextureRepeat p_base_repeat, RID &r_last_texture, PushConstant &push_constant, Size2 &r_texpixel_size); //recursive, so regular inline used instead.
+	_FORCE_INLINE_ bool _is_item_lit(const Item *p_item, const Light *p_light) const {
+		return p_light->render_index_cache >= 0 && p_item->light_mask & p_light->item_mask && p_item->z_final >= p_light->z_min && p_item->z_final <= p_light->z_max && p_item->global_rect_cache.intersects_transformed(p_light->xform_cache, p_light->rect_cache);
+	}
+	RID _get_item_material(const Item *p_item) const;
+	bool _is_material_batchable(RID p_material);
+	void _build_batches(int p_item_count, const Transform2D &p_canvas_transform_inverse, Light *p_lights);
+	void _update_batch_buffers();
+	void _render_batch(RenderingDevice::DrawListID p_draw_list, const RendererCanvasBatcher::Batch &p_batch, RID p_index_array, RenderingDevice::FramebufferFormatID p_framebuffer_format, PipelineVariants *p_pipeline_variants);
 	void _render_item(RenderingDevice::DrawListID p_draw_list, RID p_render_target, const Item *p_item, RenderingDevice::FramebufferFormatID p_framebuffer_format, const Transform2D &p_canvas_transform_inverse, Item *&current_clip, Light *p_lights, PipelineVariants *p_pipeline_variants);
 	void _render_items(RID p_to_render_target, int p_item_count, const Transform2D &p_canvas_transform_inverse, Light *p_lights, bool p_to_backbuffer = false);
 
@@ -460,6 +507,8 @@ public:
 
 	virtual void set_shadow_texture_size(int p_size);
 
+	uint64_t get_rendering_info(RS::RenderingInfo p_info);
+
 	void set_time(double p_time);
 	void update();
 	bool free(RID p_rid);
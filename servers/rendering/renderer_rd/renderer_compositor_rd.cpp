@@ -157,6 +157,10 @@ void RendererCompositorRD::finalize() {
 	blit.shader.version_free(blit.shader_version);
 	RD::get_singleton()->free(blit.index_buffer);
 	RD::get_singleton()->free(blit.sampler);
+
+	if (shader_cache) {
+		shader_cache->save_prewarm_list();
+	}
 }
 
 void RendererCompositorRD::set_boot_image(const Ref<Image> &p_image, const Color &p_color, bool p_scale, bool p_use_filter) {
@@ -264,12 +268,11 @@ RendererCompositorRD::RendererCompositorRD() {
 				if (shader_cache_dir != String()) {
 					bool compress = GLOBAL_GET("rendering/shader_compiler/shader_cache/compress");
 					bool use_zstd = GLOBAL_GET("rendering/shader_compiler/shader_cache/use_zstd_compression");
-					bool strip_debug = GLOBAL_GET("rendering/shader_compiler/shader_cache/strip_debug");
 
-					ShaderRD::set_shader_cache_dir(shader_cache_dir);
-					ShaderRD::set_shader_cache_save_compressed(compress);
-					ShaderRD::set_shader_cache_save_compressed_zstd(use_zstd);
-					ShaderRD::set_shader_cache_save_debug(!strip_debug);
+					shader_cache = memnew(ShaderCacheRD(shader_cache_dir, compress, use_zstd));
+					// Start reading the entries used last run, they are handed to the compiles below as they get there.
+					shader_cache->prewarm();
+					ShaderRD::set_shader_cache(shader_cache);
 				}
 			}
 		}
@@ -278,6 +281,8 @@ RendererCompositorRD::RendererCompositorRD() {
 	singleton = this;
 	time = 0;
 
+	ShaderRD::init_compile_threads();
+
 	storage = memnew(RendererStorageRD);
 	canvas = memnew(RendererCanvasRenderRD(storage));
 
@@ -298,5 +303,9 @@ RendererCompositorRD::RendererCompositorRD() {
 }
 
 RendererCompositorRD::~RendererCompositorRD() {
-	ShaderRD::set_shader_cache_dir(String());
+	ShaderRD::finish_compile_threads();
+	ShaderRD::set_shader_cache(nullptr);
+	if (shader_cache) {
+		memdelete(shader_cache);
+	}
 }
@@ -38,6 +38,7 @@
 #include "servers/rendering/renderer_rd/forward_mobile/render_forward_mobile.h"
 #include "servers/rendering/renderer_rd/renderer_canvas_render_rd.h"
 #include "servers/rendering/renderer_rd/renderer_storage_rd.h"
+#include "servers/rendering/renderer_rd/shader_cache_rd.h"
 #include "servers/rendering/renderer_rd/shaders/blit.glsl.gen.h"
 
 class RendererCompositorRD : public RendererCompositor {
@@ -45,6 +46,7 @@ protected:
 	RendererCanvasRenderRD *canvas;
 	RendererStorageRD *storage;
 	RendererSceneRenderRD *scene;
+	ShaderCacheRD *shader_cache = nullptr;
 
 	enum BlitMode {
 		BLIT_MODE_NORMAL,
@@ -4514,7 +4514,15 @@ void RendererSceneRenderRD::set_debug_draw_mode(RS::ViewportDebugDraw p_debug_dr
 	debug_draw = p_debug_draw;
 }
 
+uint64_t RendererSceneRenderRD::get_rendering_info(RS::RenderingInfo p_info) {
+	if (p_info == RS::RENDERING_INFO_MESH_LOD_CHANGES_IN_FRAME) {
+		return mesh_lod_changes;
+	}
+	return 0;
+}
+
 void RendererSceneRenderRD::update() {
+	mesh_lod_changes = 0;
 	sky.update_dirty_skys();
 }
 
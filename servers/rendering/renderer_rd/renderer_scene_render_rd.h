@@ -174,6 +174,8 @@ protected:
 
 	virtual void _update_shader_quality_settings() {}
 
+	uint64_t mesh_lod_changes = 0;
+
 private:
 	RS::ViewportDebugDraw debug_draw = RS::VIEWPORT_DEBUG_DRAW_DISABLED;
 	static RendererSceneRenderRD *singleton;
@@ -1277,6 +1279,8 @@ public:
 
 	virtual bool free(RID p_rid) override;
 
+	virtual uint64_t get_rendering_info(RS::RenderingInfo p_info) override;
+
 	virtual void update() override;
 
 	virtual void set_debug_draw_mode(RS::ViewportDebugDraw p_debug_draw) override;
@@ -0,0 +1,281 @@
+/*************************************************************************/
+/*  shader_cache_rd.cpp                                                  */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "shader_cache_rd.h"
+
+#include "core/crypto/crypto_core.h"
+#include "core/io/dir_access.h"
+#include "core/io/file_access.h"
+
+static const char *shader_cache_entry_header = "GDSC";
+static const char *shader_cache_prewarm_header = "GDSP";
+static const uint32_t shader_cache_version = 3;
+static const uint32_t shader_cache_uncompressed = 0xFF;
+static const int shader_cache_hash_length = 64;
+
+String ShaderCacheRD::hash_sources(const String &p_cache_key, const Vector<String> &p_sources) {
+	CryptoCore::SHA256Context ctx;
+	ctx.start();
+
+	CharString key = p_cache_key.utf8();
+	ctx.update((const uint8_t *)key.get_data(), key.length());
+	for (int i = 0; i < p_sources.size(); i++) {
+		// Prefix each stage with its length, so moving code from one stage to the next changes the hash.
+		CharString source = p_sources[i].utf8();
+		uint32_t length = source.length();
+		ctx.update((const uint8_t *)&length, sizeof(uint32_t));
+		ctx.update((const uint8_t *)source.get_data(), length);
+	}
+
+	unsigned char hash[32];
+	ctx.finish(hash);
+	return String::hex_encode_buffer(hash, 32);
+}
+
+String ShaderCacheRD::_get_entry_path(const String &p_hash) const {
+	return path.plus_file(p_hash.substr(0, 2)).plus_file(p_hash + ".cache");
+}
+
+bool ShaderCacheRD::_read_entry(const String &p_hash, Vector<uint8_t> &r_data) const {
+	FileAccessRef f = FileAccess::open(_get_entry_path(p_hash), FileAccess::READ);
+	if (!f) {
+		return false;
+	}
+
+	char header[5] = { 0, 0, 0, 0, 0 };
+	f->get_buffer((uint8_t *)header, 4);
+	if (String(header) != shader_cache_entry_header || f->get_32() != shader_cache_version) {
+		return false; // Written by another version, will be overwritten.
+	}
+
+	uint32_t mode = f->get_32();
+	uint32_t data_size = f->get_32();
+	uint32_t stored_size = f->get_32();
+	uint32_t checksum = f->get_32();
+	ERR_FAIL_COND_V_MSG(data_size == 0 || stored_size == 0 || stored_size > f->get_length() - f->get_position(), false, "Truncated shader cache entry: " + p_hash);
+
+	Vector<uint8_t> stored;
+	stored.resize(stored_size);
+	f->get_buffer(stored.ptrw(), stored_size);
+	ERR_FAIL_COND_V_MSG(hash_djb2_buffer(stored.ptr(), stored_size) != checksum, false, "Corrupt shader cache entry: " + p_hash);
+
+	if (mode == shader_cache_uncompressed) {
+		ERR_FAIL_COND_V(stored_size != data_size, false);
+		r_data = stored;
+		return true;
+	}
+
+	ERR_FAIL_COND_V(mode != Compression::MODE_DEFLATE && mode != Compression::MODE_ZSTD, false);
+	r_data.resize(data_size);
+	int decompressed = Compression::decompress(r_data.ptrw(), data_size, stored.ptr(), stored_size, Compression::Mode(mode));
+	if (decompressed != int(data_size)) {
+		r_data.clear();
+		ERR_FAIL_V_MSG(false, "Corrupt shader cache entry: " + p_hash);
+	}
+	return true;
+}
+
+void ShaderCacheRD::_prewarm_entry(uint32_t p_index, void *p_userdata) {
+	const String &hash = prewarm_hashes[p_index];
+	{
+		MutexLock lock(mutex);
+		if (used_set.has(hash)) {
+			return; // Already requested by a compile, no point in reading it again.
+		}
+	}
+
+	Vector<uint8_t> data;
+	if (!_read_entry(hash, data)) {
+		return;
+	}
+
+	MutexLock lock(mutex);
+	if (!used_set.has(hash)) {
+		prewarmed[hash] = data;
+	}
+}
+
+bool ShaderCacheRD::load(const String &p_hash, Vector<uint8_t> &r_data) {
+	{
+		MutexLock lock(mutex);
+		if (!used_set.has(p_hash)) {
+			used_set.insert(p_hash);
+			used.push_back(p_hash);
+		}
+		Vector<uint8_t> *data = prewarmed.getptr(p_hash);
+		if (data) {
+			r_data = *data;
+			prewarmed.erase(p_hash);
+			prewarm_hit_count.increment();
+			hit_count.increment();
+			return true;
+		}
+	}
+
+	if (_read_entry(p_hash, r_data)) {
+		hit_count.increment();
+		return true;
+	}
+
+	miss_count.increment();
+	return false;
+}
+
+void ShaderCacheRD::save(const String &p_hash, const Vector<uint8_t> &p_data) {
+	ERR_FAIL_COND(p_data.size() == 0);
+
+	{
+		MutexLock lock(mutex);
+		if (!used_set.has(p_hash)) {
+			used_set.insert(p_hash);
+			used.push_back(p_hash);
+		}
+	}
+
+	uint32_t mode = shader_cache_uncompressed;
+	Vector<uint8_t> stored;
+	if (compress) {
+		stored.resize(Compression::get_max_compressed_buffer_size(p_data.size(), compression_mode));
+		int stored_size = Compression::compress(stored.ptrw(), p_data.ptr(), p_data.size(), compression_mode);
+		if (stored_size > 0 && stored_size < p_data.size()) {
+			stored.resize(stored_size);
+			mode = compression_mode;
+		}
+	}
+	if (mode == shader_cache_uncompressed) {
+		stored = p_data;
+	}
+
+	String entry_path = _get_entry_path(p_hash);
+	DirAccessRef da = DirAccess::create_for_path(path);
+	ERR_FAIL_COND(!da);
+	Error err = da->make_dir_recursive(entry_path.get_base_dir());
+	ERR_FAIL_COND_MSG(err != OK, "Can't create shader cache folder: " + entry_path.get_base_dir());
+
+	// Write to a file private to this thread and move it in place, so a reader never sees half an entry.
+	String temp_path = entry_path + "." + itos(Thread::get_caller_id()) + ".tmp";
+	{
+		FileAccessRef f = FileAccess::open(temp_path, FileAccess::WRITE);
+		ERR_FAIL_COND_MSG(!f, "Can't write shader cache entry: " + temp_path);
+		f->store_buffer((const uint8_t *)shader_cache_entry_header, 4);
+		f->store_32(shader_cache_version);
+		f->store_32(mode);
+		f->store_32(p_data.size());
+		f->store_32(stored.size());
+		f->store_32(hash_djb2_buffer(stored.ptr(), stored.size()));
+		f->store_buffer(stored.ptr(), stored.size());
+		f->close();
+	}
+
+	if (da->file_exists(entry_path)) {
+		da->remove(entry_path);
+	}
+	err = da->rename(temp_path, entry_path);
+	if (err != OK) {
+		// Another thread saved the same variant first, theirs is as good as ours.
+		da->remove(temp_path);
+	}
+}
+
+void ShaderCacheRD::prewarm() {
+	ERR_FAIL_COND(prewarm_pool.is_working());
+
+	FileAccessRef f = FileAccess::open(path.plus_file("prewarm.list"), FileAccess::READ);
+	if (!f) {
+		return;
+	}
+
+	char header[5] = { 0, 0, 0, 0, 0 };
+	f->get_buffer((uint8_t *)header, 4);
+	if (String(header) != shader_cache_prewarm_header || f->get_32() != shader_cache_version) {
+		return;
+	}
+
+	uint32_t count = f->get_32();
+	ERR_FAIL_COND(uint64_t(count) * shader_cache_hash_length > f->get_length() - f->get_position());
+
+	prewarm_hashes.resize(count);
+	char hash[shader_cache_hash_length + 1];
+	hash[shader_cache_hash_length] = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		f->get_buffer((uint8_t *)hash, shader_cache_hash_length);
+		prewarm_hashes.write[i] = String(hash);
+	}
+
+	if (count == 0) {
+		return;
+	}
+
+	// Reading entries is mostly waiting on the disk, a couple of threads are enough to stay ahead of the compiles.
+	prewarm_pool.init(2);
+	prewarm_pool.begin_work(count, this, &ShaderCacheRD::_prewarm_entry, (void *)nullptr);
+}
+
+void ShaderCacheRD::wait_for_prewarm() {
+	if (prewarm_pool.is_working()) {
+		prewarm_pool.end_work();
+	}
+	prewarm_pool.finish();
+}
+
+Error ShaderCacheRD::save_prewarm_list() {
+	wait_for_prewarm();
+
+	MutexLock lock(mutex);
+	print_verbose(vformat("Shader cache: %d hits (%d prewarmed), %d misses, %d entries left unused.", hit_count.get(), prewarm_hit_count.get(), miss_count.get(), prewarmed.size()));
+
+	Error err;
+	FileAccessRef f = FileAccess::open(path.plus_file("prewarm.list"), FileAccess::WRITE, &err);
+	ERR_FAIL_COND_V_MSG(!f, err, "Can't write shader cache prewarm list: " + path);
+	f->store_buffer((const uint8_t *)shader_cache_prewarm_header, 4);
+	f->store_32(shader_cache_version);
+	Vector<CharString> hashes;
+	for (int i = 0; i < used.size(); i++) {
+		if (used[i].length() == shader_cache_hash_length) {
+			hashes.push_back(used[i].ascii());
+		}
+	}
+	f->store_32(hashes.size());
+	for (int i = 0; i < hashes.size(); i++) {
+		f->store_buffer((const uint8_t *)hashes[i].get_data(), shader_cache_hash_length);
+	}
+	f->close();
+	return OK;
+}
+
+ShaderCacheRD::ShaderCacheRD(const String &p_path, bool p_compress, bool p_use_zstd) {
+	path = p_path;
+	compress = p_compress;
+	compression_mode = p_use_zstd ? Compression::MODE_ZSTD : Compression::MODE_DEFLATE;
+}
+
+ShaderCacheRD::~ShaderCacheRD() {
+	wait_for_prewarm();
+}
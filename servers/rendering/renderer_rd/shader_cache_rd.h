@@ -0,0 +1,85 @@
+/*************************************************************************/
+/*  shader_cache_rd.h                                                    */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef SHADER_CACHE_RD_H
+#define SHADER_CACHE_RD_H
+
+#include "core/io/compression.h"
+#include "core/os/mutex.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/safe_refcount.h"
+#include "core/templates/set.h"
+#include "core/templates/thread_work_pool.h"
+
+// Content addressed cache of compiled shader variants. Entries are keyed by a hash of the
+// generated source of every stage, so variants with identical code share an entry no matter
+// which shader or version produced them. It doesn't use the RenderingDevice.
+class ShaderCacheRD {
+	String path;
+	bool compress = true;
+	Compression::Mode compression_mode = Compression::MODE_ZSTD;
+
+	Mutex mutex;
+	// Entries read ahead on the prewarm threads, handed out on their first load.
+	HashMap<String, Vector<uint8_t>> prewarmed;
+	// Every hash loaded or saved this run, in order of first use. Saved as the next prewarm list.
+	Set<String> used_set;
+	Vector<String> used;
+
+	Vector<String> prewarm_hashes;
+	ThreadWorkPool prewarm_pool;
+
+	SafeNumeric<uint32_t> hit_count;
+	SafeNumeric<uint32_t> prewarm_hit_count;
+	SafeNumeric<uint32_t> miss_count;
+
+	String _get_entry_path(const String &p_hash) const;
+	bool _read_entry(const String &p_hash, Vector<uint8_t> &r_data) const;
+	void _prewarm_entry(uint32_t p_index, void *p_userdata);
+
+public:
+	static String hash_sources(const String &p_cache_key, const Vector<String> &p_sources);
+
+	bool load(const String &p_hash, Vector<uint8_t> &r_data);
+	void save(const String &p_hash, const Vector<uint8_t> &p_data);
+
+	void prewarm();
+	void wait_for_prewarm();
+	Error save_prewarm_list();
+
+	uint32_t get_hit_count() const { return hit_count.get(); }
+	uint32_t get_prewarm_hit_count() const { return prewarm_hit_count.get(); }
+	uint32_t get_miss_count() const { return miss_count.get(); }
+
+	ShaderCacheRD(const String &p_path, bool p_compress = true, bool p_use_zstd = true);
+	~ShaderCacheRD();
+};
+
+#endif // SHADER_CACHE_RD_H
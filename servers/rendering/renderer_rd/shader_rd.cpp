@@ -30,9 +30,6 @@
 
 #include "shader_rd.h"
 
-#include "core/io/compression.h"
-#include "core/io/dir_access.h"
-#include "core/io/file_access.h"
 #include "renderer_compositor_rd.h"
 #include "servers/rendering/rendering_device.h"
 #include "thirdparty/misc/smolv.h"
@@ -115,19 +112,14 @@ void ShaderRD::setup(const char *p_vertex_code, const char *p_fragment_code, con
 		}
 	}
 
-	StringBuilder tohash;
-	tohash.append("[SpirvCacheKey]");
-	tohash.append(RenderingDevice::get_singleton()->shader_get_spirv_cache_key());
-	tohash.append("[BinaryCacheKey]");
-	tohash.append(RenderingDevice::get_singleton()->shader_get_binary_cache_key());
-	tohash.append("[Vertex]");
-	tohash.append(p_vertex_code ? p_vertex_code : "");
-	tohash.append("[Fragment]");
-	tohash.append(p_fragment_code ? p_fragment_code : "");
-	tohash.append("[Compute]");
-	tohash.append(p_compute_code ? p_compute_code : "");
+	// The source of every variant is hashed when compiled, only the compiler and the device go in the key.
+	StringBuilder key;
+	key.append("[SpirvCacheKey]");
+	key.append(RenderingDevice::get_singleton()->shader_get_spirv_cache_key());
+	key.append("[BinaryCacheKey]");
+	key.append(RenderingDevice::get_singleton()->shader_get_binary_cache_key());
 
-	base_sha256 = tohash.as_string().sha256_text();
+	cache_key = key.as_string();
 }
 
 RID ShaderRD::version_create() {
@@ -143,18 +135,19 @@ RID ShaderRD::version_create() {
 }
 
 void ShaderRD::_clear_version(Version *p_version) {
+	if (p_version->compile_state) {
+		_wait_for_version(p_version);
+	}
+
 	//clear versions if they exist
 	if (p_version->variants) {
 		for (int i = 0; i < variant_defines.size(); i++) {
-			if (variants_enabled[i]) {
+			if (variants_enabled[i] && p_version->variants[i].is_valid()) {
 				RD::get_singleton()->free(p_version->variants[i]);
 			}
 		}
 
 		memdelete_arr(p_version->variants);
-		if (p_version->variant_data) {
-			memdelete_arr(p_version->variant_data);
-		}
 		p_version->variants = nullptr;
 	}
 }
@@ -207,87 +200,77 @@ void ShaderRD::_compile_variant(uint32_t p_variant, Version *p_version) {
 		return; //variant is disabled, return
 	}
 
-	Vector<RD::ShaderStageSPIRVData> stages;
-
-	String error;
-	String current_source;
-	RD::ShaderStage current_stage = RD::SHADER_STAGE_VERTEX;
-	bool build_ok = true;
+	RD::ShaderStage stage_types[STAGE_TYPE_MAX];
+	Vector<String> sources;
 
 	if (!is_compute) {
-		//vertex stage
-
-		StringBuilder builder;
-		_build_variant_code(builder, p_variant, p_version, stage_templates[STAGE_TYPE_VERTEX]);
-
-		current_source = builder.as_string();
-		RD::ShaderStageSPIRVData stage;
-		stage.spir_v = RD::get_singleton()->shader_compile_spirv_from_source(RD::SHADER_STAGE_VERTEX, current_source, RD::SHADER_LANGUAGE_GLSL, &error);
-		if (stage.spir_v.size() == 0) {
-			build_ok = false;
-		} else {
-			stage.shader_stage = RD::SHADER_STAGE_VERTEX;
-			stages.push_back(stage);
-		}
-	}
-
-	if (!is_compute && build_ok) {
-		//fragment stage
-		current_stage = RD::SHADER_STAGE_FRAGMENT;
-
-		StringBuilder builder;
-		_build_variant_code(builder, p_variant, p_version, stage_templates[STAGE_TYPE_FRAGMENT]);
-
-		current_source = builder.as_string();
-		RD::ShaderStageSPIRVData stage;
-		stage.spir_v = RD::get_singleton()->shader_compile_spirv_from_source(RD::SHADER_STAGE_FRAGMENT, current_source, RD::SHADER_LANGUAGE_GLSL, &error);
-		if (stage.spir_v.size() == 0) {
-			build_ok = false;
-		} else {
-			stage.shader_stage = RD::SHADER_STAGE_FRAGMENT;
-			stages.push_back(stage);
-		}
-	}
-
-	if (is_compute) {
+		//vertex and fragment stages
+		StringBuilder vertex_builder;
+		_build_variant_code(vertex_builder, p_variant, p_version, stage_templates[STAGE_TYPE_VERTEX]);
+		stage_types[sources.size()] = RD::SHADER_STAGE_VERTEX;
+		sources.push_back(vertex_builder.as_string());
+
+		StringBuilder fragment_builder;
+		_build_variant_code(fragment_builder, p_variant, p_version, stage_templates[STAGE_TYPE_FRAGMENT]);
+		stage_types[sources.size()] = RD::SHADER_STAGE_FRAGMENT;
+		sources.push_back(fragment_builder.as_string());
+	} else {
 		//compute stage
-		current_stage = RD::SHADER_STAGE_COMPUTE;
-
 		StringBuilder builder;
 		_build_variant_code(builder, p_variant, p_version, stage_templates[STAGE_TYPE_COMPUTE]);
+		stage_types[sources.size()] = RD::SHADER_STAGE_COMPUTE;
+		sources.push_back(builder.as_string());
+	}
+
+	// Identical code compiles to the same binary, so the entry is shared with any other variant, version or shader producing it.
+	String hash;
+	Vector<uint8_t> shader_data;
+	if (shader_cache) {
+		hash = ShaderCacheRD::hash_sources(cache_key, sources);
+		if (shader_cache->load(hash, shader_data)) {
+			RID shader = RD::get_singleton()->shader_create_from_bytecode(shader_data);
+			if (shader.is_valid()) {
+				MutexLock lock(variant_set_mutex);
+				p_version->variants[p_variant] = shader;
+				return;
+			}
+			// Not accepted by the driver (e.g. after an update), compile it again.
+			shader_data.clear();
+		}
+	}
 
-		current_source = builder.as_string();
+	Vector<RD::ShaderStageSPIRVData> stages;
 
+	String error;
+	for (int i = 0; i < sources.size(); i++) {
 		RD::ShaderStageSPIRVData stage;
-		stage.spir_v = RD::get_singleton()->shader_compile_spirv_from_source(RD::SHADER_STAGE_COMPUTE, current_source, RD::SHADER_LANGUAGE_GLSL, &error);
+		stage.spir_v = RD::get_singleton()->shader_compile_spirv_from_source(stage_types[i], sources[i], RD::SHADER_LANGUAGE_GLSL, &error);
 		if (stage.spir_v.size() == 0) {
-			build_ok = false;
-		} else {
-			stage.shader_stage = RD::SHADER_STAGE_COMPUTE;
-			stages.push_back(stage);
-		}
-	}
-
-	if (!build_ok) {
-		MutexLock lock(variant_set_mutex); //properly print the errors
-		ERR_PRINT("Error compiling " + String(current_stage == RD::SHADER_STAGE_COMPUTE ? "Compute " : (current_stage == RD::SHADER_STAGE_VERTEX ? "Vertex" : "Fragment")) + " shader, variant #" + itos(p_variant) + " (" + variant_defines[p_variant].get_data() + ").");
-		ERR_PRINT(error);
+			RD::ShaderStage current_stage = stage_types[i];
+			MutexLock lock(variant_set_mutex); //properly print the errors
+			ERR_PRINT("Error compiling " + String(current_stage == RD::SHADER_STAGE_COMPUTE ? "Compute " : (current_stage == RD::SHADER_STAGE_VERTEX ? "Vertex" : "Fragment")) + " shader, variant #" + itos(p_variant) + " (" + variant_defines[p_variant].get_data() + ").");
+			ERR_PRINT(error);
 
 #ifdef DEBUG_ENABLED
-		ERR_PRINT("code:\n" + current_source.get_with_code_lines());
+			ERR_PRINT("code:\n" + sources[i].get_with_code_lines());
 #endif
-		return;
+			return;
+		}
+		stage.shader_stage = stage_types[i];
+		stages.push_back(stage);
 	}
 
-	Vector<uint8_t> shader_data = RD::get_singleton()->shader_compile_binary_from_spirv(stages, name + ":" + itos(p_variant));
+	shader_data = RD::get_singleton()->shader_compile_binary_from_spirv(stages, name + ":" + itos(p_variant));
 
 	ERR_FAIL_COND(shader_data.size() == 0);
 
 	RID shader = RD::get_singleton()->shader_create_from_bytecode(shader_data);
+	if (shader_cache && shader.is_valid()) {
+		shader_cache->save(hash, shader_data);
+	}
 	{
 		MutexLock lock(variant_set_mutex);
 		p_version->variants[p_variant] = shader;
-		p_version->variant_data[p_variant] = shader_data;
 	}
 }
 
@@ -342,119 +325,166 @@ RS::ShaderNativeSourceCode ShaderRD::version_get_native_source_code(RID p_versio
 	return source_code;
 }
 
-String ShaderRD::_version_get_sha1(Version *p_version) const {
-	StringBuilder hash_build;
-
-	hash_build.append("[uniforms]");
-	hash_build.append(p_version->uniforms.get_data());
-	hash_build.append("[vertex_globals]");
-	hash_build.append(p_version->vertex_globals.get_data());
-	hash_build.append("[fragment_globals]");
-	hash_build.append(p_version->fragment_globals.get_data());
-	hash_build.append("[compute_globals]");
-	hash_build.append(p_version->compute_globals.get_data());
+void ShaderRD::_compile_claimed_variant(uint32_t p_variant, Version *p_version) {
+	_compile_variant(p_variant, p_version);
 
-	Vector<StringName> code_sections;
-	for (const KeyValue<StringName, CharString> &E : p_version->code_sections) {
-		code_sections.push_back(E.key);
+	CompileState *state = p_version->compile_state;
+	if (variants_enabled[p_variant] && p_version->variants[p_variant].is_null()) {
+		state->failed.set();
 	}
-	code_sections.sort_custom<StringName::AlphCompare>();
 
-	for (int i = 0; i < code_sections.size(); i++) {
-		hash_build.append(String("[code:") + String(code_sections[i]) + "]");
-		hash_build.append(p_version->code_sections[code_sections[i]].get_data());
+	MutexLock lock(state->mutex);
+	state->variants[p_variant].compiled.set();
+	if (state->remaining.decrement() == 0) {
+		state->end_usec.set(OS::get_singleton()->get_ticks_usec());
 	}
-	for (int i = 0; i < p_version->custom_defines.size(); i++) {
-		hash_build.append("[custom_defines:" + itos(i) + "]");
-		hash_build.append(p_version->custom_defines[i].get_data());
+	if (state->waiting_variant == int32_t(p_variant)) {
+		state->waiting_variant = -1;
+		state->variant_compiled.post();
+	}
+}
+
+bool ShaderRD::_claim_and_compile_variant(uint32_t p_variant, Version *p_version) {
+	if (p_version->compile_state->variants[p_variant].claims.postincrement() != 0) {
+		return false; // Compiled (or being compiled) by another thread.
 	}
 
-	return hash_build.as_string().sha1_text();
+	_compile_claimed_variant(p_variant, p_version);
+	return true;
 }
 
-static const char *shader_file_header = "GDSC";
-static const uint32_t cache_file_version = 2;
+void ShaderRD::_wait_for_compiled(CompileState *p_state, uint32_t p_variant) {
+	if (p_state->variants[p_variant].compiled.is_set()) {
+		return;
+	}
 
-bool ShaderRD::_load_from_cache(Version *p_version) {
-	String sha1 = _version_get_sha1(p_version);
-	String path = shader_cache_dir.plus_file(name).plus_file(base_sha256).plus_file(sha1) + ".cache";
+	{
+		MutexLock lock(p_state->mutex);
+		if (p_state->variants[p_variant].compiled.is_set()) {
+			return;
+		}
+		p_state->waiting_variant = p_variant;
+	}
+	p_state->variant_compiled.wait();
+}
 
-	FileAccessRef f = FileAccess::open(path, FileAccess::READ);
-	if (!f) {
-		return false;
+void ShaderRD::_wait_for_variant(Version *p_version, uint32_t p_variant) {
+	CompileState *state = p_version->compile_state;
+	if (state->variants[p_variant].compiled.is_set()) {
+		return;
 	}
 
-	char header[5] = { 0, 0, 0, 0, 0 };
-	f->get_buffer((uint8_t *)header, 4);
-	ERR_FAIL_COND_V(header != String(shader_file_header), false);
+	uint64_t begin_usec = OS::get_singleton()->get_ticks_usec();
+	// Not picked up by a compile thread yet, compile it here rather than wait for its turn.
+	if (!_claim_and_compile_variant(p_variant, p_version)) {
+		_wait_for_compiled(state, p_variant);
+	}
+	state->wait_usec.add(OS::get_singleton()->get_ticks_usec() - begin_usec);
+}
 
-	uint32_t file_version = f->get_32();
-	if (file_version != cache_file_version) {
-		return false; // wrong version
+void ShaderRD::_wait_for_version(Version *p_version) {
+	CompileState *state = p_version->compile_state;
+
+	// Help the compile threads with the variants nobody started yet, then wait for the rest.
+	uint64_t begin_usec = OS::get_singleton()->get_ticks_usec();
+	for (uint32_t i = 0; i < state->variant_count; i++) {
+		_claim_and_compile_variant(i, p_version);
+	}
+	for (uint32_t i = 0; i < state->variant_count; i++) {
+		_wait_for_compiled(state, i);
 	}
+	state->wait_usec.add(OS::get_singleton()->get_ticks_usec() - begin_usec);
 
-	uint32_t variant_count = f->get_32();
+	_finish_version(p_version);
+}
 
-	ERR_FAIL_COND_V(variant_count != (uint32_t)variant_defines.size(), false); //should not happen but check
+void ShaderRD::_compile_thread_function(void *p_user) {
+	while (true) {
+		compile_queue_semaphore.wait();
+		if (compile_threads_exit.is_set()) {
+			break;
+		}
 
-	for (uint32_t i = 0; i < variant_count; i++) {
-		uint32_t variant_size = f->get_32();
-		ERR_FAIL_COND_V(variant_size == 0 && variants_enabled[i], false);
-		if (!variants_enabled[i]) {
-			continue;
+		CompileState *state = nullptr;
+		uint32_t variant = 0;
+		{
+			MutexLock lock(compile_queue_mutex);
+			while (!state && compile_queue.size()) {
+				CompileState *front = compile_queue[0];
+				variant = front->next_variant++;
+				if (front->next_variant == front->variant_count) {
+					compile_queue.remove(0);
+				}
+				// Claimed under the queue lock, so the version can't be finished before this variant is.
+				if (front->variants[variant].claims.postincrement() == 0) {
+					state = front;
+				}
+			}
 		}
-		Vector<uint8_t> variant_bytes;
-		variant_bytes.resize(variant_size);
 
-		uint32_t br = f->get_buffer(variant_bytes.ptrw(), variant_size);
+		if (state) {
+			state->shader->_compile_claimed_variant(variant, state->version);
+		}
+	}
+}
 
-		ERR_FAIL_COND_V(br != variant_size, false);
+void ShaderRD::init_compile_threads() {
+	ERR_FAIL_COND(compile_threads);
 
-		p_version->variant_data[i] = variant_bytes;
+	// The thread waiting for a variant compiles too.
+	compile_thread_count = MAX(1, OS::get_singleton()->get_processor_count() - 1);
+	compile_threads_exit.clear();
+	compile_threads = memnew_arr(Thread, compile_thread_count);
+	for (int i = 0; i < compile_thread_count; i++) {
+		compile_threads[i].start(&ShaderRD::_compile_thread_function, nullptr);
 	}
+}
 
-	for (uint32_t i = 0; i < variant_count; i++) {
-		if (!variants_enabled[i]) {
-			MutexLock lock(variant_set_mutex);
-			p_version->variants[i] = RID();
-			continue;
-		}
-		RID shader = RD::get_singleton()->shader_create_from_bytecode(p_version->variant_data[i]);
-		if (shader.is_null()) {
-			for (uint32_t j = 0; j < i; j++) {
-				RD::get_singleton()->free(p_version->variants[i]);
-			}
-			ERR_FAIL_COND_V(shader.is_null(), false);
-		}
-		{
-			MutexLock lock(variant_set_mutex);
-			p_version->variants[i] = shader;
-		}
+void ShaderRD::finish_compile_threads() {
+	if (!compile_threads) {
+		return;
 	}
 
-	memdelete_arr(p_version->variant_data); //clear stages
-	p_version->variant_data = nullptr;
-	p_version->valid = true;
-	return true;
+	compile_threads_exit.set();
+	for (int i = 0; i < compile_thread_count; i++) {
+		compile_queue_semaphore.post();
+	}
+	for (int i = 0; i < compile_thread_count; i++) {
+		compile_threads[i].wait_to_finish();
+	}
+
+	memdelete_arr(compile_threads);
+	compile_threads = nullptr;
+	compile_thread_count = 0;
 }
 
-void ShaderRD::_save_to_cache(Version *p_version) {
-	String sha1 = _version_get_sha1(p_version);
-	String path = shader_cache_dir.plus_file(name).plus_file(base_sha256).plus_file(sha1) + ".cache";
+void ShaderRD::_finish_version(Version *p_version) {
+	CompileState *state = p_version->compile_state;
+	{
+		MutexLock lock(compile_queue_mutex);
+		compile_queue.erase(state);
+	}
+	{
+		MutexLock lock(state->mutex); // The last compile thread is done with the state once it unlocks.
+	}
+
+	uint64_t end_usec = state->end_usec.get();
+	uint64_t compile_usec = end_usec > state->begin_usec ? end_usec - state->begin_usec : 0;
+	print_verbose(vformat("Shader '%s': %d variants compiled in %d usec, the renderer waited %d usec for them.", name, variant_defines.size(), compile_usec, state->wait_usec.get()));
 
-	FileAccessRef f = FileAccess::open(path, FileAccess::WRITE);
-	ERR_FAIL_COND(!f);
-	f->store_buffer((const uint8_t *)shader_file_header, 4);
-	f->store_32(cache_file_version); //file version
-	uint32_t variant_count = variant_defines.size();
-	f->store_32(variant_count); //variant count
+	memdelete_arr(state->variants);
+	memdelete(state);
+	p_version->compile_state = nullptr;
 
-	for (uint32_t i = 0; i < variant_count; i++) {
-		f->store_32(p_version->variant_data[i].size()); //stage count
-		f->store_buffer(p_version->variant_data[i].ptr(), p_version->variant_data[i].size());
+	// The variants that did compile may already be in use by pipelines, so they are kept until the version
+	// is cleared, even if another one failed.
+	for (int i = 0; i < variant_defines.size(); i++) {
+		if (variants_enabled[i] && p_version->variants[i].is_null()) {
+			return;
+		}
 	}
 
-	f->close();
+	p_version->valid = true;
 }
 
 void ShaderRD::_compile_version(Version *p_version) {
@@ -464,61 +494,24 @@ void ShaderRD::_compile_version(Version *p_version) {
 	p_version->dirty = false;
 
 	p_version->variants = memnew_arr(RID, variant_defines.size());
-	typedef Vector<uint8_t> ShaderStageData;
-	p_version->variant_data = memnew_arr(ShaderStageData, variant_defines.size());
 
-	if (shader_cache_dir_valid) {
-		if (_load_from_cache(p_version)) {
-			return;
-		}
-	}
-
-#if 1
+	CompileState *state = memnew(CompileState);
+	state->shader = this;
+	state->version = p_version;
+	state->variant_count = variant_defines.size();
+	state->variants = memnew_arr(CompileState::Variant, state->variant_count);
+	state->remaining.set(state->variant_count);
+	state->begin_usec = OS::get_singleton()->get_ticks_usec();
+	p_version->compile_state = state;
 
-	RendererThreadPool::singleton->thread_work_pool.do_work(variant_defines.size(), this, &ShaderRD::_compile_variant, p_version);
-#else
-	for (int i = 0; i < variant_defines.size(); i++) {
-		_compile_variant(i, p_version);
-	}
-#endif
-
-	bool all_valid = true;
-	for (int i = 0; i < variant_defines.size(); i++) {
-		if (!variants_enabled[i]) {
-			continue; //disabled
-		}
-		if (p_version->variants[i].is_null()) {
-			all_valid = false;
-			break;
-		}
+	// Returns right away, the variants are waited for as they are requested (see version_get_shader()).
+	{
+		MutexLock lock(compile_queue_mutex);
+		compile_queue.push_back(state);
 	}
-
-	if (!all_valid) {
-		//clear versions if they exist
-		for (int i = 0; i < variant_defines.size(); i++) {
-			if (!variants_enabled[i]) {
-				continue; //disabled
-			}
-			if (!p_version->variants[i].is_null()) {
-				RD::get_singleton()->free(p_version->variants[i]);
-			}
-		}
-		memdelete_arr(p_version->variants);
-		if (p_version->variant_data) {
-			memdelete_arr(p_version->variant_data);
-		}
-		p_version->variants = nullptr;
-		p_version->variant_data = nullptr;
-		return;
-	} else if (shader_cache_dir_valid) {
-		//save shader cache
-		_save_to_cache(p_version);
+	for (uint32_t i = 0; i < state->variant_count; i++) {
+		compile_queue_semaphore.post();
 	}
-
-	memdelete_arr(p_version->variant_data); //clear stages
-	p_version->variant_data = nullptr;
-
-	p_version->valid = true;
 }
 
 void ShaderRD::version_set_code(RID p_version, const Map<String, String> &p_code, const String &p_uniforms, const String &p_vertex_globals, const String &p_fragment_globals, const Vector<String> &p_custom_defines) {
@@ -580,6 +573,14 @@ bool ShaderRD::version_is_valid(RID p_version) {
 		_compile_version(version);
 	}
 
+	if (version->compile_state) {
+		// Doesn't wait for the variants still compiling, the version is only invalid once one of them failed.
+		if (version->compile_state->remaining.get() > 0) {
+			return !version->compile_state->failed.is_set();
+		}
+		_finish_version(version);
+	}
+
 	return version->valid;
 }
 
@@ -606,8 +607,6 @@ bool ShaderRD::is_variant_enabled(int p_variant) const {
 	return variants_enabled[p_variant];
 }
 
-bool ShaderRD::shader_cache_cleanup_on_start = false;
-
 ShaderRD::ShaderRD() {
 	// Do not feel forced to use this, in most cases it makes little to no difference.
 	bool use_32_threads = false;
@@ -634,63 +633,19 @@ void ShaderRD::initialize(const Vector<String> &p_variant_defines, const String
 		variant_defines.push_back(p_variant_defines[i].utf8());
 		variants_enabled.push_back(true);
 	}
-
-	if (shader_cache_dir != String()) {
-		StringBuilder hash_build;
-
-		hash_build.append("[base_hash]");
-		hash_build.append(base_sha256);
-		hash_build.append("[general_defines]");
-		hash_build.append(general_defines.get_data());
-		for (int i = 0; i < variant_defines.size(); i++) {
-			hash_build.append("[variant_defines:" + itos(i) + "]");
-			hash_build.append(variant_defines[i].get_data());
-		}
-
-		base_sha256 = hash_build.as_string().sha256_text();
-
-		DirAccessRef d = DirAccess::open(shader_cache_dir);
-		ERR_FAIL_COND(!d);
-		if (d->change_dir(name) != OK) {
-			Error err = d->make_dir(name);
-			ERR_FAIL_COND(err != OK);
-			d->change_dir(name);
-		}
-
-		//erase other versions?
-		if (shader_cache_cleanup_on_start) {
-		}
-		//
-		if (d->change_dir(base_sha256) != OK) {
-			Error err = d->make_dir(base_sha256);
-			ERR_FAIL_COND(err != OK);
-		}
-		shader_cache_dir_valid = true;
-
-		print_verbose("Shader '" + name + "' SHA256: " + base_sha256);
-	}
-}
-
-void ShaderRD::set_shader_cache_dir(const String &p_dir) {
-	shader_cache_dir = p_dir;
-}
-
-void ShaderRD::set_shader_cache_save_compressed(bool p_enable) {
-	shader_cache_save_compressed = p_enable;
-}
-
-void ShaderRD::set_shader_cache_save_compressed_zstd(bool p_enable) {
-	shader_cache_save_compressed_zstd = p_enable;
 }
 
-void ShaderRD::set_shader_cache_save_debug(bool p_enable) {
-	shader_cache_save_debug = p_enable;
+void ShaderRD::set_shader_cache(ShaderCacheRD *p_cache) {
+	shader_cache = p_cache;
 }
 
-String ShaderRD::shader_cache_dir;
-bool ShaderRD::shader_cache_save_compressed = true;
-bool ShaderRD::shader_cache_save_compressed_zstd = true;
-bool ShaderRD::shader_cache_save_debug = true;
+ShaderCacheRD *ShaderRD::shader_cache = nullptr;
+LocalVector<ShaderRD::CompileState *> ShaderRD::compile_queue;
+BinaryMutex ShaderRD::compile_queue_mutex;
+Semaphore ShaderRD::compile_queue_semaphore;
+Thread *ShaderRD::compile_threads = nullptr;
+int ShaderRD::compile_thread_count = 0;
+SafeFlag ShaderRD::compile_threads_exit;
 
 ShaderRD::~ShaderRD() {
 	List<RID> remaining;
@@ -32,12 +32,16 @@
 #define SHADER_RD_H
 
 #include "core/os/mutex.h"
+#include "core/os/semaphore.h"
+#include "core/os/thread.h"
 #include "core/string/string_builder.h"
 #include "core/templates/hash_map.h"
 #include "core/templates/local_vector.h"
 #include "core/templates/map.h"
 #include "core/templates/rid_owner.h"
+#include "core/templates/safe_refcount.h"
 #include "core/variant/variant.h"
+#include "servers/rendering/renderer_rd/shader_cache_rd.h"
 #include "servers/rendering_server.h"
 
 #include <stdio.h>
@@ -51,6 +55,34 @@ class ShaderRD {
 	Vector<CharString> variant_defines;
 	Vector<bool> variants_enabled;
 
+	struct Version;
+
+	// Progress of a version while its variants compile on the compile threads.
+	struct CompileState {
+		struct Variant {
+			SafeNumeric<uint32_t> claims;
+			SafeFlag compiled;
+		};
+
+		ShaderRD *shader = nullptr;
+		Version *version = nullptr;
+		Variant *variants = nullptr;
+		uint32_t variant_count = 0;
+		uint32_t next_variant = 0; // Next one for the compile threads, guarded by compile_queue_mutex.
+
+		// Variants are marked compiled with this held, so locking it once every variant is compiled
+		// means no compile thread touches the state anymore.
+		BinaryMutex mutex;
+		SafeNumeric<uint32_t> remaining;
+		SafeFlag failed; // Set as soon as any enabled variant fails to compile.
+		int32_t waiting_variant = -1; // Versions are only used from the render thread, so one waiter at most.
+		Semaphore variant_compiled;
+
+		uint64_t begin_usec = 0;
+		SafeNumeric<uint64_t> end_usec;
+		SafeNumeric<uint64_t> wait_usec;
+	};
+
 	struct Version {
 		CharString uniforms;
 		CharString vertex_globals;
@@ -59,8 +91,8 @@ class ShaderRD {
 		Map<StringName, CharString> code_sections;
 		Vector<CharString> custom_defines;
 
-		Vector<uint8_t> *variant_data = nullptr;
 		RID *variants = nullptr; //same size as version defines
+		CompileState *compile_state = nullptr; // Set until every variant is compiled.
 
 		bool valid;
 		bool dirty;
@@ -70,6 +102,21 @@ class ShaderRD {
 	Mutex variant_set_mutex;
 
 	void _compile_variant(uint32_t p_variant, Version *p_version);
+	void _compile_claimed_variant(uint32_t p_variant, Version *p_version);
+	bool _claim_and_compile_variant(uint32_t p_variant, Version *p_version);
+	static void _wait_for_compiled(CompileState *p_state, uint32_t p_variant);
+	void _wait_for_variant(Version *p_version, uint32_t p_variant);
+	void _wait_for_version(Version *p_version);
+	void _finish_version(Version *p_version);
+
+	// Versions with variants left for the compile threads, oldest first. Any number of them can be in flight.
+	static LocalVector<CompileState *> compile_queue;
+	static BinaryMutex compile_queue_mutex;
+	static Semaphore compile_queue_semaphore; // Posted once per queued variant.
+	static Thread *compile_threads;
+	static int compile_thread_count;
+	static SafeFlag compile_threads_exit;
+	static void _compile_thread_function(void *p_user);
 
 	void _clear_version(Version *p_version);
 	void _compile_version(Version *p_version);
@@ -101,14 +148,9 @@ class ShaderRD {
 
 	CharString base_compute_defines;
 
-	String base_sha256;
+	String cache_key; // Anything besides the source that changes the compiled result.
 
-	static String shader_cache_dir;
-	static bool shader_cache_cleanup_on_start;
-	static bool shader_cache_save_compressed;
-	static bool shader_cache_save_compressed_zstd;
-	static bool shader_cache_save_debug;
-	bool shader_cache_dir_valid = false;
+	static ShaderCacheRD *shader_cache;
 
 	enum StageType {
 		STAGE_TYPE_VERTEX,
@@ -123,10 +165,6 @@ class ShaderRD {
 
 	void _add_stage(const char *p_code, StageType p_stage_type);
 
-	String _version_get_sha1(Version *p_version) const;
-	bool _load_from_cache(Version *p_version);
-	void _save_to_cache(Version *p_version);
-
 protected:
 	ShaderRD();
 	void setup(const char *p_vertex_code, const char *p_fragment_code, const char *p_compute_code, const char *p_name);
@@ -148,6 +186,15 @@ public:
 			_compile_version(version);
 		}
 
+		if (version->compile_state) {
+			// Only wait for the variant asked for, the rest keep compiling in the background.
+			_wait_for_variant(version, p_variant);
+			if (version->compile_state->remaining.get() > 0) {
+				return version->variants[p_variant];
+			}
+			_finish_version(version);
+		}
+
 		if (!version->valid) {
 			return RID();
 		}
@@ -155,6 +202,7 @@ public:
 		return version->variants[p_variant];
 	}
 
+	// Doesn't block, a version still compiling is valid until one of its variants fails.
 	bool version_is_valid(RID p_version);
 
 	bool version_free(RID p_version);
@@ -162,10 +210,11 @@ public:
 	void set_variant_enabled(int p_variant, bool p_enabled);
 	bool is_variant_enabled(int p_variant) const;
 
-	static void set_shader_cache_dir(const String &p_dir);
-	static void set_shader_cache_save_compressed(bool p_enable);
-	static void set_shader_cache_save_compressed_zstd(bool p_enable);
-	static void set_shader_cache_save_debug(bool p_enable);
+	static void set_shader_cache(ShaderCacheRD *p_cache);
+
+	// Without compile threads, every variant compiles on the thread that asks for it.
+	static void init_compile_threads();
+	static void finish_compile_threads();
 
 	RS::ShaderNativeSourceCode version_get_native_source_code(RID p_version);
 
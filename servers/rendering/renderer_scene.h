@@ -217,6 +217,8 @@ public:
 
 	virtual bool free(RID p_rid) = 0;
 
+	virtual uint64_t get_rendering_info(RS::RenderingInfo p_info) = 0;
+
 	RendererScene();
 	virtual ~RendererScene();
 };
@@ -32,6 +32,7 @@
 
 #include "core/config/project_settings.h"
 #include "core/os/os.h"
+#include "renderer_scene_occlusion_cull_raster.h"
 #include "rendering_server_default.h"
 #include "rendering_server_globals.h"
 
@@ -141,6 +142,7 @@ void RendererSceneCull::_instance_pair(Instance *p_A, Instance *p_B) {
 
 		geom->lights.insert(B);
 		light->geometries.insert(A);
+		light->shadow_caster_version++;
 
 		if (geom->can_cast_shadows) {
 			light->shadow_dirty = true;
@@ -248,6 +250,7 @@ void RendererSceneCull::_instance_unpair(Instance *p_A, Instance *p_B) {
 
 		geom->lights.erase(B);
 		light->geometries.erase(A);
+		light->shadow_caster_version++;
 
 		if (geom->can_cast_shadows) {
 			light->shadow_dirty = true;
@@ -614,6 +617,9 @@ void RendererSceneCull::instance_set_base(RID p_instance, RID p_base) {
 		switch (instance->base_type) {
 			case RS::INSTANCE_LIGHT: {
 				InstanceLightData *light = memnew(InstanceLightData);
+				for (int i = 0; i < RendererSceneRender::MAX_DIRECTIONAL_LIGHT_CASCADES; i++) {
+					light->cascade_cull_cache[i].instances.set_page_pool(&geometry_instance_cull_page_pool);
+				}
 
 				if (scenario && RSG::storage->light_get_type(p_base) == RS::LIGHT_DIRECTIONAL) {
 					light->D = scenario->directional_lights.push_back(instance);
@@ -1138,6 +1144,7 @@ void RendererSceneCull::instance_geometry_set_cast_shadows_setting(RID p_instanc
 
 	if (instance->scenario && instance->array_index >= 0) {
 		InstanceData &idata = instance->scenario->instance_data[instance->array_index];
+		_scenario_invalidate_shadow_cull_caches(instance->scenario, instance->scenario->instance_aabbs[instance->array_index]);
 
 		if (instance->cast_shadows != RS::SHADOW_CASTING_SETTING_SHADOWS_ONLY) {
 			idata.flags |= InstanceData::FLAG_CAST_SHADOWS;
@@ -1422,6 +1429,7 @@ void RendererSceneCull::_update_instance(Instance *p_instance) {
 		scene_render->light_instance_set_transform(light->instance, p_instance->transform);
 		scene_render->light_instance_set_aabb(light->instance, p_instance->transform.xform(p_instance->aabb));
 		light->shadow_dirty = true;
+		light->shadow_caster_version++;
 
 		RS::LightBakeMode bake_mode = RSG::storage->light_get_bake_mode(p_instance->base);
 		if (RSG::storage->light_get_type(p_instance->base) != RS::LIGHT_DIRECTIONAL && bake_mode != light->bake_mode) {
@@ -1504,6 +1512,7 @@ void RendererSceneCull::_update_instance(Instance *p_instance) {
 			for (Set<Instance *>::Element *E = geom->lights.front(); E; E = E->next()) {
 				InstanceLightData *light = static_cast<InstanceLightData *>(E->get()->base_data);
 				light->shadow_dirty = true;
+				light->shadow_caster_version++;
 			}
 		}
 
@@ -1624,21 +1633,54 @@ void RendererSceneCull::_update_instance(Instance *p_instance) {
 		}
 
 		p_instance->scenario->instance_data.push_back(idata);
-		p_instance->scenario->instance_aabbs.push_back(InstanceBounds(p_instance->transformed_aabb));
+		p_instance->scenario->instance_aabbs.push_back(InstanceBounds());
+		_set_instance_bounds(p_instance->scenario, p_instance->array_index, InstanceBounds(p_instance->transformed_aabb));
 		_update_instance_visibility_dependencies(p_instance);
+
+		if ((1 << p_instance->base_type) & RS::INSTANCE_GEOMETRY_MASK) {
+			_scenario_invalidate_shadow_cull_caches(p_instance->scenario, p_instance->scenario->instance_aabbs[p_instance->array_index]);
+		}
 	} else {
 		if ((1 << p_instance->base_type) & RS::INSTANCE_GEOMETRY_MASK) {
-			p_instance->scenario->indexers[Scenario::INDEXER_GEOMETRY].update(p_instance->indexer_id, bvh_aabb);
+			// Shadows cast from both the old and the new bounds change.
+			_scenario_invalidate_shadow_cull_caches(p_instance->scenario, p_instance->scenario->instance_aabbs[p_instance->array_index]);
+			_scenario_invalidate_shadow_cull_caches(p_instance->scenario, InstanceBounds(p_instance->transformed_aabb));
+
+			if (instance_update_batching) {
+				Scenario *scenario = p_instance->scenario;
+				if (p_instance->indexer_batch_index == -1) {
+					p_instance->indexer_batch_index = scenario->geometry_indexer_batch_ids.size();
+					scenario->geometry_indexer_batch_ids.push_back(p_instance->indexer_id);
+					scenario->geometry_indexer_batch_aabbs.push_back(bvh_aabb);
+				} else {
+					scenario->geometry_indexer_batch_aabbs[p_instance->indexer_batch_index] = bvh_aabb;
+				}
+			} else {
+				p_instance->scenario->indexers[Scenario::INDEXER_GEOMETRY].update(p_instance->indexer_id, bvh_aabb);
+			}
 		} else {
 			p_instance->scenario->indexers[Scenario::INDEXER_VOLUMES].update(p_instance->indexer_id, bvh_aabb);
 		}
-		p_instance->scenario->instance_aabbs[p_instance->array_index] = InstanceBounds(p_instance->transformed_aabb);
+		_set_instance_bounds(p_instance->scenario, p_instance->array_index, InstanceBounds(p_instance->transformed_aabb));
 	}
 
 	if (p_instance->visibility_index != -1) {
 		p_instance->scenario->instance_visibility[p_instance->visibility_index].position = p_instance->transformed_aabb.get_center();
 	}
 
+	if (instance_update_batching) {
+		// Pairing queries the indexers, so it must wait until the batched updates are applied.
+		if (!p_instance->pair_pending) {
+			p_instance->pair_pending = true;
+			instance_pair_queue.push_back(p_instance);
+		}
+		return;
+	}
+
+	_update_instance_pairs(p_instance);
+}
+
+void RendererSceneCull::_update_instance_pairs(Instance *p_instance) {
 	//move instance and repair
 	pair_pass++;
 
@@ -1703,6 +1745,7 @@ void RendererSceneCull::_unpair_instance(Instance *p_instance) {
 
 	if ((1 << p_instance->base_type) & RS::INSTANCE_GEOMETRY_MASK) {
 		p_instance->scenario->indexers[Scenario::INDEXER_GEOMETRY].remove(p_instance->indexer_id);
+		_scenario_invalidate_shadow_cull_caches(p_instance->scenario, p_instance->scenario->instance_aabbs[p_instance->array_index]);
 	} else {
 		p_instance->scenario->indexers[Scenario::INDEXER_VOLUMES].remove(p_instance->indexer_id);
 	}
@@ -1715,7 +1758,7 @@ void RendererSceneCull::_unpair_instance(Instance *p_instance) {
 		Instance *swapped_instance = p_instance->scenario->instance_data[swap_with_index].instance;
 		swapped_instance->array_index = p_instance->array_index; //swap
 		p_instance->scenario->instance_data[p_instance->array_index] = p_instance->scenario->instance_data[swap_with_index];
-		p_instance->scenario->instance_aabbs[p_instance->array_index] = p_instance->scenario->instance_aabbs[swap_with_index];
+		_set_instance_bounds(p_instance->scenario, p_instance->array_index, p_instance->scenario->instance_aabbs[swap_with_index]);
 
 		if (swapped_instance->visibility_index != -1) {
 			swapped_instance->scenario->instance_visibility[swapped_instance->visibility_index].array_index = swapped_instance->array_index;
@@ -1735,6 +1778,7 @@ void RendererSceneCull::_unpair_instance(Instance *p_instance) {
 	// pop last
 	p_instance->scenario->instance_data.pop_back();
 	p_instance->scenario->instance_aabbs.pop_back();
+	p_instance->scenario->instance_bounds_blocks.resize((p_instance->scenario->instance_aabbs.size() + InstanceBoundsBlock::BLOCK_MASK) >> InstanceBoundsBlock::BLOCK_SHIFT);
 
 	//uninitialize
 	p_instance->array_index = -1;
@@ -1758,6 +1802,29 @@ void RendererSceneCull::_unpair_instance(Instance *p_instance) {
 	_update_instance_visibility_dependencies(p_instance);
 }
 
+void RendererSceneCull::_set_instance_bounds(Scenario *p_scenario, uint32_t p_index, const InstanceBounds &p_bounds) {
+	p_scenario->instance_aabbs[p_index] = p_bounds;
+
+	uint32_t block = p_index >> InstanceBoundsBlock::BLOCK_SHIFT;
+	if (block >= p_scenario->instance_bounds_blocks.size()) {
+		p_scenario->instance_bounds_blocks.resize(block + 1);
+	}
+	p_scenario->instance_bounds_blocks[block].set(p_index & InstanceBoundsBlock::BLOCK_MASK, p_bounds);
+}
+
+void RendererSceneCull::_scenario_invalidate_shadow_cull_caches(Scenario *p_scenario, const InstanceBounds &p_bounds) {
+	// Same test as the cascade cull, so any cached caster is caught.
+	for (List<Instance *>::Element *E = p_scenario->directional_lights.front(); E; E = E->next()) {
+		InstanceLightData *light = static_cast<InstanceLightData *>(E->get()->base_data);
+		for (int i = 0; i < RendererSceneRender::MAX_DIRECTIONAL_LIGHT_CASCADES; i++) {
+			ShadowCascadeCullCache &cull_cache = light->cascade_cull_cache[i];
+			if (cull_cache.valid && p_bounds.in_frustum(cull_cache.frustum)) {
+				cull_cache.valid = false;
+			}
+		}
+	}
+}
+
 void RendererSceneCull::_update_instance_aabb(Instance *p_instance) {
 	AABB new_aabb;
 
@@ -1962,6 +2029,9 @@ void RendererSceneCull::_light_instance_setup_directional_shadow(int p_shadow_in
 	for (int i = 0; i < splits; i++) {
 		RENDER_TIMESTAMP("Culling Directional Light split" + itos(i));
 
+		cull.shadows[p_shadow_index].cascades[i].cull_cache = nullptr;
+		cull.shadows[p_shadow_index].cascades[i].use_cull_cache = false;
+
 		// setup a camera matrix for that range!
 		CameraMatrix camera_matrix;
 
@@ -2098,6 +2168,38 @@ void RendererSceneCull::_light_instance_setup_directional_shadow(int p_shadow_in
 		light_frustum_planes.write[4] = Plane(z_vec, z_max + 1e6);
 		light_frustum_planes.write[5] = Plane(-z_vec, -z_min); // z_min is ok, since casters further than far-light plane are not needed
 
+		{
+			// Reuse the casters culled in a previous frame when this frustum is still inside the one they were culled with.
+			Cull::Shadow::Cascade &cascade = cull.shadows[p_shadow_index].cascades[i];
+			ShadowCascadeCullCache &cull_cache = light->cascade_cull_cache[i];
+			Scenario *scenario = p_instance->scenario;
+
+			// Visibility ranges depend on the camera position, so those scenarios are always culled.
+			bool can_cache = scenario->instance_visibility.get_bin_count() == 0;
+
+			if (can_cache && cull_cache.valid && cull_cache.contains(light_frustum_planes)) {
+				cascade.use_cull_cache = true;
+				shadow_cull_cache_hits++;
+			} else {
+				if (can_cache) {
+					// Cull with a margin, so small camera movements keep hitting the cache.
+					real_t margin = MAX(x_max - x_min, y_max - y_min) * shadow_cull_cache_margin;
+					for (int j = 0; j < light_frustum_planes.size(); j++) {
+						light_frustum_planes.write[j].d += margin;
+					}
+				}
+
+				cascade.frustum = Frustum(light_frustum_planes);
+				cascade.use_cull_cache = false;
+
+				cull_cache.frustum = cascade.frustum;
+				cull_cache.valid = false;
+				shadow_cull_cache_misses++;
+			}
+
+			cascade.cull_cache = can_cache ? &cull_cache : nullptr;
+		}
+
 		// a pre pass will need to be needed to determine the actual z-near to be used
 
 		z_max = z_vec.dot(center) + radius + pancake_size;
@@ -2115,7 +2217,6 @@ void RendererSceneCull::_light_instance_setup_directional_shadow(int p_shadow_in
 			ortho_transform.basis = transform.basis;
 			ortho_transform.origin = x_vec * (x_min_cam + half_x) + y_vec * (y_min_cam + half_y) + z_vec * z_max;
 
-			cull.shadows[p_shadow_index].cascades[i].frustum = Frustum(light_frustum_planes);
 			cull.shadows[p_shadow_index].cascades[i].projection = ortho_camera;
 			cull.shadows[p_shadow_index].cascades[i].transform = ortho_transform;
 			cull.shadows[p_shadow_index].cascades[i].zfar = z_max - z_min_cam;
@@ -2128,6 +2229,47 @@ void RendererSceneCull::_light_instance_setup_directional_shadow(int p_shadow_in
 	}
 }
 
+const LocalVector<RendererSceneCull::Instance *> &RendererSceneCull::_light_instance_get_shadow_casters(InstanceLightData *p_light, uint32_t p_pass, Scenario *p_scenario, const Vector<Plane> &p_planes) {
+	InstanceLightData::ShadowCasterCache &cache = p_light->shadow_caster_cache[p_pass];
+
+	// Pairing, unpairing or moving shadow casters in the light range increases the version,
+	// so as long as it matches, the same casters are found in the same pass.
+	if (cache.version == p_light->shadow_caster_version) {
+		shadow_cull_cache_hits++;
+		return cache.instances;
+	}
+
+	shadow_cull_cache_misses++;
+
+	Vector<Vector3> points = Geometry3D::compute_convex_mesh_points(&p_planes[0], p_planes.size());
+
+	struct CullConvex {
+		LocalVector<Instance *> *result;
+		const Set<Instance *> *geometries;
+		_FORCE_INLINE_ bool operator()(void *p_data) {
+			Instance *p_instance = (Instance *)p_data;
+			// Geometry outside of the light range can't cast shadows in it, and keeping only
+			// paired instances ensures none of them is freed while cached.
+			if (geometries->has(p_instance)) {
+				result->push_back(p_instance);
+			}
+			return false;
+		}
+	};
+
+	cache.instances.clear();
+
+	CullConvex cull_convex;
+	cull_convex.result = &cache.instances;
+	cull_convex.geometries = &p_light->geometries;
+
+	p_scenario->indexers[Scenario::INDEXER_GEOMETRY].convex_query(p_planes.ptr(), p_planes.size(), points.ptr(), points.size(), cull_convex);
+
+	cache.version = p_light->shadow_caster_version;
+
+	return cache.instances;
+}
+
 bool RendererSceneCull::_light_instance_update_shadow(Instance *p_instance, const Transform3D p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, bool p_cam_vaspect, RID p_shadow_atlas, Scenario *p_scenario, float p_screen_lod_threshold) {
 	InstanceLightData *light = static_cast<InstanceLightData *>(p_instance->base_data);
 
@@ -2162,28 +2304,12 @@ bool RendererSceneCull::_light_instance_update_shadow(Instance *p_instance, cons
 					planes.write[4] = light_transform.xform(Plane(Vector3(0, -1, z).normalized(), radius));
 					planes.write[5] = light_transform.xform(Plane(Vector3(0, 0, -z), 0));
 
-					instance_shadow_cull_result.clear();
-
-					Vector<Vector3> points = Geometry3D::compute_convex_mesh_points(&planes[0], planes.size());
-
-					struct CullConvex {
-						PagedArray<Instance *> *result;
-						_FORCE_INLINE_ bool operator()(void *p_data) {
-							Instance *p_instance = (Instance *)p_data;
-							result->push_back(p_instance);
-							return false;
-						}
-					};
-
-					CullConvex cull_convex;
-					cull_convex.result = &instance_shadow_cull_result;
-
-					p_scenario->indexers[Scenario::INDEXER_GEOMETRY].convex_query(planes.ptr(), planes.size(), points.ptr(), points.size(), cull_convex);
+					const LocalVector<Instance *> &casters = _light_instance_get_shadow_casters(light, i, p_scenario, planes);
 
 					RendererSceneRender::RenderShadowData &shadow_data = render_shadow_data[max_shadows_used++];
 
-					for (int j = 0; j < (int)instance_shadow_cull_result.size(); j++) {
-						Instance *instance = instance_shadow_cull_result[j];
+					for (uint32_t j = 0; j < casters.size(); j++) {
+						Instance *instance = casters[j];
 						if (!instance->visible || !((1 << instance->base_type) & RS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows) {
 							continue;
 						} else {
@@ -2240,28 +2366,12 @@ bool RendererSceneCull::_light_instance_update_shadow(Instance *p_instance, cons
 
 					Vector<Plane> planes = cm.get_projection_planes(xform);
 
-					instance_shadow_cull_result.clear();
-
-					Vector<Vector3> points = Geometry3D::compute_convex_mesh_points(&planes[0], planes.size());
-
-					struct CullConvex {
-						PagedArray<Instance *> *result;
-						_FORCE_INLINE_ bool operator()(void *p_data) {
-							Instance *p_instance = (Instance *)p_data;
-							result->push_back(p_instance);
-							return false;
-						}
-					};
-
-					CullConvex cull_convex;
-					cull_convex.result = &instance_shadow_cull_result;
-
-					p_scenario->indexers[Scenario::INDEXER_GEOMETRY].convex_query(planes.ptr(), planes.size(), points.ptr(), points.size(), cull_convex);
+					const LocalVector<Instance *> &casters = _light_instance_get_shadow_casters(light, i, p_scenario, planes);
 
 					RendererSceneRender::RenderShadowData &shadow_data = render_shadow_data[max_shadows_used++];
 
-					for (int j = 0; j < (int)instance_shadow_cull_result.size(); j++) {
-						Instance *instance = instance_shadow_cull_result[j];
+					for (uint32_t j = 0; j < casters.size(); j++) {
+						Instance *instance = casters[j];
 						if (!instance->visible || !((1 << instance->base_type) & RS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows) {
 							continue;
 						} else {
@@ -2303,28 +2413,12 @@ bool RendererSceneCull::_light_instance_update_shadow(Instance *p_instance, cons
 
 			Vector<Plane> planes = cm.get_projection_planes(light_transform);
 
-			instance_shadow_cull_result.clear();
-
-			Vector<Vector3> points = Geometry3D::compute_convex_mesh_points(&planes[0], planes.size());
-
-			struct CullConvex {
-				PagedArray<Instance *> *result;
-				_FORCE_INLINE_ bool operator()(void *p_data) {
-					Instance *p_instance = (Instance *)p_data;
-					result->push_back(p_instance);
-					return false;
-				}
-			};
-
-			CullConvex cull_convex;
-			cull_convex.result = &instance_shadow_cull_result;
-
-			p_scenario->indexers[Scenario::INDEXER_GEOMETRY].convex_query(planes.ptr(), planes.size(), points.ptr(), points.size(), cull_convex);
+			const LocalVector<Instance *> &casters = _light_instance_get_shadow_casters(light, 0, p_scenario, planes);
 
 			RendererSceneRender::RenderShadowData &shadow_data = render_shadow_data[max_shadows_used++];
 
-			for (int j = 0; j < (int)instance_shadow_cull_result.size(); j++) {
-				Instance *instance = instance_shadow_cull_result[j];
+			for (uint32_t j = 0; j < casters.size(); j++) {
+				Instance *instance = casters[j];
 				if (!instance->visible || !((1 << instance->base_type) & RS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows) {
 					continue;
 				} else {
@@ -2482,23 +2576,62 @@ int RendererSceneCull::_visibility_range_check(InstanceVisibilityData &r_vis_dat
 	float begin_offset = in_range_last_frame ? -r_vis_data.range_begin_margin : r_vis_data.range_begin_margin;
 	float end_offset = in_range_last_frame ? r_vis_data.range_end_margin : -r_vis_data.range_end_margin;
 
+	int result = 0;
 	if (r_vis_data.range_end > 0.0f && dist > r_vis_data.range_end + end_offset) {
-		r_vis_data.viewport_state &= ~p_viewport_mask;
-		return -1;
+		result = -1;
 	} else if (r_vis_data.range_begin > 0.0f && dist < r_vis_data.range_begin + begin_offset) {
-		r_vis_data.viewport_state &= ~p_viewport_mask;
-		return 1;
-	} else {
+		result = 1;
+	}
+
+	if ((result == 0) != in_range_last_frame) {
+		// An instance swapped with its visibility parent or children (HLOD).
+		visibility_range_changes.increment();
+	}
+
+	if (result == 0) {
 		r_vis_data.viewport_state |= p_viewport_mask;
-		return 0;
+	} else {
+		r_vis_data.viewport_state &= ~p_viewport_mask;
+	}
+	return result;
+}
+
+void RendererSceneCull::_update_instance_lod(InstanceData &r_idata, const InstanceBounds &p_bounds, const CullData &p_cull_data, uint64_t p_frame) {
+	// Same distance the scene renderer picks LODs with, from the camera plane to the closest point of the AABB.
+	const Plane &plane = p_cull_data.lod_camera_plane;
+	const real_t *bounds = p_bounds.bounds;
+	Vector3 support_min(plane.normal.x > 0 ? bounds[0] : bounds[3], plane.normal.y > 0 ? bounds[1] : bounds[4], plane.normal.z > 0 ? bounds[2] : bounds[5]);
+	Vector3 support_max(plane.normal.x > 0 ? bounds[3] : bounds[0], plane.normal.y > 0 ? bounds[4] : bounds[1], plane.normal.z > 0 ? bounds[5] : bounds[2]);
+
+	float distance_min = plane.distance_to(support_min);
+	float distance_max = plane.distance_to(support_max);
+
+	float distance = 0.0;
+	if (distance_min * distance_max < 0.0) {
+		//crossing plane
+		distance = 0.0;
+	} else if (distance_min >= 0.0) {
+		distance = distance_min;
+	} else if (distance_max <= 0.0) {
+		distance = -distance_max;
+	}
+
+	InstanceLOD &lod = r_idata.instance->lod;
+	float distance_scale = lod.update(distance * p_cull_data.lod_distance_multiplier, lod_hysteresis, p_frame);
+
+	// While the camera keeps moving one way the scale stays at the edge of the band, so this is rarely sent.
+	if (!Math::is_equal_approx(distance_scale, lod.distance_scale, 0.005f)) {
+		lod.distance_scale = distance_scale;
+		scene_render->geometry_instance_set_lod_distance_scale(r_idata.instance_geometry, distance_scale);
 	}
 }
 
 void RendererSceneCull::_scene_cull_threaded(uint32_t p_thread, CullData *cull_data) {
+	// Split on bounds block boundaries, so no block is tested by two threads.
 	uint32_t cull_total = cull_data->scenario->instance_data.size();
-	uint32_t total_threads = RendererThreadPool::singleton->thread_work_pool.get_thread_count();
-	uint32_t cull_from = p_thread * cull_total / total_threads;
-	uint32_t cull_to = (p_thread + 1 == total_threads) ? cull_total : ((p_thread + 1) * cull_total / total_threads);
+	uint32_t block_total = (cull_total + InstanceBoundsBlock::BLOCK_MASK) >> InstanceBoundsBlock::BLOCK_SHIFT;
+	uint32_t cull_from = (p_thread * block_total / cull_data->job_count) << InstanceBoundsBlock::BLOCK_SHIFT;
+	uint32_t cull_to = (p_thread + 1 == cull_data->job_count) ? cull_total : (((p_thread + 1) * block_total / cull_data->job_count) << InstanceBoundsBlock::BLOCK_SHIFT);
 
 	_scene_cull(*cull_data, scene_cull_result_threads[p_thread], cull_from, cull_to);
 }
@@ -2515,23 +2648,41 @@ void RendererSceneCull::_scene_cull(CullData &cull_data, InstanceCullResult &cul
 	Transform3D inv_cam_transform = cull_data.cam_transform.inverse();
 	float z_near = cull_data.camera_matrix->get_z_near();
 
+	// Frustum tests are done a block of instances at a time, results are kept as bit masks.
+	uint32_t frustum_mask = 0;
+	uint32_t cascade_masks[RendererSceneRender::MAX_DIRECTIONAL_LIGHTS][RendererSceneRender::MAX_DIRECTIONAL_LIGHT_CASCADES];
+
 	for (uint64_t i = p_from; i < p_to; i++) {
 		bool mesh_visible = false;
 
+		uint32_t lane = i & InstanceBoundsBlock::BLOCK_MASK;
+		if (lane == 0 || i == p_from) {
+			const InstanceBoundsBlock &block = cull_data.scenario->instance_bounds_blocks[i >> InstanceBoundsBlock::BLOCK_SHIFT];
+			frustum_mask = block.in_frustum_mask(cull_data.cull->frustum);
+			for (uint32_t j = 0; j < cull_data.cull->shadow_count; j++) {
+				for (uint32_t k = 0; k < cull_data.cull->shadows[j].cascade_count; k++) {
+					if (!cull_data.cull->shadows[j].cascades[k].use_cull_cache) {
+						cascade_masks[j][k] = block.in_frustum_mask(cull_data.cull->shadows[j].cascades[k].frustum);
+					}
+				}
+			}
+		}
+		uint32_t lane_bit = 1 << lane;
+
 		InstanceData &idata = cull_data.scenario->instance_data[i];
 		uint32_t visibility_flags = idata.flags & (InstanceData::FLAG_VISIBILITY_DEPENDENCY_HIDDEN_CLOSE_RANGE | InstanceData::FLAG_VISIBILITY_DEPENDENCY_HIDDEN);
 		int32_t visibility_check = -1;
 
 #define HIDDEN_BY_VISIBILITY_CHECKS (visibility_flags == InstanceData::FLAG_VISIBILITY_DEPENDENCY_HIDDEN_CLOSE_RANGE || visibility_flags == InstanceData::FLAG_VISIBILITY_DEPENDENCY_HIDDEN)
 #define LAYER_CHECK (cull_data.visible_layers & idata.layer_mask)
-#define IN_FRUSTUM(f) (cull_data.scenario->instance_aabbs[i].in_frustum(f))
+#define IN_FRUSTUM(mask) ((mask) & lane_bit)
 #define VIS_RANGE_CHECK ((idata.visibility_index == -1) || _visibility_range_check(cull_data.scenario->instance_visibility[idata.visibility_index], cull_data.cam_transform.origin, cull_data.visibility_viewport_mask) == 0)
 #define VIS_PARENT_CHECK ((idata.parent_array_index == -1) || ((cull_data.scenario->instance_data[idata.parent_array_index].flags & InstanceData::FLAG_VISIBILITY_DEPENDENCY_NEEDS_CHECK) == InstanceData::FLAG_VISIBILITY_DEPENDENCY_HIDDEN_CLOSE_RANGE))
 #define VIS_CHECK (visibility_check < 0 ? (visibility_check = (visibility_flags != InstanceData::FLAG_VISIBILITY_DEPENDENCY_NEEDS_CHECK || (VIS_RANGE_CHECK && VIS_PARENT_CHECK))) : visibility_check)
 #define OCCLUSION_CULLED (cull_data.occlusion_buffer != nullptr && (cull_data.scenario->instance_data[i].flags & InstanceData::FLAG_IGNORE_OCCLUSION_CULLING) == 0 && cull_data.occlusion_buffer->is_occluded(cull_data.scenario->instance_aabbs[i].bounds, cull_data.cam_transform.origin, inv_cam_transform, *cull_data.camera_matrix, z_near))
 
 		if (!HIDDEN_BY_VISIBILITY_CHECKS) {
-			if (LAYER_CHECK && IN_FRUSTUM(cull_data.cull->frustum) && VIS_CHECK && !OCCLUSION_CULLED) {
+			if (LAYER_CHECK && IN_FRUSTUM(frustum_mask) && VIS_CHECK && !OCCLUSION_CULLED) {
 				uint32_t base_type = idata.flags & InstanceData::FLAG_BASE_TYPE_MASK;
 				if (base_type == RS::INSTANCE_LIGHT) {
 					cull_result.lights.push_back(idata.instance);
@@ -2607,6 +2758,17 @@ void RendererSceneCull::_scene_cull(CullData &cull_data, InstanceCullResult &cul
 						}
 					}
 
+					if ((base_type == RS::INSTANCE_MESH || base_type == RS::INSTANCE_MULTIMESH) && lod_hysteresis > 0.0) {
+						if (!cull_data.render_reflection_probe) {
+							_update_instance_lod(idata, cull_data.scenario->instance_aabbs[i], cull_data, frame_number);
+						} else if (idata.instance->lod.distance_scale != 1.0) {
+							// Probes render before the viewports, so the scale left by the last main pass is stale and was
+							// measured from another camera. The next main pass sends its own scale again.
+							idata.instance->lod.distance_scale = 1.0;
+							scene_render->geometry_instance_set_lod_distance_scale(idata.instance_geometry, 1.0);
+						}
+					}
+
 					if (geometry_instance_pair_mask & (1 << RS::INSTANCE_LIGHT) && (idata.flags & InstanceData::FLAG_GEOM_LIGHTING_DIRTY)) {
 						InstanceGeometryData *geom = static_cast<InstanceGeometryData *>(idata.instance->base_data);
 						uint32_t idx = 0;
@@ -2698,11 +2860,18 @@ void RendererSceneCull::_scene_cull(CullData &cull_data, InstanceCullResult &cul
 
 			for (uint32_t j = 0; j < cull_data.cull->shadow_count; j++) {
 				for (uint32_t k = 0; k < cull_data.cull->shadows[j].cascade_count; k++) {
-					if (IN_FRUSTUM(cull_data.cull->shadows[j].cascades[k].frustum) && VIS_CHECK) {
+					if (cull_data.cull->shadows[j].cascades[k].use_cull_cache) {
+						continue;
+					}
+					if (IN_FRUSTUM(cascade_masks[j][k]) && VIS_CHECK) {
 						uint32_t base_type = idata.flags & InstanceData::FLAG_BASE_TYPE_MASK;
 
 						if (((1 << base_type) & RS::INSTANCE_GEOMETRY_MASK) && idata.flags & InstanceData::FLAG_CAST_SHADOWS) {
 							cull_result.directional_shadows[j].cascade_geometry_instances[k].push_back(idata.instance_geometry);
+							if (idata.flags & InstanceData::FLAG_USES_MESH_INSTANCE) {
+								// Kept apart so a cached cascade can still update the meshes it draws.
+								cull_result.directional_shadows[j].cascade_mesh_instances[k].push_back(idata.instance->mesh_instance);
+							}
 							mesh_visible = true;
 						}
 					}
@@ -2876,19 +3045,24 @@ void RendererSceneCull::_render_scene(const RendererSceneRender::CameraData *p_c
 		cull_data.occlusion_buffer = RendererSceneOcclusionCull::get_singleton()->buffer_get_ptr(p_viewport);
 		cull_data.camera_matrix = &p_camera_data->main_projection;
 		cull_data.visibility_viewport_mask = scenario->viewport_visibility_masks.has(p_viewport) ? scenario->viewport_visibility_masks[p_viewport] : 0;
+		cull_data.lod_camera_plane = Plane(-p_camera_data->main_transform.basis.get_axis(Vector3::AXIS_Z), p_camera_data->main_transform.get_origin());
+		cull_data.lod_distance_multiplier = p_camera_data->main_projection.get_lod_multiplier();
 //#define DEBUG_CULL_TIME
 #ifdef DEBUG_CULL_TIME
 		uint64_t time_from = OS::get_singleton()->get_ticks_usec();
 #endif
-		if (cull_to > thread_cull_threshold) {
+		// Mid-sized scenes are split in fewer jobs rather than waking every thread for a handful of instances.
+		cull_data.job_count = MIN((uint32_t)scene_cull_result_threads.size(), MAX(1u, uint32_t(cull_to / SCENE_CULL_MIN_INSTANCES_PER_JOB)));
+
+		if (cull_to > thread_cull_threshold && cull_data.job_count > 1) {
 			//multiple threads
-			for (uint32_t i = 0; i < scene_cull_result_threads.size(); i++) {
+			for (uint32_t i = 0; i < cull_data.job_count; i++) {
 				scene_cull_result_threads[i].clear();
 			}
 
-			RendererThreadPool::singleton->thread_work_pool.do_work(scene_cull_result_threads.size(), this, &RendererSceneCull::_scene_cull_threaded, &cull_data);
+			RendererThreadPool::singleton->thread_work_pool.do_work(cull_data.job_count, this, &RendererSceneCull::_scene_cull_threaded, &cull_data);
 
-			for (uint32_t i = 0; i < scene_cull_result_threads.size(); i++) {
+			for (uint32_t i = 0; i < cull_data.job_count; i++) {
 				scene_cull_result.append_from(scene_cull_result_threads[i]);
 			}
 
@@ -2905,6 +3079,17 @@ void RendererSceneCull::_render_scene(const RendererSceneRender::CameraData *p_c
 		print_line("time taken: " + rtos(time_avg / time_count));
 #endif
 
+		for (uint32_t i = 0; i < cull.shadow_count; i++) {
+			for (uint32_t j = 0; j < cull.shadows[i].cascade_count; j++) {
+				const Cull::Shadow::Cascade &c = cull.shadows[i].cascades[j];
+				if (c.use_cull_cache) {
+					for (uint32_t k = 0; k < c.cull_cache->mesh_instances.size(); k++) {
+						scene_cull_result.mesh_instances.push_back(c.cull_cache->mesh_instances[k]);
+					}
+				}
+			}
+		}
+
 		if (scene_cull_result.mesh_instances.size()) {
 			for (uint64_t i = 0; i < scene_cull_result.mesh_instances.size(); i++) {
 				RSG::storage->mesh_instance_check_for_update(scene_cull_result.mesh_instances[i]);
@@ -2926,12 +3111,33 @@ void RendererSceneCull::_render_scene(const RendererSceneRender::CameraData *p_c
 				const Cull::Shadow::Cascade &c = cull.shadows[i].cascades[j];
 				//			print_line("shadow " + itos(i) + " cascade " + itos(j) + " elements: " + itos(c.cull_result.size()));
 				scene_render->light_instance_set_shadow_transform(cull.shadows[i].light_instance, c.projection, c.transform, c.zfar, c.split, j, c.shadow_texel_size, c.bias_scale, c.range_begin, c.uv_scale);
+
+				PagedArray<RendererSceneRender::GeometryInstance *> &cascade_instances = scene_cull_result.directional_shadows[i].cascade_geometry_instances[j];
+				if (c.cull_cache && !c.use_cull_cache) {
+					const PagedArray<RID> &cascade_mesh_instances = scene_cull_result.directional_shadows[i].cascade_mesh_instances[j];
+					c.cull_cache->instances.clear();
+					for (uint64_t k = 0; k < cascade_instances.size(); k++) {
+						c.cull_cache->instances.push_back(cascade_instances[k]);
+					}
+					c.cull_cache->mesh_instances.clear();
+					for (uint64_t k = 0; k < cascade_mesh_instances.size(); k++) {
+						c.cull_cache->mesh_instances.push_back(cascade_mesh_instances[k]);
+					}
+					c.cull_cache->valid = true;
+				}
+
 				if (max_shadows_used == MAX_UPDATE_SHADOWS) {
 					continue;
 				}
 				render_shadow_data[max_shadows_used].light = cull.shadows[i].light_instance;
 				render_shadow_data[max_shadows_used].pass = j;
-				render_shadow_data[max_shadows_used].instances.merge_unordered(scene_cull_result.directional_shadows[i].cascade_geometry_instances[j]);
+				if (c.use_cull_cache) {
+					for (uint64_t k = 0; k < c.cull_cache->instances.size(); k++) {
+						render_shadow_data[max_shadows_used].instances.push_back(c.cull_cache->instances[k]);
+					}
+				} else {
+					render_shadow_data[max_shadows_used].instances.merge_unordered(cascade_instances);
+				}
 				max_shadows_used++;
 			}
 		}
@@ -3674,6 +3880,7 @@ void RendererSceneCull::_update_dirty_instance(Instance *p_instance) {
 				for (Set<Instance *>::Element *E = geom->lights.front(); E; E = E->next()) {
 					InstanceLightData *light = static_cast<InstanceLightData *>(E->get()->base_data);
 					light->shadow_dirty = true;
+					light->shadow_caster_version++;
 				}
 
 				geom->can_cast_shadows = can_cast_shadows;
@@ -3721,15 +3928,60 @@ void RendererSceneCull::_update_dirty_instance(Instance *p_instance) {
 	p_instance->update_dependencies = false;
 }
 
+void RendererSceneCull::_flush_instance_updates() {
+	for (uint32_t i = 0; i < scenario_owner.get_rid_count(); i++) {
+		Scenario *scenario = scenario_owner.get_ptr_by_index(i);
+		uint32_t batch_size = scenario->geometry_indexer_batch_ids.size();
+
+		if (batch_size == 0) {
+			continue;
+		}
+
+		DynamicBVH &indexer = scenario->indexers[Scenario::INDEXER_GEOMETRY];
+		if (batch_size >= indexer_batch_update_threshold) {
+			indexer.batch_update(scenario->geometry_indexer_batch_ids.ptr(), scenario->geometry_indexer_batch_aabbs.ptr(), batch_size, &RendererThreadPool::singleton->thread_work_pool);
+		} else {
+			for (uint32_t j = 0; j < batch_size; j++) {
+				indexer.update(scenario->geometry_indexer_batch_ids[j], scenario->geometry_indexer_batch_aabbs[j]);
+			}
+		}
+
+		scenario->geometry_indexer_batch_ids.clear();
+		scenario->geometry_indexer_batch_aabbs.clear();
+	}
+
+	for (uint32_t i = 0; i < instance_pair_queue.size(); i++) {
+		Instance *instance = instance_pair_queue[i];
+		instance->pair_pending = false;
+		instance->indexer_batch_index = -1;
+		if (instance->scenario && instance->indexer_id.is_valid()) {
+			_update_instance_pairs(instance);
+		}
+	}
+
+	instance_pair_queue.clear();
+}
+
 void RendererSceneCull::update_dirty_instances() {
 	RSG::storage->update_dirty_resources();
 
+	// Pairing may queue more updates (e.g. lightmap captures), keep going until everything is settled.
 	while (_instance_update_list.first()) {
-		_update_dirty_instance(_instance_update_list.first()->self());
+		instance_update_batching = true;
+		while (_instance_update_list.first()) {
+			_update_dirty_instance(_instance_update_list.first()->self());
+		}
+		instance_update_batching = false;
+
+		_flush_instance_updates();
 	}
 }
 
 void RendererSceneCull::update() {
+	shadow_cull_cache_hits = 0;
+	shadow_cull_cache_misses = 0;
+	visibility_range_changes.set(0);
+
 	//optimize bvhs
 	for (uint32_t i = 0; i < scenario_owner.get_rid_count(); i++) {
 		Scenario *s = scenario_owner.get_ptr_by_index(i);
@@ -3741,6 +3993,17 @@ void RendererSceneCull::update() {
 	render_particle_colliders();
 }
 
+uint64_t RendererSceneCull::get_rendering_info(RS::RenderingInfo p_info) {
+	if (p_info == RS::RENDERING_INFO_SHADOW_CULL_CACHE_HITS_IN_FRAME) {
+		return shadow_cull_cache_hits;
+	} else if (p_info == RS::RENDERING_INFO_SHADOW_CULL_CACHE_MISSES_IN_FRAME) {
+		return shadow_cull_cache_misses;
+	} else if (p_info == RS::RENDERING_INFO_VISIBILITY_RANGE_CHANGES_IN_FRAME) {
+		return visibility_range_changes.get();
+	}
+	return scene_render->get_rendering_info(p_info);
+}
+
 bool RendererSceneCull::free(RID p_rid) {
 	if (scene_render->free(p_rid)) {
 		return true;
@@ -3756,6 +4019,7 @@ bool RendererSceneCull::free(RID p_rid) {
 			instance_set_scenario(scenario->instances.first()->self()->self, RID());
 		}
 		scenario->instance_aabbs.reset();
+		scenario->instance_bounds_blocks.reset();
 		scenario->instance_data.reset();
 		scenario->instance_visibility.reset();
 
@@ -3837,7 +4101,6 @@ RendererSceneCull::RendererSceneCull() {
 	singleton = this;
 
 	instance_cull_result.set_page_pool(&instance_cull_page_pool);
-	instance_shadow_cull_result.set_page_pool(&instance_cull_page_pool);
 
 	for (uint32_t i = 0; i < MAX_UPDATE_SHADOWS; i++) {
 		render_shadow_data[i].instances.set_page_pool(&geometry_instance_cull_page_pool);
@@ -3854,14 +4117,16 @@ RendererSceneCull::RendererSceneCull() {
 
 	indexer_update_iterations = GLOBAL_GET("rendering/limits/spatial_indexer/update_iterations_per_frame");
 	thread_cull_threshold = GLOBAL_GET("rendering/limits/spatial_indexer/threaded_cull_minimum_instances");
+	indexer_batch_update_threshold = GLOBAL_GET("rendering/limits/spatial_indexer/batch_update_minimum_instances");
+	shadow_cull_cache_margin = GLOBAL_GET("rendering/shadows/directional_shadow/cull_cache_margin");
+	lod_hysteresis = GLOBAL_GET("rendering/mesh_lod/lod_change/hysteresis");
 	thread_cull_threshold = MAX(thread_cull_threshold, (uint32_t)RendererThreadPool::singleton->thread_work_pool.get_thread_count()); //make sure there is at least one thread per CPU
 
-	dummy_occlusion_culling = memnew(RendererSceneOcclusionCull);
+	raster_occlusion_culling = memnew(RasterOcclusionCull); // Replaced by other backends registered later, e.g. by the raycast module.
 }
 
 RendererSceneCull::~RendererSceneCull() {
 	instance_cull_result.reset();
-	instance_shadow_cull_result.reset();
 
 	for (uint32_t i = 0; i < MAX_UPDATE_SHADOWS; i++) {
 		render_shadow_data[i].instances.reset();
@@ -3876,7 +4141,7 @@ RendererSceneCull::~RendererSceneCull() {
 	}
 	scene_cull_result_threads.clear();
 
-	if (dummy_occlusion_culling) {
-		memdelete(dummy_occlusion_culling);
+	if (raster_occlusion_culling) {
+		memdelete(raster_occlusion_culling);
 	}
 }
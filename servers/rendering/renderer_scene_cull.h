@@ -44,12 +44,17 @@
 #include "core/templates/paged_allocator.h"
 #include "core/templates/paged_array.h"
 #include "core/templates/rid_owner.h"
+#include "core/templates/safe_refcount.h"
 #include "core/templates/self_list.h"
 #include "servers/rendering/renderer_scene.h"
 #include "servers/rendering/renderer_scene_occlusion_cull.h"
 #include "servers/rendering/renderer_scene_render.h"
 #include "servers/xr/xr_interface.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 class RendererSceneCull : public RendererScene {
 public:
 	RendererSceneRender *scene_render;
@@ -58,7 +63,8 @@ public:
 		SDFGI_MAX_CASCADES = 8,
 		SDFGI_MAX_REGIONS_PER_CASCADE = 3,
 		MAX_INSTANCE_PAIRS = 32,
-		MAX_UPDATE_SHADOWS = 512
+		MAX_UPDATE_SHADOWS = 512,
+		SCENE_CULL_MIN_INSTANCES_PER_JOB = 256,
 	};
 
 	uint64_t render_pass;
@@ -120,7 +126,7 @@ public:
 
 	/* VISIBILITY NOTIFIER API */
 
-	RendererSceneOcclusionCull *dummy_occlusion_culling;
+	RendererSceneOcclusionCull *raster_occlusion_culling;
 
 	/* SCENARIO API */
 
@@ -186,6 +192,55 @@ public:
 		}
 	};
 
+	struct ShadowCascadeCullCache {
+		// Casters found in an enlarged cascade frustum. They are reused while the cascade frustum
+		// stays inside it and no geometry inside it changed since they were culled.
+		Frustum frustum;
+		bool valid = false;
+		PagedArray<RendererSceneRender::GeometryInstance *> instances;
+		LocalVector<RID> mesh_instances;
+
+		_FORCE_INLINE_ bool contains(const Vector<Plane> &p_planes) const {
+			if (p_planes.size() != frustum.planes.size()) {
+				return false;
+			}
+			for (int i = 0; i < p_planes.size(); i++) {
+				if (p_planes[i].normal != frustum.planes[i].normal || p_planes[i].d > frustum.planes[i].d) {
+					return false;
+				}
+			}
+			return true;
+		}
+	};
+
+	struct InstanceLOD {
+		// Camera distance used to pick mesh LODs. It only follows the real distance once it moves past
+		// the hysteresis band, so an instance sitting on a LOD switch doesn't change LOD every frame.
+		float distance = -1.0;
+		float distance_scale = 1.0; // Last scale sent to the scene renderer.
+		uint64_t frame = 0;
+
+		// Returns the scale from the real distance to the one LODs are picked with.
+		_FORCE_INLINE_ float update(float p_distance, float p_hysteresis, uint64_t p_frame) {
+			if (frame == p_frame) {
+				// Another viewport, keep the state of the first one.
+			} else if (distance < 0.0 || p_frame != frame + 1) {
+				// Wasn't visible last frame, nothing to keep.
+				distance = p_distance;
+			} else if (p_distance > distance * (1.0 + p_hysteresis)) {
+				distance = p_distance / (1.0 + p_hysteresis);
+			} else if (p_distance < distance * (1.0 - p_hysteresis)) {
+				distance = p_distance / (1.0 - p_hysteresis);
+			}
+			frame = p_frame;
+
+			if (p_distance <= 0.0 || distance <= 0.0) {
+				return 1.0;
+			}
+			return distance / p_distance;
+		}
+	};
+
 	struct InstanceBounds {
 		// Efficiently store instance bounds.
 		// Because bounds checking is performed first,
@@ -245,6 +300,65 @@ public:
 		}
 	};
 
+	struct InstanceBoundsBlock {
+		// Bounds of BLOCK_SIZE consecutive instances, stored as one array per component (in the same order
+		// as InstanceBounds) so a frustum plane is tested against the whole block at once.
+		enum {
+			BLOCK_SIZE = 4,
+			BLOCK_SHIFT = 2,
+			BLOCK_MASK = BLOCK_SIZE - 1,
+		};
+
+		real_t bounds[6][BLOCK_SIZE];
+
+		_ALWAYS_INLINE_ void set(uint32_t p_lane, const InstanceBounds &p_bounds) {
+			for (int i = 0; i < 6; i++) {
+				bounds[i][p_lane] = p_bounds.bounds[i];
+			}
+		}
+
+		// Returns a bit per instance of the block, set when it is inside the frustum (same test as InstanceBounds::in_frustum()).
+		_ALWAYS_INLINE_ uint32_t in_frustum_mask(const Frustum &p_frustum) const {
+#if defined(__SSE2__) && !defined(REAL_T_IS_DOUBLE)
+			const __m128 zero = _mm_setzero_ps();
+			__m128 inside = _mm_cmpeq_ps(zero, zero);
+
+			for (uint32_t i = 0; i < p_frustum.plane_count; i++) {
+				const Plane &plane = p_frustum.planes_ptr[i];
+				const uint32_t *signs = p_frustum.plane_signs_ptr[i].signs;
+
+				__m128 distance = _mm_mul_ps(_mm_loadu_ps(bounds[signs[0]]), _mm_set1_ps(plane.normal.x));
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_loadu_ps(bounds[signs[1]]), _mm_set1_ps(plane.normal.y)));
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_loadu_ps(bounds[signs[2]]), _mm_set1_ps(plane.normal.z)));
+				distance = _mm_sub_ps(distance, _mm_set1_ps(plane.d));
+
+				inside = _mm_and_ps(inside, _mm_cmplt_ps(distance, zero));
+				if (_mm_movemask_ps(inside) == 0) {
+					return 0;
+				}
+			}
+
+			return _mm_movemask_ps(inside);
+#else
+			uint32_t mask = (1 << BLOCK_SIZE) - 1;
+
+			for (uint32_t i = 0; i < p_frustum.plane_count && mask; i++) {
+				const Plane &plane = p_frustum.planes_ptr[i];
+				const uint32_t *signs = p_frustum.plane_signs_ptr[i].signs;
+
+				for (uint32_t j = 0; j < BLOCK_SIZE; j++) {
+					real_t distance = bounds[signs[0]][j] * plane.normal.x + bounds[signs[1]][j] * plane.normal.y + bounds[signs[2]][j] * plane.normal.z - plane.d;
+					if (distance >= 0.0) {
+						mask &= ~(1 << j);
+					}
+				}
+			}
+
+			return mask;
+#endif
+		}
+	};
+
 	struct InstanceVisibilityNotifierData;
 
 	struct InstanceData {
@@ -332,9 +446,14 @@ public:
 		LocalVector<RID> dynamic_lights;
 
 		PagedArray<InstanceBounds> instance_aabbs;
+		LocalVector<InstanceBoundsBlock> instance_bounds_blocks; // Same bounds as instance_aabbs, for culling.
 		PagedArray<InstanceData> instance_data;
 		VisibilityArray instance_visibility;
 
+		// Moved geometry instances, applied to the indexer at once when all dirty instances are updated.
+		LocalVector<DynamicBVH::ID> geometry_indexer_batch_ids;
+		LocalVector<AABB> geometry_indexer_batch_aabbs;
+
 		Scenario() {
 			indexers[INDEXER_GEOMETRY].set_index(INDEXER_GEOMETRY);
 			indexers[INDEXER_VOLUMES].set_index(INDEXER_VOLUMES);
@@ -343,6 +462,7 @@ public:
 	};
 
 	int indexer_update_iterations = 0;
+	uint32_t indexer_batch_update_threshold = 128;
 
 	mutable RID_Owner<Scenario, true> scenario_owner;
 
@@ -392,6 +512,7 @@ public:
 		Transform3D transform;
 
 		float lod_bias;
+		InstanceLOD lod;
 
 		bool ignore_occlusion_culling;
 
@@ -434,6 +555,8 @@ public:
 		RID self;
 		//scenario stuff
 		DynamicBVH::ID indexer_id;
+		int32_t indexer_batch_index = -1; // Pending geometry indexer update, see update_dirty_instances().
+		bool pair_pending = false;
 		int32_t array_index;
 		int32_t visibility_index = -1;
 		float visibility_range_begin;
@@ -569,6 +692,8 @@ public:
 	};
 
 	SelfList<Instance>::List _instance_update_list;
+	bool instance_update_batching = false;
+	LocalVector<Instance *> instance_pair_queue; // Paired once the indexers are up to date.
 	void _instance_queue_update(Instance *p_instance, bool p_update_aabb, bool p_update_dependencies = false);
 
 	struct InstanceGeometryData : public InstanceBaseData {
@@ -652,6 +777,16 @@ public:
 		RS::LightBakeMode bake_mode;
 		uint32_t max_sdfgi_cascade = 2;
 
+		// Paired geometry found by the last cull of each shadow pass (up to 6 for cube maps),
+		// valid while their version matches shadow_caster_version.
+		struct ShadowCasterCache {
+			LocalVector<Instance *> instances;
+			uint64_t version = 0;
+		} shadow_caster_cache[6];
+		uint64_t shadow_caster_version = 1;
+
+		ShadowCascadeCullCache cascade_cull_cache[RendererSceneRender::MAX_DIRECTIONAL_LIGHT_CASCADES];
+
 		InstanceLightData() {
 			bake_mode = RS::LIGHT_BAKE_DISABLED;
 			shadow_dirty = true;
@@ -777,7 +912,6 @@ public:
 	PagedArrayPool<RID> rid_cull_page_pool;
 
 	PagedArray<Instance *> instance_cull_result;
-	PagedArray<Instance *> instance_shadow_cull_result;
 
 	struct InstanceCullResult {
 		PagedArray<RendererSceneRender::GeometryInstance *> geometry_instances;
@@ -791,6 +925,7 @@ public:
 
 		struct DirectionalShadow {
 			PagedArray<RendererSceneRender::GeometryInstance *> cascade_geometry_instances[RendererSceneRender::MAX_DIRECTIONAL_LIGHT_CASCADES];
+			PagedArray<RID> cascade_mesh_instances[RendererSceneRender::MAX_DIRECTIONAL_LIGHT_CASCADES];
 		} directional_shadows[RendererSceneRender::MAX_DIRECTIONAL_LIGHTS];
 
 		PagedArray<RendererSceneRender::GeometryInstance *> sdfgi_region_geometry_instances[SDFGI_MAX_CASCADES * SDFGI_MAX_REGIONS_PER_CASCADE];
@@ -808,6 +943,7 @@ public:
 			for (int i = 0; i < RendererSceneRender::MAX_DIRECTIONAL_LIGHTS; i++) {
 				for (int j = 0; j < RendererSceneRender::MAX_DIRECTIONAL_LIGHT_CASCADES; j++) {
 					directional_shadows[i].cascade_geometry_instances[j].clear();
+					directional_shadows[i].cascade_mesh_instances[j].clear();
 				}
 			}
 
@@ -832,6 +968,7 @@ public:
 			for (int i = 0; i < RendererSceneRender::MAX_DIRECTIONAL_LIGHTS; i++) {
 				for (int j = 0; j < RendererSceneRender::MAX_DIRECTIONAL_LIGHT_CASCADES; j++) {
 					directional_shadows[i].cascade_geometry_instances[j].reset();
+					directional_shadows[i].cascade_mesh_instances[j].reset();
 				}
 			}
 
@@ -857,6 +994,7 @@ public:
 			for (int i = 0; i < RendererSceneRender::MAX_DIRECTIONAL_LIGHTS; i++) {
 				for (int j = 0; j < RendererSceneRender::MAX_DIRECTIONAL_LIGHT_CASCADES; j++) {
 					directional_shadows[i].cascade_geometry_instances[j].merge_unordered(p_cull_result.directional_shadows[i].cascade_geometry_instances[j]);
+					directional_shadows[i].cascade_mesh_instances[j].merge_unordered(p_cull_result.directional_shadows[i].cascade_mesh_instances[j]);
 				}
 			}
 
@@ -881,6 +1019,7 @@ public:
 			for (int i = 0; i < RendererSceneRender::MAX_DIRECTIONAL_LIGHTS; i++) {
 				for (int j = 0; j < RendererSceneRender::MAX_DIRECTIONAL_LIGHT_CASCADES; j++) {
 					directional_shadows[i].cascade_geometry_instances[j].set_page_pool(p_geometry_instance_pool);
+					directional_shadows[i].cascade_mesh_instances[j].set_page_pool(p_rid_pool);
 				}
 			}
 
@@ -905,6 +1044,13 @@ public:
 
 	uint32_t thread_cull_threshold = 200;
 
+	float shadow_cull_cache_margin = 0.05;
+	uint64_t shadow_cull_cache_hits = 0;
+	uint64_t shadow_cull_cache_misses = 0;
+
+	float lod_hysteresis = 0.1;
+	SafeNumeric<uint64_t> visibility_range_changes;
+
 	RID_Owner<Instance, true> instance_owner;
 
 	uint32_t geometry_instance_pair_mask; // used in traditional forward, unnecessary on clustered
@@ -954,13 +1100,18 @@ public:
 	virtual Variant instance_geometry_get_shader_parameter_default_value(RID p_instance, const StringName &p_parameter) const;
 
 	_FORCE_INLINE_ void _update_instance(Instance *p_instance);
+	_FORCE_INLINE_ void _update_instance_pairs(Instance *p_instance);
+	void _flush_instance_updates();
 	_FORCE_INLINE_ void _update_instance_aabb(Instance *p_instance);
+	_FORCE_INLINE_ void _set_instance_bounds(Scenario *p_scenario, uint32_t p_index, const InstanceBounds &p_bounds);
+	void _scenario_invalidate_shadow_cull_caches(Scenario *p_scenario, const InstanceBounds &p_bounds);
 	_FORCE_INLINE_ void _update_dirty_instance(Instance *p_instance);
 	_FORCE_INLINE_ void _update_instance_lightmap_captures(Instance *p_instance);
 	void _unpair_instance(Instance *p_instance);
 
 	void _light_instance_setup_directional_shadow(int p_shadow_index, Instance *p_instance, const Transform3D p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, bool p_cam_vaspect);
 
+	const LocalVector<Instance *> &_light_instance_get_shadow_casters(InstanceLightData *p_light, uint32_t p_pass, Scenario *p_scenario, const Vector<Plane> &p_planes);
 	_FORCE_INLINE_ bool _light_instance_update_shadow(Instance *p_instance, const Transform3D p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, bool p_cam_vaspect, RID p_shadow_atlas, Scenario *p_scenario, float p_scren_lod_threshold);
 
 	RID _render_get_environment(RID p_camera, RID p_scenario);
@@ -980,6 +1131,9 @@ public:
 				real_t range_begin;
 				Vector2 uv_scale;
 
+				ShadowCascadeCullCache *cull_cache;
+				bool use_cull_cache;
+
 			} cascades[RendererSceneRender::MAX_DIRECTIONAL_LIGHT_CASCADES]; //max 4 cascades
 			uint32_t cascade_count;
 
@@ -1026,10 +1180,14 @@ public:
 		const RendererSceneOcclusionCull::HZBuffer *occlusion_buffer;
 		const CameraMatrix *camera_matrix;
 		uint64_t visibility_viewport_mask;
+		Plane lod_camera_plane;
+		float lod_distance_multiplier;
+		uint32_t job_count;
 	};
 
 	void _scene_cull_threaded(uint32_t p_thread, CullData *cull_data);
 	void _scene_cull(CullData &cull_data, InstanceCullResult &cull_result, uint64_t p_from, uint64_t p_to);
+	_FORCE_INLINE_ void _update_instance_lod(InstanceData &r_idata, const InstanceBounds &p_bounds, const CullData &p_cull_data, uint64_t p_frame);
 
 	bool _render_reflection_probe_step(Instance *p_instance, int p_step);
 	void _render_scene(const RendererSceneRender::CameraData *p_camera_data, RID p_render_buffers, RID p_environment, RID p_force_camera_effects, uint32_t p_visible_layers, RID p_scenario, RID p_viewport, RID p_shadow_atlas, RID p_reflection_probe, int p_reflection_probe_pass, float p_screen_lod_threshold, bool p_using_shadows = true, RenderInfo *r_render_info = nullptr);
@@ -1148,6 +1306,8 @@ public:
 
 	virtual void update();
 
+	virtual uint64_t get_rendering_info(RS::RenderingInfo p_info);
+
 	bool free(RID p_rid);
 
 	void set_scene_render(RendererSceneRender *p_scene_render);
@@ -0,0 +1,547 @@
+/*************************************************************************/
+/*  renderer_scene_occlusion_cull_raster.cpp                             */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "renderer_scene_occlusion_cull_raster.h"
+
+void RasterOcclusionCull::RasterHZBuffer::clear() {
+	HZBuffer::clear();
+
+	clip_vertices.clear();
+	thread_triangles.clear();
+	thread_bins.clear();
+	tile_grid_size = Size2i();
+	tile_count = 0;
+}
+
+void RasterOcclusionCull::RasterHZBuffer::resize(const Size2i &p_size) {
+	if (p_size == Size2i()) {
+		clear();
+		return;
+	}
+
+	if (!sizes.is_empty() && p_size == sizes[0]) {
+		return; // Size didn't change
+	}
+
+	HZBuffer::resize(p_size);
+
+	tile_grid_size = Size2i((p_size.x + TILE_SIZE - 1) / TILE_SIZE, (p_size.y + TILE_SIZE - 1) / TILE_SIZE);
+	tile_count = tile_grid_size.x * tile_grid_size.y;
+	thread_bins.clear();
+}
+
+float RasterOcclusionCull::RasterHZBuffer::get_depth(int p_x, int p_y) const {
+	ERR_FAIL_COND_V(is_empty(), FLT_MAX);
+	ERR_FAIL_INDEX_V(p_x, sizes[0].x, FLT_MAX);
+	ERR_FAIL_INDEX_V(p_y, sizes[0].y, FLT_MAX);
+	return mips[0][p_y * sizes[0].x + p_x];
+}
+
+void RasterOcclusionCull::RasterHZBuffer::rasterize(const Geometry &p_geometry, const Transform3D &p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, ThreadWorkPool &p_thread_pool) {
+	ERR_FAIL_COND(is_empty());
+
+	RasterThreadData td;
+	td.thread_count = p_thread_pool.get_thread_count();
+	td.geometry = p_geometry;
+	td.cam_inv_transform = p_cam_transform.affine_inverse();
+	td.cam_projection = p_cam_projection;
+	td.cam_orthogonal = p_cam_orthogonal;
+
+	debug_tex_range = p_cam_projection.get_z_far();
+
+	if (thread_triangles.size() != td.thread_count) {
+		thread_triangles.resize(td.thread_count);
+		thread_bins.clear();
+	}
+	thread_bins.resize(td.thread_count * tile_count);
+
+	if (p_geometry.vertex_count > 0 && p_geometry.index_count >= 3) {
+		clip_vertices.resize(p_geometry.vertex_count);
+		p_thread_pool.do_work(td.thread_count, this, &RasterHZBuffer::_transform_vertices_threaded, &td);
+		p_thread_pool.do_work(td.thread_count, this, &RasterHZBuffer::_setup_triangles_threaded, &td);
+	} else {
+		for (uint32_t i = 0; i < thread_bins.size(); i++) {
+			thread_bins[i].clear();
+		}
+	}
+
+	p_thread_pool.do_work(tile_count, this, &RasterHZBuffer::_rasterize_tile_threaded, &td);
+
+	update_mips();
+}
+
+void RasterOcclusionCull::RasterHZBuffer::_transform_vertices_threaded(uint32_t p_thread, const RasterThreadData *p_data) {
+	uint32_t vertex_total = p_data->geometry.vertex_count;
+	uint32_t total_threads = p_data->thread_count;
+	uint32_t from = p_thread * vertex_total / total_threads;
+	uint32_t to = (p_thread + 1 == total_threads) ? vertex_total : ((p_thread + 1) * vertex_total / total_threads);
+
+	const Vector3 *read = p_data->geometry.vertices;
+	ClipVertex *write = clip_vertices.ptr();
+
+	for (uint32_t i = from; i < to; i++) {
+		Vector3 view = p_data->cam_inv_transform.xform(read[i]);
+		Plane clip = p_data->cam_projection.xform4(Plane(view, 1.0));
+
+		ClipVertex &v = write[i];
+		v.x = clip.normal.x;
+		v.y = clip.normal.y;
+		v.z = clip.normal.z;
+		v.w = clip.d;
+		v.depth = -view.z;
+	}
+}
+
+void RasterOcclusionCull::RasterHZBuffer::_setup_triangles_threaded(uint32_t p_thread, const RasterThreadData *p_data) {
+	LocalVector<Triangle> &triangles = thread_triangles[p_thread];
+	triangles.clear();
+
+	LocalVector<uint32_t> *bins = &thread_bins[p_thread * tile_count];
+	for (uint32_t i = 0; i < tile_count; i++) {
+		bins[i].clear();
+	}
+
+	uint32_t triangle_total = p_data->geometry.index_count / 3;
+	uint32_t total_threads = p_data->thread_count;
+	uint32_t from = p_thread * triangle_total / total_threads;
+	uint32_t to = (p_thread + 1 == total_threads) ? triangle_total : ((p_thread + 1) * triangle_total / total_threads);
+
+	const uint32_t *indices = p_data->geometry.indices;
+	const ClipVertex *vertices = clip_vertices.ptr();
+
+	for (uint32_t i = from; i < to; i++) {
+		ClipVertex v[3] = { vertices[indices[i * 3 + 0]], vertices[indices[i * 3 + 1]], vertices[indices[i * 3 + 2]] };
+
+		// Trivial reject against the side planes of the frustum.
+		if ((v[0].x < -v[0].w && v[1].x < -v[1].w && v[2].x < -v[2].w) ||
+				(v[0].x > v[0].w && v[1].x > v[1].w && v[2].x > v[2].w) ||
+				(v[0].y < -v[0].w && v[1].y < -v[1].w && v[2].y < -v[2].w) ||
+				(v[0].y > v[0].w && v[1].y > v[1].w && v[2].y > v[2].w)) {
+			continue;
+		}
+
+		// Clip space z + w is positive in front of the near plane, for both perspective and orthogonal projections.
+		float d[3];
+		int inside_count = 0;
+		for (int j = 0; j < 3; j++) {
+			d[j] = v[j].z + v[j].w;
+			if (d[j] >= 0.0f) {
+				inside_count++;
+			}
+		}
+
+		if (inside_count == 0) {
+			continue;
+		}
+
+		if (inside_count == 3) {
+			_setup_triangle(p_thread, v, p_data->cam_orthogonal);
+			continue;
+		}
+
+		// Clip against the near plane, which leaves either one or two triangles.
+		ClipVertex clipped[4];
+		int clipped_count = 0;
+		for (int j = 0; j < 3; j++) {
+			int k = (j + 1) % 3;
+			if (d[j] >= 0.0f) {
+				clipped[clipped_count++] = v[j];
+			}
+			if ((d[j] >= 0.0f) != (d[k] >= 0.0f)) {
+				float t = d[j] / (d[j] - d[k]);
+				ClipVertex &c = clipped[clipped_count++];
+				c.x = Math::lerp(v[j].x, v[k].x, t);
+				c.y = Math::lerp(v[j].y, v[k].y, t);
+				c.z = Math::lerp(v[j].z, v[k].z, t);
+				c.w = Math::lerp(v[j].w, v[k].w, t);
+				c.depth = Math::lerp(v[j].depth, v[k].depth, t);
+			}
+		}
+
+		_setup_triangle(p_thread, clipped, p_data->cam_orthogonal);
+		if (clipped_count == 4) {
+			ClipVertex second[3] = { clipped[0], clipped[2], clipped[3] };
+			_setup_triangle(p_thread, second, p_data->cam_orthogonal);
+		}
+	}
+}
+
+void RasterOcclusionCull::RasterHZBuffer::_setup_triangle(uint32_t p_thread, const ClipVertex *p_vertices, bool p_orthogonal) {
+	const Size2i &buffer_size = sizes[0];
+
+	float x[3];
+	float y[3];
+	float z[3];
+	for (int i = 0; i < 3; i++) {
+		const ClipVertex &v = p_vertices[i];
+		if (v.w <= 0.0f || v.depth <= 0.0f) {
+			return;
+		}
+		x[i] = (v.x / v.w * 0.5f + 0.5f) * buffer_size.x;
+		y[i] = (v.y / v.w * 0.5f + 0.5f) * buffer_size.y;
+		// View depth is linear in screen space for orthogonal projections, its reciprocal is for perspective ones.
+		z[i] = p_orthogonal ? v.depth : 1.0f / v.depth;
+	}
+
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (Math::is_zero_approx(area)) {
+		return;
+	}
+
+	// Occluders are not back-face culled, flip the winding instead.
+	if (area < 0.0f) {
+		SWAP(x[1], x[2]);
+		SWAP(y[1], y[2]);
+		SWAP(z[1], z[2]);
+		area = -area;
+	}
+
+	// Pixels are covered when their center is inside the triangle.
+	float min_x = MIN(MIN(x[0], x[1]), x[2]) - 0.5f;
+	float max_x = MAX(MAX(x[0], x[1]), x[2]) - 0.5f;
+	float min_y = MIN(MIN(y[0], y[1]), y[2]) - 0.5f;
+	float max_y = MAX(MAX(y[0], y[1]), y[2]) - 0.5f;
+
+	if (max_x < 0.0f || max_y < 0.0f || min_x > buffer_size.x - 1 || min_y > buffer_size.y - 1) {
+		return;
+	}
+
+	Triangle triangle;
+	triangle.min_x = Math::ceil(MAX(min_x, 0.0f));
+	triangle.min_y = Math::ceil(MAX(min_y, 0.0f));
+	triangle.max_x = Math::floor(MIN(max_x, float(buffer_size.x - 1)));
+	triangle.max_y = Math::floor(MIN(max_y, float(buffer_size.y - 1)));
+
+	if (triangle.min_x > triangle.max_x || triangle.min_y > triangle.max_y) {
+		return;
+	}
+
+	for (int i = 0; i < 3; i++) {
+		int j = (i + 1) % 3;
+		triangle.edge_x[i] = y[i] - y[j];
+		triangle.edge_y[i] = x[j] - x[i];
+		triangle.edge_c[i] = -(triangle.edge_x[i] * x[i] + triangle.edge_y[i] * y[i]);
+	}
+
+	triangle.depth_x = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+	triangle.depth_y = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+	triangle.depth_c = z[0] - triangle.depth_x * x[0] - triangle.depth_y * y[0];
+
+	LocalVector<Triangle> &triangles = thread_triangles[p_thread];
+	uint32_t triangle_index = triangles.size();
+	triangles.push_back(triangle);
+
+	LocalVector<uint32_t> *bins = &thread_bins[p_thread * tile_count];
+	for (int tile_y = triangle.min_y / TILE_SIZE; tile_y <= triangle.max_y / TILE_SIZE; tile_y++) {
+		for (int tile_x = triangle.min_x / TILE_SIZE; tile_x <= triangle.max_x / TILE_SIZE; tile_x++) {
+			bins[tile_y * tile_grid_size.x + tile_x].push_back(triangle_index);
+		}
+	}
+}
+
+void RasterOcclusionCull::RasterHZBuffer::_rasterize_tile_threaded(uint32_t p_tile, const RasterThreadData *p_data) {
+	const int buffer_width = sizes[0].x;
+	const int buffer_height = sizes[0].y;
+
+	const int tile_min_x = (p_tile % tile_grid_size.x) * TILE_SIZE;
+	const int tile_min_y = (p_tile / tile_grid_size.x) * TILE_SIZE;
+	const int tile_max_x = MIN(tile_min_x + TILE_SIZE, buffer_width) - 1;
+	const int tile_max_y = MIN(tile_min_y + TILE_SIZE, buffer_height) - 1;
+
+	float *depth_buffer = mips[0];
+
+	for (int y = tile_min_y; y <= tile_max_y; y++) {
+		float *row = &depth_buffer[y * buffer_width];
+		for (int x = tile_min_x; x <= tile_max_x; x++) {
+			row[x] = FLT_MAX;
+		}
+	}
+
+	const bool orthogonal = p_data->cam_orthogonal;
+
+	for (uint32_t i = 0; i < thread_triangles.size(); i++) {
+		const LocalVector<uint32_t> &bin = thread_bins[i * tile_count + p_tile];
+		const Triangle *triangles = thread_triangles[i].ptr();
+
+		for (uint32_t j = 0; j < bin.size(); j++) {
+			const Triangle &t = triangles[bin[j]];
+
+			int min_x = MAX(t.min_x, tile_min_x);
+			int max_x = MIN(t.max_x, tile_max_x);
+			int min_y = MAX(t.min_y, tile_min_y);
+			int max_y = MIN(t.max_y, tile_max_y);
+
+			float start_x = min_x + 0.5f;
+
+			for (int y = min_y; y <= max_y; y++) {
+				float py = y + 0.5f;
+
+				// Edge functions and depth are stepped incrementally along the row.
+				float e0 = t.edge_x[0] * start_x + t.edge_y[0] * py + t.edge_c[0];
+				float e1 = t.edge_x[1] * start_x + t.edge_y[1] * py + t.edge_c[1];
+				float e2 = t.edge_x[2] * start_x + t.edge_y[2] * py + t.edge_c[2];
+				float z = t.depth_x * start_x + t.depth_y * py + t.depth_c;
+
+				float *row = &depth_buffer[y * buffer_width];
+
+				for (int x = min_x; x <= max_x; x++) {
+					if (e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f) {
+						float depth = orthogonal ? z : 1.0f / z;
+						row[x] = MIN(row[x], depth);
+					}
+					e0 += t.edge_x[0];
+					e1 += t.edge_x[1];
+					e2 += t.edge_x[2];
+					z += t.depth_x;
+				}
+			}
+		}
+	}
+}
+
+////////////////////////////////////////////////////////
+
+bool RasterOcclusionCull::is_occluder(RID p_rid) {
+	return occluder_owner.owns(p_rid);
+}
+
+RID RasterOcclusionCull::occluder_allocate() {
+	return occluder_owner.allocate_rid();
+}
+
+void RasterOcclusionCull::occluder_initialize(RID p_occluder) {
+	Occluder *occluder = memnew(Occluder);
+	occluder_owner.initialize_rid(p_occluder, occluder);
+}
+
+void RasterOcclusionCull::occluder_set_mesh(RID p_occluder, const PackedVector3Array &p_vertices, const PackedInt32Array &p_indices) {
+	Occluder *occluder = occluder_owner.get_or_null(p_occluder);
+	ERR_FAIL_COND(!occluder);
+
+	occluder->vertices = p_vertices;
+	occluder->indices = p_indices;
+
+	_mark_occluder_users_dirty(occluder);
+}
+
+void RasterOcclusionCull::free_occluder(RID p_occluder) {
+	Occluder *occluder = occluder_owner.get_or_null(p_occluder);
+	ERR_FAIL_COND(!occluder);
+	_mark_occluder_users_dirty(occluder);
+	memdelete(occluder);
+	occluder_owner.free(p_occluder);
+}
+
+void RasterOcclusionCull::_mark_occluder_users_dirty(Occluder *p_occluder) {
+	for (Set<InstanceID>::Element *E = p_occluder->users.front(); E; E = E->next()) {
+		Scenario *scenario = scenarios.getptr(E->get().scenario);
+		if (scenario) {
+			scenario->dirty = true;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////
+
+void RasterOcclusionCull::add_scenario(RID p_scenario) {
+	if (!scenarios.has(p_scenario)) {
+		scenarios[p_scenario] = Scenario();
+	}
+}
+
+void RasterOcclusionCull::remove_scenario(RID p_scenario) {
+	ERR_FAIL_COND(!scenarios.has(p_scenario));
+	Scenario &scenario = scenarios[p_scenario];
+
+	const RID *instance_rid = nullptr;
+	while ((instance_rid = scenario.instances.next(instance_rid))) {
+		Occluder *occluder = occluder_owner.get_or_null(scenario.instances[*instance_rid].occluder);
+		if (occluder) {
+			occluder->users.erase(InstanceID(p_scenario, *instance_rid));
+		}
+	}
+
+	scenarios.erase(p_scenario);
+}
+
+void RasterOcclusionCull::scenario_set_instance(RID p_scenario, RID p_instance, RID p_occluder, const Transform3D &p_xform, bool p_enabled) {
+	ERR_FAIL_COND(!scenarios.has(p_scenario));
+	Scenario &scenario = scenarios[p_scenario];
+
+	if (!scenario.instances.has(p_instance)) {
+		scenario.instances[p_instance] = OccluderInstance();
+	}
+
+	OccluderInstance &instance = scenario.instances[p_instance];
+
+	if (instance.occluder != p_occluder) {
+		Occluder *old_occluder = occluder_owner.get_or_null(instance.occluder);
+		if (old_occluder) {
+			old_occluder->users.erase(InstanceID(p_scenario, p_instance));
+		}
+
+		instance.occluder = p_occluder;
+		scenario.dirty = true;
+
+		if (p_occluder.is_valid()) {
+			Occluder *occluder = occluder_owner.get_or_null(p_occluder);
+			ERR_FAIL_COND(!occluder);
+			occluder->users.insert(InstanceID(p_scenario, p_instance));
+		}
+	}
+
+	if (instance.xform != p_xform) {
+		instance.xform = p_xform;
+		scenario.dirty = true;
+	}
+
+	if (instance.enabled != p_enabled) {
+		instance.enabled = p_enabled;
+		scenario.dirty = true;
+	}
+}
+
+void RasterOcclusionCull::scenario_remove_instance(RID p_scenario, RID p_instance) {
+	ERR_FAIL_COND(!scenarios.has(p_scenario));
+	Scenario &scenario = scenarios[p_scenario];
+
+	OccluderInstance *instance = scenario.instances.getptr(p_instance);
+	if (!instance) {
+		return;
+	}
+
+	Occluder *occluder = occluder_owner.get_or_null(instance->occluder);
+	if (occluder) {
+		occluder->users.erase(InstanceID(p_scenario, p_instance));
+	}
+
+	scenario.instances.erase(p_instance);
+	scenario.dirty = true;
+}
+
+void RasterOcclusionCull::Scenario::update(RasterOcclusionCull *p_owner) {
+	if (!dirty) {
+		return;
+	}
+
+	vertices.clear();
+	indices.clear();
+
+	const RID *instance_rid = nullptr;
+	while ((instance_rid = instances.next(instance_rid))) {
+		const OccluderInstance &instance = instances[*instance_rid];
+		Occluder *occluder = p_owner->occluder_owner.get_or_null(instance.occluder);
+
+		if (!occluder || !instance.enabled) {
+			continue;
+		}
+
+		uint32_t vertex_offset = vertices.size();
+		uint32_t vertex_count = occluder->vertices.size();
+		vertices.resize(vertex_offset + vertex_count);
+
+		const Vector3 *read = occluder->vertices.ptr();
+		Vector3 *write = &vertices[vertex_offset];
+		for (uint32_t i = 0; i < vertex_count; i++) {
+			write[i] = instance.xform.xform(read[i]);
+		}
+
+		const int32_t *occluder_indices = occluder->indices.ptr();
+		uint32_t index_count = occluder->indices.size() - occluder->indices.size() % 3;
+		for (uint32_t i = 0; i < index_count; i += 3) {
+			if ((uint32_t)occluder_indices[i + 0] >= vertex_count || (uint32_t)occluder_indices[i + 1] >= vertex_count || (uint32_t)occluder_indices[i + 2] >= vertex_count) {
+				continue;
+			}
+			indices.push_back(vertex_offset + occluder_indices[i + 0]);
+			indices.push_back(vertex_offset + occluder_indices[i + 1]);
+			indices.push_back(vertex_offset + occluder_indices[i + 2]);
+		}
+	}
+
+	dirty = false;
+}
+
+////////////////////////////////////////////////////////
+
+void RasterOcclusionCull::add_buffer(RID p_buffer) {
+	ERR_FAIL_COND(buffers.has(p_buffer));
+	buffers[p_buffer] = RasterHZBuffer();
+}
+
+void RasterOcclusionCull::remove_buffer(RID p_buffer) {
+	ERR_FAIL_COND(!buffers.has(p_buffer));
+	buffers.erase(p_buffer);
+}
+
+void RasterOcclusionCull::buffer_set_scenario(RID p_buffer, RID p_scenario) {
+	ERR_FAIL_COND(!buffers.has(p_buffer));
+	ERR_FAIL_COND(p_scenario.is_valid() && !scenarios.has(p_scenario));
+	buffers[p_buffer].scenario_rid = p_scenario;
+}
+
+void RasterOcclusionCull::buffer_set_size(RID p_buffer, const Vector2i &p_size) {
+	ERR_FAIL_COND(!buffers.has(p_buffer));
+	buffers[p_buffer].resize(p_size);
+}
+
+void RasterOcclusionCull::buffer_update(RID p_buffer, const Transform3D &p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, ThreadWorkPool &p_thread_pool) {
+	if (!buffers.has(p_buffer)) {
+		return;
+	}
+
+	RasterHZBuffer &buffer = buffers[p_buffer];
+
+	if (buffer.is_empty() || !scenarios.has(buffer.scenario_rid)) {
+		return;
+	}
+
+	Scenario &scenario = scenarios[buffer.scenario_rid];
+	scenario.update(this);
+
+	RasterHZBuffer::Geometry geometry;
+	geometry.vertices = scenario.vertices.ptr();
+	geometry.vertex_count = scenario.vertices.size();
+	geometry.indices = scenario.indices.ptr();
+	geometry.index_count = scenario.indices.size();
+
+	buffer.rasterize(geometry, p_cam_transform, p_cam_projection, p_cam_orthogonal, p_thread_pool);
+}
+
+RasterOcclusionCull::HZBuffer *RasterOcclusionCull::buffer_get_ptr(RID p_buffer) {
+	if (!buffers.has(p_buffer)) {
+		return nullptr;
+	}
+	return &buffers[p_buffer];
+}
+
+RID RasterOcclusionCull::buffer_get_debug_texture(RID p_buffer) {
+	ERR_FAIL_COND_V(!buffers.has(p_buffer), RID());
+	return buffers[p_buffer].get_debug_texture();
+}
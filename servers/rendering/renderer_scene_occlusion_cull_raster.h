@@ -0,0 +1,179 @@
+/*************************************************************************/
+/*  renderer_scene_occlusion_cull_raster.h                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef RENDERER_SCENE_OCCLUSION_CULL_RASTER_H
+#define RENDERER_SCENE_OCCLUSION_CULL_RASTER_H
+
+#include "core/math/camera_matrix.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/local_vector.h"
+#include "core/templates/rid_owner.h"
+#include "core/templates/set.h"
+#include "core/templates/thread_work_pool.h"
+#include "servers/rendering/renderer_scene_occlusion_cull.h"
+
+// Occlusion culling backend that does not depend on Embree. Occluders are rasterized
+// on the CPU into the low resolution depth buffer, split in tiles that are filled in
+// parallel on the worker pool. The HZBuffer pyramid is then built from it as usual.
+class RasterOcclusionCull : public RendererSceneOcclusionCull {
+public:
+	class RasterHZBuffer : public HZBuffer {
+	public:
+		static const int TILE_SIZE = 16;
+
+		struct Geometry {
+			const Vector3 *vertices = nullptr;
+			uint32_t vertex_count = 0;
+			const uint32_t *indices = nullptr;
+			uint32_t index_count = 0;
+		};
+
+	private:
+		struct ClipVertex {
+			float x;
+			float y;
+			float z;
+			float w;
+			float depth; // View space distance, interpolated linearly in clip space.
+		};
+
+		// Edge functions and depth plane, evaluated at pixel centers in buffer space.
+		struct Triangle {
+			float edge_x[3];
+			float edge_y[3];
+			float edge_c[3];
+			float depth_x;
+			float depth_y;
+			float depth_c;
+			int min_x;
+			int min_y;
+			int max_x;
+			int max_y;
+		};
+
+		struct RasterThreadData {
+			uint32_t thread_count;
+			Geometry geometry;
+			Transform3D cam_inv_transform;
+			CameraMatrix cam_projection;
+			bool cam_orthogonal;
+		};
+
+		Size2i tile_grid_size;
+		uint32_t tile_count = 0;
+
+		LocalVector<ClipVertex> clip_vertices;
+		LocalVector<LocalVector<Triangle>> thread_triangles;
+		LocalVector<LocalVector<uint32_t>> thread_bins; // One bin per tile for each thread, indexing its triangles.
+
+		void _transform_vertices_threaded(uint32_t p_thread, const RasterThreadData *p_data);
+		void _setup_triangles_threaded(uint32_t p_thread, const RasterThreadData *p_data);
+		void _rasterize_tile_threaded(uint32_t p_tile, const RasterThreadData *p_data);
+
+		void _setup_triangle(uint32_t p_thread, const ClipVertex *p_vertices, bool p_orthogonal);
+
+	public:
+		RID scenario_rid;
+
+		virtual void clear() override;
+		virtual void resize(const Size2i &p_size) override;
+
+		void rasterize(const Geometry &p_geometry, const Transform3D &p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, ThreadWorkPool &p_thread_pool);
+		float get_depth(int p_x, int p_y) const;
+	};
+
+private:
+	struct InstanceID {
+		RID scenario;
+		RID instance;
+
+		bool operator<(const InstanceID &rhs) const {
+			if (instance == rhs.instance) {
+				return rhs.scenario < scenario;
+			}
+			return instance < rhs.instance;
+		}
+
+		InstanceID() {}
+		InstanceID(RID s, RID i) :
+				scenario(s), instance(i) {}
+	};
+
+	struct Occluder {
+		PackedVector3Array vertices;
+		PackedInt32Array indices;
+		Set<InstanceID> users;
+	};
+
+	struct OccluderInstance {
+		RID occluder;
+		Transform3D xform;
+		bool enabled = true;
+	};
+
+	// All enabled occluders of a scenario, already in world space and merged in a single mesh.
+	struct Scenario {
+		HashMap<RID, OccluderInstance> instances;
+		bool dirty = false;
+
+		LocalVector<Vector3> vertices;
+		LocalVector<uint32_t> indices;
+
+		void update(RasterOcclusionCull *p_owner);
+	};
+
+	RID_PtrOwner<Occluder> occluder_owner;
+	HashMap<RID, Scenario> scenarios;
+	HashMap<RID, RasterHZBuffer> buffers;
+
+	void _mark_occluder_users_dirty(Occluder *p_occluder);
+
+public:
+	virtual bool is_occluder(RID p_rid) override;
+	virtual RID occluder_allocate() override;
+	virtual void occluder_initialize(RID p_occluder) override;
+	virtual void occluder_set_mesh(RID p_occluder, const PackedVector3Array &p_vertices, const PackedInt32Array &p_indices) override;
+	virtual void free_occluder(RID p_occluder) override;
+
+	virtual void add_scenario(RID p_scenario) override;
+	virtual void remove_scenario(RID p_scenario) override;
+	virtual void scenario_set_instance(RID p_scenario, RID p_instance, RID p_occluder, const Transform3D &p_xform, bool p_enabled) override;
+	virtual void scenario_remove_instance(RID p_scenario, RID p_instance) override;
+
+	virtual void add_buffer(RID p_buffer) override;
+	virtual void remove_buffer(RID p_buffer) override;
+	virtual HZBuffer *buffer_get_ptr(RID p_buffer) override;
+	virtual void buffer_set_scenario(RID p_buffer, RID p_scenario) override;
+	virtual void buffer_set_size(RID p_buffer, const Vector2i &p_size) override;
+	virtual void buffer_update(RID p_buffer, const Transform3D &p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, ThreadWorkPool &p_thread_pool) override;
+	virtual RID buffer_get_debug_texture(RID p_buffer) override;
+};
+
+#endif // RENDERER_SCENE_OCCLUSION_CULL_RASTER_H
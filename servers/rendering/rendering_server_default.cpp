@@ -32,6 +32,7 @@
 
 #include "core/config/project_settings.h"
 #include "core/io/marshalls.h"
+#include "core/os/frame_arena.h"
 #include "core/os/os.h"
 #include "core/templates/sort_array.h"
 #include "renderer_canvas_cull.h"
@@ -251,6 +252,10 @@ uint64_t RenderingServerDefault::get_rendering_info(RenderingInfo p_info) {
 		return RSG::viewport->get_total_vertices_drawn();
 	} else if (p_info == RENDERING_INFO_TOTAL_DRAW_CALLS_IN_FRAME) {
 		return RSG::viewport->get_total_draw_calls_used();
+	} else if (p_info == RENDERING_INFO_SHADOW_CULL_CACHE_HITS_IN_FRAME || p_info == RENDERING_INFO_SHADOW_CULL_CACHE_MISSES_IN_FRAME || p_info == RENDERING_INFO_MESH_LOD_CHANGES_IN_FRAME || p_info == RENDERING_INFO_VISIBILITY_RANGE_CHANGES_IN_FRAME) {
+		return RSG::scene->get_rendering_info(p_info);
+	} else if (p_info == RENDERING_INFO_CANVAS_BATCHES_IN_FRAME || p_info == RENDERING_INFO_CANVAS_BATCHED_COMMANDS_IN_FRAME) {
+		return RSG::canvas_render->get_rendering_info(p_info);
 	}
 	return RSG::storage->get_rendering_info(p_info);
 }
@@ -330,6 +335,8 @@ void RenderingServerDefault::_thread_draw(bool p_swap_buffers, double frame_step
 	if (!draw_pending.decrement()) {
 		_draw(p_swap_buffers, frame_step);
 	}
+	// The main loop ends the frame of its own thread.
+	FrameArena::end_frame();
 }
 
 void RenderingServerDefault::_thread_flush() {
@@ -123,6 +123,7 @@ public:
 #endif
 
 #define WRITE_ACTION redraw_request();
+#define READ_ACTION
 
 #ifdef DEBUG_SYNC
 #define SYNC_DEBUG print_line("sync on: " + String(__FUNCTION__));
@@ -855,6 +856,7 @@ public:
 #undef server_name
 #undef ServerName
 #undef WRITE_ACTION
+#undef READ_ACTION
 #undef SYNC_DEBUG
 
 	/* FREE */
@@ -2713,6 +2713,12 @@ void RenderingServer::_bind_methods() {
 	BIND_ENUM_CONSTANT(RENDERING_INFO_TEXTURE_MEM_USED);
 	BIND_ENUM_CONSTANT(RENDERING_INFO_BUFFER_MEM_USED);
 	BIND_ENUM_CONSTANT(RENDERING_INFO_VIDEO_MEM_USED);
+	BIND_ENUM_CONSTANT(RENDERING_INFO_SHADOW_CULL_CACHE_HITS_IN_FRAME);
+	BIND_ENUM_CONSTANT(RENDERING_INFO_SHADOW_CULL_CACHE_MISSES_IN_FRAME);
+	BIND_ENUM_CONSTANT(RENDERING_INFO_CANVAS_BATCHES_IN_FRAME);
+	BIND_ENUM_CONSTANT(RENDERING_INFO_CANVAS_BATCHED_COMMANDS_IN_FRAME);
+	BIND_ENUM_CONSTANT(RENDERING_INFO_MESH_LOD_CHANGES_IN_FRAME);
+	BIND_ENUM_CONSTANT(RENDERING_INFO_VISIBILITY_RANGE_CHANGES_IN_FRAME);
 
 	BIND_ENUM_CONSTANT(FEATURE_SHADERS);
 	BIND_ENUM_CONSTANT(FEATURE_MULTITHREADED);
@@ -2797,12 +2803,19 @@ RenderingServer::RenderingServer() {
 	GLOBAL_DEF("rendering/shadows/directional_shadow/soft_shadow_quality.mobile", 0);
 	ProjectSettings::get_singleton()->set_custom_property_info("rendering/shadows/directional_shadow/soft_shadow_quality", PropertyInfo(Variant::INT, "rendering/shadows/directional_shadow/soft_shadow_quality", PROPERTY_HINT_ENUM, "Hard (Fastest),Soft Low (Fast),Soft Medium (Average),Soft High (Slow),Soft Ultra (Slowest)"));
 	GLOBAL_DEF("rendering/shadows/directional_shadow/16_bits", true);
+	GLOBAL_DEF("rendering/shadows/directional_shadow/cull_cache_margin", 0.05);
+	ProjectSettings::get_singleton()->set_custom_property_info("rendering/shadows/directional_shadow/cull_cache_margin", PropertyInfo(Variant::FLOAT, "rendering/shadows/directional_shadow/cull_cache_margin", PROPERTY_HINT_RANGE, "0,0.5,0.01"));
+	GLOBAL_DEF("rendering/mesh_lod/lod_change/hysteresis", 0.1);
+	ProjectSettings::get_singleton()->set_custom_property_info("rendering/mesh_lod/lod_change/hysteresis", PropertyInfo(Variant::FLOAT, "rendering/mesh_lod/lod_change/hysteresis", PROPERTY_HINT_RANGE, "0,0.5,0.01"));
 
 	GLOBAL_DEF("rendering/shadows/shadows/soft_shadow_quality", 2);
 	GLOBAL_DEF("rendering/shadows/shadows/soft_shadow_quality.mobile", 0);
 	ProjectSettings::get_singleton()->set_custom_property_info("rendering/shadows/shadows/soft_shadow_quality", PropertyInfo(Variant::INT, "rendering/shadows/shadows/soft_shadow_quality", PROPERTY_HINT_ENUM, "Hard (Fastest),Soft Low (Fast),Soft Medium (Average),Soft High (Slow),Soft Ultra (Slowest)"));
 
 	GLOBAL_DEF("rendering/2d/shadow_atlas/size", 2048);
+	GLOBAL_DEF("rendering/2d/cull/threaded_cull_minimum_items", 2000);
+	ProjectSettings::get_singleton()->set_custom_property_info("rendering/2d/cull/threaded_cull_minimum_items", PropertyInfo(Variant::INT, "rendering/2d/cull/threaded_cull_minimum_items", PROPERTY_HINT_RANGE, "128,1048576,1,or_greater"));
+	GLOBAL_DEF("rendering/2d/batching/enabled", true);
 
 	GLOBAL_DEF_RST_BASIC("rendering/vulkan/rendering/back_end", 0);
 	GLOBAL_DEF_RST_BASIC("rendering/vulkan/rendering/back_end.mobile", 1);
@@ -2891,6 +2904,7 @@ RenderingServer::RenderingServer() {
 	GLOBAL_DEF_RST("rendering/occlusion_culling/occlusion_rays_per_thread", 512);
 	GLOBAL_DEF_RST("rendering/occlusion_culling/bvh_build_quality", 2);
 	ProjectSettings::get_singleton()->set_custom_property_info("rendering/occlusion_culling/bvh_build_quality", PropertyInfo(Variant::INT, "rendering/occlusion_culling/bvh_build_quality", PROPERTY_HINT_ENUM, "Low,Medium,High"));
+	GLOBAL_DEF_RST("rendering/occlusion_culling/use_software_rasterizer", false);
 
 	GLOBAL_DEF("rendering/environment/glow/upscale_mode", 1);
 	ProjectSettings::get_singleton()->set_custom_property_info("rendering/environment/glow/upscale_mode", PropertyInfo(Variant::INT, "rendering/environment/glow/upscale_mode", PROPERTY_HINT_ENUM, "Linear (Fast),Bicubic (Slow)"));
@@ -2930,6 +2944,8 @@ RenderingServer::RenderingServer() {
 	ProjectSettings::get_singleton()->set_custom_property_info("rendering/limits/spatial_indexer/update_iterations_per_frame", PropertyInfo(Variant::INT, "rendering/limits/spatial_indexer/update_iterations_per_frame", PROPERTY_HINT_RANGE, "0,1024,1"));
 	GLOBAL_DEF("rendering/limits/spatial_indexer/threaded_cull_minimum_instances", 1000);
 	ProjectSettings::get_singleton()->set_custom_property_info("rendering/limits/spatial_indexer/threaded_cull_minimum_instances", PropertyInfo(Variant::INT, "rendering/limits/spatial_indexer/threaded_cull_minimum_instances", PROPERTY_HINT_RANGE, "32,65536,1"));
+	GLOBAL_DEF("rendering/limits/spatial_indexer/batch_update_minimum_instances", 128);
+	ProjectSettings::get_singleton()->set_custom_property_info("rendering/limits/spatial_indexer/batch_update_minimum_instances", PropertyInfo(Variant::INT, "rendering/limits/spatial_indexer/batch_update_minimum_instances", PROPERTY_HINT_RANGE, "1,65536,1"));
 	GLOBAL_DEF("rendering/limits/forward_renderer/threaded_render_minimum_instances", 500);
 	ProjectSettings::get_singleton()->set_custom_property_info("rendering/limits/forward_renderer/threaded_render_minimum_instances", PropertyInfo(Variant::INT, "rendering/limits/forward_renderer/threaded_render_minimum_instances", PROPERTY_HINT_RANGE, "32,65536,1"));
 
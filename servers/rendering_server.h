@@ -1428,6 +1428,12 @@ public:
 		RENDERING_INFO_TEXTURE_MEM_USED,
 		RENDERING_INFO_BUFFER_MEM_USED,
 		RENDERING_INFO_VIDEO_MEM_USED,
+		RENDERING_INFO_SHADOW_CULL_CACHE_HITS_IN_FRAME,
+		RENDERING_INFO_SHADOW_CULL_CACHE_MISSES_IN_FRAME,
+		RENDERING_INFO_CANVAS_BATCHES_IN_FRAME,
+		RENDERING_INFO_CANVAS_BATCHED_COMMANDS_IN_FRAME,
+		RENDERING_INFO_MESH_LOD_CHANGES_IN_FRAME,
+		RENDERING_INFO_VISIBILITY_RANGE_CHANGES_IN_FRAME,
 		RENDERING_INFO_MAX
 	};
 
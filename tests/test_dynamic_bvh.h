@@ -0,0 +1,208 @@
+/*************************************************************************/
+/*  test_dynamic_bvh.h                                                   */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_DYNAMIC_BVH_H
+#define TEST_DYNAMIC_BVH_H
+
+#include "core/math/dynamic_bvh.h"
+#include "core/math/random_pcg.h"
+#include "core/os/os.h"
+#include "core/templates/thread_work_pool.h"
+
+#include "tests/test_macros.h"
+
+namespace TestDynamicBVH {
+
+struct CountQueryResult {
+	uint32_t count = 0;
+
+	_FORCE_INLINE_ bool operator()(void *p_data) {
+		count++;
+		return false;
+	}
+};
+
+struct CollectQueryResult {
+	LocalVector<uint32_t> indices;
+
+	_FORCE_INLINE_ bool operator()(void *p_data) {
+		indices.push_back((uint32_t)(uintptr_t)p_data - 1);
+		return false;
+	}
+};
+
+static AABB random_box(RandomPCG &p_rng, real_t p_range) {
+	return AABB(Vector3(p_rng.randf(), p_rng.randf(), p_rng.randf()) * p_range, Vector3(1, 1, 1));
+}
+
+static void check_queries(DynamicBVH &p_bvh, const LocalVector<AABB> &p_boxes, RandomPCG &p_rng, real_t p_range) {
+	for (int i = 0; i < 20; i++) {
+		AABB query = AABB(Vector3(p_rng.randf(), p_rng.randf(), p_rng.randf()) * p_range, Vector3(10, 10, 10));
+
+		CollectQueryResult result;
+		p_bvh.aabb_query(query, result);
+		result.indices.sort();
+
+		LocalVector<uint32_t> expected;
+		for (uint32_t j = 0; j < p_boxes.size(); j++) {
+			if (p_boxes[j].intersects_inclusive(query)) {
+				expected.push_back(j);
+			}
+		}
+
+		bool matches = result.indices.size() == expected.size();
+		for (uint32_t j = 0; matches && j < expected.size(); j++) {
+			matches = result.indices[j] == expected[j];
+		}
+		CHECK_MESSAGE(matches, "Queries after a batch update should find exactly the intersecting leaves.");
+	}
+}
+
+TEST_CASE("[DynamicBVH] Batch update") {
+	const uint32_t leaf_count = 4000;
+	const real_t range = 100;
+
+	ThreadWorkPool thread_pool;
+	thread_pool.init();
+
+	RandomPCG rng(1234);
+	DynamicBVH bvh;
+	LocalVector<DynamicBVH::ID> ids;
+	LocalVector<AABB> boxes;
+
+	for (uint32_t i = 0; i < leaf_count; i++) {
+		boxes.push_back(random_box(rng, range));
+		ids.push_back(bvh.insert(boxes[i], (void *)(uintptr_t)(i + 1)));
+	}
+
+	SUBCASE("Small moves are refit in place") {
+		for (uint32_t i = 0; i < leaf_count; i++) {
+			boxes[i].position += Vector3(rng.randf() - 0.5, rng.randf() - 0.5, rng.randf() - 0.5) * 0.5;
+		}
+		bvh.batch_update(ids.ptr(), boxes.ptr(), leaf_count, &thread_pool);
+		check_queries(bvh, boxes, rng, range);
+	}
+
+	SUBCASE("Large moves reinsert leaves") {
+		for (uint32_t i = 0; i < leaf_count; i += 2) {
+			boxes[i] = random_box(rng, range);
+		}
+		bvh.batch_update(ids.ptr(), boxes.ptr(), leaf_count, &thread_pool);
+		check_queries(bvh, boxes, rng, range);
+		CHECK(bvh.get_leaf_count() == (int)leaf_count);
+	}
+
+	SUBCASE("Without a thread pool") {
+		for (uint32_t i = 0; i < 100; i++) {
+			boxes[i].position += Vector3(0.25, 0, 0);
+		}
+		bvh.batch_update(ids.ptr(), boxes.ptr(), 100);
+		check_queries(bvh, boxes, rng, range);
+	}
+
+	thread_pool.finish();
+}
+
+// Moves the first p_moving_count leaves for a few frames, returns how many leaves a fixed query finds afterwards.
+static uint32_t move_leaves(uint32_t p_leaf_count, uint32_t p_moving_count, uint32_t p_frame_count, real_t p_range, ThreadWorkPool *p_thread_pool, uint64_t *r_usec) {
+	RandomPCG rng(1234);
+	DynamicBVH bvh;
+	LocalVector<DynamicBVH::ID> ids;
+	LocalVector<AABB> boxes;
+
+	for (uint32_t i = 0; i < p_leaf_count; i++) {
+		boxes.push_back(random_box(rng, p_range));
+		ids.push_back(bvh.insert(boxes[i], (void *)(uintptr_t)(i + 1)));
+	}
+
+	*r_usec = 0;
+	for (uint32_t frame = 0; frame < p_frame_count; frame++) {
+		// Crowd-like motion, every moving leaf takes a small step.
+		for (uint32_t i = 0; i < p_moving_count; i++) {
+			boxes[i].position += Vector3(rng.randf() - 0.5, 0, rng.randf() - 0.5);
+		}
+
+		uint64_t time = OS::get_singleton()->get_ticks_usec();
+		if (p_thread_pool) {
+			bvh.batch_update(ids.ptr(), boxes.ptr(), p_moving_count, p_thread_pool);
+		} else {
+			for (uint32_t i = 0; i < p_moving_count; i++) {
+				bvh.update(ids[i], boxes[i]);
+			}
+		}
+		*r_usec += OS::get_singleton()->get_ticks_usec() - time;
+	}
+
+	CountQueryResult result;
+	bvh.aabb_query(AABB(Vector3(), Vector3(p_range, p_range, p_range) * 0.5), result);
+	return result.count;
+}
+
+TEST_CASE("[DynamicBVH] Batch and one by one updates agree") {
+	ThreadWorkPool thread_pool;
+	thread_pool.init();
+
+	const uint32_t moving_counts[] = { 20, 200, 2000 };
+	for (uint32_t moving_count : moving_counts) {
+		uint64_t usec = 0;
+		uint32_t one_by_one_hits = move_leaves(2000, moving_count, 5, 100, nullptr, &usec);
+		uint32_t batched_hits = move_leaves(2000, moving_count, 5, 100, &thread_pool, &usec);
+		CHECK_MESSAGE(one_by_one_hits == batched_hits, "Both update paths should leave the same leaves in the tree.");
+	}
+
+	thread_pool.finish();
+}
+
+void benchmark() {
+	const uint32_t leaf_count = 20000;
+	const uint32_t frame_count = 10;
+	const real_t range = 500;
+	const uint32_t moving_counts[] = { 200, 2000, 20000 };
+
+	ThreadWorkPool thread_pool;
+	thread_pool.init();
+
+	for (uint32_t moving_count : moving_counts) {
+		uint64_t one_by_one_usec = 0;
+		uint64_t batched_usec = 0;
+		uint32_t one_by_one_hits = move_leaves(leaf_count, moving_count, frame_count, range, nullptr, &one_by_one_usec);
+		uint32_t batched_hits = move_leaves(leaf_count, moving_count, frame_count, range, &thread_pool, &batched_usec);
+		ERR_CONTINUE_MSG(one_by_one_hits != batched_hits, "Both update paths should leave the same leaves in the tree.");
+
+		print_line(vformat("DynamicBVH with %d leaves, %d moving per frame: %d usec per frame updating one by one, %d usec batched.",
+				leaf_count, moving_count, one_by_one_usec / frame_count, batched_usec / frame_count));
+	}
+
+	thread_pool.finish();
+}
+
+} // namespace TestDynamicBVH
+
+#endif // TEST_DYNAMIC_BVH_H
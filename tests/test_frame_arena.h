@@ -0,0 +1,187 @@
+/*************************************************************************/
+/*  test_frame_arena.h                                                   */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_FRAME_ARENA_H
+#define TEST_FRAME_ARENA_H
+
+#include "core/os/frame_arena.h"
+#include "core/os/os.h"
+#include "core/templates/local_vector.h"
+
+#include "tests/test_macros.h"
+
+namespace TestFrameArena {
+
+TEST_CASE("[FrameArena] Allocate, grow and free") {
+	FrameArena::end_frame();
+	CHECK(FrameArena::get_used_bytes() == 0);
+
+	uint8_t *first = (uint8_t *)FrameArena::alloc(10);
+	uint8_t *second = (uint8_t *)FrameArena::alloc(100);
+	REQUIRE(first != nullptr);
+	REQUIRE(second != nullptr);
+	CHECK(((uintptr_t)first & 15) == 0);
+	CHECK(((uintptr_t)second & 15) == 0);
+	CHECK(second >= first + 10);
+	memset(second, 0xAB, 100);
+
+	CHECK_MESSAGE(FrameArena::realloc(second, 1000) == second, "The last allocation should grow in place.");
+	CHECK(second[99] == 0xAB);
+
+	uint8_t *moved = (uint8_t *)FrameArena::realloc(first, 1000);
+	CHECK_MESSAGE(moved != first, "Other allocations should move when growing.");
+	CHECK(FrameArena::realloc(moved, 10) == moved);
+
+	size_t used = FrameArena::get_used_bytes();
+	FrameArena::free(moved);
+	CHECK_MESSAGE(FrameArena::get_used_bytes() < used, "Freeing the last allocation should give its memory back.");
+
+	FrameArena::free(second);
+	CHECK_MESSAGE(FrameArena::get_used_bytes() == 0, "The arena should rewind once everything is freed.");
+}
+
+TEST_CASE("[FrameArena] LocalVector") {
+	FrameArena::end_frame();
+	LocalVector<int, uint32_t, false, FrameArena> numbers;
+	LocalVector<String, uint32_t, false, FrameArena> strings;
+	for (int i = 0; i < 10000; i++) {
+		numbers.push_back(i);
+		if (i % 100 == 0) {
+			strings.push_back(itos(i));
+		}
+	}
+	CHECK(numbers.size() == 10000);
+	CHECK(numbers[9999] == 9999);
+	CHECK(strings.size() == 100);
+	CHECK(strings[99] == "9900");
+
+	numbers.reset();
+	strings.reset();
+	CHECK(FrameArena::get_used_bytes() == 0);
+}
+
+TEST_CASE("[FrameArena] Ending frames") {
+	FrameArena::end_frame();
+	uint64_t blocks = FrameArena::get_block_allocation_count();
+
+	// Needs several blocks.
+	for (int i = 0; i < 64; i++) {
+		FrameArena::alloc(10000);
+	}
+	FrameArena::end_frame();
+	CHECK(FrameArena::get_used_bytes() == 0);
+
+	uint64_t merged_blocks = FrameArena::get_block_allocation_count();
+	CHECK(merged_blocks > blocks);
+	for (int i = 0; i < 64; i++) {
+		FrameArena::alloc(10000);
+	}
+	FrameArena::end_frame();
+	CHECK_MESSAGE(FrameArena::get_block_allocation_count() == merged_blocks, "The blocks should have been merged into one large enough for a whole frame.");
+}
+
+// Counts the heap allocations made by the containers.
+struct CountingAllocator {
+	static uint64_t count;
+	static void *alloc(size_t p_memory) {
+		count++;
+		return DefaultAllocator::alloc(p_memory);
+	}
+	static void *realloc(void *p_ptr, size_t p_memory) {
+		count++;
+		return DefaultAllocator::realloc(p_ptr, p_memory);
+	}
+	static void free(void *p_ptr) {
+		DefaultAllocator::free(p_ptr);
+	}
+};
+
+uint64_t CountingAllocator::count = 0;
+
+// Like a culling pass, a temporary list per visited node.
+template <class A>
+static uint64_t simulate_frame(int p_nodes) {
+	uint64_t sum = 0;
+	for (int i = 0; i < p_nodes; i++) {
+		LocalVector<uint32_t, uint32_t, false, A> visible;
+		for (int j = 0; j < 100; j++) {
+			if ((i + j) % 3) {
+				visible.push_back(j);
+			}
+		}
+		for (uint32_t j = 0; j < visible.size(); j++) {
+			sum += visible[j];
+		}
+	}
+	return sum;
+}
+
+TEST_CASE("[FrameArena] Per-frame temporaries") {
+	FrameArena::end_frame();
+	CountingAllocator::count = 0;
+	uint64_t heap_sum = simulate_frame<CountingAllocator>(100);
+
+	uint64_t blocks = FrameArena::get_block_allocation_count();
+	uint64_t arena_sum = simulate_frame<FrameArena>(100);
+	FrameArena::end_frame();
+
+	CHECK(arena_sum == heap_sum);
+	CHECK_MESSAGE(FrameArena::get_block_allocation_count() - blocks < CountingAllocator::count, "Temporaries should come out of the arena's blocks rather than the heap.");
+}
+
+void benchmark() {
+	const int frames = 100;
+	const int nodes = 1000;
+
+	FrameArena::end_frame();
+	CountingAllocator::count = 0;
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < frames; i++) {
+		simulate_frame<CountingAllocator>(nodes);
+	}
+	uint64_t heap_usec = OS::get_singleton()->get_ticks_usec() - begin;
+	uint64_t heap_allocations = CountingAllocator::count;
+
+	uint64_t blocks = FrameArena::get_block_allocation_count();
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < frames; i++) {
+		simulate_frame<FrameArena>(nodes);
+		FrameArena::end_frame();
+	}
+	uint64_t arena_usec = OS::get_singleton()->get_ticks_usec() - begin;
+	uint64_t arena_allocations = FrameArena::get_block_allocation_count() - blocks;
+
+	print_line(vformat("%d frames of %d temporary lists: ", frames, nodes) +
+			vformat("heap %d usec with %d allocations, frame arena %d usec with %d allocations.", heap_usec, heap_allocations, arena_usec, arena_allocations));
+}
+
+} // namespace TestFrameArena
+
+#endif // TEST_FRAME_ARENA_H
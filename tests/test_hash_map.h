@@ -0,0 +1,339 @@
+/*************************************************************************/
+/*  test_hash_map.h                                                      */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_HASH_MAP_H
+#define TEST_HASH_MAP_H
+
+#include "core/os/os.h"
+#include "core/string/string_name.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/map.h"
+#include "core/templates/oa_hash_map.h"
+#include "core/templates/rid.h"
+
+#include "tests/test_macros.h"
+
+namespace TestHashMap {
+
+// Everything in the same run of slots.
+struct CollidingHasher {
+	static _FORCE_INLINE_ uint32_t hash(const int p_int) { return 7; }
+};
+
+TEST_CASE("[HashMap] Set, get and erase") {
+	HashMap<int, int> map;
+	CHECK(map.is_empty());
+	CHECK(map.getptr(1) == nullptr);
+	CHECK_FALSE(map.erase(1));
+
+	map.set(1, 10);
+	map[2] = 20;
+	CHECK(map.size() == 2);
+	CHECK(map.has(1));
+	CHECK(map.get(2) == 20);
+
+	map.set(1, 11);
+	CHECK(map.size() == 2);
+	CHECK(map[1] == 11);
+
+	CHECK(map.erase(1));
+	CHECK_FALSE(map.has(1));
+	CHECK(map.has(2));
+	CHECK(map.size() == 1);
+
+	map.clear();
+	CHECK(map.is_empty());
+	CHECK_FALSE(map.has(2));
+}
+
+TEST_CASE("[HashMap] Iteration follows insertion order") {
+	HashMap<int, int> map;
+	for (int i = 0; i < 1000; i++) {
+		map.set((i * 7919) % 1000, i);
+	}
+	for (int i = 0; i < 1000; i += 3) {
+		map.erase((i * 7919) % 1000);
+	}
+	map.set(5000, 0);
+
+	Vector<int> expected;
+	for (int i = 0; i < 1000; i++) {
+		if (i % 3) {
+			expected.push_back((i * 7919) % 1000);
+		}
+	}
+	expected.push_back(5000);
+
+	Vector<int> keys;
+	const int *k = nullptr;
+	while ((k = map.next(k))) {
+		keys.push_back(*k);
+	}
+	CHECK(keys == expected);
+
+	keys.clear();
+	for (HashMap<int, int>::Element *E = map.front(); E; E = E->next()) {
+		keys.push_back(E->key());
+	}
+	CHECK(keys == expected);
+
+	List<int> key_list;
+	map.get_key_list(&key_list);
+	CHECK(key_list.size() == expected.size());
+	CHECK(key_list.front()->get() == expected[0]);
+	CHECK(key_list.back()->get() == 5000);
+}
+
+TEST_CASE("[HashMap] Pointers stay valid while the table grows") {
+	HashMap<int, int> map;
+	int *first = &map[0];
+	*first = 42;
+	for (int i = 1; i < 10000; i++) {
+		map.set(i, i);
+	}
+	for (int i = 1; i < 10000; i += 2) {
+		map.erase(i);
+	}
+	CHECK(first == map.getptr(0));
+	CHECK(*first == 42);
+}
+
+TEST_CASE("[HashMap] Colliding hashes") {
+	HashMap<int, int, CollidingHasher> map;
+	for (int i = 0; i < 100; i++) {
+		map.set(i, i * 2);
+	}
+	for (int i = 0; i < 100; i += 2) {
+		CHECK(map.erase(i));
+	}
+
+	bool all_found = true;
+	for (int i = 0; i < 100; i++) {
+		const int *value = map.getptr(i);
+		all_found = all_found && ((i % 2) ? (value && *value == i * 2) : value == nullptr);
+	}
+	CHECK(all_found);
+	CHECK(map.size() == 50);
+}
+
+TEST_CASE("[HashMap] Copy and custom lookup") {
+	HashMap<String, int> map;
+	map["one"] = 1;
+	map["two"] = 2;
+
+	HashMap<String, int> copy = map;
+	copy["three"] = 3;
+	CHECK(map.size() == 2);
+	CHECK(copy.size() == 3);
+	CHECK(*copy.next(nullptr) == "one");
+
+	const char *key = "two";
+	const int *value = map.custom_getptr(key, String(key).hash());
+	REQUIRE(value);
+	CHECK(*value == 2);
+
+	map = copy;
+	CHECK(map.size() == 3);
+	CHECK(map["three"] == 3);
+}
+
+template <class K>
+static Vector<K> make_keys(int p_count);
+
+template <>
+Vector<int> make_keys<int>(int p_count) {
+	Vector<int> keys;
+	for (int i = 0; i < p_count; i++) {
+		keys.push_back(i * 16); // Aligned, like offsets or IDs often are.
+	}
+	return keys;
+}
+
+template <>
+Vector<StringName> make_keys<StringName>(int p_count) {
+	Vector<StringName> keys;
+	for (int i = 0; i < p_count; i++) {
+		keys.push_back(StringName("key_" + itos(i)));
+	}
+	return keys;
+}
+
+template <>
+Vector<RID> make_keys<RID>(int p_count) {
+	Vector<RID> keys;
+	for (int i = 0; i < p_count; i++) {
+		keys.push_back(RID::from_uint64((uint64_t(i * 7 + 1) << 32) | i)); // Slot index in the lower bits, validator in the upper ones, like RID_Owner.
+	}
+	return keys;
+}
+
+struct BenchmarkTimes {
+	uint64_t insert = 0;
+	uint64_t lookup = 0;
+	uint64_t iterate = 0;
+	uint64_t erase = 0;
+};
+
+template <class K>
+static BenchmarkTimes benchmark_hash_map(const Vector<K> &p_keys, const Vector<int> &p_order) {
+	BenchmarkTimes times;
+	HashMap<K, int> map;
+	int sum = 0;
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < p_keys.size(); i++) {
+		map.set(p_keys[i], i);
+	}
+	times.insert = OS::get_singleton()->get_ticks_usec() - begin;
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < p_order.size(); i++) {
+		sum += *map.getptr(p_keys[p_order[i]]);
+	}
+	times.lookup = OS::get_singleton()->get_ticks_usec() - begin;
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (typename HashMap<K, int>::Element *E = map.front(); E; E = E->next()) {
+		sum += E->value();
+	}
+	times.iterate = OS::get_singleton()->get_ticks_usec() - begin;
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < p_order.size(); i++) {
+		map.erase(p_keys[p_order[i]]);
+	}
+	times.erase = OS::get_singleton()->get_ticks_usec() - begin;
+
+	ERR_FAIL_COND_V(!map.is_empty() || sum == 0, times);
+	return times;
+}
+
+template <class K>
+static BenchmarkTimes benchmark_oa_hash_map(const Vector<K> &p_keys, const Vector<int> &p_order) {
+	BenchmarkTimes times;
+	OAHashMap<K, int> map;
+	int sum = 0;
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < p_keys.size(); i++) {
+		map.set(p_keys[i], i);
+	}
+	times.insert = OS::get_singleton()->get_ticks_usec() - begin;
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < p_order.size(); i++) {
+		sum += *map.lookup_ptr(p_keys[p_order[i]]);
+	}
+	times.lookup = OS::get_singleton()->get_ticks_usec() - begin;
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (typename OAHashMap<K, int>::Iterator it = map.iter(); it.valid; it = map.next_iter(it)) {
+		sum += *it.value;
+	}
+	times.iterate = OS::get_singleton()->get_ticks_usec() - begin;
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < p_order.size(); i++) {
+		map.remove(p_keys[p_order[i]]);
+	}
+	times.erase = OS::get_singleton()->get_ticks_usec() - begin;
+
+	ERR_FAIL_COND_V(!map.is_empty() || sum == 0, times);
+	return times;
+}
+
+template <class K>
+static BenchmarkTimes benchmark_map(const Vector<K> &p_keys, const Vector<int> &p_order) {
+	BenchmarkTimes times;
+	Map<K, int> map;
+	int sum = 0;
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < p_keys.size(); i++) {
+		map.insert(p_keys[i], i);
+	}
+	times.insert = OS::get_singleton()->get_ticks_usec() - begin;
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < p_order.size(); i++) {
+		sum += map.find(p_keys[p_order[i]])->get();
+	}
+	times.lookup = OS::get_singleton()->get_ticks_usec() - begin;
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (typename Map<K, int>::Element *E = map.front(); E; E = E->next()) {
+		sum += E->get();
+	}
+	times.iterate = OS::get_singleton()->get_ticks_usec() - begin;
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < p_order.size(); i++) {
+		map.erase(p_keys[p_order[i]]);
+	}
+	times.erase = OS::get_singleton()->get_ticks_usec() - begin;
+
+	ERR_FAIL_COND_V(!map.is_empty() || sum == 0, times);
+	return times;
+}
+
+static void print_benchmark(const String &p_name, const BenchmarkTimes &p_times) {
+	String result = vformat("%s: insert %d usec, lookup %d usec, iterate %d usec, erase %d usec.", p_name, p_times.insert, p_times.lookup, p_times.iterate, p_times.erase);
+	print_line(result);
+}
+
+template <class K>
+static void run_benchmarks(const String &p_key_type) {
+	const int count = 100000;
+	Vector<K> keys = make_keys<K>(count);
+
+	// Look up and erase in an order unrelated to insertion.
+	Vector<int> order;
+	order.resize(count);
+	for (int i = 0; i < count; i++) {
+		order.write[i] = i;
+	}
+	for (int i = count - 1; i > 0; i--) {
+		SWAP(order.write[i], order.write[(i * 2654435761u) % (i + 1)]);
+	}
+
+	print_benchmark(vformat("HashMap<%s> x%d", p_key_type, count), benchmark_hash_map(keys, order));
+	print_benchmark(vformat("OAHashMap<%s> x%d", p_key_type, count), benchmark_oa_hash_map(keys, order));
+	print_benchmark(vformat("Map<%s> x%d", p_key_type, count), benchmark_map(keys, order));
+}
+
+void benchmark() {
+	run_benchmarks<int>("int");
+	run_benchmarks<StringName>("StringName");
+	run_benchmarks<RID>("RID");
+}
+
+} // namespace TestHashMap
+
+#endif // TEST_HASH_MAP_H
@@ -32,6 +32,7 @@
 #define TEST_JSON_H
 
 #include "core/io/json.h"
+#include "core/os/os.h"
 
 #include "thirdparty/doctest/doctest.h"
 
@@ -146,6 +147,144 @@ TEST_CASE("[JSON] Parsing objects (dictionaries)") {
 			dictionary["empty_object"].hash() == Dictionary().hash(),
 			"The parsed JSON should contain the expected values.");
 }
+
+// Records the events as text, to check their order.
+class JSONEventRecorder : public JSON::Handler {
+public:
+	String events;
+	int value_limit = -1;
+
+	virtual Error begin_object() override {
+		events += "{";
+		return OK;
+	}
+	virtual Error end_object() override {
+		events += "}";
+		return OK;
+	}
+	virtual Error begin_array() override {
+		events += "[";
+		return OK;
+	}
+	virtual Error end_array() override {
+		events += "]";
+		return OK;
+	}
+	virtual Error key(const String &p_key) override {
+		events += p_key + "=";
+		return OK;
+	}
+	virtual Error value(const Variant &p_value) override {
+		if (value_limit == 0) {
+			return ERR_SKIP;
+		}
+		value_limit--;
+		events += String(p_value) + ";";
+		return OK;
+	}
+};
+
+TEST_CASE("[JSON] Parsing events") {
+	JSONEventRecorder recorder;
+	String err_str;
+	int err_line = 0;
+
+	Error err = JSON::parse_events(R"({"name": "Godot", "list": [1, true, null, {}], "nested": {"a": []}})", &recorder, err_str, err_line);
+	CHECK(err == OK);
+	CHECK_MESSAGE(
+			recorder.events == "{name=Godot;list=[1;true;null;{}]nested={a=[]}}",
+			"The events should follow the document.");
+
+	recorder.events = "";
+	err = JSON::parse_events("[1,\n2\n", &recorder, err_str, err_line);
+	CHECK(err == ERR_PARSE_ERROR);
+	CHECK(err_str == "Expected ','");
+	CHECK(err_line == 2);
+
+	recorder.events = "";
+	recorder.value_limit = 2;
+	err = JSON::parse_events("[1, 2, 3, 4]", &recorder, err_str, err_line);
+	CHECK_MESSAGE(err == ERR_SKIP, "Errors returned by the handler should stop parsing.");
+	CHECK(recorder.events == "[1;2;");
+}
+
+TEST_CASE("[JSON] Stringify into a buffer") {
+	JSON json;
+	json.parse(R"({"name": "Godot \"Engine\"\n", "list": [1, 2.5, true, null, {"\u00e9t\u00e9": "\ud83c\udfa4"}], "empty": []})");
+	REQUIRE(json.get_error_line() == 0);
+
+	Vector<uint8_t> buffer;
+	for (const String &indent : { String(), String("\t") }) {
+		String text = json.stringify(json.get_data(), indent);
+		int length = JSON::stringify_utf8(json.get_data(), buffer, indent);
+		CHECK_MESSAGE(
+				String::utf8((const char *)buffer.ptr(), length) == text,
+				"Both writers should produce the same document.");
+
+		JSON reparsed;
+		CHECK(reparsed.parse(text) == OK);
+		CHECK(reparsed.stringify(reparsed.get_data(), indent) == text);
+	}
+
+	// Large enough already, the buffer is reused as is.
+	const uint8_t *data = buffer.ptr();
+	JSON::stringify_utf8(json.get_data(), buffer);
+	CHECK(buffer.ptr() == data);
+}
+
+void benchmark() {
+	Array root;
+	for (int i = 0; i < 20000; i++) {
+		Dictionary item;
+		item["name"] = "node_" + itos(i);
+		Array position;
+		position.push_back(1.5 * i);
+		position.push_back(-2.25);
+		position.push_back(3);
+		item["position"] = position;
+		item["visible"] = i % 2 == 0;
+		item["text"] = "Line with \"quotes\",\n\ta tab and a newline.";
+		root.push_back(item);
+	}
+
+	JSON json;
+	const String text = json.stringify(root, "\t");
+	Vector<uint8_t> buffer;
+	String err_str;
+	int err_line = 0;
+
+	// Best of the rounds, so the numbers don't depend on what else the machine is doing.
+	const int rounds = 5;
+	uint64_t best_usec[4] = { UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX };
+	for (int i = 0; i < rounds; i++) {
+		uint64_t time = OS::get_singleton()->get_ticks_usec();
+		Error err = json.parse(text);
+		uint64_t after_parse = OS::get_singleton()->get_ticks_usec();
+		// Only counting values, the recorder would mostly measure string concatenation.
+		JSON::Handler counter;
+		Error events_err = JSON::parse_events(text, &counter, err_str, err_line);
+		uint64_t after_events = OS::get_singleton()->get_ticks_usec();
+		String stringified = json.stringify(json.get_data(), "\t");
+		uint64_t after_stringify = OS::get_singleton()->get_ticks_usec();
+		int length = JSON::stringify_utf8(json.get_data(), buffer, "\t");
+		uint64_t after_stringify_utf8 = OS::get_singleton()->get_ticks_usec();
+
+		best_usec[0] = MIN(best_usec[0], after_parse - time);
+		best_usec[1] = MIN(best_usec[1], after_events - after_parse);
+		best_usec[2] = MIN(best_usec[2], after_stringify - after_events);
+		best_usec[3] = MIN(best_usec[3], after_stringify_utf8 - after_stringify);
+
+		if (i == 0) {
+			ERR_FAIL_COND(err != OK || events_err != OK);
+			ERR_FAIL_COND(stringified != text || length != text.utf8().length());
+		}
+	}
+
+	String result = vformat("JSON document of %d characters: parse %d usec, parse_events %d usec, ",
+			text.length(), best_usec[0], best_usec[1]);
+	result += vformat("stringify %d usec, stringify_utf8 %d usec.", best_usec[2], best_usec[3]);
+	print_line(result);
+}
 } // namespace TestJSON
 
 #endif // TEST_JSON_H
@@ -44,12 +44,15 @@
 #include "test_crypto.h"
 #include "test_curve.h"
 #include "test_dictionary.h"
+#include "test_dynamic_bvh.h"
 #include "test_expression.h"
 #include "test_file_access.h"
+#include "test_frame_arena.h"
 #include "test_geometry_2d.h"
 #include "test_geometry_3d.h"
 #include "test_gradient.h"
 #include "test_gui.h"
+#include "test_hash_map.h"
 #include "test_hashing_context.h"
 #include "test_image.h"
 #include "test_json.h"
@@ -57,6 +60,7 @@
 #include "test_local_vector.h"
 #include "test_lru.h"
 #include "test_marshalls.h"
+#include "test_message_queue.h"
 #include "test_math.h"
 #include "test_method_bind.h"
 #include "test_node_path.h"
@@ -64,17 +68,27 @@
 #include "test_object.h"
 #include "test_ordered_hash_map.h"
 #include "test_paged_array.h"
+#include "test_paged_node_allocator.h"
 #include "test_path_3d.h"
 #include "test_pck_packer.h"
 #include "test_physics_2d.h"
 #include "test_physics_3d.h"
+#include "test_physics_server_3d_wrap_mt.h"
 #include "test_random_number_generator.h"
 #include "test_rect2.h"
 #include "test_render.h"
+#include "test_renderer_canvas_batcher.h"
+#include "test_renderer_canvas_cull.h"
+#include "test_renderer_scene_cull.h"
+#include "test_renderer_scene_occlusion_cull_raster.h"
 #include "test_resource.h"
+#include "test_shader_cache_rd.h"
 #include "test_shader_lang.h"
+#include "test_shader_rd.h"
+#include "test_static_batch_3d.h"
 #include "test_string.h"
 #include "test_text_server.h"
+#include "test_thread_cache_allocator.h"
 #include "test_time.h"
 #include "test_translation.h"
 #include "test_validate_testing.h"
@@ -86,6 +100,29 @@
 
 #include "tests/test_macros.h"
 
+REGISTER_TEST_COMMAND("dynamic-bvh-benchmark", &TestDynamicBVH::benchmark);
+REGISTER_TEST_COMMAND("frame-arena-benchmark", &TestFrameArena::benchmark);
+REGISTER_TEST_COMMAND("hash-map-benchmark", &TestHashMap::benchmark);
+REGISTER_TEST_COMMAND("json-benchmark", &TestJSON::benchmark);
+REGISTER_TEST_COMMAND("marshalls-compact-encoding-benchmark", &TestMarshalls::benchmark);
+REGISTER_TEST_COMMAND("message-queue-benchmark", &TestMessageQueue::benchmark);
+REGISTER_TEST_COMMAND("object-signal-emission-benchmark", &TestObject::benchmark_signal_emission);
+REGISTER_TEST_COMMAND("paged-node-allocator-benchmark", &TestPagedNodeAllocator::benchmark);
+REGISTER_TEST_COMMAND("physics-2d-benchmark", &TestPhysics2D::benchmark);
+REGISTER_TEST_COMMAND("physics-3d-ccd-benchmark", &TestPhysics3D::benchmark_ccd);
+#if !defined(NO_THREADS)
+REGISTER_TEST_COMMAND("physics-server-3d-wrap-mt-benchmark", &TestPhysicsServer3DWrapMT::benchmark);
+#endif
+REGISTER_TEST_COMMAND("renderer-canvas-batcher-benchmark", &TestRendererCanvasBatcher::benchmark);
+REGISTER_TEST_COMMAND("renderer-canvas-cull-benchmark", &TestRendererCanvasCull::benchmark);
+REGISTER_TEST_COMMAND("renderer-scene-cull-benchmark", &TestRendererSceneCull::benchmark);
+REGISTER_TEST_COMMAND("shader-rd-benchmark", &TestShaderRD::benchmark);
+REGISTER_TEST_COMMAND("static-batch-3d-benchmark", &TestStaticBatch3D::benchmark);
+REGISTER_TEST_COMMAND("string-allocation-benchmark", &TestString::benchmark_allocations);
+REGISTER_TEST_COMMAND("string-transcoding-benchmark", &TestString::benchmark_transcoding);
+REGISTER_TEST_COMMAND("thread-cache-allocator-benchmark", &TestThreadCacheAllocator::benchmark);
+REGISTER_TEST_COMMAND("vector-allocation-benchmark", &TestVector::benchmark_allocations);
+
 int test_main(int argc, char *argv[]) {
 	bool run_tests = true;
 
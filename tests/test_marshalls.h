@@ -32,6 +32,8 @@
 #define TEST_MARSHALLS_H
 
 #include "core/io/marshalls.h"
+#include "core/math/random_pcg.h"
+#include "core/os/os.h"
 
 #include "tests/test_macros.h"
 
@@ -324,6 +326,283 @@ TEST_CASE("[Marshalls] FLOAT double precision Variant decoding") {
 	CHECK(r_len == 12);
 	CHECK(variant == Variant(0.33333333333333333));
 }
+
+TEST_CASE("[Marshalls] Compact Variant encoding") {
+	Vector<uint8_t> buffer;
+	Variant variant;
+	int r_len;
+
+	CHECK(encode_variant_compact(Variant(), buffer) == OK);
+	CHECK(buffer.size() == 1);
+
+	CHECK(encode_variant_compact(-3, buffer) == OK);
+	CHECK_MESSAGE(buffer.size() == 2, "Small integers should fit in one byte after the tag.");
+	CHECK(decode_variant_compact(variant, buffer.ptr(), buffer.size(), &r_len) == OK);
+	CHECK(r_len == 2);
+	CHECK(variant == Variant(-3));
+
+	CHECK(encode_variant_compact(0.5, buffer) == OK);
+	CHECK_MESSAGE(buffer.size() == 5, "Floats that are exact in single precision should be stored as such.");
+	CHECK(encode_variant_compact(0.1, buffer) == OK);
+	CHECK(buffer.size() == 9);
+	CHECK(decode_variant_compact(variant, buffer.ptr(), buffer.size(), &r_len) == OK);
+	CHECK(variant == Variant(0.1));
+
+	Array array;
+	for (int i = 0; i < 10; i++) {
+		array.push_back("position");
+	}
+	CHECK(encode_variant_compact(array, buffer) == OK);
+	// Tag and count, the first string in full, then one tag and one index byte per repeat.
+	CHECK_MESSAGE(buffer.size() == 2 + 10 + 9 * 2, "Repeated strings should be written once.");
+	CHECK(decode_variant_compact(variant, buffer.ptr(), buffer.size(), &r_len) == OK);
+	CHECK(variant.hash_compare(array));
+
+	Vector<Vector3> points;
+	points.push_back(Vector3(1, 2, 3));
+	points.push_back(Vector3(4, 5, 6));
+	CHECK(encode_variant_compact(points, buffer) == OK);
+	CHECK(buffer.size() == 2 + 2 * int(sizeof(Vector3)));
+	CHECK(decode_variant_compact(variant, buffer.ptr(), buffer.size(), &r_len) == OK);
+	CHECK(variant == Variant(points));
+
+	NodePath path = NodePath("/root/Player:position:x");
+	CHECK(encode_variant_compact(path, buffer) == OK);
+	CHECK(decode_variant_compact(variant, buffer.ptr(), buffer.size(), &r_len) == OK);
+	CHECK(variant == Variant(path));
+
+	ERR_PRINT_OFF;
+	CHECK_MESSAGE(decode_variant_compact(variant, buffer.ptr(), buffer.size() - 1) == ERR_INVALID_DATA, "Truncated data should fail to decode.");
+	uint8_t invalid_type[] = { Variant::VARIANT_MAX };
+	CHECK(decode_variant_compact(variant, invalid_type, 1) == ERR_INVALID_DATA);
+	uint8_t long_varint[] = { Variant::INT, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01 };
+	CHECK(decode_variant_compact(variant, long_varint, sizeof(long_varint)) == ERR_INVALID_DATA);
+	uint8_t huge_array[] = { Variant::PACKED_INT64_ARRAY, 0xff, 0xff, 0xff, 0xff, 0x0f };
+	CHECK_MESSAGE(decode_variant_compact(variant, huge_array, sizeof(huge_array)) == ERR_INVALID_DATA, "Counts larger than the data left should be rejected before allocating.");
+	uint8_t unknown_string[] = { Variant::STRING, 0x01 };
+	CHECK(decode_variant_compact(variant, unknown_string, sizeof(unknown_string)) == ERR_INVALID_DATA);
+	ERR_PRINT_ON;
+}
+
+static Variant make_random_variant(RandomPCG &p_rng, int p_depth) {
+	static const char *words[] = { "name", "position", "velocity", "health", "ñandú", "" };
+	const int word_count = sizeof(words) / sizeof(words[0]);
+
+	switch (p_rng.rand(p_depth < 3 ? 20 : 17)) {
+		case 0:
+			return Variant();
+		case 1:
+			return p_rng.rand(2) == 1;
+		case 2:
+			// Mix small and large magnitudes, both signs.
+			return int64_t((uint64_t(p_rng.rand()) << 32) | p_rng.rand()) >> p_rng.rand(64);
+		case 3:
+			return p_rng.rand(2) ? p_rng.randd() * 1000.0 : double(p_rng.randf());
+		case 4:
+			return String::utf8(words[p_rng.rand(word_count)]) + itos(p_rng.rand(4));
+		case 5:
+			return StringName(String::utf8(words[p_rng.rand(word_count)]));
+		case 6:
+			return Vector2(p_rng.randf(), p_rng.randf());
+		case 7:
+			return Vector3i(p_rng.rand(), -int32_t(p_rng.rand(1000)), 7);
+		case 8:
+			return Rect2i(-1, p_rng.rand(), 300, INT32_MIN);
+		case 9:
+			return Transform3D(Basis(Vector3(0, 1, 0), p_rng.randf()), Vector3(p_rng.randf(), 2, 3));
+		case 10:
+			return Color(p_rng.randf(), 0.5, 0.25, 1);
+		case 11:
+			return NodePath(String("/root/") + words[p_rng.rand(word_count - 1)] + ":position:x");
+		case 12: {
+			Vector<uint8_t> bytes;
+			bytes.resize(p_rng.rand(64));
+			for (int i = 0; i < bytes.size(); i++) {
+				bytes.write[i] = p_rng.rand(256);
+			}
+			return bytes;
+		}
+		case 13: {
+			Vector<double> doubles;
+			doubles.resize(p_rng.rand(16));
+			for (int i = 0; i < doubles.size(); i++) {
+				doubles.write[i] = p_rng.randd();
+			}
+			return doubles;
+		}
+		case 14: {
+			Vector<String> strings;
+			for (uint32_t i = p_rng.rand(8); i > 0; i--) {
+				strings.push_back(String::utf8(words[p_rng.rand(word_count)]));
+			}
+			return strings;
+		}
+		case 15: {
+			Vector<Vector2> points;
+			for (uint32_t i = p_rng.rand(8); i > 0; i--) {
+				points.push_back(Vector2(p_rng.randf(), p_rng.randf()));
+			}
+			return points;
+		}
+		case 16:
+			return AABB(Vector3(p_rng.randf(), 0, 1), Vector3(1, 1, p_rng.randf()));
+		case 17:
+		case 18: {
+			Array array;
+			for (uint32_t i = p_rng.rand(6); i > 0; i--) {
+				array.push_back(make_random_variant(p_rng, p_depth + 1));
+			}
+			return array;
+		}
+		default: {
+			Dictionary dictionary;
+			for (uint32_t i = p_rng.rand(6); i > 0; i--) {
+				dictionary[make_random_variant(p_rng, p_depth + 1)] = make_random_variant(p_rng, p_depth + 1);
+			}
+			return dictionary;
+		}
+	}
+}
+
+// Dictionaries compare by reference, this compares contents instead.
+static bool variant_deep_equal(const Variant &p_a, const Variant &p_b) {
+	if (p_a.get_type() != p_b.get_type()) {
+		return false;
+	}
+
+	if (p_a.get_type() == Variant::ARRAY) {
+		Array a = p_a;
+		Array b = p_b;
+		if (a.size() != b.size()) {
+			return false;
+		}
+		for (int i = 0; i < a.size(); i++) {
+			if (!variant_deep_equal(a[i], b[i])) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	if (p_a.get_type() == Variant::DICTIONARY) {
+		Dictionary a = p_a;
+		Dictionary b = p_b;
+		if (a.size() != b.size()) {
+			return false;
+		}
+		for (int i = 0; i < a.size(); i++) {
+			if (!variant_deep_equal(a.get_key_at_index(i), b.get_key_at_index(i)) || !variant_deep_equal(a.get_value_at_index(i), b.get_value_at_index(i))) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	return p_a.hash_compare(p_b);
+}
+
+TEST_CASE("[Marshalls] Compact Variant round trip fuzzing") {
+	RandomPCG rng(1234);
+	Vector<uint8_t> buffer;
+
+	ERR_PRINT_OFF;
+	for (int i = 0; i < 2000; i++) {
+		Variant original = make_random_variant(rng, 0);
+		REQUIRE(encode_variant_compact(original, buffer) == OK);
+
+		Variant decoded;
+		int r_len = 0;
+		REQUIRE(decode_variant_compact(decoded, buffer.ptr(), buffer.size(), &r_len) == OK);
+		CHECK(r_len == buffer.size());
+		CHECK_MESSAGE(variant_deep_equal(decoded, original), vformat("Round trip mismatch for %s.", original).utf8().ptr());
+
+		// Every strict prefix is incomplete and has to be rejected.
+		int cut = rng.rand(buffer.size());
+		CHECK(decode_variant_compact(decoded, buffer.ptr(), cut) != OK);
+
+		// Corrupted data may still decode, but never reads past the end.
+		Vector<uint8_t> corrupted = buffer;
+		corrupted.write[rng.rand(corrupted.size())] ^= 1 << rng.rand(8);
+		r_len = 0;
+		if (decode_variant_compact(decoded, corrupted.ptr(), corrupted.size(), &r_len) == OK) {
+			CHECK(r_len <= corrupted.size());
+		}
+	}
+	ERR_PRINT_ON;
+}
+
+// A snapshot of entities, in the shape of a typical state sync message.
+static Array make_state_message(int p_entity_count) {
+	Array message;
+	RandomPCG rng(42);
+	for (int i = 0; i < p_entity_count; i++) {
+		Dictionary entity;
+		entity["id"] = i;
+		entity["name"] = "Entity" + itos(i % 10);
+		entity["position"] = Vector3(rng.randf(), rng.randf(), rng.randf());
+		entity["velocity"] = Vector3(rng.randf(), 0, rng.randf());
+		entity["health"] = int(rng.rand(100));
+		entity["alive"] = true;
+		Vector<float> samples;
+		samples.resize(16);
+		for (int j = 0; j < samples.size(); j++) {
+			samples.write[j] = rng.randf();
+		}
+		entity["samples"] = samples;
+		message.push_back(entity);
+	}
+	return message;
+}
+
+TEST_CASE("[Marshalls] Compact Variant encoding of a state sync message") {
+	Array message = make_state_message(20);
+
+	int default_size = 0;
+	REQUIRE(encode_variant(message, nullptr, default_size) == OK);
+
+	Vector<uint8_t> buffer;
+	REQUIRE(encode_variant_compact(message, buffer) == OK);
+	CHECK_MESSAGE(buffer.size() < default_size, "The compact encoding should be smaller than the default one.");
+
+	Variant decoded;
+	REQUIRE(decode_variant_compact(decoded, buffer.ptr(), buffer.size()) == OK);
+	CHECK(variant_deep_equal(decoded, message));
+}
+
+void benchmark() {
+	Array message = make_state_message(200);
+
+	const int iterations = 50;
+	uint64_t best[4] = { UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX };
+	int default_size = 0;
+	Vector<uint8_t> default_buffer;
+	Vector<uint8_t> compact_buffer;
+
+	for (int i = 0; i < iterations; i++) {
+		Variant decoded;
+
+		uint64_t time = OS::get_singleton()->get_ticks_usec();
+		ERR_FAIL_COND(encode_variant(message, nullptr, default_size) != OK);
+		default_buffer.resize(default_size);
+		ERR_FAIL_COND(encode_variant(message, default_buffer.ptrw(), default_size) != OK);
+		best[0] = MIN(best[0], OS::get_singleton()->get_ticks_usec() - time);
+
+		time = OS::get_singleton()->get_ticks_usec();
+		ERR_FAIL_COND(decode_variant(decoded, default_buffer.ptr(), default_buffer.size()) != OK);
+		best[1] = MIN(best[1], OS::get_singleton()->get_ticks_usec() - time);
+
+		time = OS::get_singleton()->get_ticks_usec();
+		ERR_FAIL_COND(encode_variant_compact(message, compact_buffer) != OK);
+		best[2] = MIN(best[2], OS::get_singleton()->get_ticks_usec() - time);
+
+		time = OS::get_singleton()->get_ticks_usec();
+		ERR_FAIL_COND(decode_variant_compact(decoded, compact_buffer.ptr(), compact_buffer.size()) != OK);
+		best[3] = MIN(best[3], OS::get_singleton()->get_ticks_usec() - time);
+	}
+
+	print_line(vformat("Default encoding: %d bytes, encode %d usec, decode %d usec.", default_buffer.size(), best[0], best[1]));
+	print_line(vformat("Compact encoding: %d bytes, encode %d usec, decode %d usec.", compact_buffer.size(), best[2], best[3]));
+}
 } // namespace TestMarshalls
 
 #endif // TEST_MARSHALLS_H
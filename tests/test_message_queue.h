@@ -0,0 +1,278 @@
+/*************************************************************************/
+/*  test_message_queue.h                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_MESSAGE_QUEUE_H
+#define TEST_MESSAGE_QUEUE_H
+
+#include "core/object/message_queue.h"
+#include "core/os/os.h"
+#include "core/os/thread.h"
+#include "tests/test_macros.h"
+
+namespace TestMessageQueue {
+
+class Receiver : public Object {
+public:
+	Vector<int> values;
+	int chain_length = 0;
+
+	void record(int p_value) {
+		values.push_back(p_value);
+	}
+
+	void record_padded(int p_value, const String &p_padding) {
+		values.push_back(p_value);
+	}
+
+	void chain(int p_value) {
+		values.push_back(p_value);
+		if (p_value + 1 < chain_length) {
+			MessageQueue::get_singleton()->push_callable(callable_mp(this, &Receiver::chain), p_value + 1);
+		}
+	}
+};
+
+struct PushData {
+	Receiver *receiver = nullptr;
+	int first = 0;
+	int count = 0;
+};
+
+static void push_values(void *p_userdata) {
+	PushData *data = static_cast<PushData *>(p_userdata);
+	Callable callable = callable_mp(data->receiver, &Receiver::record);
+	for (int i = 0; i < data->count; i++) {
+		MessageQueue::get_singleton()->push_callable(callable, data->first + i);
+	}
+}
+
+TEST_CASE("[MessageQueue] Calls are flushed in push order") {
+	MessageQueue *queue = memnew(MessageQueue);
+	Receiver receiver;
+
+	for (int i = 0; i < 1000; i++) {
+		queue->push_callable(callable_mp(&receiver, &Receiver::record), i);
+	}
+	CHECK(receiver.values.is_empty());
+
+	queue->flush();
+	REQUIRE(receiver.values.size() == 1000);
+	bool in_order = true;
+	for (int i = 0; i < 1000; i++) {
+		in_order = in_order && receiver.values[i] == i;
+	}
+	CHECK_MESSAGE(in_order, "Calls should run in the order they were pushed.");
+
+	memdelete(queue);
+}
+
+#if !defined(NO_THREADS)
+TEST_CASE("[MessageQueue] Calls from several threads are merged in push order") {
+	MessageQueue *queue = memnew(MessageQueue);
+	Receiver receiver;
+
+	PushData first_data;
+	first_data.receiver = &receiver;
+	first_data.first = 0;
+	first_data.count = 100;
+	Thread first_thread;
+	first_thread.start(push_values, &first_data);
+	first_thread.wait_to_finish();
+
+	for (int i = 100; i < 200; i++) {
+		queue->push_callable(callable_mp(&receiver, &Receiver::record), i);
+	}
+
+	PushData second_data;
+	second_data.receiver = &receiver;
+	second_data.first = 200;
+	second_data.count = 100;
+	Thread second_thread;
+	second_thread.start(push_values, &second_data);
+	second_thread.wait_to_finish();
+
+	queue->flush();
+	REQUIRE(receiver.values.size() == 300);
+	bool in_order = true;
+	for (int i = 0; i < 300; i++) {
+		in_order = in_order && receiver.values[i] == i;
+	}
+	CHECK_MESSAGE(in_order, "Calls from different threads should run in the order they were pushed.");
+
+	memdelete(queue);
+}
+
+TEST_CASE("[MessageQueue] Concurrent pushes keep the order of each thread") {
+	MessageQueue *queue = memnew(MessageQueue);
+	Receiver receiver;
+
+	const int thread_count = 8;
+	const int per_thread = 2000;
+	PushData data[thread_count];
+	Thread threads[thread_count];
+	for (int i = 0; i < thread_count; i++) {
+		data[i].receiver = &receiver;
+		data[i].first = i * per_thread;
+		data[i].count = per_thread;
+		threads[i].start(push_values, &data[i]);
+	}
+	for (int i = 0; i < thread_count; i++) {
+		threads[i].wait_to_finish();
+	}
+
+	queue->flush();
+	REQUIRE(receiver.values.size() == thread_count * per_thread);
+
+	int last[thread_count];
+	for (int i = 0; i < thread_count; i++) {
+		last[i] = -1;
+	}
+	bool in_order = true;
+	for (int i = 0; i < receiver.values.size(); i++) {
+		int value = receiver.values[i];
+		int thread = value / per_thread;
+		in_order = in_order && value > last[thread];
+		last[thread] = value;
+	}
+	CHECK_MESSAGE(in_order, "Calls from each thread should run in the order that thread pushed them.");
+
+	memdelete(queue);
+}
+#endif // NO_THREADS
+
+TEST_CASE("[MessageQueue] Calls pushed while flushing run in the same flush") {
+	MessageQueue *queue = memnew(MessageQueue);
+	Receiver receiver;
+	receiver.chain_length = 100;
+
+	queue->push_callable(callable_mp(&receiver, &Receiver::chain), 0);
+	queue->flush();
+
+	CHECK(receiver.values.size() == 100);
+	CHECK_FALSE(queue->is_flushing());
+
+	memdelete(queue);
+}
+
+TEST_CASE("[MessageQueue] The queue grows instead of dropping calls") {
+	MessageQueue *queue = memnew(MessageQueue);
+	Receiver receiver;
+
+	// Needs more memory than the default maximum page size.
+	const String padding = String("x").repeat(256);
+	const int count = 60000;
+	int failed = 0;
+	for (int i = 0; i < count; i++) {
+		if (queue->push_callable(callable_mp(&receiver, &Receiver::record_padded), i, padding) != OK) {
+			failed++;
+		}
+	}
+	CHECK(failed == 0);
+
+	queue->flush();
+	CHECK(receiver.values.size() == count);
+	CHECK(queue->get_max_buffer_usage() > 0);
+
+	// Pending calls are released with the queue.
+	queue->push_callable(callable_mp(&receiver, &Receiver::record), count);
+	memdelete(queue);
+	CHECK(receiver.values.size() == count);
+}
+
+TEST_CASE("[MessageQueue] Drained pages are reused") {
+	MessageQueue *queue = memnew(MessageQueue);
+	Receiver receiver;
+	Callable callable = callable_mp(&receiver, &Receiver::record);
+
+	// Enough calls to need several pages.
+	const int count = 5000;
+	for (int round = 0; round < 3; round++) {
+		uint64_t alloc_calls = Memory::get_alloc_call_count();
+		for (int i = 0; i < count; i++) {
+			queue->push_callable(callable, i);
+		}
+		alloc_calls = Memory::get_alloc_call_count() - alloc_calls;
+
+		receiver.values.clear();
+		queue->flush();
+		REQUIRE(receiver.values.size() == count);
+		bool in_order = true;
+		for (int i = 0; i < count; i++) {
+			in_order = in_order && receiver.values[i] == i;
+		}
+		CHECK_MESSAGE(in_order, "Calls in reused pages should run in the order they were pushed.");
+
+#ifdef DEBUG_ENABLED
+		if (round > 0) {
+			CHECK_MESSAGE(alloc_calls == 0, "Pushing as many calls as the previous frame should only use drained pages.");
+		}
+#endif
+	}
+
+	memdelete(queue);
+}
+
+void benchmark() {
+#if !defined(NO_THREADS)
+	MessageQueue *queue = memnew(MessageQueue);
+	Receiver receiver;
+
+	const int thread_count = 16;
+	const int per_thread = 10000;
+	PushData data[thread_count];
+	Thread threads[thread_count];
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < thread_count; i++) {
+		data[i].receiver = &receiver;
+		data[i].first = i * per_thread;
+		data[i].count = per_thread;
+		threads[i].start(push_values, &data[i]);
+	}
+	for (int i = 0; i < thread_count; i++) {
+		threads[i].wait_to_finish();
+	}
+	uint64_t push_usec = OS::get_singleton()->get_ticks_usec() - begin;
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	queue->flush();
+	uint64_t flush_usec = OS::get_singleton()->get_ticks_usec() - begin;
+
+	print_line(vformat("%d threads pushing %d calls each: ", thread_count, per_thread) +
+			vformat("push %d usec, flush %d usec, %d bytes used.", push_usec, flush_usec, queue->get_max_buffer_usage()));
+
+	memdelete(queue);
+	ERR_FAIL_COND(receiver.values.size() != thread_count * per_thread);
+#endif
+}
+
+} // namespace TestMessageQueue
+
+#endif // TEST_MESSAGE_QUEUE_H
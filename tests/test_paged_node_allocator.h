@@ -0,0 +1,213 @@
+/*************************************************************************/
+/*  test_paged_node_allocator.h                                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_PAGED_NODE_ALLOCATOR_H
+#define TEST_PAGED_NODE_ALLOCATOR_H
+
+#include "core/os/os.h"
+#include "core/os/thread.h"
+#include "core/templates/list.h"
+#include "core/templates/map.h"
+#include "core/templates/paged_node_allocator.h"
+#include "core/templates/set.h"
+
+#include "tests/test_macros.h"
+
+namespace TestPagedNodeAllocator {
+
+TEST_CASE("[PagedNodeAllocator] Allocate and free blocks of every size") {
+	const int count = 300;
+	uint8_t *blocks[count];
+	for (int i = 0; i < count; i++) {
+		// Goes past the largest size class, those blocks come from Memory.
+		blocks[i] = (uint8_t *)PagedNodeAllocator::alloc(i + 1);
+		REQUIRE(blocks[i] != nullptr);
+		CHECK_MESSAGE(((uintptr_t)blocks[i] & 7) == 0, "Blocks should be aligned to 8 bytes.");
+		memset(blocks[i], i & 0xFF, i + 1);
+	}
+
+	bool intact = true;
+	for (int i = 0; i < count; i++) {
+		for (int j = 0; j <= i; j++) {
+			intact = intact && blocks[i][j] == (i & 0xFF);
+		}
+	}
+	CHECK_MESSAGE(intact, "Blocks should not overlap.");
+
+	for (int i = 0; i < count; i++) {
+		PagedNodeAllocator::free(blocks[i]);
+	}
+}
+
+TEST_CASE("[PagedNodeAllocator] Containers") {
+	Map<int, String, Comparator<int>, PagedNodeAllocator> map;
+	Set<int, Comparator<int>, PagedNodeAllocator> set;
+	List<String, PagedNodeAllocator> list;
+	for (int i = 0; i < 1000; i++) {
+		map.insert(i, itos(i));
+		set.insert(i);
+		list.push_back(itos(i));
+	}
+	for (int i = 0; i < 1000; i += 2) {
+		map.erase(i);
+		set.erase(i);
+		list.pop_front();
+	}
+	CHECK(map.size() == 500);
+	CHECK(set.size() == 500);
+	CHECK(list.size() == 500);
+	CHECK(map[999] == "999");
+	CHECK(set.has(501));
+	CHECK_FALSE(set.has(500));
+	CHECK(list.front()->get() == "500");
+
+	// Reuses the freed nodes.
+	for (int i = 0; i < 1000; i += 2) {
+		map.insert(i, itos(i));
+	}
+	int expected = 0;
+	bool ordered = true;
+	for (Map<int, String, Comparator<int>, PagedNodeAllocator>::Element *E = map.front(); E; E = E->next()) {
+		ordered = ordered && E->key() == expected && E->get() == itos(expected);
+		expected++;
+	}
+	CHECK(ordered);
+	CHECK(expected == 1000);
+
+	map.clear();
+	set.clear();
+	list.clear();
+	CHECK(map.is_empty());
+}
+
+#if !defined(NO_THREADS)
+static void build_and_free_maps(void *p_userdata) {
+	for (int i = 0; i < 100; i++) {
+		Map<int, int, Comparator<int>, PagedNodeAllocator> map;
+		for (int j = 0; j < 100; j++) {
+			map.insert(j, j);
+		}
+	}
+}
+
+TEST_CASE("[PagedNodeAllocator] Allocate from several threads") {
+	Thread threads[4];
+	for (int i = 0; i < 4; i++) {
+		threads[i].start(build_and_free_maps, nullptr);
+	}
+	build_and_free_maps(nullptr);
+	for (int i = 0; i < 4; i++) {
+		threads[i].wait_to_finish();
+	}
+}
+#endif
+
+struct BenchmarkTimes {
+	uint64_t build = 0;
+	uint64_t teardown = 0;
+};
+
+template <class A>
+static BenchmarkTimes benchmark_map(int p_count) {
+	BenchmarkTimes times;
+	Map<int, int, Comparator<int>, A> *map = memnew((Map<int, int, Comparator<int>, A>));
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < p_count; i++) {
+		// Not in key order.
+		map->insert(int((i * 7919ll) % p_count), i);
+	}
+	times.build = OS::get_singleton()->get_ticks_usec() - begin;
+	ERR_FAIL_COND_V(map->size() != p_count, times);
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	memdelete(map);
+	times.teardown = OS::get_singleton()->get_ticks_usec() - begin;
+	return times;
+}
+
+template <class A>
+static BenchmarkTimes benchmark_set(int p_count) {
+	BenchmarkTimes times;
+	Set<int, Comparator<int>, A> *set = memnew((Set<int, Comparator<int>, A>));
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < p_count; i++) {
+		set->insert(int((i * 7919ll) % p_count));
+	}
+	times.build = OS::get_singleton()->get_ticks_usec() - begin;
+	ERR_FAIL_COND_V(set->size() != p_count, times);
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	memdelete(set);
+	times.teardown = OS::get_singleton()->get_ticks_usec() - begin;
+	return times;
+}
+
+template <class A>
+static BenchmarkTimes benchmark_list(int p_count) {
+	BenchmarkTimes times;
+	List<int, A> *list = memnew((List<int, A>));
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < p_count; i++) {
+		list->push_back(i);
+	}
+	times.build = OS::get_singleton()->get_ticks_usec() - begin;
+	ERR_FAIL_COND_V(list->size() != p_count, times);
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	memdelete(list);
+	times.teardown = OS::get_singleton()->get_ticks_usec() - begin;
+	return times;
+}
+
+static void print_benchmark(const String &p_name, const BenchmarkTimes &p_times) {
+	String result = vformat("%s: build %d usec, teardown %d usec.", p_name, p_times.build, p_times.teardown);
+	print_line(result);
+}
+
+// Builds and tears down 1M element containers.
+void benchmark() {
+	const int count = 1000000;
+	// The second round reuses the nodes freed by the first one.
+	for (int round = 1; round <= 2; round++) {
+		print_benchmark(vformat("Round %d, Map<int, int>", round), benchmark_map<DefaultAllocator>(count));
+		print_benchmark(vformat("Round %d, Map<int, int> with PagedNodeAllocator", round), benchmark_map<PagedNodeAllocator>(count));
+		print_benchmark(vformat("Round %d, Set<int>", round), benchmark_set<DefaultAllocator>(count));
+		print_benchmark(vformat("Round %d, Set<int> with PagedNodeAllocator", round), benchmark_set<PagedNodeAllocator>(count));
+		print_benchmark(vformat("Round %d, List<int>", round), benchmark_list<DefaultAllocator>(count));
+		print_benchmark(vformat("Round %d, List<int> with PagedNodeAllocator", round), benchmark_list<PagedNodeAllocator>(count));
+	}
+}
+
+} // namespace TestPagedNodeAllocator
+
+#endif // TEST_PAGED_NODE_ALLOCATOR_H
@@ -36,6 +36,7 @@
 #include "core/templates/map.h"
 #include "scene/resources/texture.h"
 #include "servers/display_server.h"
+#include "servers/physics_2d/godot_physics_server_2d.h"
 #include "servers/physics_server_2d.h"
 #include "servers/rendering_server.h"
 
@@ -400,4 +401,99 @@ namespace TestPhysics2D {
 MainLoop *test() {
 	return memnew(TestPhysics2DMainLoop);
 }
+
+static void _add_benchmark_boundary(PhysicsServer2D *p_server, RID p_space, const Vector2 &p_normal, real_t p_d, List<RID> &r_bodies, List<RID> &r_shapes) {
+	Array arr;
+	arr.push_back(p_normal);
+	arr.push_back(p_d);
+
+	RID world_boundary = p_server->world_boundary_shape_create();
+	p_server->shape_set_data(world_boundary, arr);
+
+	RID body = p_server->body_create();
+	p_server->body_set_mode(body, PhysicsServer2D::BODY_MODE_STATIC);
+	p_server->body_add_shape(body, world_boundary);
+	p_server->body_set_space(body, p_space);
+
+	r_bodies.push_back(body);
+	r_shapes.push_back(world_boundary);
+}
+
+// Circles falling into a box, run with `godot --test physics-2d-benchmark`.
+// The checksum of the final positions must not depend on the thread count.
+void benchmark() {
+	const int body_counts[] = { 1000, 5000, 10000, 30000 };
+	const int warmup_steps = 10;
+	const int steps = 60;
+	const real_t step_delta = 1.0 / 60.0;
+
+	for (const int body_count : body_counts) {
+		PhysicsServer2D *ps = memnew(GodotPhysicsServer2D);
+		ps->init();
+		ps->set_active(true);
+
+		RID space = ps->space_create();
+		ps->space_set_active(space, true);
+		ps->area_set_param(space, PhysicsServer2D::AREA_PARAM_GRAVITY_VECTOR, Vector2(0, 1));
+		ps->area_set_param(space, PhysicsServer2D::AREA_PARAM_GRAVITY, 980);
+
+		const int columns = (int)Math::sqrt((double)body_count);
+		const real_t spacing = 9.0;
+		const real_t width = columns * spacing;
+
+		List<RID> static_bodies;
+		List<RID> shapes;
+		_add_benchmark_boundary(ps, space, Vector2(0, -1), -width, static_bodies, shapes);
+		_add_benchmark_boundary(ps, space, Vector2(1, 0), -spacing, static_bodies, shapes);
+		_add_benchmark_boundary(ps, space, Vector2(-1, 0), -(width + spacing), static_bodies, shapes);
+
+		RID circle = ps->circle_shape_create();
+		ps->shape_set_data(circle, 4.0);
+		shapes.push_back(circle);
+
+		Vector<RID> bodies;
+		bodies.resize(body_count);
+		for (int i = 0; i < body_count; i++) {
+			RID body = ps->body_create();
+			ps->body_add_shape(body, circle);
+			ps->body_set_space(body, space);
+			ps->body_set_state(body, PhysicsServer2D::BODY_STATE_TRANSFORM, Transform2D(0, Point2((i % columns) * spacing, (i / columns) * spacing - width)));
+			bodies.write[i] = body;
+		}
+
+		uint64_t begin_usec = 0;
+		for (int i = 0; i < warmup_steps + steps; i++) {
+			if (i == warmup_steps) {
+				begin_usec = OS::get_singleton()->get_ticks_usec();
+			}
+			ps->sync();
+			ps->flush_queries();
+			ps->end_sync();
+			ps->step(step_delta);
+		}
+		double seconds = (OS::get_singleton()->get_ticks_usec() - begin_usec) / 1000000.0;
+
+		uint32_t checksum = 0;
+		for (int i = 0; i < body_count; i++) {
+			Transform2D xform = ps->body_get_state(bodies[i], PhysicsServer2D::BODY_STATE_TRANSFORM);
+			checksum = hash_djb2_one_float(xform.elements[2].x, checksum);
+			checksum = hash_djb2_one_float(xform.elements[2].y, checksum);
+			ps->free(bodies[i]);
+		}
+
+		print_line(vformat("%d bodies: %.1f steps/sec, checksum %x", body_count, steps / seconds, checksum));
+
+		for (const RID &body : static_bodies) {
+			ps->free(body);
+		}
+		for (const RID &shape : shapes) {
+			ps->free(shape);
+		}
+		ps->free(space);
+
+		ps->finish();
+		memdelete(ps);
+	}
+}
+
 } // namespace TestPhysics2D
@@ -37,6 +37,7 @@
 #include "core/string/print_string.h"
 #include "core/templates/map.h"
 #include "servers/display_server.h"
+#include "servers/physics_3d/godot_physics_server_3d.h"
 #include "servers/physics_server_3d.h"
 #include "servers/rendering_server.h"
 
@@ -411,4 +412,97 @@ namespace TestPhysics3D {
 MainLoop *test() {
 	return memnew(TestPhysics3DMainLoop);
 }
+
+// Small spheres shot at a thin wall, run with `godot --test physics-3d-ccd-benchmark`.
+// Compares continuous collision detection with raising the tick rate.
+void benchmark_ccd() {
+	struct Config {
+		int ticks_per_second;
+		bool ccd;
+	};
+	const Config configs[] = {
+		{ 60, true },
+		{ 60, false },
+		{ 120, false },
+		{ 240, false },
+		{ 480, false },
+		{ 960, false },
+	};
+
+	const int grid_size = 32;
+	const real_t spacing = 0.3;
+	const real_t radius = 0.1;
+	const real_t speed = 100.0;
+	const real_t wall_x = 5.0;
+	const real_t wall_thickness = 0.05;
+	const real_t duration = 0.25;
+
+	for (const Config &config : configs) {
+		PhysicsServer3D *ps = memnew(GodotPhysicsServer3D);
+		ps->init();
+		ps->set_active(true);
+
+		RID space = ps->space_create();
+		ps->space_set_active(space, true);
+		ps->area_set_param(space, PhysicsServer3D::AREA_PARAM_GRAVITY, 0.0);
+
+		RID wall_shape = ps->box_shape_create();
+		ps->shape_set_data(wall_shape, Vector3(wall_thickness * 0.5, grid_size * spacing, grid_size * spacing));
+		RID wall = ps->body_create();
+		ps->body_set_mode(wall, PhysicsServer3D::BODY_MODE_STATIC);
+		ps->body_add_shape(wall, wall_shape);
+		ps->body_set_space(wall, space);
+		ps->body_set_state(wall, PhysicsServer3D::BODY_STATE_TRANSFORM, Transform3D(Basis(), Vector3(wall_x, 0, 0)));
+
+		RID sphere_shape = ps->sphere_shape_create();
+		ps->shape_set_data(sphere_shape, radius);
+
+		Vector<RID> bodies;
+		for (int i = 0; i < grid_size * grid_size; i++) {
+			Vector3 origin(0, (i % grid_size - grid_size / 2) * spacing, (i / grid_size - grid_size / 2) * spacing);
+
+			RID body = ps->body_create();
+			ps->body_add_shape(body, sphere_shape);
+			ps->body_set_space(body, space);
+			ps->body_set_enable_continuous_collision_detection(body, config.ccd);
+			ps->body_set_state(body, PhysicsServer3D::BODY_STATE_CAN_SLEEP, false);
+			ps->body_set_state(body, PhysicsServer3D::BODY_STATE_TRANSFORM, Transform3D(Basis(), origin));
+			ps->body_set_state(body, PhysicsServer3D::BODY_STATE_LINEAR_VELOCITY, Vector3(speed, 0, 0));
+			bodies.push_back(body);
+		}
+
+		const int steps = (int)Math::ceil(duration * config.ticks_per_second);
+		const real_t step_delta = 1.0 / config.ticks_per_second;
+
+		uint64_t begin_usec = OS::get_singleton()->get_ticks_usec();
+		for (int i = 0; i < steps; i++) {
+			ps->sync();
+			ps->flush_queries();
+			ps->end_sync();
+			ps->step(step_delta);
+		}
+		double msec = (OS::get_singleton()->get_ticks_usec() - begin_usec) / 1000.0;
+
+		int tunneled = 0;
+		for (int i = 0; i < bodies.size(); i++) {
+			Transform3D xform = ps->body_get_state(bodies[i], PhysicsServer3D::BODY_STATE_TRANSFORM);
+			if (xform.origin.x > wall_x) {
+				tunneled++;
+			}
+			ps->free(bodies[i]);
+		}
+
+		print_line(vformat("%d ticks/sec, CCD %s: %d of %d bodies tunneled, %.2f ms CPU per simulated second.",
+				config.ticks_per_second, config.ccd ? "on" : "off", tunneled, bodies.size(), msec / duration));
+
+		ps->free(wall);
+		ps->free(wall_shape);
+		ps->free(sphere_shape);
+		ps->free(space);
+
+		ps->finish();
+		memdelete(ps);
+	}
+}
+
 } // namespace TestPhysics3D
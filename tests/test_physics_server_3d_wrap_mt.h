@@ -0,0 +1,288 @@
+/*************************************************************************/
+/*  test_physics_server_3d_wrap_mt.h                                     */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_PHYSICS_SERVER_3D_WRAP_MT_H
+#define TEST_PHYSICS_SERVER_3D_WRAP_MT_H
+
+#include "core/config/project_settings.h"
+#include "core/os/os.h"
+#include "servers/physics_3d/godot_physics_server_3d.h"
+#include "servers/physics_server_3d_wrap_mt.h"
+
+#include "tests/test_macros.h"
+
+#if !defined(NO_THREADS)
+
+namespace TestPhysicsServer3DWrapMT {
+
+static PhysicsServer3D *create_threaded_server(PhysicsServer3D **r_contained = nullptr) {
+	GLOBAL_DEF("memory/limits/multithreaded_server/rid_pool_prealloc", 60);
+	PhysicsServer3D *contained = memnew(GodotPhysicsServer3D(true));
+	if (r_contained) {
+		*r_contained = contained;
+	}
+	PhysicsServer3D *server = memnew(PhysicsServer3DWrapMT(contained, true));
+	server->init();
+	return server;
+}
+
+static void finish_server(PhysicsServer3D *p_server) {
+	p_server->finish();
+	memdelete(p_server);
+}
+
+static RID create_body(PhysicsServer3D *p_server, RID p_space, RID p_shape, const Vector3 &p_origin) {
+	RID body = p_server->body_create();
+	p_server->body_set_mode(body, PhysicsServer3D::BODY_MODE_DYNAMIC);
+	p_server->body_add_shape(body, p_shape);
+	p_server->body_set_space(body, p_space);
+	p_server->body_set_state(body, PhysicsServer3D::BODY_STATE_CAN_SLEEP, false);
+	p_server->body_set_state(body, PhysicsServer3D::BODY_STATE_TRANSFORM, Transform3D(Basis(), p_origin));
+	return body;
+}
+
+// Same call order as Main::iteration(), the step runs while the main thread does its own work.
+static void begin_frame(PhysicsServer3D *p_server) {
+	p_server->sync();
+	p_server->flush_queries();
+}
+
+static void end_frame(PhysicsServer3D *p_server) {
+	p_server->end_sync();
+	p_server->step(1.0 / 60.0);
+}
+
+TEST_CASE("[PhysicsServer3DWrapMT] Body state reads and writes from the main thread") {
+	PhysicsServer3D *server = create_threaded_server();
+	begin_frame(server);
+
+	RID space = server->space_create();
+	server->space_set_active(space, true);
+	RID shape = server->sphere_shape_create();
+	server->shape_set_data(shape, 0.5);
+
+	RID body = create_body(server, space, shape, Vector3());
+
+	// Redundant writes within a frame are coalesced, only the last one reaches the server.
+	server->body_set_state(body, PhysicsServer3D::BODY_STATE_TRANSFORM, Transform3D(Basis(), Vector3(1, 2, 3)));
+	server->body_set_state(body, PhysicsServer3D::BODY_STATE_LINEAR_VELOCITY, Vector3(5, 0, 0));
+	server->body_set_state(body, PhysicsServer3D::BODY_STATE_TRANSFORM, Transform3D(Basis(), Vector3(0, 10, 0)));
+
+	Transform3D transform = server->body_get_state(body, PhysicsServer3D::BODY_STATE_TRANSFORM);
+	CHECK_MESSAGE(
+			transform.origin.is_equal_approx(Vector3(0, 10, 0)),
+			"Reads after writes should return the last written value.");
+	Vector3 linear_velocity = server->body_get_state(body, PhysicsServer3D::BODY_STATE_LINEAR_VELOCITY);
+	CHECK_MESSAGE(
+			linear_velocity.is_equal_approx(Vector3(5, 0, 0)),
+			"Reads after writes should return the last written value.");
+
+	real_t last_x = transform.origin.x;
+	for (int i = 0; i < 10; i++) {
+		end_frame(server);
+		begin_frame(server);
+
+		transform = server->body_get_state(body, PhysicsServer3D::BODY_STATE_TRANSFORM);
+		CHECK_MESSAGE(
+				transform.origin.x > last_x,
+				"The snapshot should follow the body after each step.");
+		last_x = transform.origin.x;
+	}
+
+	CHECK_FALSE(bool(server->body_get_state(body, PhysicsServer3D::BODY_STATE_SLEEPING)));
+	CHECK_FALSE(bool(server->body_get_state(body, PhysicsServer3D::BODY_STATE_CAN_SLEEP)));
+
+	server->free(body);
+	server->free(shape);
+	server->free(space);
+
+	finish_server(server);
+}
+
+TEST_CASE("[PhysicsServer3DWrapMT] Body getters keep the state snapshot") {
+	PhysicsServer3D *server = create_threaded_server();
+	begin_frame(server);
+
+	RID space = server->space_create();
+	server->space_set_active(space, true);
+	RID shape = server->sphere_shape_create();
+	server->shape_set_data(shape, 0.5);
+
+	RID body = create_body(server, space, shape, Vector3());
+	server->body_set_state(body, PhysicsServer3D::BODY_STATE_LINEAR_VELOCITY, Vector3(5, 0, 0));
+	// The first read starts tracking the body, so the next syncs update its snapshot.
+	server->body_get_state(body, PhysicsServer3D::BODY_STATE_TRANSFORM);
+
+	end_frame(server);
+	begin_frame(server);
+	end_frame(server);
+
+	// The step is running, reads come from the snapshot taken at the last sync.
+	Transform3D before = server->body_get_state(body, PhysicsServer3D::BODY_STATE_TRANSFORM);
+
+	CHECK(server->body_get_mode(body) == PhysicsServer3D::BODY_MODE_DYNAMIC);
+	CHECK(server->body_get_space(body) == space);
+	CHECK(server->body_get_shape_count(body) == 1);
+	CHECK(server->body_get_collision_layer(body) == 1);
+	server->body_get_param(body, PhysicsServer3D::BODY_PARAM_MASS);
+	List<RID> exceptions;
+	server->body_get_collision_exceptions(body, &exceptions);
+
+	// Had a getter dropped the snapshot, this read would wait for the step and see the body move.
+	Transform3D after = server->body_get_state(body, PhysicsServer3D::BODY_STATE_TRANSFORM);
+	CHECK_MESSAGE(
+			after.origin.is_equal_approx(before.origin),
+			"Getters should not invalidate the body state snapshot.");
+
+	// A write drops it, the next read waits for the step.
+	server->body_set_mode(body, PhysicsServer3D::BODY_MODE_DYNAMIC);
+	after = server->body_get_state(body, PhysicsServer3D::BODY_STATE_TRANSFORM);
+	CHECK_MESSAGE(
+			after.origin.x > before.origin.x,
+			"Writes should invalidate the body state snapshot.");
+
+	begin_frame(server);
+
+	server->free(body);
+	server->free(shape);
+	server->free(space);
+
+	finish_server(server);
+}
+
+TEST_CASE("[PhysicsServer3DWrapMT] Direct body state writes reach the state snapshot") {
+	PhysicsServer3D *contained = nullptr;
+	PhysicsServer3D *server = create_threaded_server(&contained);
+	begin_frame(server);
+
+	RID space = server->space_create();
+	server->space_set_active(space, true);
+	RID shape = server->sphere_shape_create();
+	server->shape_set_data(shape, 0.5);
+
+	RID body = create_body(server, space, shape, Vector3());
+	server->body_get_state(body, PhysicsServer3D::BODY_STATE_TRANSFORM);
+
+	end_frame(server);
+	server->sync();
+	// Stands in for state sync callbacks and _integrate_forces(), which write to the contained server's bodies.
+	contained->body_get_direct_state(body)->set_linear_velocity(Vector3(0, 0, 3));
+	server->flush_queries();
+
+	Vector3 linear_velocity = server->body_get_state(body, PhysicsServer3D::BODY_STATE_LINEAR_VELOCITY);
+	CHECK_MESSAGE(
+			linear_velocity.is_equal_approx(Vector3(0, 0, 3)),
+			"The snapshot should be refreshed after the queries are flushed.");
+
+	PhysicsDirectBodyState3D *state = server->body_get_direct_state(body);
+	REQUIRE(state);
+	state->set_transform(Transform3D(Basis(), Vector3(4, 5, 6)));
+
+	Transform3D transform = server->body_get_state(body, PhysicsServer3D::BODY_STATE_TRANSFORM);
+	CHECK_MESSAGE(
+			transform.origin.is_equal_approx(Vector3(4, 5, 6)),
+			"Writes through the direct body state should invalidate the snapshot.");
+
+	end_frame(server);
+	begin_frame(server);
+
+	server->free(body);
+	server->free(shape);
+	server->free(space);
+
+	finish_server(server);
+}
+
+void benchmark() {
+	const int body_count = 500;
+	const int frame_count = 30;
+
+	PhysicsServer3D *server = create_threaded_server();
+
+	RID space = server->space_create();
+	server->space_set_active(space, true);
+	RID shape = server->sphere_shape_create();
+	server->shape_set_data(shape, 0.5);
+
+	Vector<RID> bodies;
+	for (int i = 0; i < body_count; i++) {
+		bodies.push_back(create_body(server, space, shape, Vector3((i % 20) * 2.0, 0, (i / 20) * 2.0)));
+	}
+
+	// Reads issued while the step is running, e.g. from _process().
+	uint64_t snapshot_usec = 0;
+	uint64_t blocking_usec = 0;
+
+	begin_frame(server);
+	for (int i = 0; i < frame_count; i++) {
+		end_frame(server);
+
+		uint64_t time = OS::get_singleton()->get_ticks_usec();
+		for (int j = 0; j < body_count; j++) {
+			Transform3D transform = server->body_get_state(bodies[j], PhysicsServer3D::BODY_STATE_TRANSFORM);
+			(void)transform;
+		}
+		snapshot_usec += OS::get_singleton()->get_ticks_usec() - time;
+
+		begin_frame(server);
+	}
+
+	for (int i = 0; i < frame_count; i++) {
+		end_frame(server);
+
+		uint64_t time = OS::get_singleton()->get_ticks_usec();
+		for (int j = 0; j < body_count; j++) {
+			// Writing a state drops the snapshot, so the read has to wait for the server thread.
+			server->body_set_state(bodies[j], PhysicsServer3D::BODY_STATE_CAN_SLEEP, false);
+			Transform3D transform = server->body_get_state(bodies[j], PhysicsServer3D::BODY_STATE_TRANSFORM);
+			(void)transform;
+		}
+		blocking_usec += OS::get_singleton()->get_ticks_usec() - time;
+
+		begin_frame(server);
+	}
+
+	print_line(vformat("Main thread stall per frame reading %d body transforms: %d usec from snapshots, %d usec waiting on the server thread.",
+			body_count, snapshot_usec / frame_count, blocking_usec / frame_count));
+
+	for (int i = 0; i < body_count; i++) {
+		server->free(bodies[i]);
+	}
+	server->free(shape);
+	server->free(space);
+
+	finish_server(server);
+}
+
+} // namespace TestPhysicsServer3DWrapMT
+
+#endif // !defined(NO_THREADS)
+
+#endif // TEST_PHYSICS_SERVER_3D_WRAP_MT_H
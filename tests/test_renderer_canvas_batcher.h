@@ -0,0 +1,326 @@
+/*************************************************************************/
+/*  test_renderer_canvas_batcher.h                                       */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_RENDERER_CANVAS_BATCHER_H
+#define TEST_RENDERER_CANVAS_BATCHER_H
+
+#include "core/os/os.h"
+#include "servers/rendering/renderer_canvas_batcher.h"
+
+#include "tests/test_macros.h"
+
+namespace TestRendererCanvasBatcher {
+
+typedef RendererCanvasRender::Item Item;
+
+class TestBatcher : public RendererCanvasBatcher {
+public:
+	Size2i texture_size = Size2i(64, 32);
+	HashMap<PolygonID, Polygon> polygons;
+
+protected:
+	virtual bool _get_texture_size(RID p_texture, RS::CanvasItemTextureFilter p_filter, RS::CanvasItemTextureRepeat p_repeat, Size2i &r_size) {
+		r_size = texture_size;
+		return true;
+	}
+
+	virtual const Polygon *_get_polygon(PolygonID p_polygon) const {
+		return polygons.getptr(p_polygon);
+	}
+};
+
+static Item::CommandRect *add_rect(Item &r_item, const Rect2 &p_rect, RID p_texture, const Color &p_modulate = Color(1, 1, 1, 1)) {
+	Item::CommandRect *rect = r_item.alloc_command<Item::CommandRect>();
+	rect->rect = p_rect;
+	rect->texture = p_texture;
+	rect->modulate = p_modulate;
+	return rect;
+}
+
+static void add_items(TestBatcher &r_batcher, Item *p_items, int p_count) {
+	for (int i = 0; i < p_count; i++) {
+		r_batcher.add_item(&p_items[i], RID(), r_batcher.is_item_batchable(&p_items[i]));
+	}
+}
+
+static Vector2 get_position(const TestBatcher &p_batcher, uint32_t p_vertex) {
+	return Vector2(p_batcher.vertices[p_vertex].position[0], p_batcher.vertices[p_vertex].position[1]);
+}
+
+static Vector2 get_uv(const TestBatcher &p_batcher, uint32_t p_vertex) {
+	return Vector2(p_batcher.vertices[p_vertex].uv[0], p_batcher.vertices[p_vertex].uv[1]);
+}
+
+TEST_CASE("[RendererCanvasBatcher] Rects sharing a texture are merged across items") {
+	RID texture = RID::from_uint64(1);
+	TestBatcher batcher;
+	batcher.begin(Transform2D(), RS::CANVAS_ITEM_TEXTURE_FILTER_LINEAR, RS::CANVAS_ITEM_TEXTURE_REPEAT_DISABLED);
+
+	Item items[3];
+	for (int i = 0; i < 3; i++) {
+		items[i].final_transform = Transform2D(0, Vector2(100 * i, 0));
+		items[i].final_modulate = Color(1, 1, 1, 0.5);
+		add_rect(items[i], Rect2(0, 0, 10, 20), texture, Color(1, 0, 0, 1));
+	}
+	add_items(batcher, items, 3);
+
+	REQUIRE(batcher.batches.size() == 1);
+	CHECK(batcher.batches[0].item == nullptr);
+	CHECK(batcher.batches[0].texture == texture);
+	CHECK(batcher.batches[0].filter == RS::CANVAS_ITEM_TEXTURE_FILTER_LINEAR);
+	CHECK(batcher.batches[0].command_count == 3);
+	CHECK(batcher.batches[0].index_count == 18);
+	CHECK(batcher.vertices.size() == 12);
+	CHECK(batcher.stats.batches == 1);
+	CHECK(batcher.stats.batched_commands == 3);
+
+	// Vertices are moved to canvas space, and the colors include the item modulate.
+	CHECK(get_position(batcher, 8).is_equal_approx(Vector2(200, 0)));
+	CHECK(get_position(batcher, 10).is_equal_approx(Vector2(210, 20)));
+	CHECK(batcher.vertices[4].color[0] == doctest::Approx(1));
+	CHECK(batcher.vertices[4].color[1] == doctest::Approx(0));
+	CHECK(batcher.vertices[4].color[3] == doctest::Approx(0.5));
+	CHECK(batcher.indices[6] == 4);
+	CHECK(batcher.indices[11] == 7);
+}
+
+TEST_CASE("[RendererCanvasBatcher] State changes split batches in draw order") {
+	RID texture_a = RID::from_uint64(1);
+	RID texture_b = RID::from_uint64(2);
+	RID material = RID::from_uint64(3);
+	TestBatcher batcher;
+	batcher.begin(Transform2D(), RS::CANVAS_ITEM_TEXTURE_FILTER_LINEAR, RS::CANVAS_ITEM_TEXTURE_REPEAT_DISABLED);
+
+	Item clip;
+	Item items[7];
+	add_rect(items[0], Rect2(0, 0, 10, 10), texture_a);
+	add_rect(items[1], Rect2(0, 0, 10, 10), texture_b);
+	add_rect(items[2], Rect2(0, 0, 10, 10), texture_b);
+	items[2].texture_filter = RS::CANVAS_ITEM_TEXTURE_FILTER_NEAREST;
+	add_rect(items[3], Rect2(0, 0, 10, 10), texture_b);
+	items[3].final_clip_owner = &clip;
+	// MSDF needs the rect in the fragment shader, so the item is drawn on its own.
+	add_rect(items[4], Rect2(0, 0, 10, 10), texture_b)->flags = RendererCanvasRender::CANVAS_RECT_MSDF;
+	items[4].final_clip_owner = &clip;
+	add_rect(items[5], Rect2(0, 0, 10, 10), texture_b);
+	items[5].final_clip_owner = &clip;
+	add_rect(items[6], Rect2(0, 0, 10, 10), texture_b);
+	items[6].final_clip_owner = &clip;
+
+	add_items(batcher, items, 6);
+	batcher.add_item(&items[6], material, true);
+
+	REQUIRE(batcher.batches.size() == 7);
+	CHECK(batcher.batches[0].texture == texture_a);
+	CHECK(batcher.batches[1].texture == texture_b);
+	CHECK_MESSAGE(batcher.batches[2].filter == RS::CANVAS_ITEM_TEXTURE_FILTER_NEAREST, "A different filter needs another batch.");
+	CHECK_MESSAGE(batcher.batches[3].clip_owner == &clip, "A different clip needs another batch.");
+	CHECK(batcher.batches[4].item == &items[4]);
+	CHECK_MESSAGE(batcher.batches[5].index_from == batcher.batches[3].index_from + 6, "Batches can't be extended across an item drawn on its own.");
+	CHECK(batcher.batches[6].material == material);
+	CHECK(batcher.stats.batches == 6);
+	CHECK(batcher.stats.unbatched_items == 1);
+
+	Item mesh;
+	mesh.alloc_command<Item::CommandMesh>();
+	CHECK_FALSE(batcher.is_item_batchable(&mesh));
+	Item empty;
+	CHECK_FALSE(batcher.is_item_batchable(&empty));
+}
+
+TEST_CASE("[RendererCanvasBatcher] Rect regions and flips") {
+	RID texture = RID::from_uint64(1);
+	TestBatcher batcher;
+	batcher.begin(Transform2D(), RS::CANVAS_ITEM_TEXTURE_FILTER_LINEAR, RS::CANVAS_ITEM_TEXTURE_REPEAT_DISABLED);
+
+	Item item;
+	Item::CommandRect *rect = add_rect(item, Rect2(10, 10, 16, 8), texture);
+	rect->source = Rect2(16, 8, 16, 8);
+	rect->flags = RendererCanvasRender::CANVAS_RECT_REGION | RendererCanvasRender::CANVAS_RECT_FLIP_H;
+	// Tiling switches the repeat mode of the item.
+	add_rect(item, Rect2(0, 0, -4, 4), texture)->flags = RendererCanvasRender::CANVAS_RECT_TILE;
+	add_items(batcher, &item, 1);
+
+	REQUIRE(batcher.batches.size() == 2);
+	CHECK(batcher.batches[1].repeat == RS::CANVAS_ITEM_TEXTURE_REPEAT_ENABLED);
+
+	// The source is normalized by the 64x32 texture, flipping mirrors the vertices like the quad shader does.
+	CHECK(get_uv(batcher, 0).is_equal_approx(Vector2(0.25, 0.25)));
+	CHECK(get_uv(batcher, 2).is_equal_approx(Vector2(0.5, 0.5)));
+	CHECK(get_position(batcher, 0).is_equal_approx(Vector2(26, 10)));
+	CHECK(get_position(batcher, 2).is_equal_approx(Vector2(10, 18)));
+
+	// Negative sizes are drawn from the other corner.
+	CHECK(get_position(batcher, 4).is_equal_approx(Vector2(-4, 0)));
+	CHECK(get_position(batcher, 6).is_equal_approx(Vector2(0, 4)));
+	CHECK(get_uv(batcher, 6).is_equal_approx(Vector2(1, 1)));
+}
+
+TEST_CASE("[RendererCanvasBatcher] Nine patches") {
+	RID texture = RID::from_uint64(1);
+	TestBatcher batcher;
+	batcher.begin(Transform2D(), RS::CANVAS_ITEM_TEXTURE_FILTER_LINEAR, RS::CANVAS_ITEM_TEXTURE_REPEAT_DISABLED);
+
+	Item item;
+	Item::CommandNinePatch *np = item.alloc_command<Item::CommandNinePatch>();
+	np->rect = Rect2(0, 0, 100, 50);
+	np->texture = texture;
+	np->color = Color(1, 1, 1, 1);
+	np->axis_x = RS::NINE_PATCH_STRETCH;
+	np->axis_y = RS::NINE_PATCH_STRETCH;
+	np->margin[SIDE_LEFT] = 4;
+	np->margin[SIDE_TOP] = 8;
+	np->margin[SIDE_RIGHT] = 16;
+	np->margin[SIDE_BOTTOM] = 4;
+	add_items(batcher, &item, 1);
+
+	REQUIRE(batcher.batches.size() == 1);
+	CHECK(batcher.batches[0].index_count == 9 * 6);
+
+	// Top left corner keeps its size in pixels, the center stretches.
+	CHECK(get_position(batcher, 2).is_equal_approx(Vector2(4, 8)));
+	CHECK(get_uv(batcher, 2).is_equal_approx(Vector2(4.0 / 64, 8.0 / 32)));
+	CHECK(get_position(batcher, 4 * 4 + 2).is_equal_approx(Vector2(84, 46)));
+	CHECK(get_uv(batcher, 4 * 4 + 2).is_equal_approx(Vector2(48.0 / 64, 28.0 / 32)));
+
+	batcher.begin(Transform2D(), RS::CANVAS_ITEM_TEXTURE_FILTER_LINEAR, RS::CANVAS_ITEM_TEXTURE_REPEAT_DISABLED);
+	np->draw_center = false;
+	add_items(batcher, &item, 1);
+	CHECK(batcher.batches[0].index_count == 8 * 6);
+
+	np->axis_x = RS::NINE_PATCH_TILE;
+	CHECK_FALSE_MESSAGE(batcher.is_item_batchable(&item), "Tiled nine patches are mapped per pixel.");
+	np->axis_x = RS::NINE_PATCH_STRETCH;
+	np->margin[SIDE_LEFT] = 90;
+	CHECK_FALSE_MESSAGE(batcher.is_item_batchable(&item), "Overlapping margins can't be split into a grid.");
+}
+
+TEST_CASE("[RendererCanvasBatcher] Polygons and primitives") {
+	TestBatcher batcher;
+	batcher.begin(Transform2D(), RS::CANVAS_ITEM_TEXTURE_FILTER_LINEAR, RS::CANVAS_ITEM_TEXTURE_REPEAT_DISABLED);
+
+	RendererCanvasBatcher::Polygon polygon;
+	polygon.points.push_back(Vector2(0, 0));
+	polygon.points.push_back(Vector2(10, 0));
+	polygon.points.push_back(Vector2(10, 10));
+	polygon.points.push_back(Vector2(0, 10));
+	polygon.colors.push_back(Color(0, 1, 0, 1));
+	polygon.indices.push_back(0);
+	polygon.indices.push_back(1);
+	polygon.indices.push_back(2);
+	polygon.indices.push_back(0);
+	polygon.indices.push_back(2);
+	polygon.indices.push_back(3);
+	batcher.polygons[7] = polygon;
+
+	Item items[2];
+	Item::CommandPolygon *command = items[0].alloc_command<Item::CommandPolygon>();
+	command->primitive = RS::PRIMITIVE_TRIANGLES;
+	command->polygon.polygon_id = 7;
+	items[0].final_transform = Transform2D(0, Vector2(5, 5));
+
+	Item::CommandPrimitive *primitive = items[1].alloc_command<Item::CommandPrimitive>();
+	primitive->point_count = 4;
+	for (int i = 0; i < 4; i++) {
+		primitive->points[i] = polygon.points[i];
+		primitive->colors[i] = Color(1, 1, 1, 1);
+	}
+
+	add_items(batcher, items, 2);
+
+	REQUIRE(batcher.batches.size() == 1);
+	CHECK(batcher.batches[0].command_count == 2);
+	CHECK(batcher.batches[0].index_count == 12);
+	CHECK(batcher.vertices.size() == 8);
+	CHECK(get_position(batcher, 2).is_equal_approx(Vector2(15, 15)));
+	CHECK_MESSAGE(batcher.vertices[3].color[0] == doctest::Approx(0), "A single polygon color applies to all vertices.");
+	CHECK(batcher.indices[6] == 4);
+	CHECK(batcher.indices[11] == 7);
+
+	command->primitive = RS::PRIMITIVE_LINES;
+	CHECK_FALSE(batcher.is_item_batchable(&items[0]));
+	command->primitive = RS::PRIMITIVE_TRIANGLES;
+	command->polygon.polygon_id = 8;
+	CHECK_FALSE_MESSAGE(batcher.is_item_batchable(&items[0]), "Polygons without a copy of their arrays are drawn on their own.");
+	primitive->point_count = 2;
+	CHECK_FALSE(batcher.is_item_batchable(&items[1]));
+
+	// Not allocated through the renderer, don't let the items free it.
+	command->polygon.polygon_id = 0;
+}
+
+static Item *make_sprites(int p_item_count, int p_texture_count) {
+	Item *items = memnew_arr(Item, p_item_count);
+	for (int i = 0; i < p_item_count; i++) {
+		items[i].final_transform = Transform2D(0, Vector2((i % 100) * 16, (i / 100) * 16));
+		// Runs of 250 sprites share a texture, like a tile map drawn per layer.
+		add_rect(items[i], Rect2(0, 0, 16, 16), RID::from_uint64(1 + (i / 250) % p_texture_count));
+	}
+	return items;
+}
+
+TEST_CASE("[RendererCanvasBatcher] Batching 10k sprites") {
+	const int item_count = 10000;
+
+	TestBatcher batcher;
+	Item *items = make_sprites(item_count, 4);
+
+	batcher.begin(Transform2D(), RS::CANVAS_ITEM_TEXTURE_FILTER_LINEAR, RS::CANVAS_ITEM_TEXTURE_REPEAT_DISABLED);
+	add_items(batcher, items, item_count);
+
+	CHECK(batcher.stats.batched_commands == item_count);
+	CHECK(batcher.stats.batches == item_count / 250);
+
+	memdelete_arr(items);
+}
+
+void benchmark() {
+	const int item_count = 10000;
+	const int frame_count = 100;
+
+	TestBatcher batcher;
+	Item *items = make_sprites(item_count, 4);
+
+	uint64_t usec = 0;
+	for (int i = 0; i < frame_count; i++) {
+		uint64_t time = OS::get_singleton()->get_ticks_usec();
+		batcher.begin(Transform2D(), RS::CANVAS_ITEM_TEXTURE_FILTER_LINEAR, RS::CANVAS_ITEM_TEXTURE_REPEAT_DISABLED);
+		add_items(batcher, items, item_count);
+		usec += OS::get_singleton()->get_ticks_usec() - time;
+	}
+
+	print_line(vformat("Batching %d sprites: %d draw calls instead of %d, built in %d usec per frame.", item_count, batcher.stats.batches, item_count, usec / frame_count));
+
+	memdelete_arr(items);
+}
+
+} // namespace TestRendererCanvasBatcher
+
+#endif // TEST_RENDERER_CANVAS_BATCHER_H
@@ -0,0 +1,202 @@
+/*************************************************************************/
+/*  test_renderer_canvas_cull.h                                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_RENDERER_CANVAS_CULL_H
+#define TEST_RENDERER_CANVAS_CULL_H
+
+#include "core/math/random_pcg.h"
+#include "core/os/os.h"
+#include "servers/display_server.h"
+#include "servers/rendering/renderer_canvas_cull.h"
+#include "servers/rendering/rendering_server_default.h"
+#include "servers/rendering/rendering_server_globals.h"
+
+#include "tests/test_macros.h"
+
+namespace TestRendererCanvasCull {
+
+struct Dashboard {
+	RID canvas;
+	Vector<RID> items;
+	Vector<RID> leaves;
+};
+
+// Panels of rows of small widgets, most of them scrolled out of view.
+static Dashboard create_dashboard(int p_panels, int p_rows, int p_widgets) {
+	RenderingServer *rs = RenderingServer::get_singleton();
+	Dashboard dashboard;
+	dashboard.canvas = rs->canvas_create();
+
+	RID root = rs->canvas_item_create();
+	rs->canvas_item_set_parent(root, dashboard.canvas);
+	dashboard.items.push_back(root);
+
+	for (int i = 0; i < p_panels; i++) {
+		RID panel = rs->canvas_item_create();
+		rs->canvas_item_set_parent(panel, root);
+		rs->canvas_item_set_transform(panel, Transform2D(0, Vector2((i % 10) * 400, (i / 10) * 400)));
+		rs->canvas_item_set_clip(panel, true);
+		rs->canvas_item_add_rect(panel, Rect2(0, 0, 390, 390), Color(0.2, 0.2, 0.2));
+		dashboard.items.push_back(panel);
+
+		for (int j = 0; j < p_rows; j++) {
+			RID row = rs->canvas_item_create();
+			rs->canvas_item_set_parent(row, panel);
+			rs->canvas_item_set_transform(row, Transform2D(0, Vector2(0, j * 40)));
+			dashboard.items.push_back(row);
+
+			for (int k = 0; k < p_widgets; k++) {
+				RID widget = rs->canvas_item_create();
+				rs->canvas_item_set_parent(widget, row);
+				rs->canvas_item_set_transform(widget, Transform2D(0, Vector2((k % 25) * 16, (k / 25) * 10)));
+				rs->canvas_item_add_rect(widget, Rect2(0, 0, 14, 8), Color(1, 1, 1));
+				dashboard.items.push_back(widget);
+				dashboard.leaves.push_back(widget);
+			}
+		}
+	}
+
+	return dashboard;
+}
+
+static void free_dashboard(const Dashboard &p_dashboard) {
+	RenderingServer *rs = RenderingServer::get_singleton();
+	for (int i = p_dashboard.items.size() - 1; i >= 0; i--) {
+		rs->free(p_dashboard.items[i]);
+	}
+	rs->free(p_dashboard.canvas);
+}
+
+static void render(const Dashboard &p_dashboard) {
+	RendererCanvasCull::Canvas *canvas = RSG::canvas->canvas_owner.get_or_null(p_dashboard.canvas);
+	RSG::canvas->render_canvas(RID(), canvas, Transform2D(), nullptr, nullptr, Rect2(0, 0, 1920, 1080), RS::CANVAS_ITEM_TEXTURE_FILTER_LINEAR, RS::CANVAS_ITEM_TEXTURE_REPEAT_DISABLED, false, false);
+}
+
+// The draw list is linked through the items, so the next pointers describe it completely.
+static Vector<RendererCanvasRender::Item *> get_draw_list(const Dashboard &p_dashboard) {
+	Vector<RendererCanvasRender::Item *> list;
+	for (int i = 0; i < p_dashboard.items.size(); i++) {
+		list.push_back(RSG::canvas->canvas_item_owner.get_or_null(p_dashboard.items[i])->next);
+	}
+	return list;
+}
+
+static uint64_t render_frames(const Dashboard &p_dashboard, int p_frames, int p_changes_per_frame) {
+	RenderingServer *rs = RenderingServer::get_singleton();
+	RandomPCG rng(1234);
+
+	uint64_t usec = 0;
+	for (int i = 0; i < p_frames; i++) {
+		for (int j = 0; j < p_changes_per_frame; j++) {
+			RID widget = p_dashboard.leaves[rng.rand() % p_dashboard.leaves.size()];
+			rs->canvas_item_set_modulate(widget, Color(1, 1, 1, rng.randf()));
+		}
+
+		uint64_t time = OS::get_singleton()->get_ticks_usec();
+		render(p_dashboard);
+		usec += OS::get_singleton()->get_ticks_usec() - time;
+	}
+	return usec / p_frames;
+}
+
+TEST_CASE("[SceneTree][RendererCanvasCull] Threaded culling matches serial culling") {
+	RenderingServer *rs = RenderingServer::get_singleton();
+	RendererCanvasCull *canvas_cull = RSG::canvas;
+	uint32_t threshold = canvas_cull->thread_cull_threshold;
+
+	Dashboard dashboard = create_dashboard(20, 10, 50);
+
+	canvas_cull->thread_cull_threshold = UINT32_MAX;
+	render(dashboard);
+	Vector<RendererCanvasRender::Item *> serial = get_draw_list(dashboard);
+
+	canvas_cull->thread_cull_threshold = 0;
+	render(dashboard);
+	CHECK_MESSAGE(get_draw_list(dashboard) == serial, "Threaded culling should draw the same items in the same order.");
+	render(dashboard);
+	CHECK_MESSAGE(get_draw_list(dashboard) == serial, "Cached runs should draw the same items in the same order.");
+
+	// Reorder and hide a few widgets, the cached runs containing them must be culled again.
+	rs->canvas_item_set_draw_behind_parent(dashboard.leaves[10], true);
+	rs->canvas_item_set_visible(dashboard.leaves[20], false);
+	rs->canvas_item_set_z_index(dashboard.leaves[30], 1);
+	rs->canvas_item_set_transform(dashboard.items[1], Transform2D(0, Vector2(5, 5)));
+
+	render(dashboard);
+	Vector<RendererCanvasRender::Item *> threaded = get_draw_list(dashboard);
+	canvas_cull->thread_cull_threshold = UINT32_MAX;
+	render(dashboard);
+	CHECK_MESSAGE(get_draw_list(dashboard) == threaded, "Changed items should invalidate the cached runs.");
+
+	canvas_cull->thread_cull_threshold = threshold;
+	free_dashboard(dashboard);
+}
+
+void benchmark() {
+	const int frame_count = 20;
+
+	// Same servers the scene tree tests get, a headless display server with the dummy renderer.
+	Error err = OK;
+	for (int i = 0; i < DisplayServer::get_create_function_count(); i++) {
+		if (String("headless") == DisplayServer::get_create_function_name(i)) {
+			DisplayServer::create(i, "", DisplayServer::WindowMode::WINDOW_MODE_MINIMIZED, DisplayServer::VSyncMode::VSYNC_ENABLED, 0, Vector2i(0, 0), err);
+			break;
+		}
+	}
+	memnew(RenderingServerDefault());
+	RenderingServerDefault::get_singleton()->init();
+	RenderingServerDefault::get_singleton()->set_render_loop_enabled(false);
+
+	RendererCanvasCull *canvas_cull = RSG::canvas;
+	Dashboard dashboard = create_dashboard(100, 10, 100);
+
+	canvas_cull->thread_cull_threshold = UINT32_MAX;
+	render(dashboard);
+	uint64_t serial_usec = render_frames(dashboard, frame_count, 0);
+
+	canvas_cull->thread_cull_threshold = 0;
+	render(dashboard);
+	uint64_t static_usec = render_frames(dashboard, frame_count, 0);
+	uint64_t changing_usec = render_frames(dashboard, frame_count, 100);
+
+	print_line(vformat("Culling %d canvas items: %d usec per frame serially, %d usec threaded with an unchanged tree, %d usec threaded with 100 changed items per frame.",
+			dashboard.items.size(), serial_usec, static_usec, changing_usec));
+
+	free_dashboard(dashboard);
+
+	RenderingServer::get_singleton()->sync();
+	RenderingServer::get_singleton()->finish();
+	memdelete(RenderingServer::get_singleton());
+	memdelete(DisplayServer::get_singleton());
+}
+
+} // namespace TestRendererCanvasCull
+
+#endif // TEST_RENDERER_CANVAS_CULL_H
@@ -0,0 +1,365 @@
+/*************************************************************************/
+/*  test_renderer_scene_cull.h                                           */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_RENDERER_SCENE_CULL_H
+#define TEST_RENDERER_SCENE_CULL_H
+
+#include "core/math/random_pcg.h"
+#include "core/os/os.h"
+#include "core/templates/thread_work_pool.h"
+#include "servers/rendering/rasterizer_dummy.h"
+#include "servers/rendering/renderer_scene_cull.h"
+#include "servers/rendering/rendering_server_globals.h"
+
+#include "tests/test_macros.h"
+
+namespace TestRendererSceneCull {
+
+// Same layout as the planes of a directional shadow cascade: right/left, top/bottom, near/far.
+static Vector<Plane> cascade_planes(const Vector3 &p_center, real_t p_half_size) {
+	Vector<Plane> planes;
+	planes.resize(6);
+	planes.write[0] = Plane(Vector3(1, 0, 0), p_center.x + p_half_size);
+	planes.write[1] = Plane(Vector3(-1, 0, 0), -(p_center.x - p_half_size));
+	planes.write[2] = Plane(Vector3(0, 1, 0), p_center.y + p_half_size);
+	planes.write[3] = Plane(Vector3(0, -1, 0), -(p_center.y - p_half_size));
+	planes.write[4] = Plane(Vector3(0, 0, 1), p_center.z + p_half_size + 1e6);
+	planes.write[5] = Plane(Vector3(0, 0, -1), -(p_center.z - p_half_size));
+	return planes;
+}
+
+static Vector<Plane> enlarge_planes(const Vector<Plane> &p_planes, real_t p_margin) {
+	Vector<Plane> planes = p_planes;
+	for (int i = 0; i < planes.size(); i++) {
+		planes.write[i].d += p_margin;
+	}
+	return planes;
+}
+
+TEST_CASE("[RendererSceneCull] Shadow cascade cull cache containment") {
+	RendererSceneCull::ShadowCascadeCullCache cache;
+	cache.frustum = RendererSceneCull::Frustum(enlarge_planes(cascade_planes(Vector3(), 10), 1));
+
+	CHECK_MESSAGE(cache.contains(cascade_planes(Vector3(), 10)), "The frustum the cache was culled with should be contained.");
+	CHECK_MESSAGE(cache.contains(cascade_planes(Vector3(0.5, -0.5, 0.5), 10)), "Movements within the margin should be contained.");
+	CHECK_MESSAGE(!cache.contains(cascade_planes(Vector3(2, 0, 0), 10)), "Movements beyond the margin should not be contained.");
+	CHECK_MESSAGE(!cache.contains(cascade_planes(Vector3(), 12)), "Larger cascades should not be contained.");
+
+	Vector<Plane> rotated = cascade_planes(Vector3(), 5);
+	rotated.write[0].normal = Vector3(1, 0.01, 0).normalized();
+	CHECK_MESSAGE(!cache.contains(rotated), "A rotated light should not be contained.");
+}
+
+// LOD 1 is used past 100 units, as with a single LOD whose switch falls at that distance.
+static int lod_for_distance(RendererSceneCull::InstanceLOD &r_lod, float p_distance, float p_hysteresis, uint64_t p_frame) {
+	float distance_scale = r_lod.update(p_distance, p_hysteresis, p_frame);
+	return p_distance * distance_scale >= 100.0 ? 1 : 0;
+}
+
+TEST_CASE("[RendererSceneCull] Mesh LOD distance hysteresis") {
+	RendererSceneCull::InstanceLOD lod;
+	RendererSceneCull::InstanceLOD lod_no_hysteresis;
+
+	// A camera bobbing around the switch.
+	int changes = 0;
+	int changes_no_hysteresis = 0;
+	int last = lod_for_distance(lod, 101, 0.1, 1);
+	int last_no_hysteresis = lod_for_distance(lod_no_hysteresis, 101, 0.0, 1);
+	for (uint64_t frame = 2; frame < 100; frame++) {
+		float distance = 100.0 + ((frame & 1) ? 3.0 : -3.0);
+		int current = lod_for_distance(lod, distance, 0.1, frame);
+		int current_no_hysteresis = lod_for_distance(lod_no_hysteresis, distance, 0.0, frame);
+		changes += current != last;
+		changes_no_hysteresis += current_no_hysteresis != last_no_hysteresis;
+		last = current;
+		last_no_hysteresis = current_no_hysteresis;
+	}
+	CHECK_MESSAGE(changes == 0, "Moves within the hysteresis band shouldn't change the LOD.");
+	CHECK_MESSAGE(changes_no_hysteresis == 98, "Without hysteresis the LOD follows the camera every frame.");
+
+	// Moving away and back, the switch is delayed both ways.
+	RendererSceneCull::InstanceLOD walk;
+	uint64_t frame = 1;
+	float switch_out = -1.0;
+	for (float distance = 50.5; distance < 150.0; distance += 1.0) {
+		if (lod_for_distance(walk, distance, 0.1, frame++) == 1 && switch_out < 0.0) {
+			switch_out = distance;
+		}
+	}
+	float switch_in = -1.0;
+	for (float distance = 149.5; distance > 50.0; distance -= 1.0) {
+		if (lod_for_distance(walk, distance, 0.1, frame++) == 0 && switch_in < 0.0) {
+			switch_in = distance;
+		}
+	}
+	CHECK(switch_out == doctest::Approx(110.5));
+	CHECK(switch_in == doctest::Approx(89.5));
+
+	// Other viewports in the same frame don't move the state.
+	float scale = walk.update(50.0, 0.1, frame);
+	CHECK(walk.update(500.0, 0.1, frame) * 500.0 == doctest::Approx(scale * 50.0));
+
+	CHECK_MESSAGE(walk.update(200.0, 0.1, frame + 5) == doctest::Approx(1.0), "Instances that weren't visible last frame start over.");
+	CHECK(walk.update(0.0, 0.1, frame + 6) == doctest::Approx(1.0));
+}
+
+// The dummy storage has no lights or meshes, so report a shadowed directional light and a few unit cubes.
+class ShadowCasterStorage : public RasterizerStorageDummy {
+public:
+	RID light = RID::from_uint64(uint64_t(1) << 62);
+	RID mesh = RID::from_uint64((uint64_t(1) << 62) + 1);
+
+	RS::InstanceType get_base_type(RID p_rid) const override {
+		if (p_rid == light) {
+			return RS::INSTANCE_LIGHT;
+		}
+		return p_rid == mesh ? RS::INSTANCE_MESH : RS::INSTANCE_NONE;
+	}
+	AABB mesh_get_aabb(RID p_mesh, RID p_skeleton = RID()) override { return AABB(Vector3(-1, -1, -1), Vector3(2, 2, 2)); }
+	RS::LightType light_get_type(RID p_light) const override { return RS::LIGHT_DIRECTIONAL; }
+	bool light_has_shadow(RID p_light) const override { return true; }
+};
+
+struct ShadowCullCacheFrame {
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+};
+
+static ShadowCullCacheFrame draw_shadow_cascades(RID p_camera, RID p_scenario) {
+	RendererSceneCull *scene = RendererSceneCull::singleton;
+	scene->update();
+
+	// Any valid atlas enables directional shadows, the dummy renderer never reads it.
+	Ref<XRInterface> xr_interface;
+	scene->render_camera(RID(), p_camera, p_scenario, RID(), Size2(1024, 600), 1.0, RID::from_uint64((uint64_t(1) << 62) + 2), xr_interface, nullptr);
+
+	ShadowCullCacheFrame frame;
+	frame.hits = scene->get_rendering_info(RS::RENDERING_INFO_SHADOW_CULL_CACHE_HITS_IN_FRAME);
+	frame.misses = scene->get_rendering_info(RS::RENDERING_INFO_SHADOW_CULL_CACHE_MISSES_IN_FRAME);
+	return frame;
+}
+
+TEST_CASE("[SceneTree][RendererSceneCull] Shadow cascade cull cache invalidation") {
+	RendererSceneCull *scene = RendererSceneCull::singleton;
+	ShadowCasterStorage storage;
+	RendererStorage *prev_storage = RSG::storage;
+	RSG::storage = &storage;
+
+	RID scenario = scene->scenario_allocate();
+	scene->scenario_initialize(scenario);
+
+	RID camera = scene->camera_allocate();
+	scene->camera_initialize(camera);
+	scene->camera_set_perspective(camera, 75, 0.05, 50);
+
+	RID light = scene->instance_allocate();
+	scene->instance_initialize(light);
+	scene->instance_set_base(light, storage.light);
+	scene->instance_set_scenario(light, scenario);
+	scene->instance_set_transform(light, Transform3D().looking_at(Vector3(0.3, -1, 0.2), Vector3(0, 1, 0)));
+
+	// One caster in front of the camera, the other far outside the single orthogonal cascade.
+	RID near_caster = scene->instance_allocate();
+	scene->instance_initialize(near_caster);
+	scene->instance_set_base(near_caster, storage.mesh);
+	scene->instance_set_scenario(near_caster, scenario);
+	scene->instance_set_transform(near_caster, Transform3D(Basis(), Vector3(0, 0, -10)));
+
+	RID far_caster = scene->instance_allocate();
+	scene->instance_initialize(far_caster);
+	scene->instance_set_base(far_caster, storage.mesh);
+	scene->instance_set_scenario(far_caster, scenario);
+	scene->instance_set_transform(far_caster, Transform3D(Basis(), Vector3(1000, 0, 1000)));
+
+	ShadowCullCacheFrame frame = draw_shadow_cascades(camera, scenario);
+	CHECK_MESSAGE(frame.misses == 1, "The first frame should cull the cascade.");
+	CHECK(frame.hits == 0);
+
+	frame = draw_shadow_cascades(camera, scenario);
+	CHECK_MESSAGE(frame.hits == 1, "Nothing moved, so the cascade should be reused.");
+	CHECK(frame.misses == 0);
+
+	scene->instance_set_transform(far_caster, Transform3D(Basis(), Vector3(1000, 0, 1010)));
+	frame = draw_shadow_cascades(camera, scenario);
+	CHECK_MESSAGE(frame.hits == 1, "Moving an instance outside the cascade shouldn't invalidate it.");
+	CHECK(frame.misses == 0);
+
+	scene->instance_set_transform(near_caster, Transform3D(Basis(), Vector3(1, 0, -10)));
+	frame = draw_shadow_cascades(camera, scenario);
+	CHECK_MESSAGE(frame.misses == 1, "Moving an instance inside the cascade should invalidate it.");
+	CHECK(frame.hits == 0);
+
+	frame = draw_shadow_cascades(camera, scenario);
+	CHECK(frame.hits == 1);
+
+	scene->instance_set_transform(far_caster, Transform3D(Basis(), Vector3(0, 0, -20)));
+	frame = draw_shadow_cascades(camera, scenario);
+	CHECK_MESSAGE(frame.misses == 1, "Moving an instance into the cascade should invalidate it.");
+
+	scene->free(far_caster);
+	scene->free(near_caster);
+	scene->free(light);
+	scene->free(camera);
+	scene->free(scenario);
+	RSG::storage = prev_storage;
+}
+
+struct BlockCull {
+	const LocalVector<RendererSceneCull::InstanceBoundsBlock> *blocks = nullptr;
+	const RendererSceneCull::Frustum *frustum = nullptr;
+	uint32_t job_count = 1;
+	LocalVector<uint32_t> visible_counts;
+
+	void cull(uint32_t p_job, void *p_userdata) {
+		uint32_t from = p_job * blocks->size() / job_count;
+		uint32_t to = (p_job + 1) * blocks->size() / job_count;
+		uint32_t count = 0;
+		for (uint32_t i = from; i < to; i++) {
+			uint32_t mask = (*blocks)[i].in_frustum_mask(*frustum);
+			// Population count of the 4 bits.
+			count += (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+		}
+		visible_counts[p_job] = count;
+	}
+};
+
+static void random_bounds(uint32_t p_count, real_t p_range, LocalVector<RendererSceneCull::InstanceBounds> &r_bounds, LocalVector<RendererSceneCull::InstanceBoundsBlock> &r_blocks) {
+	r_blocks.resize(p_count / RendererSceneCull::InstanceBoundsBlock::BLOCK_SIZE);
+
+	RandomPCG rng(1234);
+	for (uint32_t i = 0; i < p_count; i++) {
+		Vector3 position = Vector3(rng.randf(), rng.randf(), rng.randf()) * p_range - Vector3(p_range, p_range, p_range) * 0.5;
+		r_bounds.push_back(RendererSceneCull::InstanceBounds(AABB(position, Vector3(2, 2, 2))));
+		r_blocks[i >> RendererSceneCull::InstanceBoundsBlock::BLOCK_SHIFT].set(i & RendererSceneCull::InstanceBoundsBlock::BLOCK_MASK, r_bounds[i]);
+	}
+}
+
+static RendererSceneCull::Frustum camera_frustum() {
+	CameraMatrix projection;
+	projection.set_perspective(75, 16.0 / 9.0, 0.05, 500);
+	Transform3D camera = Transform3D().looking_at(Vector3(1, -0.2, 0.5), Vector3(0, 1, 0));
+	return RendererSceneCull::Frustum(projection.get_projection_planes(camera));
+}
+
+TEST_CASE("[RendererSceneCull] Block frustum culling matches per instance culling") {
+	// Small enough that many boxes straddle the frustum planes.
+	const uint32_t instance_count = 4096;
+
+	LocalVector<RendererSceneCull::InstanceBounds> bounds;
+	LocalVector<RendererSceneCull::InstanceBoundsBlock> blocks;
+	random_bounds(instance_count, 100, bounds, blocks);
+
+	RendererSceneCull::Frustum frustum = camera_frustum();
+
+	bool masks_match = true;
+	uint32_t visible_instances = 0;
+	for (uint32_t i = 0; i < instance_count; i++) {
+		bool visible = bounds[i].in_frustum(frustum);
+		uint32_t mask = blocks[i >> RendererSceneCull::InstanceBoundsBlock::BLOCK_SHIFT].in_frustum_mask(frustum);
+		masks_match = masks_match && visible == bool(mask & (1 << (i & RendererSceneCull::InstanceBoundsBlock::BLOCK_MASK)));
+		visible_instances += visible;
+	}
+	CHECK_MESSAGE(masks_match, "Block and per instance frustum tests should agree.");
+	CHECK(visible_instances > 0);
+	CHECK(visible_instances < instance_count);
+
+	ThreadWorkPool thread_pool;
+	thread_pool.init(4);
+
+	BlockCull block_cull;
+	block_cull.blocks = &blocks;
+	block_cull.frustum = &frustum;
+	block_cull.job_count = thread_pool.get_thread_count();
+	block_cull.visible_counts.resize(block_cull.job_count);
+	thread_pool.do_work(block_cull.job_count, &block_cull, &BlockCull::cull, (void *)nullptr);
+	thread_pool.finish();
+
+	uint32_t threaded_visible_instances = 0;
+	for (uint32_t i = 0; i < block_cull.job_count; i++) {
+		threaded_visible_instances += block_cull.visible_counts[i];
+	}
+	CHECK_MESSAGE(threaded_visible_instances == visible_instances, "Threaded block frustum tests should agree.");
+}
+
+void benchmark() {
+	const uint32_t instance_count = 1000000;
+	const uint32_t frame_count = 10;
+
+	LocalVector<RendererSceneCull::InstanceBounds> bounds;
+	LocalVector<RendererSceneCull::InstanceBoundsBlock> blocks;
+	random_bounds(instance_count, 1000, bounds, blocks);
+
+	RendererSceneCull::Frustum frustum = camera_frustum();
+
+	uint32_t visible_instances = 0;
+	uint64_t instance_usec = OS::get_singleton()->get_ticks_usec();
+	for (uint32_t frame = 0; frame < frame_count; frame++) {
+		visible_instances = 0;
+		for (uint32_t i = 0; i < instance_count; i++) {
+			if (bounds[i].in_frustum(frustum)) {
+				visible_instances++;
+			}
+		}
+	}
+	instance_usec = OS::get_singleton()->get_ticks_usec() - instance_usec;
+
+	BlockCull block_cull;
+	block_cull.blocks = &blocks;
+	block_cull.frustum = &frustum;
+	block_cull.visible_counts.resize(1);
+
+	uint64_t block_usec = OS::get_singleton()->get_ticks_usec();
+	for (uint32_t frame = 0; frame < frame_count; frame++) {
+		block_cull.cull(0, nullptr);
+	}
+	block_usec = OS::get_singleton()->get_ticks_usec() - block_usec;
+
+	ThreadWorkPool thread_pool;
+	thread_pool.init();
+
+	block_cull.job_count = thread_pool.get_thread_count();
+	block_cull.visible_counts.resize(block_cull.job_count);
+
+	uint64_t threaded_usec = OS::get_singleton()->get_ticks_usec();
+	for (uint32_t frame = 0; frame < frame_count; frame++) {
+		thread_pool.do_work(block_cull.job_count, &block_cull, &BlockCull::cull, (void *)nullptr);
+	}
+	threaded_usec = OS::get_singleton()->get_ticks_usec() - threaded_usec;
+
+	thread_pool.finish();
+
+	print_line(vformat("Frustum culling %d instances (%d visible): %d usec per frame testing each instance, %d usec per frame testing blocks of 4.",
+			instance_count, visible_instances, instance_usec / frame_count, block_usec / frame_count));
+	print_line(vformat("Blocks of 4 on %d threads: %d usec per frame.", block_cull.job_count, threaded_usec / frame_count));
+}
+
+} // namespace TestRendererSceneCull
+
+#endif // TEST_RENDERER_SCENE_CULL_H
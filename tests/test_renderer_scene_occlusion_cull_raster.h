@@ -0,0 +1,159 @@
+/*************************************************************************/
+/*  test_renderer_scene_occlusion_cull_raster.h                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_RENDERER_SCENE_OCCLUSION_CULL_RASTER_H
+#define TEST_RENDERER_SCENE_OCCLUSION_CULL_RASTER_H
+
+#include "core/templates/thread_work_pool.h"
+#include "servers/rendering/renderer_scene_occlusion_cull_raster.h"
+
+#include "tests/test_macros.h"
+
+namespace TestRendererSceneOcclusionCullRaster {
+
+static const Size2i buffer_size = Size2i(64, 64);
+
+// Square facing the camera, centered on the -Z axis.
+static RID create_wall_occluder(RasterOcclusionCull *p_cull, real_t p_half_size) {
+	PackedVector3Array vertices;
+	vertices.push_back(Vector3(-p_half_size, -p_half_size, 0));
+	vertices.push_back(Vector3(p_half_size, -p_half_size, 0));
+	vertices.push_back(Vector3(p_half_size, p_half_size, 0));
+	vertices.push_back(Vector3(-p_half_size, p_half_size, 0));
+
+	PackedInt32Array indices;
+	indices.push_back(0);
+	indices.push_back(1);
+	indices.push_back(2);
+	indices.push_back(0);
+	indices.push_back(2);
+	indices.push_back(3);
+
+	RID occluder = p_cull->occluder_allocate();
+	p_cull->occluder_initialize(occluder);
+	p_cull->occluder_set_mesh(occluder, vertices, indices);
+	return occluder;
+}
+
+static bool is_aabb_occluded(RasterOcclusionCull *p_cull, RID p_buffer, const AABB &p_aabb, const Transform3D &p_cam_transform, const CameraMatrix &p_cam_projection) {
+	real_t bounds[6] = { p_aabb.position.x, p_aabb.position.y, p_aabb.position.z, p_aabb.position.x + p_aabb.size.x, p_aabb.position.y + p_aabb.size.y, p_aabb.position.z + p_aabb.size.z };
+	return p_cull->buffer_get_ptr(p_buffer)->is_occluded(bounds, p_cam_transform.origin, p_cam_transform.affine_inverse(), p_cam_projection, p_cam_projection.get_z_near());
+}
+
+TEST_CASE("[RasterOcclusionCull] Occluder depth and AABB tests") {
+	ThreadWorkPool thread_pool;
+	thread_pool.init();
+
+	RasterOcclusionCull *cull = memnew(RasterOcclusionCull);
+
+	RID scenario = RID::from_uint64(1);
+	RID instance = RID::from_uint64(2);
+	RID buffer = RID::from_uint64(3);
+
+	cull->add_scenario(scenario);
+	cull->add_buffer(buffer);
+	cull->buffer_set_scenario(buffer, scenario);
+	cull->buffer_set_size(buffer, buffer_size);
+
+	RID occluder = create_wall_occluder(cull, 5);
+	cull->scenario_set_instance(scenario, instance, occluder, Transform3D(Basis(), Vector3(0, 0, -10)), true);
+
+	RasterOcclusionCull::RasterHZBuffer *hz_buffer = static_cast<RasterOcclusionCull::RasterHZBuffer *>(cull->buffer_get_ptr(buffer));
+
+	SUBCASE("Perspective projection") {
+		Transform3D cam_transform;
+		CameraMatrix cam_projection;
+		cam_projection.set_perspective(60, 1, 0.05, 100);
+
+		cull->buffer_update(buffer, cam_transform, cam_projection, false, thread_pool);
+
+		CHECK_MESSAGE(
+				Math::is_equal_approx(hz_buffer->get_depth(buffer_size.x / 2, buffer_size.y / 2), 10.0f, 0.01f),
+				"The center of the buffer should hold the distance to the wall.");
+		CHECK_MESSAGE(
+				hz_buffer->get_depth(0, 0) == FLT_MAX,
+				"The corners of the buffer should not be covered by the wall.");
+
+		CHECK_MESSAGE(
+				is_aabb_occluded(cull, buffer, AABB(Vector3(-1, -1, -20), Vector3(2, 2, 2)), cam_transform, cam_projection),
+				"An AABB behind the wall should be occluded.");
+		CHECK_FALSE_MESSAGE(
+				is_aabb_occluded(cull, buffer, AABB(Vector3(-1, -1, -6), Vector3(2, 2, 2)), cam_transform, cam_projection),
+				"An AABB in front of the wall should not be occluded.");
+		CHECK_FALSE_MESSAGE(
+				is_aabb_occluded(cull, buffer, AABB(Vector3(10.5, -0.5, -20), Vector3(0.5, 1, 1)), cam_transform, cam_projection),
+				"An AABB next to the wall should not be occluded.");
+
+		// Disabled occluders are dropped from the buffer.
+		cull->scenario_set_instance(scenario, instance, occluder, Transform3D(Basis(), Vector3(0, 0, -10)), false);
+		cull->buffer_update(buffer, cam_transform, cam_projection, false, thread_pool);
+		CHECK(hz_buffer->get_depth(buffer_size.x / 2, buffer_size.y / 2) == FLT_MAX);
+	}
+
+	SUBCASE("Orthogonal projection") {
+		Transform3D cam_transform;
+		CameraMatrix cam_projection;
+		cam_projection.set_orthogonal(20, 1, 0.05, 100);
+
+		cull->buffer_update(buffer, cam_transform, cam_projection, true, thread_pool);
+
+		CHECK(Math::is_equal_approx(hz_buffer->get_depth(buffer_size.x / 2, buffer_size.y / 2), 10.0f, 0.01f));
+		CHECK(hz_buffer->get_depth(0, 0) == FLT_MAX);
+	}
+
+	SUBCASE("Occluders crossing the near plane") {
+		// The wall is rotated to become a floor that goes behind the camera.
+		cull->scenario_set_instance(scenario, instance, occluder, Transform3D(Basis(Vector3(1, 0, 0), -Math_PI / 2), Vector3(0, -1, 0)), true);
+
+		Transform3D cam_transform;
+		CameraMatrix cam_projection;
+		cam_projection.set_perspective(60, 1, 0.05, 100);
+
+		cull->buffer_update(buffer, cam_transform, cam_projection, false, thread_pool);
+
+		float depth = hz_buffer->get_depth(buffer_size.x / 2, 0);
+		CHECK_MESSAGE(
+				(depth > 0.05f && depth < 5.0f),
+				"The bottom of the buffer should be covered by the clipped floor.");
+		CHECK(hz_buffer->get_depth(buffer_size.x / 2, buffer_size.y - 1) == FLT_MAX);
+	}
+
+	cull->scenario_remove_instance(scenario, instance);
+	cull->free_occluder(occluder);
+	cull->remove_buffer(buffer);
+	cull->remove_scenario(scenario);
+	memdelete(cull);
+
+	thread_pool.finish();
+}
+
+} // namespace TestRendererSceneOcclusionCullRaster
+
+#endif // TEST_RENDERER_SCENE_OCCLUSION_CULL_RASTER_H
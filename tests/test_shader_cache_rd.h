@@ -0,0 +1,217 @@
+/*************************************************************************/
+/*  test_shader_cache_rd.h                                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_SHADER_CACHE_RD_H
+#define TEST_SHADER_CACHE_RD_H
+
+#include "core/io/dir_access.h"
+#include "core/io/file_access.h"
+#include "core/os/os.h"
+#include "servers/rendering/renderer_rd/shader_cache_rd.h"
+
+#include "tests/test_macros.h"
+
+namespace TestShaderCacheRD {
+
+static String make_cache_dir(const String &p_name) {
+	String path = OS::get_singleton()->get_cache_path().plus_file(p_name);
+	DirAccessRef da = DirAccess::create_for_path(path);
+	if (da->change_dir(path) == OK) {
+		da->erase_contents_recursive();
+	}
+	da->make_dir_recursive(path);
+	return path;
+}
+
+static Vector<uint8_t> make_shader_data(int p_size, int p_seed) {
+	// Compressible, like SPIR-V.
+	Vector<uint8_t> data;
+	data.resize(p_size);
+	for (int i = 0; i < p_size; i++) {
+		data.write[i] = uint8_t((i / 16 + p_seed) % 7);
+	}
+	return data;
+}
+
+static Vector<String> make_sources(const String &p_vertex, const String &p_fragment) {
+	Vector<String> sources;
+	sources.push_back(p_vertex);
+	sources.push_back(p_fragment);
+	return sources;
+}
+
+TEST_CASE("[ShaderCacheRD] Source hashing") {
+	String hash = ShaderCacheRD::hash_sources("key", make_sources("void main() {}", "void main() { frag_color = vec4(1.0); }"));
+	CHECK(hash.length() == 64);
+	CHECK_MESSAGE(
+			hash == ShaderCacheRD::hash_sources("key", make_sources("void main() {}", "void main() { frag_color = vec4(1.0); }")),
+			"The same sources should hash the same.");
+	CHECK_MESSAGE(
+			hash != ShaderCacheRD::hash_sources("other key", make_sources("void main() {}", "void main() { frag_color = vec4(1.0); }")),
+			"A different compiler or device should not share entries.");
+	CHECK_MESSAGE(
+			hash != ShaderCacheRD::hash_sources("key", make_sources("void main() {}", "void main() { frag_color = vec4(0.0); }")),
+			"Any change to the code should change the hash.");
+	CHECK_MESSAGE(
+			ShaderCacheRD::hash_sources("key", make_sources("ab", "c")) != ShaderCacheRD::hash_sources("key", make_sources("a", "bc")),
+			"Moving code from one stage to the other should change the hash.");
+}
+
+TEST_CASE("[ShaderCacheRD] Save and load entries") {
+	String path = make_cache_dir("shader_cache_rd_entries");
+	Vector<uint8_t> data = make_shader_data(4096, 0);
+	String hash = ShaderCacheRD::hash_sources("key", make_sources("vertex", "fragment"));
+
+	SUBCASE("Compressed") {
+		ShaderCacheRD cache(path, true, true);
+		Vector<uint8_t> loaded;
+		CHECK_FALSE(cache.load(hash, loaded));
+		CHECK(cache.get_miss_count() == 1);
+
+		cache.save(hash, data);
+		CHECK(cache.load(hash, loaded));
+		CHECK(loaded == data);
+		CHECK(cache.get_hit_count() == 1);
+
+		FileAccessRef f = FileAccess::open(path.plus_file(hash.substr(0, 2)).plus_file(hash + ".cache"), FileAccess::READ);
+		REQUIRE(f);
+		CHECK_MESSAGE(
+				f->get_length() < uint64_t(data.size()),
+				"Entries should be stored compressed.");
+	}
+
+	SUBCASE("Uncompressed") {
+		ShaderCacheRD cache(path, false);
+		cache.save(hash, data);
+		Vector<uint8_t> loaded;
+		CHECK(cache.load(hash, loaded));
+		CHECK(loaded == data);
+	}
+
+	SUBCASE("Shared across instances") {
+		{
+			ShaderCacheRD cache(path, true, false);
+			cache.save(hash, data);
+		}
+		ShaderCacheRD cache(path, true, true);
+		Vector<uint8_t> loaded;
+		CHECK_MESSAGE(
+				cache.load(hash, loaded),
+				"Entries should be read back whatever compression the reader would use to save.");
+		CHECK(loaded == data);
+	}
+}
+
+TEST_CASE("[ShaderCacheRD] Corrupt entries are rejected") {
+	String path = make_cache_dir("shader_cache_rd_corrupt");
+	Vector<uint8_t> data = make_shader_data(4096, 1);
+	String hash = ShaderCacheRD::hash_sources("key", make_sources("vertex", "corrupt"));
+	String entry_path = path.plus_file(hash.substr(0, 2)).plus_file(hash + ".cache");
+
+	ShaderCacheRD cache(path);
+	cache.save(hash, data);
+
+	Vector<uint8_t> bytes = FileAccess::get_file_as_array(entry_path);
+	REQUIRE(bytes.size() > 32);
+
+	ERR_PRINT_OFF;
+
+	SUBCASE("Flipped byte") {
+		bytes.write[bytes.size() - 8] ^= 0xFF;
+		FileAccessRef f = FileAccess::open(entry_path, FileAccess::WRITE);
+		f->store_buffer(bytes.ptr(), bytes.size());
+		f->close();
+
+		Vector<uint8_t> loaded;
+		CHECK_FALSE(cache.load(hash, loaded));
+	}
+
+	SUBCASE("Truncated") {
+		FileAccessRef f = FileAccess::open(entry_path, FileAccess::WRITE);
+		f->store_buffer(bytes.ptr(), bytes.size() / 2);
+		f->close();
+
+		Vector<uint8_t> loaded;
+		CHECK_FALSE(cache.load(hash, loaded));
+	}
+
+	ERR_PRINT_ON;
+
+	// A corrupt entry is a miss, the compiled result overwrites it.
+	cache.save(hash, data);
+	Vector<uint8_t> loaded;
+	CHECK(cache.load(hash, loaded));
+	CHECK(loaded == data);
+}
+
+TEST_CASE("[ShaderCacheRD] Prewarm entries used in the last run") {
+	String path = make_cache_dir("shader_cache_rd_prewarm");
+	const int entry_count = 32;
+
+	Vector<String> hashes;
+	{
+		ShaderCacheRD cache(path);
+		for (int i = 0; i < entry_count; i++) {
+			hashes.push_back(ShaderCacheRD::hash_sources("key", make_sources("vertex", itos(i))));
+			cache.save(hashes[i], make_shader_data(1024, i));
+		}
+		CHECK(cache.save_prewarm_list() == OK);
+	}
+
+	ShaderCacheRD cache(path);
+	cache.prewarm();
+	cache.wait_for_prewarm();
+
+	for (int i = 0; i < entry_count; i++) {
+		Vector<uint8_t> loaded;
+		CHECK(cache.load(hashes[i], loaded));
+		CHECK(loaded == make_shader_data(1024, i));
+	}
+	CHECK(cache.get_hit_count() == entry_count);
+	CHECK_MESSAGE(
+			cache.get_prewarm_hit_count() == entry_count,
+			"Every entry should have been read ahead of its load.");
+	CHECK(cache.get_miss_count() == 0);
+
+	// Loading while the prewarm is still running gives the same results.
+	ShaderCacheRD racing_cache(path);
+	racing_cache.prewarm();
+	for (int i = entry_count - 1; i >= 0; i--) {
+		Vector<uint8_t> loaded;
+		CHECK(racing_cache.load(hashes[i], loaded));
+		CHECK(loaded == make_shader_data(1024, i));
+	}
+	racing_cache.wait_for_prewarm();
+	CHECK(racing_cache.get_hit_count() == entry_count);
+}
+
+} // namespace TestShaderCacheRD
+
+#endif // TEST_SHADER_CACHE_RD_H
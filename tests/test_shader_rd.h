@@ -0,0 +1,101 @@
+/*************************************************************************/
+/*  test_shader_rd.h                                                     */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_SHADER_RD_H
+#define TEST_SHADER_RD_H
+
+#include "core/os/os.h"
+#include "servers/display_server.h"
+#include "servers/rendering/renderer_rd/shader_rd.h"
+#include "servers/rendering/rendering_device.h"
+#include "servers/rendering/rendering_server_default.h"
+
+#include "tests/test_macros.h"
+
+namespace TestShaderRD {
+
+// Returns the time the render thread spends in shader_set_code(), which waits for the variants its pipelines use.
+static uint64_t set_shader_codes(int p_count, int p_seed) {
+	uint64_t usec = 0;
+	for (int i = 0; i < p_count; i++) {
+		RID shader = RenderingServer::get_singleton()->shader_create();
+		// A different constant in each one, so none of them comes from the shader cache.
+		String code = vformat("shader_type spatial;\n\nvoid fragment() {\n\tALBEDO = vec3(%d.0, %d.0, 1.0) / 65536.0;\n}\n", p_seed, i);
+
+		uint64_t time = OS::get_singleton()->get_ticks_usec();
+		RenderingServer::get_singleton()->shader_set_code(shader, code);
+		usec += OS::get_singleton()->get_ticks_usec() - time;
+
+		RenderingServer::get_singleton()->free(shader);
+	}
+	return usec;
+}
+
+void benchmark() {
+	const int shader_count = 20;
+
+	// Shaders only compile on a real rendering device, the headless display server doesn't have one.
+	DisplayServer *display_server = nullptr;
+	for (int i = 0; i < DisplayServer::get_create_function_count() && !display_server; i++) {
+		if (String("headless") == DisplayServer::get_create_function_name(i)) {
+			continue;
+		}
+		Error err = OK;
+		display_server = DisplayServer::create(i, "vulkan", DisplayServer::WindowMode::WINDOW_MODE_MINIMIZED, DisplayServer::VSyncMode::VSYNC_ENABLED, 0, Vector2i(64, 64), err);
+		if (display_server && (err != OK || !RenderingDevice::get_singleton())) {
+			memdelete(display_server);
+			display_server = nullptr;
+		}
+	}
+	ERR_FAIL_COND_MSG(!display_server, "Compiling shaders needs a display server with a rendering device.");
+
+	memnew(RenderingServerDefault());
+	RenderingServerDefault::get_singleton()->init();
+	RenderingServerDefault::get_singleton()->set_render_loop_enabled(false);
+
+	int seed = int(uint64_t(OS::get_singleton()->get_unix_time()) % 10000) * 3;
+	set_shader_codes(1, seed); // Warm up.
+	uint64_t threaded_usec = set_shader_codes(shader_count, seed + 1);
+	ShaderRD::finish_compile_threads();
+	uint64_t serial_usec = set_shader_codes(shader_count, seed + 2);
+	ShaderRD::init_compile_threads();
+
+	print_line(vformat("Compiling %d spatial shaders: %d usec per shader with the compile threads, %d usec on the render thread alone.",
+			shader_count, threaded_usec / shader_count, serial_usec / shader_count));
+
+	RenderingServer::get_singleton()->sync();
+	RenderingServer::get_singleton()->finish();
+	memdelete(RenderingServer::get_singleton());
+	memdelete(display_server);
+}
+
+} // namespace TestShaderRD
+
+#endif // TEST_SHADER_RD_H
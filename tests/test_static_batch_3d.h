@@ -0,0 +1,343 @@
+/*************************************************************************/
+/*  test_static_batch_3d.h                                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_STATIC_BATCH_3D_H
+#define TEST_STATIC_BATCH_3D_H
+
+#include "core/math/random_pcg.h"
+#include "core/os/os.h"
+#include "core/templates/sort_array.h"
+#include "scene/3d/mesh_instance_3d.h"
+#include "scene/3d/static_batch_3d.h"
+#include "scene/main/window.h"
+#include "scene/resources/material.h"
+#include "servers/rendering/renderer_scene_cull.h"
+
+#include "tests/test_macros.h"
+
+namespace TestStaticBatch3D {
+
+static Array make_quad(bool p_indexed) {
+	PackedVector3Array vertices;
+	PackedVector3Array normals;
+	PackedVector2Array uvs;
+	vertices.push_back(Vector3(0, 0, 0));
+	vertices.push_back(Vector3(1, 0, 0));
+	vertices.push_back(Vector3(1, 1, 0));
+	vertices.push_back(Vector3(0, 1, 0));
+	for (int i = 0; i < 4; i++) {
+		normals.push_back(Vector3(0, 0, 1));
+		uvs.push_back(Vector2(vertices[i].x, vertices[i].y));
+	}
+
+	Array arrays;
+	arrays.resize(Mesh::ARRAY_MAX);
+	arrays[Mesh::ARRAY_VERTEX] = vertices;
+	arrays[Mesh::ARRAY_NORMAL] = normals;
+	arrays[Mesh::ARRAY_TEX_UV] = uvs;
+
+	if (p_indexed) {
+		PackedInt32Array indices;
+		indices.push_back(0);
+		indices.push_back(1);
+		indices.push_back(2);
+		indices.push_back(0);
+		indices.push_back(2);
+		indices.push_back(3);
+		arrays[Mesh::ARRAY_INDEX] = indices;
+	} else {
+		vertices.resize(3);
+		normals.resize(3);
+		uvs.resize(3);
+		arrays[Mesh::ARRAY_VERTEX] = vertices;
+		arrays[Mesh::ARRAY_NORMAL] = normals;
+		arrays[Mesh::ARRAY_TEX_UV] = uvs;
+	}
+
+	return arrays;
+}
+
+TEST_CASE("[StaticBatch3D] Merge surfaces") {
+	Vector<StaticBatch3D::SurfaceSource> surfaces;
+
+	StaticBatch3D::SurfaceSource source;
+	source.arrays = make_quad(true);
+	source.transform = Transform3D(Basis(), Vector3(10, 0, 0));
+	surfaces.push_back(source);
+
+	source.arrays = make_quad(false);
+	source.transform = Transform3D(Basis(Vector3(0, 1, 0), Math_PI * 0.5), Vector3());
+	surfaces.push_back(source);
+
+	// Mirrored along X.
+	source.arrays = make_quad(true);
+	source.transform = Transform3D(Basis().scaled(Vector3(-1, 1, 1)), Vector3());
+	surfaces.push_back(source);
+
+	Array merged = StaticBatch3D::merge_surfaces(surfaces);
+	REQUIRE(merged.size() == Mesh::ARRAY_MAX);
+
+	PackedVector3Array vertices = merged[Mesh::ARRAY_VERTEX];
+	PackedVector3Array normals = merged[Mesh::ARRAY_NORMAL];
+	PackedVector2Array uvs = merged[Mesh::ARRAY_TEX_UV];
+	PackedInt32Array indices = merged[Mesh::ARRAY_INDEX];
+
+	CHECK(StaticBatch3D::get_surface_format(merged) == (Mesh::ARRAY_FORMAT_VERTEX | Mesh::ARRAY_FORMAT_NORMAL | Mesh::ARRAY_FORMAT_TEX_UV));
+	CHECK(vertices.size() == 11);
+	CHECK(normals.size() == 11);
+	CHECK(uvs.size() == 11);
+	CHECK(indices.size() == 15);
+
+	CHECK(vertices[2].is_equal_approx(Vector3(11, 1, 0)));
+	CHECK(uvs[2].is_equal_approx(Vector2(1, 1)));
+	CHECK_MESSAGE(vertices[5].is_equal_approx(Vector3(0, 0, -1)), "Vertices should be transformed into the batch space.");
+	CHECK_MESSAGE(normals[5].is_equal_approx(Vector3(1, 0, 0)), "Normals should be rotated with the surface.");
+
+	CHECK_MESSAGE(indices[8] == 6, "Non-indexed surfaces should get sequential indices after the previous surface.");
+	CHECK(indices[3] == 0);
+	CHECK(indices[5] == 3);
+
+	CHECK(indices[9] == 7);
+	CHECK_MESSAGE(indices[10] == 9, "Mirrored surfaces should flip their winding order.");
+	CHECK_MESSAGE(indices[11] == 8, "Mirrored surfaces should flip their winding order.");
+	CHECK(vertices[8].is_equal_approx(Vector3(-1, 0, 0)));
+
+	SUBCASE("Surfaces with different formats can't be merged") {
+		Array arrays = make_quad(true);
+		arrays[Mesh::ARRAY_TEX_UV] = Variant();
+		source.arrays = arrays;
+		surfaces.push_back(source);
+
+		ERR_PRINT_OFF;
+		CHECK(StaticBatch3D::merge_surfaces(surfaces).is_empty());
+		ERR_PRINT_ON;
+	}
+}
+
+// ArrayMesh reads its arrays back from the rendering server, which the dummy renderer doesn't keep.
+class TestQuadMesh : public Mesh {
+	Array arrays = make_quad(true);
+	Ref<Material> material;
+
+public:
+	int get_surface_count() const override { return 1; }
+	int surface_get_array_len(int p_idx) const override { return PackedVector3Array(arrays[Mesh::ARRAY_VERTEX]).size(); }
+	int surface_get_array_index_len(int p_idx) const override { return PackedInt32Array(arrays[Mesh::ARRAY_INDEX]).size(); }
+	Array surface_get_arrays(int p_surface) const override { return arrays; }
+	Array surface_get_blend_shape_arrays(int p_surface) const override { return Array(); }
+	Dictionary surface_get_lods(int p_surface) const override { return Dictionary(); }
+	uint32_t surface_get_format(int p_idx) const override { return StaticBatch3D::get_surface_format(arrays) | Mesh::ARRAY_FORMAT_INDEX; }
+	PrimitiveType surface_get_primitive_type(int p_idx) const override { return PRIMITIVE_TRIANGLES; }
+	void surface_set_material(int p_idx, const Ref<Material> &p_material) override { material = p_material; }
+	Ref<Material> surface_get_material(int p_idx) const override { return material; }
+	int get_blend_shape_count() const override { return 0; }
+	StringName get_blend_shape_name(int p_index) const override { return StringName(); }
+	void set_blend_shape_name(int p_index, const StringName &p_name) override {}
+	AABB get_aabb() const override { return AABB(Vector3(), Vector3(1, 1, 0)); }
+};
+
+static MeshInstance3D *add_prop(Node *p_parent, const Ref<Mesh> &p_mesh, const Vector3 &p_position) {
+	MeshInstance3D *prop = memnew(MeshInstance3D);
+	prop->set_mesh(p_mesh);
+	prop->set_position(p_position);
+	p_parent->add_child(prop);
+	return prop;
+}
+
+TEST_CASE("[SceneTree][StaticBatch3D] Batch and unbatch a scene") {
+	Ref<Material> wood = memnew(ShaderMaterial);
+	Ref<Material> stone = memnew(ShaderMaterial);
+
+	Ref<TestQuadMesh> crate = memnew(TestQuadMesh);
+	crate->surface_set_material(0, wood);
+	Ref<TestQuadMesh> wall = memnew(TestQuadMesh);
+	wall->surface_set_material(0, stone);
+
+	StaticBatch3D *batch = memnew(StaticBatch3D);
+	batch->set_batch_on_ready(false);
+	SceneTree::get_singleton()->get_root()->add_child(batch);
+
+	// Three crates sharing a mesh, one of them nested, and a wall.
+	MeshInstance3D *props[4];
+	props[0] = add_prop(batch, crate, Vector3(0, 0, 0));
+	props[1] = add_prop(batch, crate, Vector3(2, 0, 0));
+	Node3D *group = memnew(Node3D);
+	group->set_position(Vector3(0, 0, 2));
+	batch->add_child(group);
+	props[2] = add_prop(group, crate, Vector3(4, 0, 0));
+	props[3] = add_prop(batch, wall, Vector3(0, 0, 4));
+	Node3D *attachment = memnew(Node3D);
+	props[0]->add_child(attachment);
+
+	MeshInstance3D *hidden = add_prop(batch, crate, Vector3(6, 0, 0));
+	hidden->hide();
+
+	batch->batch();
+
+	CHECK(batch->is_batched());
+	CHECK(batch->get_batched_instance_count() == 4);
+	CHECK_MESSAGE(batch->get_chunk_count() == 2, "Props in the same cell should be merged per material.");
+	for (int i = 0; i < 4; i++) {
+		CHECK_MESSAGE(props[i]->is_visible(), "Batching should only hide the instances of the props, not the nodes.");
+	}
+	CHECK_MESSAGE(attachment->is_visible_in_tree(), "Children of batched props should stay visible.");
+	CHECK_MESSAGE(!hidden->is_visible(), "Hidden props aren't batched.");
+
+	int crate_chunks = 0;
+	int wall_chunks = 0;
+	for (int i = batch->get_child_count(false); i < batch->get_child_count(); i++) {
+		MeshInstance3D *chunk = Object::cast_to<MeshInstance3D>(batch->get_child(i));
+		REQUIRE(chunk);
+		Ref<Mesh> mesh = chunk->get_mesh();
+		REQUIRE(mesh.is_valid());
+		REQUIRE(mesh->get_surface_count() == 1);
+
+		if (mesh->surface_get_material(0) == wood) {
+			crate_chunks++;
+			CHECK(mesh->surface_get_array_len(0) == 12);
+			CHECK(mesh->surface_get_array_index_len(0) == 18);
+			CHECK(mesh->get_aabb().is_equal_approx(AABB(Vector3(0, 0, 0), Vector3(5, 1, 2))));
+		} else if (mesh->surface_get_material(0) == stone) {
+			wall_chunks++;
+			CHECK(mesh->surface_get_array_len(0) == 4);
+			CHECK(mesh->surface_get_array_index_len(0) == 6);
+			CHECK(mesh->get_aabb().is_equal_approx(AABB(Vector3(0, 0, 4), Vector3(1, 1, 0))));
+		}
+	}
+	CHECK(crate_chunks == 1);
+	CHECK(wall_chunks == 1);
+
+	batch->unbatch();
+
+	CHECK(!batch->is_batched());
+	CHECK(batch->get_chunk_count() == 0);
+	CHECK_MESSAGE(batch->get_child_count() == batch->get_child_count(false), "The chunks should be freed.");
+	CHECK(batch->get_child_count(false) == 5);
+	for (int i = 0; i < 4; i++) {
+		CHECK_MESSAGE(props[i]->is_visible(), "Unbatched props should be shown again.");
+	}
+	CHECK(!hidden->is_visible());
+
+	memdelete(batch);
+}
+
+// Same work the scene cull and render list do per visible geometry: a frustum test, then a sort by material.
+static uint32_t cull_and_submit(const LocalVector<RendererSceneCull::InstanceBounds> &p_bounds, const LocalVector<uint32_t> &p_materials, const RendererSceneCull::Frustum &p_frustum, LocalVector<uint64_t> &r_render_list) {
+	r_render_list.clear();
+	for (uint32_t i = 0; i < p_bounds.size(); i++) {
+		if (p_bounds[i].in_frustum(p_frustum)) {
+			r_render_list.push_back((uint64_t(p_materials[i]) << 32) | i);
+		}
+	}
+
+	SortArray<uint64_t> sorter;
+	sorter.sort(r_render_list.ptr(), r_render_list.size());
+	return r_render_list.size();
+}
+
+void benchmark() {
+	const uint32_t prop_count = 200000;
+	const uint32_t material_count = 8;
+	const uint32_t frame_count = 30;
+	const real_t city_size = 2000;
+	const real_t cell_size = 32;
+
+	// A flat city, props share one of a few materials.
+	const int cells_per_side = int(Math::ceil(city_size / cell_size));
+	LocalVector<RendererSceneCull::InstanceBounds> prop_bounds;
+	LocalVector<uint32_t> prop_materials;
+	LocalVector<AABB> chunk_aabbs;
+	LocalVector<uint32_t> chunk_materials;
+	LocalVector<int> chunk_for_key;
+	chunk_for_key.resize(cells_per_side * cells_per_side * material_count);
+	for (uint32_t i = 0; i < chunk_for_key.size(); i++) {
+		chunk_for_key[i] = -1;
+	}
+
+	RandomPCG rng(1234);
+	for (uint32_t i = 0; i < prop_count; i++) {
+		Vector3 position = Vector3(rng.randf() * city_size, rng.randf() * 2, rng.randf() * city_size);
+		AABB aabb(position, Vector3(1, 2, 1));
+		uint32_t material = rng.rand() % material_count;
+		prop_bounds.push_back(RendererSceneCull::InstanceBounds(aabb));
+		prop_materials.push_back(material);
+
+		// Same clustering as StaticBatch3D, one chunk per cell and material.
+		Vector3i cell = Vector3i((aabb.get_center() / cell_size).floor());
+		int key = (cell.z * cells_per_side + cell.x) * material_count + material;
+		if (chunk_for_key[key] < 0) {
+			chunk_for_key[key] = chunk_aabbs.size();
+			chunk_aabbs.push_back(aabb);
+			chunk_materials.push_back(material);
+		} else {
+			chunk_aabbs[chunk_for_key[key]].merge_with(aabb);
+		}
+	}
+
+	LocalVector<RendererSceneCull::InstanceBounds> chunk_bounds;
+	for (uint32_t i = 0; i < chunk_aabbs.size(); i++) {
+		chunk_bounds.push_back(RendererSceneCull::InstanceBounds(chunk_aabbs[i]));
+	}
+
+	CameraMatrix projection;
+	projection.set_perspective(75, 16.0 / 9.0, 0.05, 500);
+
+	LocalVector<uint64_t> render_list;
+	uint64_t usec[2] = { 0, 0 };
+	uint32_t draws[2] = { 0, 0 };
+
+	for (int batched = 0; batched < 2; batched++) {
+		for (uint32_t frame = 0; frame < frame_count; frame++) {
+			// Walk along the street, looking down it.
+			Vector3 eye = Vector3(city_size * 0.5, 2, frame * 10.0);
+			Transform3D camera = Transform3D().looking_at(Vector3(0, 0, 1), Vector3(0, 1, 0));
+			camera.origin = eye;
+			RendererSceneCull::Frustum frustum(projection.get_projection_planes(camera));
+
+			uint64_t time = OS::get_singleton()->get_ticks_usec();
+			if (batched) {
+				draws[1] = cull_and_submit(chunk_bounds, chunk_materials, frustum, render_list);
+			} else {
+				draws[0] = cull_and_submit(prop_bounds, prop_materials, frustum, render_list);
+			}
+			usec[batched] += OS::get_singleton()->get_ticks_usec() - time;
+		}
+	}
+
+	ERR_FAIL_COND_MSG(draws[1] == 0 || draws[1] >= draws[0], "Batched chunks should need fewer draws than individual props.");
+
+	print_line(vformat("%d static props in %d chunks: %d usec per frame culling and submitting props, %d usec with chunks.",
+			prop_count, chunk_bounds.size(), usec[0] / frame_count, usec[1] / frame_count));
+	print_line(vformat("Draws in the last frame: %d props, %d chunks.", draws[0], draws[1]));
+}
+
+} // namespace TestStaticBatch3D
+
+#endif // TEST_STATIC_BATCH_3D_H
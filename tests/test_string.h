@@ -159,6 +159,40 @@ TEST_CASE("[String] UTF16 with BOM") {
 	CHECK(String::utf16(cs) == s);
 }
 
+TEST_CASE("[String] UTF8 and UTF16 around ASCII runs") {
+	// Runs are measured in chunks, put a non-ASCII character at every offset around the chunk boundaries.
+	for (int length = 1; length < 40; length++) {
+		for (int position = 0; position < length; position++) {
+			String s;
+			for (int i = 0; i < length; i++) {
+				s += i == position ? char32_t(0x304A) : char32_t('a' + i % 26);
+			}
+
+			CharString utf8 = s.utf8();
+			CHECK(utf8.length() == length + 2);
+			String from_utf8;
+			CHECK(!from_utf8.parse_utf8(utf8.get_data(), utf8.length()));
+			CHECK(from_utf8 == s);
+
+			Char16String utf16 = s.utf16();
+			CHECK(utf16.length() == length);
+			String from_utf16;
+			CHECK(!from_utf16.parse_utf16(utf16.get_data(), utf16.length()));
+			CHECK(from_utf16 == s);
+		}
+	}
+
+	// Parsing stops at a null character, even with a length given.
+	static const char u8str[] = "abcdefghijklmnop\0qrstuvwxyz";
+	String s;
+	CHECK(!s.parse_utf8(u8str, sizeof(u8str) - 1));
+	CHECK(s == "abcdefghijklmnop");
+
+	static const char16_t u16str[] = u"abcdefghijklmnop\0qrstuvwxyz";
+	CHECK(!s.parse_utf16(u16str, sizeof(u16str) / sizeof(char16_t) - 1));
+	CHECK(s == "abcdefghijklmnop");
+}
+
 TEST_CASE("[String] Invalid UTF8") {
 	ERR_PRINT_OFF
 	static const uint8_t u8str[] = { 0x45, 0xE3, 0x81, 0x8A, 0x8F, 0xE3, 0xE3, 0x98, 0x8F, 0xE3, 0x82, 0x88, 0xE3, 0x81, 0x86, 0xF0, 0x9F, 0x8E, 0xA4, 0 };
@@ -1453,6 +1487,131 @@ TEST_CASE("[String] Variant ptr indexed set") {
 
 	CHECK_EQ(s, String("azcd"));
 }
+
+TEST_CASE("[String] Allocations concatenating short strings") {
+	const int string_count = 100;
+	const String prefix = "node_";
+	const String suffix = "item";
+
+	uint64_t alloc_calls = Memory::get_alloc_call_count();
+	for (int i = 0; i < string_count; i++) {
+		// Shares the prefix buffer, then copies it into a buffer large enough for the result.
+		String name = prefix + suffix;
+		CHECK(name.length() == 9);
+	}
+	alloc_calls = Memory::get_alloc_call_count() - alloc_calls;
+#ifdef DEBUG_ENABLED
+	CHECK_MESSAGE(alloc_calls <= uint64_t(string_count), "Concatenating two strings should allocate once.");
+#endif
+
+	alloc_calls = Memory::get_alloc_call_count();
+	for (int i = 0; i < string_count; i++) {
+		String name;
+		for (int j = 0; j < 6; j++) {
+			name += char32_t('a' + j);
+		}
+		CHECK(name == "abcdef");
+	}
+	alloc_calls = Memory::get_alloc_call_count() - alloc_calls;
+#ifdef DEBUG_ENABLED
+	CHECK_MESSAGE(alloc_calls <= uint64_t(string_count), "Appending up to 7 characters should fit the first allocation.");
+#endif
+
+	String shared = prefix;
+	String appended = shared + suffix;
+	CHECK(shared == "node_");
+	CHECK(appended == "node_item");
+}
+
+void benchmark_allocations() {
+	const int string_count = 100000;
+	const String prefix = "node_";
+	const String suffix = "item";
+	int total_length = 0;
+
+	uint64_t alloc_calls = Memory::get_alloc_call_count();
+	uint64_t time = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < string_count; i++) {
+		String name = prefix + suffix;
+		total_length += name.length();
+	}
+	time = OS::get_singleton()->get_ticks_usec() - time;
+	alloc_calls = Memory::get_alloc_call_count() - alloc_calls;
+
+	print_line(vformat("Concatenating two strings: %.2f allocations per string, %d usec for %d strings (%d characters).",
+			double(alloc_calls) / string_count, time, string_count, total_length));
+
+	total_length = 0;
+	alloc_calls = Memory::get_alloc_call_count();
+	time = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < string_count; i++) {
+		String name;
+		for (int j = 0; j < 6; j++) {
+			name += char32_t('a' + j);
+		}
+		total_length += name.length();
+	}
+	time = OS::get_singleton()->get_ticks_usec() - time;
+	alloc_calls = Memory::get_alloc_call_count() - alloc_calls;
+
+	print_line(vformat("Appending 6 characters: %.2f allocations per string, %d usec for %d strings (%d characters).",
+			double(alloc_calls) / string_count, time, string_count, total_length));
+}
+
+void benchmark_transcoding() {
+	String json = "[\n";
+	for (int i = 0; i < 5000; i++) {
+		json += "\t{\"name\": \"node_" + itos(i) + "\", \"position\": [1.5, 2.25, -3.0], \"visible\": true},\n";
+	}
+	json += "]\n";
+
+	String text;
+	static const char32_t line[] = U"Gr\u00fc\u00dfe aus K\u00f6ln, \u6771\u4eac\u3068\u5927\u962a\u3092\u8a2a\u308c\u307e\u3057\u305f. \u041f\u0440\u0438\u0432\u0435\u0442!\n";
+	for (int i = 0; i < 5000; i++) {
+		text += line;
+	}
+
+	const int rounds = 20;
+	const String names[] = { "JSON", "text" };
+	const String *sources[] = { &json, &text };
+	for (int i = 0; i < 2; i++) {
+		const String &source = *sources[i];
+		CharString utf8 = source.utf8();
+		Char16String utf16 = source.utf16();
+
+		// Best of the rounds, so the numbers don't depend on what else the machine is doing.
+		uint64_t best_usec[4] = { UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX };
+		for (int j = 0; j < rounds; j++) {
+			uint64_t time = OS::get_singleton()->get_ticks_usec();
+			String from_utf8;
+			from_utf8.parse_utf8(utf8.get_data(), utf8.length());
+			uint64_t after_parse_utf8 = OS::get_singleton()->get_ticks_usec();
+			CharString to_utf8 = source.utf8();
+			uint64_t after_utf8 = OS::get_singleton()->get_ticks_usec();
+			Char16String to_utf16 = source.utf16();
+			uint64_t after_utf16 = OS::get_singleton()->get_ticks_usec();
+			String from_utf16;
+			from_utf16.parse_utf16(utf16.get_data(), utf16.length());
+			uint64_t after_parse_utf16 = OS::get_singleton()->get_ticks_usec();
+
+			best_usec[0] = MIN(best_usec[0], after_parse_utf8 - time);
+			best_usec[1] = MIN(best_usec[1], after_utf8 - after_parse_utf8);
+			best_usec[2] = MIN(best_usec[2], after_utf16 - after_utf8);
+			best_usec[3] = MIN(best_usec[3], after_parse_utf16 - after_utf16);
+
+			if (j == 0) {
+				ERR_FAIL_COND(from_utf8 != source || from_utf16 != source);
+				ERR_FAIL_COND(strcmp(to_utf8.get_data(), utf8.get_data()) != 0 || to_utf16.length() != utf16.length());
+			}
+		}
+
+		String result = vformat("Transcoding %d bytes of %s: parse_utf8 %d usec, utf8 %d usec, ",
+				utf8.length(), names[i], best_usec[0], best_usec[1]);
+		result += vformat("utf16 %d usec, parse_utf16 %d usec.", best_usec[2], best_usec[3]);
+		print_line(result);
+	}
+}
+
 } // namespace TestString
 
 #endif // TEST_STRING_H
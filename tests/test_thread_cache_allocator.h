@@ -0,0 +1,296 @@
+/*************************************************************************/
+/*  test_thread_cache_allocator.h                                        */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_THREAD_CACHE_ALLOCATOR_H
+#define TEST_THREAD_CACHE_ALLOCATOR_H
+
+#include "core/os/os.h"
+#include "core/os/thread.h"
+#include "core/os/thread_cache_allocator.h"
+#include "scene/main/node.h"
+#include "scene/resources/packed_scene.h"
+
+#include "tests/test_macros.h"
+
+#include <stdlib.h>
+
+namespace TestThreadCacheAllocator {
+
+static int find_size_class(size_t p_bytes) {
+	for (int i = 0; i < ThreadCacheAllocator::get_size_class_count(); i++) {
+		uint32_t block_size = ThreadCacheAllocator::get_size_class_stats(i).block_size;
+		if (block_size == 0 || block_size >= p_bytes) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+TEST_CASE("[ThreadCacheAllocator] Allocate and free blocks of every size") {
+	Vector<uint8_t *> blocks;
+	Vector<size_t> sizes;
+	for (size_t size = 1; size <= 100000; size += size / 8 + 1) {
+		uint8_t *block = (uint8_t *)ThreadCacheAllocator::alloc(size);
+		REQUIRE(block != nullptr);
+		CHECK_MESSAGE(((uintptr_t)block & 15) == 0, "Blocks should be aligned to 16 bytes.");
+		CHECK(ThreadCacheAllocator::get_usable_size(block) >= size);
+		memset(block, size & 0xFF, size);
+		blocks.push_back(block);
+		sizes.push_back(size);
+	}
+
+	bool intact = true;
+	for (int i = 0; i < blocks.size(); i++) {
+		for (size_t j = 0; j < sizes[i]; j++) {
+			intact = intact && blocks[i][j] == (sizes[i] & 0xFF);
+		}
+	}
+	CHECK_MESSAGE(intact, "Blocks should not overlap.");
+
+	for (int i = 0; i < blocks.size(); i++) {
+		ThreadCacheAllocator::free(blocks[i]);
+	}
+}
+
+TEST_CASE("[ThreadCacheAllocator] Reallocate") {
+	uint8_t *block = (uint8_t *)ThreadCacheAllocator::alloc(24);
+	for (int i = 0; i < 24; i++) {
+		block[i] = i;
+	}
+
+	// Grows within its size class, then to another one, then past the largest one.
+	const size_t sizes[] = { 32, 1000, 50000, 100 };
+	for (size_t size : sizes) {
+		block = (uint8_t *)ThreadCacheAllocator::realloc(block, size);
+		REQUIRE(block != nullptr);
+		CHECK(ThreadCacheAllocator::get_usable_size(block) >= size);
+		bool intact = true;
+		for (int i = 0; i < 24; i++) {
+			intact = intact && block[i] == i;
+		}
+		CHECK_MESSAGE(intact, vformat("Contents should be kept when reallocating to %d bytes.", (int64_t)size).utf8().ptr());
+	}
+
+	CHECK(ThreadCacheAllocator::realloc(block, 0) == nullptr);
+}
+
+TEST_CASE("[ThreadCacheAllocator] Size class statistics") {
+	const int count = 1000;
+	const int size_class = find_size_class(200);
+	REQUIRE(size_class >= 0);
+	ThreadCacheAllocator::SizeClassStats before = ThreadCacheAllocator::get_size_class_stats(size_class);
+	CHECK(before.block_size >= 200);
+
+	void *blocks[count];
+	for (int i = 0; i < count; i++) {
+		blocks[i] = ThreadCacheAllocator::alloc(200);
+	}
+	ThreadCacheAllocator::SizeClassStats during = ThreadCacheAllocator::get_size_class_stats(size_class);
+	CHECK(during.allocations >= before.allocations + count);
+	CHECK(during.blocks_in_use >= before.blocks_in_use + count);
+	CHECK(during.bytes_reserved >= count * during.block_size);
+
+	for (int i = 0; i < count; i++) {
+		ThreadCacheAllocator::free(blocks[i]);
+	}
+	ThreadCacheAllocator::flush_thread_cache();
+	ThreadCacheAllocator::SizeClassStats after = ThreadCacheAllocator::get_size_class_stats(size_class);
+	CHECK(after.blocks_in_use + count <= during.blocks_in_use);
+	CHECK_MESSAGE(after.bytes_reserved < during.bytes_reserved, "Empty spans should be reclaimed.");
+
+	const int large_class = ThreadCacheAllocator::get_size_class_count() - 1;
+	CHECK(ThreadCacheAllocator::get_size_class_stats(large_class).block_size == 0);
+	uint64_t large_before = ThreadCacheAllocator::get_size_class_stats(large_class).blocks_in_use;
+	void *large = ThreadCacheAllocator::alloc(1 << 20);
+	CHECK(ThreadCacheAllocator::get_size_class_stats(large_class).blocks_in_use == large_before + 1);
+	ThreadCacheAllocator::free(large);
+}
+
+#if !defined(NO_THREADS)
+struct CrossThreadData {
+	void *blocks[1000];
+	int count = 1000;
+};
+
+static void allocate_blocks(void *p_userdata) {
+	CrossThreadData *data = (CrossThreadData *)p_userdata;
+	for (int i = 0; i < data->count; i++) {
+		data->blocks[i] = ThreadCacheAllocator::alloc(16 + i % 500);
+		memset(data->blocks[i], 0xAB, 16 + i % 500);
+	}
+}
+
+TEST_CASE("[ThreadCacheAllocator] Free blocks allocated by an exited thread") {
+	CrossThreadData data;
+	Thread thread;
+	thread.start(allocate_blocks, &data);
+	thread.wait_to_finish();
+
+	// The allocating thread's cache is gone, its blocks are still valid.
+	bool intact = true;
+	for (int i = 0; i < data.count; i++) {
+		intact = intact && ((uint8_t *)data.blocks[i])[15] == 0xAB;
+		ThreadCacheAllocator::free(data.blocks[i]);
+	}
+	CHECK(intact);
+	ThreadCacheAllocator::flush_thread_cache();
+}
+#endif
+
+// Engine workloads, going through Memory like the rest of the engine.
+
+static void build_strings(void *p_userdata) {
+	for (int i = 0; i < 200; i++) {
+		String text;
+		for (int j = 0; j < 100; j++) {
+			text += "item_" + itos(j) + ", ";
+		}
+		Vector<String> parts = text.split(", ", false);
+		String joined = String("; ").join(parts);
+		ERR_FAIL_COND(joined.length() <= text.length() / 2);
+	}
+}
+
+static Ref<PackedScene> make_scene(int p_node_count) {
+	Node *root = memnew(Node);
+	root->set_name("Root");
+	for (int i = 0; i < p_node_count; i++) {
+		Node *child = memnew(Node);
+		child->set_name(vformat("Child%d", i));
+		child->add_to_group("children");
+		root->add_child(child);
+		child->set_owner(root);
+	}
+	Ref<PackedScene> scene;
+	scene.instantiate();
+	scene->pack(root);
+	memdelete(root);
+	return scene;
+}
+
+static void benchmark_engine_workload() {
+#ifdef BUILTIN_ALLOCATOR_ENABLED
+	const String allocator = "built-in allocator";
+#else
+	const String allocator = "system allocator";
+#endif
+
+	Ref<PackedScene> scene = make_scene(200);
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < 100; i++) {
+		Node *instance = scene->instantiate();
+		ERR_FAIL_COND(!instance);
+		memdelete(instance);
+	}
+	uint64_t instancing_usec = OS::get_singleton()->get_ticks_usec() - begin;
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	build_strings(nullptr);
+	uint64_t strings_usec = OS::get_singleton()->get_ticks_usec() - begin;
+
+	uint64_t threaded_strings_usec = 0;
+#if !defined(NO_THREADS)
+	begin = OS::get_singleton()->get_ticks_usec();
+	Thread threads[4];
+	for (int i = 0; i < 4; i++) {
+		threads[i].start(build_strings, nullptr);
+	}
+	for (int i = 0; i < 4; i++) {
+		threads[i].wait_to_finish();
+	}
+	threaded_strings_usec = OS::get_singleton()->get_ticks_usec() - begin;
+#endif
+
+	String result = vformat("With the %s: instancing a 200 node scene 100 times %d usec, building strings %d usec, building strings on 4 threads %d usec.",
+			allocator, instancing_usec, strings_usec, threaded_strings_usec);
+	print_line(result);
+}
+
+// Same sequence of allocations against malloc, independently of the allocator Memory uses.
+
+template <bool BUILTIN>
+static void allocate_mixed_sizes(void *p_userdata) {
+	const int slot_count = 4096;
+	void *slots[slot_count] = {};
+	uint32_t seed = (uint32_t)(uintptr_t)p_userdata;
+	for (int i = 0; i < 200000; i++) {
+		seed = seed * 1664525u + 1013904223u;
+		void *&slot = slots[(seed >> 8) % slot_count];
+		if (slot) {
+			BUILTIN ? ThreadCacheAllocator::free(slot) : ::free(slot);
+			slot = nullptr;
+		} else {
+			seed = seed * 1664525u + 1013904223u;
+			// Mostly small blocks, a few large ones.
+			uint32_t bucket = (seed >> 8) % 100;
+			size_t size = bucket < 90 ? (seed >> 16) % 256 + 1 : (bucket < 99 ? (seed >> 16) % 8000 + 1 : (seed >> 12) % 100000 + 1);
+			slot = BUILTIN ? ThreadCacheAllocator::alloc(size) : malloc(size);
+			*(uint8_t *)slot = 1;
+		}
+	}
+	for (int i = 0; i < slot_count; i++) {
+		if (slots[i]) {
+			BUILTIN ? ThreadCacheAllocator::free(slots[i]) : ::free(slots[i]);
+		}
+	}
+}
+
+template <bool BUILTIN>
+static uint64_t benchmark_mixed_sizes(int p_thread_count) {
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+#if !defined(NO_THREADS)
+	Thread threads[4];
+	for (int i = 1; i < p_thread_count; i++) {
+		threads[i].start(allocate_mixed_sizes<BUILTIN>, (void *)(uintptr_t)(i + 1));
+	}
+#endif
+	allocate_mixed_sizes<BUILTIN>((void *)(uintptr_t)1);
+#if !defined(NO_THREADS)
+	for (int i = 1; i < p_thread_count; i++) {
+		threads[i].wait_to_finish();
+	}
+#endif
+	return OS::get_singleton()->get_ticks_usec() - begin;
+}
+
+void benchmark() {
+	benchmark_engine_workload();
+
+	int thread_counts[] = { 1, 4 };
+	for (int thread_count : thread_counts) {
+		String result = vformat("Mixed sizes on %d threads: malloc %d usec, ThreadCacheAllocator %d usec.",
+				thread_count, benchmark_mixed_sizes<false>(thread_count), benchmark_mixed_sizes<true>(thread_count));
+		print_line(result);
+	}
+}
+
+} // namespace TestThreadCacheAllocator
+
+#endif // TEST_THREAD_CACHE_ALLOCATOR_H
@@ -31,6 +31,8 @@
 #ifndef TEST_VECTOR_H
 #define TEST_VECTOR_H
 
+#include "core/os/memory.h"
+#include "core/os/os.h"
 #include "core/templates/vector.h"
 
 #include "tests/test_macros.h"
@@ -504,6 +506,83 @@ TEST_CASE("[Vector] Operators") {
 	CHECK(vector != vector_other);
 }
 
+TEST_CASE("[Vector] Copy on write") {
+	Vector<int> vector;
+	for (int i = 0; i < 4; i++) {
+		vector.push_back(i);
+	}
+
+	Vector<int> copy = vector;
+	CHECK(copy.ptr() == vector.ptr());
+
+	copy.push_back(4);
+	CHECK(copy.ptr() != vector.ptr());
+	CHECK(vector.size() == 4);
+	CHECK(copy.size() == 5);
+	for (int i = 0; i < 4; i++) {
+		CHECK(vector[i] == i);
+		CHECK(copy[i] == i);
+	}
+	CHECK(copy[4] == 4);
+
+	Vector<int> shrunk = vector;
+	shrunk.resize(2);
+	CHECK(vector.size() == 4);
+	CHECK(shrunk.size() == 2);
+	CHECK(shrunk[1] == 1);
+	CHECK(vector[3] == 3);
+
+	Vector<String> strings;
+	strings.push_back("a");
+	strings.push_back("b");
+	Vector<String> strings_copy = strings;
+	strings_copy.resize(3);
+	strings_copy.write[2] = "c";
+	CHECK(strings.size() == 2);
+	CHECK(strings_copy[0] == "a");
+	CHECK(strings_copy[2] == "c");
+}
+
+TEST_CASE("[Vector] Allocations pushing back small vectors") {
+	const int vector_count = 100;
+
+	for (int element_count = 1; element_count <= 8; element_count *= 2) {
+		uint64_t alloc_calls = Memory::get_alloc_call_count();
+		for (int i = 0; i < vector_count; i++) {
+			Vector<int> vector;
+			for (int j = 0; j < element_count; j++) {
+				vector.push_back(j);
+			}
+			CHECK(vector.size() == element_count);
+		}
+		alloc_calls = Memory::get_alloc_call_count() - alloc_calls;
+
+#ifdef DEBUG_ENABLED
+		CHECK_MESSAGE(alloc_calls <= uint64_t(vector_count), "Vectors of up to 8 ints should fit their first allocation.");
+#endif
+	}
+}
+
+void benchmark_allocations() {
+	const int vector_count = 100000;
+
+	for (int element_count = 1; element_count <= 64; element_count *= 4) {
+		uint64_t alloc_calls = Memory::get_alloc_call_count();
+		uint64_t time = OS::get_singleton()->get_ticks_usec();
+		for (int i = 0; i < vector_count; i++) {
+			Vector<int> vector;
+			for (int j = 0; j < element_count; j++) {
+				vector.push_back(j);
+			}
+		}
+		time = OS::get_singleton()->get_ticks_usec() - time;
+		alloc_calls = Memory::get_alloc_call_count() - alloc_calls;
+
+		print_line(vformat("Pushing back %d ints: %.2f allocations per vector, %d usec for %d vectors.",
+				element_count, double(alloc_calls) / vector_count, time, vector_count));
+	}
+}
+
 } // namespace TestVector
 
 #endif // TEST_VECTOR_H